@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <memory>
 #include <vector>
 
 #include "db/compaction_iterator.h"
@@ -32,15 +33,219 @@
 #include "vidardb/table.h"
 #include "table/block_based_table_builder.h"
 #include "table/internal_iterator.h"
+#include "util/coding.h"
 #include "util/file_reader_writer.h"
 #include "util/iostats_context_imp.h"
+#include "util/mutexlock.h"
 #include "util/stop_watch.h"
+#include "util/sync_point.h"
 #include "util/thread_status_util.h"
 
 namespace vidardb {
 
 class TableFactory;
 
+namespace {
+
+// Moves the entries produced by the compaction iterator to a job in the
+// thread pool of pri that feeds the table builder, so that memtable iteration
+// overlaps with block encoding, compression and file writes. Entries are
+// copied into batches of length prefixed key/value pairs; at most kMaxBatches
+// batches are in flight, after which Add() blocks until the builder catches
+// up.
+//
+// If the job has not started by then, e.g. because the pool is busy with the
+// calling thread itself, the calling thread takes over and feeds the builder
+// inline for the rest of the table.
+class PipelinedTableBuilder {
+ public:
+  PipelinedTableBuilder(TableBuilder* builder, Env* env, Env::Priority pri)
+      : state_(std::make_shared<State>(builder)),
+        env_(env),
+        pri_(pri),
+        inline_(false),
+        finished_(false) {
+    env_->Schedule(&PipelinedTableBuilder::BGWork,
+                   new std::shared_ptr<State>(state_), pri_, this,
+                   &PipelinedTableBuilder::UnscheduleWork);
+  }
+
+  ~PipelinedTableBuilder() { Finish(); }
+
+  void Add(const Slice& key, const Slice& value) {
+    if (inline_) {
+      state_->builder->Add(key, value);
+      return;
+    }
+    PutLengthPrefixedSlice(&current_, key);
+    PutLengthPrefixedSlice(&current_, value);
+    if (current_.size() >= kBatchSize) {
+      Submit();
+    }
+  }
+
+  // Hands over the last batch and waits until the builder has consumed
+  // everything.
+  void Finish() {
+    if (finished_) {
+      return;
+    }
+    finished_ = true;
+    if (inline_) {
+      return;
+    }
+    Submit();
+    if (inline_) {
+      return;
+    }
+    MutexLock l(&state_->mu);
+    state_->done = true;
+    state_->cv.SignalAll();
+    if (state_->consumer == kNone) {
+      TakeOver();
+      return;
+    }
+    while (!state_->job_exited) {
+      state_->cv.Wait();
+    }
+    ReportBytesWritten();
+  }
+
+ private:
+  static const size_t kBatchSize = 256 << 10;
+  static const size_t kMaxBatches = 4;
+
+  enum Consumer { kNone, kJob, kProducer };
+
+  // Shared with the job, which may only get to run after the pipeline is
+  // gone when the calling thread took over.
+  struct State {
+    explicit State(TableBuilder* b)
+        : builder(b),
+          cv(&mu),
+          done(false),
+          consumer(kNone),
+          job_exited(false),
+          bytes_written(0) {}
+
+    TableBuilder* builder;
+    port::Mutex mu;
+    port::CondVar cv;
+    std::deque<std::string> queue;
+    std::vector<std::string> free;
+    bool done;
+    Consumer consumer;  // the one feeding the builder
+    bool job_exited;
+    // written by the job and not yet added to the IOStats of the producer
+    uint64_t bytes_written;
+  };
+
+  static void Feed(TableBuilder* builder, const std::string& batch) {
+    Slice input(batch);
+    Slice key, value;
+    while (GetLengthPrefixedSlice(&input, &key) &&
+           GetLengthPrefixedSlice(&input, &value)) {
+      builder->Add(key, value);
+    }
+  }
+
+  // REQUIRES: state_->mu held
+  // The file writes of the job are added to the IOStats of the calling
+  // thread batch by batch, so that the progress of a flush stays visible.
+  void ReportBytesWritten() {
+    IOSTATS_ADD(bytes_written, state_->bytes_written);
+    state_->bytes_written = 0;
+  }
+
+  // REQUIRES: state_->mu held, the job has not started
+  void TakeOver() {
+    TEST_SYNC_POINT("PipelinedTableBuilder::TakeOver");
+    state_->consumer = kProducer;
+    inline_ = true;
+    env_->UnSchedule(this, pri_);
+    for (const auto& batch : state_->queue) {
+      Feed(state_->builder, batch);
+    }
+    state_->queue.clear();
+    Feed(state_->builder, current_);
+    current_.clear();
+  }
+
+  void Submit() {
+    if (current_.empty()) {
+      return;
+    }
+    MutexLock l(&state_->mu);
+    ReportBytesWritten();
+    while (state_->queue.size() >= kMaxBatches) {
+      if (state_->consumer == kNone) {
+        TakeOver();
+        return;
+      }
+      state_->cv.Wait();
+      ReportBytesWritten();
+    }
+    state_->queue.emplace_back();
+    state_->queue.back().swap(current_);
+    if (!state_->free.empty()) {
+      current_.swap(state_->free.back());
+      state_->free.pop_back();
+    }
+    state_->cv.SignalAll();
+  }
+
+  static void BGWork(void* arg) {
+    std::unique_ptr<std::shared_ptr<State>> holder(
+        static_cast<std::shared_ptr<State>*>(arg));
+    State* state = holder->get();
+    MutexLock l(&state->mu);
+    if (state->consumer != kNone) {
+      return;
+    }
+    state->consumer = kJob;
+    TEST_SYNC_POINT("PipelinedTableBuilder::BGWork");
+    std::string batch;
+    while (true) {
+      if (!batch.empty()) {
+        batch.clear();
+        state->free.emplace_back();
+        state->free.back().swap(batch);
+      }
+      while (state->queue.empty() && !state->done) {
+        state->cv.Wait();
+      }
+      if (state->queue.empty()) {
+        break;
+      }
+      batch.swap(state->queue.front());
+      state->queue.pop_front();
+      state->cv.SignalAll();
+
+      state->mu.Unlock();
+      uint64_t prev_bytes_written = IOSTATS(bytes_written);
+      Feed(state->builder, batch);
+      uint64_t bytes_written = IOSTATS(bytes_written) - prev_bytes_written;
+      state->mu.Lock();
+      state->bytes_written += bytes_written;
+    }
+    state->job_exited = true;
+    state->cv.SignalAll();
+  }
+
+  static void UnscheduleWork(void* arg) {
+    delete static_cast<std::shared_ptr<State>*>(arg);
+  }
+
+  std::shared_ptr<State> state_;
+  Env* env_;
+  const Env::Priority pri_;
+  std::string current_;  // only touched by the producer
+  bool inline_;          // the producer feeds the builder itself
+  bool finished_;
+};
+
+}  // namespace
+
 TableBuilder* NewTableBuilder(
     const ImmutableCFOptions& ioptions,
     const InternalKeyComparator& internal_comparator,
@@ -119,11 +324,21 @@ Status BuildTable(
                               kMaxSequenceNumber, &snapshots,
                               earliest_write_conflict_snapshot,
                               true /* internal key corruption is not ok */);
+    std::unique_ptr<PipelinedTableBuilder> pipeline;
+    if (ioptions.enable_pipelined_flush) {
+      // flushes usually run in the HIGH pool, leaving the LOW one to the
+      // compactions and to the pipeline
+      pipeline.reset(new PipelinedTableBuilder(builder, env, Env::LOW));
+    }
     c_iter.SeekToFirst();
     for (; c_iter.Valid(); c_iter.Next()) {
       const Slice& key = c_iter.key();
       const Slice& value = c_iter.value();
-      builder->Add(key, value);
+      if (pipeline) {
+        pipeline->Add(key, value);
+      } else {
+        builder->Add(key, value);
+      }
       meta->UpdateBoundaries(key, c_iter.ikey().sequence);
 
       // TODO(noetzli): Update stats after flush, too.
@@ -134,6 +349,10 @@ Status BuildTable(
       }
     }
 
+    if (pipeline) {
+      pipeline->Finish();
+    }
+
     // Finish and check for builder errors
     bool empty = builder->NumEntries() == 0;
     s = c_iter.status();
@@ -164,6 +164,12 @@ ColumnFamilyOptions SanitizeOptions(const DBOptions& db_options,
   if (result.max_write_buffer_number_to_maintain < 0) {
     result.max_write_buffer_number_to_maintain = result.max_write_buffer_number;
   }
+  // bloom filter size shouldn't exceed 1/4 of memtable size.
+  if (result.memtable_prefix_bloom_size_ratio > 0.25) {
+    result.memtable_prefix_bloom_size_ratio = 0.25;
+  } else if (result.memtable_prefix_bloom_size_ratio < 0) {
+    result.memtable_prefix_bloom_size_ratio = 0;
+  }
 
   if (result.compaction_style == kCompactionStyleFIFO) {
     result.num_levels = 1;
@@ -178,6 +184,16 @@ ColumnFamilyOptions SanitizeOptions(const DBOptions& db_options,
     result.level0_file_num_compaction_trigger = 1;
   }
 
+  if (result.soft_pending_compaction_bytes_limit == 0) {
+    result.soft_pending_compaction_bytes_limit =
+        result.hard_pending_compaction_bytes_limit;
+  } else if (result.hard_pending_compaction_bytes_limit > 0 &&
+             result.hard_pending_compaction_bytes_limit <
+                 result.soft_pending_compaction_bytes_limit) {
+    result.soft_pending_compaction_bytes_limit =
+        result.hard_pending_compaction_bytes_limit;
+  }
+
   return result;
 }
 
@@ -264,6 +280,10 @@ ColumnFamilyData::ColumnFamilyData(
       imm_(options_.min_write_buffer_number_to_merge,
            options_.max_write_buffer_number_to_maintain),
       super_version_(nullptr),
+      retired_mem_data_size_(0),
+      last_sampled_data_size_(0),
+      write_rate_(0),
+      write_buffer_budget_(0),
       super_version_number_(0),
       local_sv_(new ThreadLocalPtr(&SuperVersionUnrefHandle)),
       next_(nullptr),
@@ -281,7 +301,10 @@ ColumnFamilyData::ColumnFamilyData(
   if (_dummy_versions != nullptr) {
     internal_stats_.reset(
         new InternalStats(ioptions_.num_levels, db_options->env, this));
-    table_cache_.reset(new TableCache(ioptions_, env_options, _table_cache));
+    table_cache_.reset(
+        new TableCache(ioptions_, env_options, _table_cache,
+                       column_family_set->get_range_query_table_cache(),
+                       internal_stats_->read_amp_stats()));
     if (ioptions_.compaction_style == kCompactionStyleLevel) {
       compaction_picker_.reset(
           new LevelCompactionPicker(ioptions_, &internal_comparator_));
@@ -384,10 +407,34 @@ void ColumnFamilyData::SetDropped() {
   column_family_set_->RemoveColumnFamily(this);
 }
 
+namespace {
+const uint64_t kMinWriteRate = 16 * 1024u;  // Minimum write rate 16KB/s.
+
+// Scale the delayed write rate down linearly as the pending compaction bytes
+// move from the soft limit towards the hard limit, so writers feel a gradually
+// increasing back-pressure instead of hitting a hard stop.
+uint64_t SetupDelay(uint64_t max_write_rate, uint64_t compaction_needed_bytes,
+                    uint64_t soft_limit, uint64_t hard_limit) {
+  if (hard_limit <= soft_limit || compaction_needed_bytes <= soft_limit) {
+    return max_write_rate;
+  }
+  if (compaction_needed_bytes >= hard_limit) {
+    return kMinWriteRate;
+  }
+  double ratio = static_cast<double>(hard_limit - compaction_needed_bytes) /
+                 static_cast<double>(hard_limit - soft_limit);
+  uint64_t write_rate = static_cast<uint64_t>(max_write_rate * ratio);
+  return std::max(write_rate, kMinWriteRate);
+}
+}  // namespace
+
 void ColumnFamilyData::RecalculateWriteStallConditions(
       const MutableCFOptions& mutable_cf_options) {
   if (current_ != nullptr) {
+    auto* vstorage = current_->storage_info();
     auto write_controller = column_family_set_->write_controller_;
+    uint64_t compaction_needed_bytes =
+        vstorage->estimated_compaction_needed_bytes();
 
     if (imm()->NumNotFlushed() >= mutable_cf_options.max_write_buffer_number) {
       write_controller_token_ = write_controller->GetStopToken();
@@ -397,6 +444,45 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
           "(waiting for flush), max_write_buffer_number is set to %d",
           name_.c_str(), imm()->NumNotFlushed(),
           mutable_cf_options.max_write_buffer_number);
+    } else if (!mutable_cf_options.disable_auto_compactions &&
+               mutable_cf_options.hard_pending_compaction_bytes_limit > 0 &&
+               compaction_needed_bytes >=
+                   mutable_cf_options.hard_pending_compaction_bytes_limit) {
+      write_controller_token_ = write_controller->GetStopToken();
+      internal_stats_->AddCFStats(
+          InternalStats::HARD_PENDING_COMPACTION_BYTES_LIMIT, 1);
+      Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
+          "[%s] Stopping writes because of estimated pending compaction "
+          "bytes %" PRIu64,
+          name_.c_str(), compaction_needed_bytes);
+    } else if (mutable_cf_options.max_write_buffer_number > 3 &&
+               imm()->NumNotFlushed() >=
+                   mutable_cf_options.max_write_buffer_number - 1) {
+      write_controller_token_ =
+          write_controller->GetDelayToken(ioptions_.delayed_write_rate);
+      internal_stats_->AddCFStats(InternalStats::MEMTABLE_SLOWDOWN, 1);
+      Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
+          "[%s] Stalling writes because we have %d immutable memtables "
+          "(waiting for flush), max_write_buffer_number is set to %d "
+          "rate %" PRIu64,
+          name_.c_str(), imm()->NumNotFlushed(),
+          mutable_cf_options.max_write_buffer_number,
+          write_controller->delayed_write_rate());
+    } else if (!mutable_cf_options.disable_auto_compactions &&
+               mutable_cf_options.soft_pending_compaction_bytes_limit > 0 &&
+               compaction_needed_bytes >=
+                   mutable_cf_options.soft_pending_compaction_bytes_limit) {
+      write_controller_token_ = write_controller->GetDelayToken(SetupDelay(
+          ioptions_.delayed_write_rate, compaction_needed_bytes,
+          mutable_cf_options.soft_pending_compaction_bytes_limit,
+          mutable_cf_options.hard_pending_compaction_bytes_limit));
+      internal_stats_->AddCFStats(
+          InternalStats::SOFT_PENDING_COMPACTION_BYTES_LIMIT, 1);
+      Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
+          "[%s] Stalling writes because of estimated pending compaction "
+          "bytes %" PRIu64 " rate %" PRIu64,
+          name_.c_str(), compaction_needed_bytes,
+          write_controller->delayed_write_rate());
     } else {
       // Increase compaction threads.
       write_controller_token_ = write_controller->GetCompactionPressureToken();
@@ -420,13 +506,47 @@ uint64_t ColumnFamilyData::GetTotalSstFilesSize() const {
   return VersionSet::GetTotalSstFilesSize(dummy_versions_);
 }
 
+void ColumnFamilyData::SetMemtable(MemTable* new_mem) {
+  if (mem_ != nullptr) {
+    retired_mem_data_size_ += mem_->data_size();
+  }
+  mem_ = new_mem;
+}
+
 MemTable* ColumnFamilyData::ConstructNewMemtable(
     const MutableCFOptions& mutable_cf_options, SequenceNumber earliest_seq) {
   assert(current_ != nullptr);
-  return new MemTable(internal_comparator_, ioptions_, mutable_cf_options,
+  size_t budget = write_buffer_budget();
+  if (budget == 0 || budget >= mutable_cf_options.write_buffer_size) {
+    return new MemTable(internal_comparator_, ioptions_, mutable_cf_options,
+                        write_buffer_, earliest_seq);
+  }
+  // keep the arena blocks in proportion to the smaller memtable, the same
+  // way SanitizeOptions derives the default arena_block_size
+  MutableCFOptions budgeted_options = mutable_cf_options;
+  budgeted_options.write_buffer_size = budget;
+  budgeted_options.arena_block_size =
+      std::min(mutable_cf_options.arena_block_size, budget / 8);
+  return new MemTable(internal_comparator_, ioptions_, budgeted_options,
                       write_buffer_, earliest_seq);
 }
 
+double ColumnFamilyData::UpdateWriteRate(uint64_t elapsed_micros) {
+  uint64_t data_size = retired_mem_data_size_;
+  if (mem_ != nullptr) {
+    data_size += mem_->data_size();
+  }
+  if (elapsed_micros > 0) {
+    double rate = static_cast<double>(data_size - last_sampled_data_size_) *
+                  1000000.0 / elapsed_micros;
+    // smooth over a few periods so that a short burst does not evict the
+    // memtables of the other column families
+    write_rate_ = write_rate_ * 0.5 + rate * 0.5;
+  }
+  last_sampled_data_size_ = data_size;
+  return write_rate_;
+}
+
 void ColumnFamilyData::CreateNewMemtable(
     const MutableCFOptions& mutable_cf_options, SequenceNumber earliest_seq) {
   if (mem_ != nullptr) {
@@ -604,7 +724,8 @@ ColumnFamilySet::ColumnFamilySet(const std::string& dbname,
                                  const EnvOptions& env_options,
                                  Cache* table_cache,
                                  WriteBuffer* write_buffer,
-                                 WriteController* write_controller)
+                                 WriteController* write_controller,
+                                 Cache* range_query_table_cache)
     : max_column_family_(0),
       dummy_cfd_(new ColumnFamilyData(0, "", nullptr, nullptr, nullptr,
                                       ColumnFamilyOptions(), db_options,
@@ -614,6 +735,7 @@ ColumnFamilySet::ColumnFamilySet(const std::string& dbname,
       db_options_(db_options),
       env_options_(env_options),
       table_cache_(table_cache),
+      range_query_table_cache_(range_query_table_cache),
       write_buffer_(write_buffer),
       write_controller_(write_controller) {
   // initialize linked list
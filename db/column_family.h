@@ -233,11 +233,26 @@ class ColumnFamilyData {
   void SetCurrent(Version* _current);
   uint64_t GetNumLiveVersions() const;  // REQUIRE: DB mutex held
   uint64_t GetTotalSstFilesSize() const;  // REQUIRE: DB mutex held
-  void SetMemtable(MemTable* new_mem) { mem_ = new_mem; }
+  void SetMemtable(MemTable* new_mem);
 
   // See Memtable constructor for explanation of earliest_seq param.
+  // If a write buffer budget is set, it replaces the write_buffer_size of
+  // mutable_cf_options when it is smaller.
   MemTable* ConstructNewMemtable(const MutableCFOptions& mutable_cf_options,
                                  SequenceNumber earliest_seq);
+
+  // Used by DBOptions::adaptive_write_buffer_sizing. Both are only called
+  // from the write thread with the DB mutex held.
+  // Samples the bytes written since the last call and returns the smoothed
+  // write rate in bytes per second.
+  double UpdateWriteRate(uint64_t elapsed_micros);
+  // Size of the next memtable, 0 means mutable_cf_options.write_buffer_size
+  void SetWriteBufferBudget(size_t budget) {
+    write_buffer_budget_.store(budget, std::memory_order_relaxed);
+  }
+  size_t write_buffer_budget() const {
+    return write_buffer_budget_.load(std::memory_order_relaxed);
+  }
   void CreateNewMemtable(const MutableCFOptions& mutable_cf_options,
                          SequenceNumber earliest_seq);
 
@@ -354,6 +369,14 @@ class ColumnFamilyData {
   MemTableList imm_;
   SuperVersion* super_version_;
 
+  // Adaptive write buffer sizing: bytes written into memtables that are no
+  // longer mutable, the total at the last UpdateWriteRate() and the smoothed
+  // write rate
+  uint64_t retired_mem_data_size_;
+  uint64_t last_sampled_data_size_;
+  double write_rate_;
+  std::atomic<size_t> write_buffer_budget_;
+
   // An ordinal representing the current SuperVersion. Updated by
   // InstallSuperVersion(), i.e. incremented every time super_version_
   // changes.
@@ -436,7 +459,8 @@ class ColumnFamilySet {
 
   ColumnFamilySet(const std::string& dbname, const DBOptions* db_options,
                   const EnvOptions& env_options, Cache* table_cache,
-                  WriteBuffer* write_buffer, WriteController* write_controller);
+                  WriteBuffer* write_buffer, WriteController* write_controller,
+                  Cache* range_query_table_cache = nullptr);
   ~ColumnFamilySet();
 
   ColumnFamilyData* GetDefault() const;
@@ -465,6 +489,8 @@ class ColumnFamilySet {
 
   Cache* get_table_cache() { return table_cache_; }
 
+  Cache* get_range_query_table_cache() { return range_query_table_cache_; }
+
  private:
   friend class ColumnFamilyData;
   // helper function that gets called from cfd destructor
@@ -493,6 +519,7 @@ class ColumnFamilySet {
   const DBOptions* const db_options_;
   const EnvOptions env_options_;
   Cache* table_cache_;
+  Cache* range_query_table_cache_;
   WriteBuffer* write_buffer_;
   WriteController* write_controller_;
 };
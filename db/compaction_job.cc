@@ -953,8 +953,8 @@ Status CompactionJob::FinishCompactionOutputFile(
         ReadOptions(), env_options_, cfd->internal_comparator(), meta->fd,
         nullptr, cfd->internal_stats()->GetFileReadHist(
                      compact_->compaction->output_level()),
-
-                     false);
+        false /* for_compaction */, nullptr /* arena */,
+        compact_->compaction->output_level());
     s = iter->status();
 
     if (s.ok() && paranoid_file_checks_) {
@@ -54,6 +54,7 @@
 #include "db/job_context.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
+#include "db/operation_tracer.h"
 #include "db/table_cache.h"
 #include "db/table_properties_collector.h"
 #include "db/transaction_log_impl.h"
@@ -184,10 +185,25 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
     result.db_paths.emplace_back(dbname, std::numeric_limits<uint64_t>::max());
   }
 
+  if (result.use_direct_io_for_flush_and_compaction &&
+      result.compaction_readahead_size == 0) {
+    // the inputs are read sequentially, without the page cache
+    result.compaction_readahead_size = 1024 * 1024 * 2;
+  }
+
   if (result.compaction_readahead_size > 0) {
     result.new_table_reader_for_compaction_inputs = true;
   }
 
+  if (result.rate_limiter.get() != nullptr) {
+    if (result.bytes_per_sync == 0) {
+      result.bytes_per_sync = 1024 * 1024;
+    }
+    // Compaction inputs are read through their own table readers, so the
+    // reads can be charged to the rate limiter.
+    result.new_table_reader_for_compaction_inputs = true;
+  }
+
   return result;
 }
 
@@ -240,6 +256,20 @@ static Status ValidateOptions(
         "then os caching (allow_os_buffer) must also be enabled. ");
   }
 
+  if (db_options.allow_mmap_reads && db_options.use_direct_reads) {
+    return Status::NotSupported(
+        "If memory mapped reads (allow_mmap_reads) are enabled "
+        "then direct reads (use_direct_reads) must be disabled. ");
+  }
+
+  if (db_options.allow_mmap_writes &&
+      db_options.use_direct_io_for_flush_and_compaction) {
+    return Status::NotSupported(
+        "If memory mapped writes (allow_mmap_writes) are enabled "
+        "then direct I/O writes (use_direct_io_for_flush_and_compaction) "
+        "must be disabled. ");
+  }
+
   return Status::OK();
 }
 
@@ -292,9 +322,13 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
       total_log_size_(0),
       max_total_in_memory_state_(0),
       is_snapshot_supported_(true),
-      write_buffer_(options.db_write_buffer_size),
+      write_buffer_(options.db_write_buffer_size, options.write_buffer_cache),
+      last_write_buffer_rebalance_micros_(0),
+      writes_since_write_buffer_rebalance_check_(0),
       write_thread_(0, options.write_thread_slow_yield_usec),
       write_controller_(options.delayed_write_rate),
+      last_batch_group_size_(0),
+      write_scratch_(new ThreadLocalPtr(&DeleteWriteScratch)),
       unscheduled_flushes_(0),
       unscheduled_compactions_(0),
       bg_compaction_scheduled_(0),
@@ -309,6 +343,8 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
       next_job_id_(1),
       has_unpersisted_data_(false),
       env_options_(db_options_),
+      env_options_for_compaction_(
+          env_->OptimizeForCompactionTableWrite(env_options_, db_options_)),
 #ifndef VIDARDB_LITE
       wal_manager_(db_options_, env_options_),
 #endif  // VIDARDB_LITE
@@ -325,10 +361,16 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
         4194304 : db_options_.max_open_files - 10;
   table_cache_ =
       NewLRUCache(table_cache_size, db_options_.table_cache_numshardbits);
+  if (db_options_.max_range_query_table_readers > 0) {
+    range_query_table_cache_ =
+        NewLRUCache(db_options_.max_range_query_table_readers,
+                    db_options_.table_cache_numshardbits);
+  }
 
   versions_.reset(new VersionSet(dbname_, &db_options_, env_options_,
                                  table_cache_.get(), &write_buffer_,
-                                 &write_controller_));
+                                 &write_controller_,
+                                 range_query_table_cache_.get()));
   column_family_memtables_.reset(
       new ColumnFamilyMemTablesImpl(versions_->GetColumnFamilySet()));
 
@@ -454,6 +496,9 @@ DBImpl::~DBImpl() {
   // we can guarantee that after versions_.reset(), table cache is empty
   // so the cache can be safely destroyed.
   table_cache_->EraseUnRefEntries();
+  if (range_query_table_cache_) {
+    range_query_table_cache_->EraseUnRefEntries();
+  }
 
   for (auto& txn_entry : recovered_transactions_) {
     delete txn_entry.second;
@@ -975,6 +1020,9 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state) {
     if (type == kTableFile) {
       // evict from cache
       TableCache::Evict(table_cache_.get(), number);
+      if (range_query_table_cache_) {
+        TableCache::Evict(range_query_table_cache_.get(), number);
+      }
       fname = TableFileName(db_options_.db_paths, number, path_id);
     /************************** Shichao **************************/
     } else if (type == kTableSubFile) {
@@ -1555,8 +1603,9 @@ Status DBImpl::WriteLevel0TableForRecovery(int job_id, ColumnFamilyData* cfd,
           snapshots_.GetAll(&earliest_write_conflict_snapshot);
 
       s = BuildTable(
-          dbname_, env_, *cfd->ioptions(), mutable_cf_options, env_options_,
-          cfd->table_cache(), iter.get(), &meta, cfd->internal_comparator(),
+          dbname_, env_, *cfd->ioptions(), mutable_cf_options,
+          env_options_for_compaction_, cfd->table_cache(), iter.get(), &meta,
+          cfd->internal_comparator(),
           cfd->int_tbl_prop_collector_factories(), cfd->GetID(), cfd->GetName(),
           snapshot_seqs, earliest_write_conflict_snapshot,
           GetCompressionFlush(*cfd->ioptions(), mutable_cf_options),
@@ -1607,9 +1656,9 @@ Status DBImpl::FlushMemTableToOutputFile(
       snapshots_.GetAll(&earliest_write_conflict_snapshot);
 
   FlushJob flush_job(
-      dbname_, cfd, db_options_, mutable_cf_options, env_options_,
-      versions_.get(), &mutex_, &shutting_down_, snapshot_seqs,
-      earliest_write_conflict_snapshot, job_context, log_buffer,
+      dbname_, cfd, db_options_, mutable_cf_options,
+      env_options_for_compaction_, versions_.get(), &mutex_, &shutting_down_,
+      snapshot_seqs, earliest_write_conflict_snapshot, job_context, log_buffer,
       directories_.GetDbDir(), directories_.GetDataDir(0U),
       GetCompressionFlush(*cfd->ioptions(), mutable_cf_options), stats_,
       &event_logger_, mutable_cf_options.report_bg_io_stats);
@@ -1921,8 +1970,8 @@ Status DBImpl::CompactFilesImpl(
 
   assert(is_snapshot_supported_ || snapshots_.empty());
   CompactionJob compaction_job(
-      job_context->job_id, c.get(), db_options_, env_options_, versions_.get(),
-      &shutting_down_, log_buffer, directories_.GetDbDir(),
+      job_context->job_id, c.get(), db_options_, env_options_for_compaction_,
+      versions_.get(), &shutting_down_, log_buffer, directories_.GetDbDir(),
       directories_.GetDataDir(c->output_path_id()), stats_, &mutex_, &bg_error_,
       snapshot_seqs, earliest_write_conflict_snapshot, table_cache_,
       &event_logger_, c->mutable_cf_options()->paranoid_file_checks,
@@ -3179,7 +3228,7 @@ Status DBImpl::BackgroundCompaction(bool* made_progress,
 
     assert(is_snapshot_supported_ || snapshots_.empty());
     CompactionJob compaction_job(
-        job_context->job_id, c.get(), db_options_, env_options_,
+        job_context->job_id, c.get(), db_options_, env_options_for_compaction_,
         versions_.get(), &shutting_down_, log_buffer, directories_.GetDbDir(),
         directories_.GetDataDir(c->output_path_id()), stats_, &mutex_,
         &bg_error_, snapshot_seqs, earliest_write_conflict_snapshot,
@@ -3467,6 +3516,8 @@ SuperVersion* DBImpl::InstallSuperVersionAndScheduleWork(
 Status DBImpl::GetImpl(ReadOptions& read_options,
                        ColumnFamilyHandle* column_family, const Slice& key,
                        std::string* value, bool* value_found) {
+  OperationTracer tracer(env_, db_options_, OperationTracer::kGet,
+                         column_family);
   StopWatch sw(env_, stats_, DB_GET);
   PERF_TIMER_GUARD(get_snapshot_time);
 
@@ -3549,16 +3600,11 @@ Iterator* DBImpl::NewFileIterator(const ReadOptions& read_options) {
   // Collect all needed child iterators for immutable memtables
   sv->imm->AddIterators(read_options, iters, nullptr);
 
-  // Try not to pollute the os cache with 3 methods with pros and cons listed:
-  // O_DIRECT: no impact to other threads but poor performance
-  // FADV_DONTNEED: good performance but impact OS working set
-  // FADV_NOREUSE: noop in linux
-  // Currently, default is to use os cache, but not db cache.
-  EnvOptions env_options(env_options_);
-  //  env_options.use_direct_reads = true;
-//  env_options.use_os_buffer = false;  // consider increase db cache
+  // The files are read through the os cache unless use_direct_reads is set,
+  // in which case ReadOptions::readahead_size keeps the O_DIRECT reads large
+  // and aligned. Either way, the blocks don't go into the db cache.
   // Collect iterators for files in L0 - Ln
-  Status s = sv->current->AddIterators(read_options, env_options, iters);
+  Status s = sv->current->AddIterators(read_options, env_options_, iters);
   if (!s.ok()) {
     // possible with "too many open files"
     delete file_iter;
@@ -3983,7 +4029,8 @@ Iterator* DBImpl::NewIterator(const ReadOptions& read_options,
     auto iter = new ForwardIterator(this, read_options, cfd, sv);
     return NewDBIterator(env_, *cfd->ioptions(), cfd->user_comparator(), iter,
                          kMaxSequenceNumber, sv->version_number,
-                         read_options.pin_data);
+                         read_options.pin_data,
+                         read_options.prefix_same_as_start);
 #endif
   } else {
     SequenceNumber latest_snapshot = versions_->LastSequence();
@@ -4038,7 +4085,8 @@ Iterator* DBImpl::NewIterator(const ReadOptions& read_options,
     // that they are likely to be in the same cache line and/or page.
     ArenaWrappedDBIter* db_iter = NewArenaWrappedDbIterator(
         env_, *cfd->ioptions(), cfd->user_comparator(), snapshot,
-        sv->version_number, read_options.pin_data);
+        sv->version_number, read_options.pin_data,
+        read_options.prefix_same_as_start);
 
     InternalIterator* internal_iter =
         NewInternalIterator(read_options, cfd, sv, db_iter->GetArena());
@@ -4083,14 +4131,81 @@ void DBImpl::ReleaseSnapshot(const Snapshot* s) {
 }
 
 // Convenience methods
+// The batch a thread serializes its Put/Delete into, and the writer list it
+// fills while leading a batch group. Both keep their capacity between writes.
+struct DBImpl::WriteScratch {
+  // Initial reservation of the pooled batch, enough for typical small
+  // key/value pairs.
+  static const size_t kReservedBytes = 4096;
+  // A batch grown beyond this by one huge write is dropped instead of being
+  // kept alive for the lifetime of the thread.
+  static const size_t kMaxPooledBytes = 1 << 20;
+
+  WriteScratch() : batch(kReservedBytes), batch_in_use(false) {}
+
+  // Empty the batch for the next write of the thread, and release it.
+  void ReleaseBatch() {
+    if (batch.GetDataSize() > kMaxPooledBytes) {
+      batch = WriteBatch(kReservedBytes);
+    } else {
+      batch.Clear();
+    }
+    batch_in_use = false;
+  }
+
+  WriteBatch batch;
+  bool batch_in_use;
+  std::vector<WriteThread::Writer*> write_group;
+};
+
+void DBImpl::DeleteWriteScratch(void* ptr) {
+  TEST_SYNC_POINT_CALLBACK("DBImpl::DeleteWriteScratch", ptr);
+  delete static_cast<WriteScratch*>(ptr);
+}
+
+DBImpl::WriteScratch* DBImpl::GetWriteScratch() {
+  auto* scratch = static_cast<WriteScratch*>(write_scratch_->Get());
+  if (scratch == nullptr) {
+    scratch = new WriteScratch();
+    write_scratch_->Reset(scratch);
+  }
+  return scratch;
+}
+
+#ifndef NDEBUG
+const WriteBatch* DBImpl::TEST_GetPooledWriteBatch() {
+  return &GetWriteScratch()->batch;
+}
+
+void DBImpl::TEST_SetPooledWriteBatchInUse(bool in_use) {
+  GetWriteScratch()->batch_in_use = in_use;
+}
+#endif  // NDEBUG
+
 Status DBImpl::Put(const WriteOptions& o, ColumnFamilyHandle* column_family,
                    const Slice& key, const Slice& val) {
-  return DB::Put(o, column_family, key, val);
+  WriteScratch* scratch = GetWriteScratch();
+  if (scratch->batch_in_use) {
+    return DB::Put(o, column_family, key, val);
+  }
+  scratch->batch_in_use = true;
+  scratch->batch.Put(column_family, key, val);
+  Status s = WriteImpl(o, &scratch->batch, nullptr, nullptr);
+  scratch->ReleaseBatch();
+  return s;
 }
 
 Status DBImpl::Delete(const WriteOptions& write_options,
                       ColumnFamilyHandle* column_family, const Slice& key) {
-  return DB::Delete(write_options, column_family, key);
+  WriteScratch* scratch = GetWriteScratch();
+  if (scratch->batch_in_use) {
+    return DB::Delete(write_options, column_family, key);
+  }
+  scratch->batch_in_use = true;
+  scratch->batch.Delete(column_family, key);
+  Status s = WriteImpl(write_options, &scratch->batch, nullptr, nullptr);
+  scratch->ReleaseBatch();
+  return s;
 }
 
 Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
@@ -4107,6 +4222,7 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
 
   Status status;
 
+  OperationTracer tracer(env_, db_options_, OperationTracer::kWrite, nullptr);
   PERF_TIMER_GUARD(write_pre_and_post_process_time);
   WriteThread::Writer w;
   w.batch = my_batch;
@@ -4122,7 +4238,9 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
 
   StopWatch write_sw(env_, db_options_.statistics.get(), DB_WRITE);
 
+  uint64_t join_start = tracer.StartSpan();
   write_thread_.JoinBatchGroup(&w);
+  tracer.EndSpan("write thread", join_start);
   if (w.state == WriteThread::STATE_PARALLEL_FOLLOWER) {
     // we are a non-leader in a parallel group
     PERF_TIMER_GUARD(write_memtable_time);
@@ -4183,6 +4301,11 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   assert(!single_column_family_mode_ ||
          versions_->GetColumnFamilySet()->NumberOfColumnFamilies() == 1);
 
+  if (db_options_.adaptive_write_buffer_sizing &&
+      write_buffer_.buffer_size() > 0) {
+    MaybeRebalanceWriteBuffers();
+  }
+
   uint64_t max_total_wal_size = (db_options_.max_total_wal_size == 0)
                                     ? 4 * max_total_in_memory_state_
                                     : db_options_.max_total_wal_size;
@@ -4219,6 +4342,7 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
     // no need to refcount because drop is happening in write thread, so can't
     // happen while we're in the write thread
     ColumnFamilyData* largest_cfd = nullptr;
+    size_t largest_cfd_excess = 0;
     size_t largest_cfd_size = 0;
 
     for (auto cfd : *versions_->GetColumnFamilySet()) {
@@ -4229,8 +4353,20 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
         // We only consider active mem table, hoping immutable memtable is
         // already in the process of flushing.
         size_t cfd_size = cfd->mem()->ApproximateMemoryUsage();
-        if (largest_cfd == nullptr || cfd_size > largest_cfd_size) {
+        // With adaptive sizing, pick the memtable furthest over its budget,
+        // which is usually one of an idle column family, and the largest one
+        // among those equally far, e.g. when all are within their budgets.
+        size_t cfd_excess = 0;
+        size_t budget = cfd->write_buffer_budget();
+        if (db_options_.adaptive_write_buffer_sizing && budget > 0 &&
+            cfd_size > budget) {
+          cfd_excess = cfd_size - budget;
+        }
+        if (largest_cfd == nullptr || cfd_excess > largest_cfd_excess ||
+            (cfd_excess == largest_cfd_excess &&
+             cfd_size > largest_cfd_size)) {
           largest_cfd = cfd;
+          largest_cfd_excess = cfd_excess;
           largest_cfd_size = cfd_size;
         }
       }
@@ -4253,20 +4389,25 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
     status = ScheduleFlushes(&context);
   }
 
-  if (UNLIKELY(status.ok() && write_controller_.IsStopped())) {
+  if (UNLIKELY(status.ok() && (write_controller_.IsStopped() ||
+                                write_controller_.NeedsDelay()))) {
     PERF_TIMER_STOP(write_pre_and_post_process_time);
     PERF_TIMER_GUARD(write_delay_time);
     // We don't know size of current batch so that we always use the size
     // for previous one. It might create a fairness issue that expiration
     // might happen for smaller writes but larger writes can go through.
     // Can optimize it if it is an issue.
-    status = DelayWrite();
+    status = DelayWrite(last_batch_group_size_);
     PERF_TIMER_START(write_pre_and_post_process_time);
   }
 
   uint64_t last_sequence = versions_->LastSequence();
   WriteThread::Writer* last_writer = &w;
-  std::vector<WriteThread::Writer*> write_group;
+  // Reuse this thread's writer list; only the group leader touches it and it
+  // is not read once the leader has exited the group.
+  std::vector<WriteThread::Writer*>& write_group =
+      GetWriteScratch()->write_group;
+  write_group.clear();
   bool need_log_sync = !write_options.disableWAL && write_options.sync;
   bool need_log_dir_sync = need_log_sync && !log_dir_synced_;
 
@@ -4292,7 +4433,8 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   // At this point the mutex is unlocked
 
   bool exit_completed_early = false;
-  write_thread_.EnterAsBatchGroupLeader(&w, &last_writer, &write_group);
+  last_batch_group_size_ =
+      write_thread_.EnterAsBatchGroupLeader(&w, &last_writer, &write_group);
 
   if (status.ok()) {
     // Rules for when we can update the memtable concurrently
@@ -4511,11 +4653,80 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
 
 // REQUIRES: mutex_ is held
 // REQUIRES: this thread is currently at the front of the writer queue
-Status DBImpl::DelayWrite() {
+void DBImpl::MaybeRebalanceWriteBuffers() {
+  mutex_.AssertHeld();
+  // Only look at the clock every kRebalanceCheckWrites batch groups.
+  const uint64_t kRebalanceCheckWrites = 256;
+  if (++writes_since_write_buffer_rebalance_check_ < kRebalanceCheckWrites &&
+      last_write_buffer_rebalance_micros_ != 0) {
+    return;
+  }
+  writes_since_write_buffer_rebalance_check_ = 0;
+  const uint64_t kRebalancePeriodMicros = 1000000;
+  uint64_t now = env_->NowMicros();
+  if (now < last_write_buffer_rebalance_micros_ + kRebalancePeriodMicros) {
+    return;
+  }
+  uint64_t elapsed = now - last_write_buffer_rebalance_micros_;
+  bool first = last_write_buffer_rebalance_micros_ == 0;
+  last_write_buffer_rebalance_micros_ = now;
+
+  // no need to refcount because drop is happening in write thread, so can't
+  // happen while we're in the write thread
+  std::vector<std::pair<ColumnFamilyData*, double>> rates;
+  double total_rate = 0;
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (cfd->IsDropped()) {
+      continue;
+    }
+    double rate = cfd->UpdateWriteRate(first ? 0 : elapsed);
+    rates.emplace_back(cfd, rate);
+    total_rate += rate;
+  }
+  if (first || rates.empty()) {
+    return;
+  }
+
+  const size_t budget = write_buffer_.buffer_size();
+  const size_t min_budget = budget / (4 * rates.size());
+  for (auto& cfd_rate : rates) {
+    ColumnFamilyData* cfd = cfd_rate.first;
+    double share = total_rate > 0 ? cfd_rate.second / total_rate
+                                  : 1.0 / rates.size();
+    size_t cf_budget = static_cast<size_t>(budget * share);
+    cf_budget = std::max(cf_budget, min_budget);
+    cf_budget = std::min(cf_budget,
+                         cfd->GetLatestMutableCFOptions()->write_buffer_size);
+    cfd->SetWriteBufferBudget(cf_budget);
+  }
+}
+
+// REQUIRES: mutex_ is held
+// REQUIRES: this thread is currently at the front of the writer queue
+Status DBImpl::DelayWrite(uint64_t num_bytes) {
   uint64_t time_delayed = 0;
   bool delayed = false;
   {
     StopWatch sw(env_, stats_, WRITE_STALL, &time_delayed);
+    auto delay = write_controller_.GetDelay(env_, num_bytes);
+    if (delay > 0) {
+      mutex_.Unlock();
+      delayed = true;
+      TEST_SYNC_POINT("DBImpl::DelayWrite:Sleep");
+      // hopefully we don't have to sleep more than 2 billion microseconds
+      const uint64_t kDelayInterval = 1000;
+      uint64_t stall_end = sw.start_time() + delay;
+      while (write_controller_.NeedsDelay()) {
+        if (env_->NowMicros() >= stall_end) {
+          // We already delayed this write `delay` microseconds
+          break;
+        }
+        // Sleep for 0.001 seconds
+        env_->SleepForMicroseconds(static_cast<int>(kDelayInterval));
+      }
+      mutex_.Lock();
+    }
+
     while (bg_error_.ok() && write_controller_.IsStopped()) {
       delayed = true;
       TEST_SYNC_POINT("DBImpl::DelayWrite:Wait");
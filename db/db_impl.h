@@ -329,6 +329,13 @@ class DBImpl : public DB {
   uint64_t TEST_FindMinLogContainingOutstandingPrep();
   uint64_t TEST_FindMinPrepLogReferencedByMemTable();
 
+  // The pooled batch Put and Delete of the calling thread serialize into.
+  const WriteBatch* TEST_GetPooledWriteBatch();
+
+  // Mark the pooled batch of the calling thread as taken, as while a write
+  // of the thread is in progress.
+  void TEST_SetPooledWriteBatchInUse(bool in_use);
+
 #endif  // NDEBUG
 
   // Return maximum background compaction allowed to be scheduled based on
@@ -581,7 +588,15 @@ class DBImpl : public DB {
   Status WriteLevel0TableForRecovery(int job_id, ColumnFamilyData* cfd,
                                      MemTable* mem, VersionEdit* edit);
 
-  Status DelayWrite();
+  // num_bytes: for slowdown case, delay time is calculated based on
+  //            `num_bytes` going through.
+  Status DelayWrite(uint64_t num_bytes);
+
+  // Shares db_write_buffer_size among the column families according to
+  // their write rates, see DBOptions::adaptive_write_buffer_sizing. Does
+  // nothing if the last rebalance is less than a second ago.
+  // REQUIRES: mutex locked and in the write thread
+  void MaybeRebalanceWriteBuffers();
 
   Status ScheduleFlushes(WriteContext* context);
 
@@ -648,6 +663,10 @@ class DBImpl : public DB {
   // table_cache_ provides its own synchronization
   std::shared_ptr<Cache> table_cache_;
 
+  // The table readers of the range queries, nullptr if they share the ones
+  // of table_cache_
+  std::shared_ptr<Cache> range_query_table_cache_;
+
   // Lock over the persistent DB state.  Non-nullptr iff successfully acquired.
   FileLock* db_lock_;
 
@@ -761,12 +780,28 @@ class DBImpl : public DB {
 
   WriteBuffer write_buffer_;
 
+  // Time of the last MaybeRebalanceWriteBuffers() that did any work
+  uint64_t last_write_buffer_rebalance_micros_;
+  // Batch groups led since MaybeRebalanceWriteBuffers() last read the clock
+  uint64_t writes_since_write_buffer_rebalance_check_;
+
   WriteThread write_thread_;
 
   WriteBatch tmp_batch_;
 
   WriteController write_controller_;
 
+  // Size of the last batch group. In slowdown mode, next write needs to
+  // sleep if it uses up the quota.
+  uint64_t last_batch_group_size_;
+
+  // Per-thread buffers reused by the write path, so that a single-key Put or
+  // Delete does not touch the heap once the calling thread is warmed up.
+  struct WriteScratch;
+  std::unique_ptr<ThreadLocalPtr> write_scratch_;
+  WriteScratch* GetWriteScratch();
+  static void DeleteWriteScratch(void* ptr);
+
   FlushScheduler flush_scheduler_;
 
   SnapshotList snapshots_;
@@ -882,6 +917,9 @@ class DBImpl : public DB {
   // The options to access storage files
   const EnvOptions env_options_;
 
+  // The options to write the table files of flushes and compactions
+  const EnvOptions env_options_for_compaction_;
+
 #ifndef VIDARDB_LITE
   WalManager wal_manager_;
 #endif  // VIDARDB_LITE
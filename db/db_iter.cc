@@ -20,6 +20,7 @@
 #include "vidardb/env.h"
 #include "vidardb/iterator.h"
 #include "vidardb/options.h"
+#include "vidardb/slice_transform.h"
 #include "table/internal_iterator.h"
 #include "util/arena.h"
 #include "util/logging.h"
@@ -100,11 +101,13 @@ class DBIter: public Iterator {
 
   DBIter(Env* env, const ImmutableCFOptions& ioptions, const Comparator* cmp,
          InternalIterator* iter, SequenceNumber s, bool arena_mode,
-         uint64_t version_number, bool pin_data = false)
+         uint64_t version_number, bool pin_data = false,
+         bool prefix_same_as_start = false)
       : arena_mode_(arena_mode),
         env_(env),
         logger_(ioptions.info_log),
         user_comparator_(cmp),
+        prefix_extractor_(ioptions.prefix_extractor),
         iter_(iter),
         sequence_(s),
         direction_(kForward),
@@ -112,7 +115,10 @@ class DBIter: public Iterator {
         current_entry_is_merged_(false),
         statistics_(ioptions.statistics),
         version_number_(version_number),
-        pin_thru_lifetime_(pin_data) {
+        pin_thru_lifetime_(pin_data),
+        prefix_same_as_start_(prefix_same_as_start &&
+                              prefix_extractor_ != nullptr),
+        check_prefix_(false) {
     RecordTick(statistics_, NO_ITERATORS);
     if (pin_thru_lifetime_) {
       pinned_iters_mgr_.StartPinning();
@@ -195,10 +201,16 @@ class DBIter: public Iterator {
   bool FindValueForCurrentKey();
   void FindPrevUserKey();
   void FindNextUserKey();
-  inline void FindNextUserEntry(bool skipping);
-  void FindNextUserEntryInternal(bool skipping);
+  inline void FindNextUserEntry(bool skipping, bool prefix_check);
+  void FindNextUserEntryInternal(bool skipping, bool prefix_check);
   bool ParseKey(ParsedInternalKey* key);
 
+  // Returns true if user_key has the prefix of the last Seek() target.
+  bool PrefixMatchesStart(const Slice& user_key) const {
+    return prefix_extractor_->InDomain(user_key) &&
+           prefix_extractor_->Transform(user_key) == Slice(prefix_start_key_);
+  }
+
   // Temporarily pin the blocks that we encounter until ReleaseTempPinnedData()
   // is called
   void TempPinData() {
@@ -227,6 +239,7 @@ class DBIter: public Iterator {
   Env* const env_;
   Logger* logger_;
   const Comparator* const user_comparator_;
+  const SliceTransform* const prefix_extractor_;
   InternalIterator* iter_;
   SequenceNumber const sequence_;
 
@@ -242,6 +255,11 @@ class DBIter: public Iterator {
   // Means that we will pin all data blocks we read as long the Iterator
   // is not deleted, will be true if ReadOptions::pin_data is true
   const bool pin_thru_lifetime_;
+  // If true, the iterator stops at the end of the prefix of the Seek() target
+  const bool prefix_same_as_start_;
+  // Set by Seek() when the target has a prefix to stay in
+  bool check_prefix_;
+  std::string prefix_start_key_;
   // List of operands for merge operator.
   LocalStatistics local_stats_;
   PinnedIteratorsManager pinned_iters_mgr_;
@@ -293,7 +311,7 @@ void DBIter::Next() {
     valid_ = false;
     return;
   }
-  FindNextUserEntry(true /* skipping the current user key */);
+  FindNextUserEntry(true /* skipping the current user key */, check_prefix_);
   if (statistics_ != nullptr && valid_) {
     local_stats_.next_found_count_++;
     local_stats_.bytes_read_ += (key().size() + value().size());
@@ -312,14 +330,14 @@ void DBIter::Next() {
 // The prefix_check parameter controls whether we check the iterated
 // keys against the prefix of the seeked key. Set to false when
 // performing a seek without a key (e.g. SeekToFirst). Set to
-// prefix_same_as_start_ for other iterations.
-inline void DBIter::FindNextUserEntry(bool skipping) {
+// check_prefix_ for other iterations.
+inline void DBIter::FindNextUserEntry(bool skipping, bool prefix_check) {
   PERF_TIMER_GUARD(find_next_user_entry_time);
-  FindNextUserEntryInternal(skipping);
+  FindNextUserEntryInternal(skipping, prefix_check);
 }
 
 // Actual implementation of DBIter::FindNextUserEntry()
-void DBIter::FindNextUserEntryInternal(bool skipping) {
+void DBIter::FindNextUserEntryInternal(bool skipping, bool prefix_check) {
   // Loop until we hit an acceptable entry to yield
   assert(iter_->Valid());
   assert(direction_ == kForward);
@@ -328,6 +346,11 @@ void DBIter::FindNextUserEntryInternal(bool skipping) {
     ParsedInternalKey ikey;
 
     if (ParseKey(&ikey)) {
+      if (prefix_check && !PrefixMatchesStart(ikey.user_key)) {
+        // the keys of the prefix are exhausted
+        break;
+      }
+
       if (ikey.sequence <= sequence_) {
         if (skipping &&
            user_comparator_->Compare(ikey.user_key, saved_key_.GetKey()) <= 0) {
@@ -416,6 +439,11 @@ void DBIter::PrevInternal() {
   while (iter_->Valid()) {
     saved_key_.SetKey(ExtractUserKey(iter_->key()),
                       !iter_->IsKeyPinned() || !pin_thru_lifetime_ /* copy */);
+    if (check_prefix_ && !PrefixMatchesStart(saved_key_.GetKey())) {
+      // the keys of the prefix are exhausted
+      valid_ = false;
+      return;
+    }
     if (FindValueForCurrentKey()) {
       valid_ = true;
       if (!iter_->Valid()) {
@@ -540,6 +568,12 @@ void DBIter::Seek(const Slice& target) {
   // now savved_key is used to store internal key.
   saved_key_.SetInternalKey(target, sequence_);
 
+  check_prefix_ = prefix_same_as_start_ && prefix_extractor_->InDomain(target);
+  if (check_prefix_) {
+    Slice prefix = prefix_extractor_->Transform(target);
+    prefix_start_key_.assign(prefix.data(), prefix.size());
+  }
+
   {
     PERF_TIMER_GUARD(seek_internal_seek_time);
     iter_->Seek(saved_key_.GetKey());
@@ -549,7 +583,7 @@ void DBIter::Seek(const Slice& target) {
   if (iter_->Valid()) {
     direction_ = kForward;
     ClearSavedValue();
-    FindNextUserEntry(false /* not skipping */);
+    FindNextUserEntry(false /* not skipping */, check_prefix_);
     if (statistics_ != nullptr) {
       if (valid_) {
         RecordTick(statistics_, NUMBER_DB_SEEK_FOUND);
@@ -567,6 +601,7 @@ void DBIter::SeekToFirst() {
   direction_ = kForward;
   ReleaseTempPinnedData();
   ClearSavedValue();
+  check_prefix_ = false;
 
   {
     PERF_TIMER_GUARD(seek_internal_seek_time);
@@ -575,7 +610,7 @@ void DBIter::SeekToFirst() {
 
   RecordTick(statistics_, NUMBER_DB_SEEK);
   if (iter_->Valid()) {
-    FindNextUserEntry(false /* not skipping */);
+    FindNextUserEntry(false /* not skipping */, false /* no prefix check */);
     if (statistics_ != nullptr) {
       if (valid_) {
         RecordTick(statistics_, NUMBER_DB_SEEK_FOUND);
@@ -593,6 +628,7 @@ void DBIter::SeekToLast() {
   direction_ = kReverse;
   ReleaseTempPinnedData();
   ClearSavedValue();
+  check_prefix_ = false;
 
   {
     PERF_TIMER_GUARD(seek_internal_seek_time);
@@ -612,10 +648,11 @@ Iterator* NewDBIterator(Env* env, const ImmutableCFOptions& ioptions,
                         const Comparator* user_key_comparator,
                         InternalIterator* internal_iter,
                         const SequenceNumber& sequence, uint64_t version_number,
-                        bool pin_data) {
+                        bool pin_data, bool prefix_same_as_start) {
   DBIter* db_iter =
       new DBIter(env, ioptions, user_key_comparator, internal_iter, sequence,
-                 false, version_number, /*iterate_upper_bound,*/ pin_data);
+                 false, version_number, /*iterate_upper_bound,*/ pin_data,
+                 prefix_same_as_start);
   return db_iter;
 }
 
@@ -650,13 +687,13 @@ void ArenaWrappedDBIter::RegisterCleanup(CleanupFunction function, void* arg1,
 ArenaWrappedDBIter* NewArenaWrappedDbIterator(
     Env* env, const ImmutableCFOptions& ioptions,
     const Comparator* user_key_comparator, const SequenceNumber& sequence,
-    uint64_t version_number, bool pin_data) {
+    uint64_t version_number, bool pin_data, bool prefix_same_as_start) {
   ArenaWrappedDBIter* iter = new ArenaWrappedDBIter();
   Arena* arena = iter->GetArena();
   auto mem = arena->AllocateAligned(sizeof(DBIter));
   DBIter* db_iter =
       new (mem) DBIter(env, ioptions, user_key_comparator, nullptr, sequence,
-                       true, version_number, pin_data);
+                       true, version_number, pin_data, prefix_same_as_start);
 
   iter->SetDBIter(db_iter);
 
@@ -61,6 +61,7 @@ void EventHelpers::LogAndNotifyTableFileCreationFinished(
       jwriter << "data_size" << table_properties.data_size 
               << "raw_data_size" << table_properties.raw_data_size
               << "index_size" << table_properties.index_size
+              << "filter_size" << table_properties.filter_size
               << "raw_key_size" << table_properties.raw_key_size
               << "raw_average_key_size"
               << SafeDivide(table_properties.raw_key_size,
@@ -70,7 +71,8 @@ void EventHelpers::LogAndNotifyTableFileCreationFinished(
               << SafeDivide(table_properties.raw_value_size,
                             table_properties.num_entries)
               << "num_data_blocks" << table_properties.num_data_blocks
-              << "num_entries" << table_properties.num_entries;
+              << "num_entries" << table_properties.num_entries
+              << "filter_policy_name" << table_properties.filter_policy_name;
 
       // user collected properties
       for (const auto& prop : table_properties.readable_properties) {
@@ -108,6 +108,7 @@ static const std::string sstables = "sstables";
 static const std::string cfstats = "cfstats";
 static const std::string dbstats = "dbstats";
 static const std::string levelstats = "levelstats";
+static const std::string read_amp_stats = "read-amp-stats";
 static const std::string num_immutable_mem_table = "num-immutable-mem-table";
 static const std::string num_immutable_mem_table_flushed =
     "num-immutable-mem-table-flushed";
@@ -157,6 +158,8 @@ const std::string DB::Properties::kSSTables = vidardb_prefix + sstables;
 const std::string DB::Properties::kCFStats = vidardb_prefix + cfstats;
 const std::string DB::Properties::kDBStats = vidardb_prefix + dbstats;
 const std::string DB::Properties::kLevelStats = vidardb_prefix + levelstats;
+const std::string DB::Properties::kReadAmpStats =
+                      vidardb_prefix + read_amp_stats;
 const std::string DB::Properties::kNumImmutableMemTable =
                       vidardb_prefix + num_immutable_mem_table;
 const std::string DB::Properties::kNumImmutableMemTableFlushed =
@@ -219,6 +222,8 @@ const std::unordered_map<std::string,
      {false, &InternalStats::HandleCompressionRatioAtLevelPrefix, nullptr}},
     {DB::Properties::kLevelStats,
      {false, &InternalStats::HandleLevelStats, nullptr}},
+    {DB::Properties::kReadAmpStats,
+     {false, &InternalStats::HandleReadAmpStats, nullptr}},
     {DB::Properties::kStats, {false, &InternalStats::HandleStats, nullptr}},
     {DB::Properties::kCFStats, {false, &InternalStats::HandleCFStats, nullptr}},
     {DB::Properties::kDBStats, {false, &InternalStats::HandleDBStats, nullptr}},
@@ -360,6 +365,11 @@ bool InternalStats::HandleLevelStats(std::string* value, Slice suffix) {
   return true;
 }
 
+bool InternalStats::HandleReadAmpStats(std::string* value, Slice suffix) {
+  value->append(read_amp_stats_.ToString());
+  return true;
+}
+
 bool InternalStats::HandleStats(std::string* value, Slice suffix) {
   if (!HandleCFStats(value, suffix)) {
     return false;
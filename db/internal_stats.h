@@ -10,6 +10,7 @@
 
 #pragma once
 #include "db/version_set.h"
+#include "table/read_amp_stats.h"
 
 #include <vector>
 #include <string>
@@ -80,6 +81,7 @@ class InternalStats {
         cf_stats_count_{},
         comp_stats_(num_levels),
         file_read_latency_(num_levels),
+        read_amp_stats_(num_levels),
         bg_error_count_(0),
         number_levels_(num_levels),
         env_(env),
@@ -226,6 +228,8 @@ class InternalStats {
     return &file_read_latency_[level];
   }
 
+  ReadAmpStats* read_amp_stats() { return &read_amp_stats_; }
+
   uint64_t GetBackgroundErrorCount() const { return bg_error_count_; }
 
   uint64_t BumpAndGetBackgroundErrorCount() { return ++bg_error_count_; }
@@ -255,6 +259,8 @@ class InternalStats {
   // Per-ColumnFamily/level compaction stats
   std::vector<CompactionStats> comp_stats_;
   std::vector<HistogramImpl> file_read_latency_;
+  // Data blocks read by the table readers, per level and per column
+  ReadAmpStats read_amp_stats_;
 
   // Used to compute per-interval statistics
   struct CFStatsSnapshot {
@@ -314,6 +320,7 @@ class InternalStats {
   bool HandleNumFilesAtLevel(std::string* value, Slice suffix);
   bool HandleCompressionRatioAtLevelPrefix(std::string* value, Slice suffix);
   bool HandleLevelStats(std::string* value, Slice suffix);
+  bool HandleReadAmpStats(std::string* value, Slice suffix);
   bool HandleStats(std::string* value, Slice suffix);
   bool HandleCFStats(std::string* value, Slice suffix);
   bool HandleDBStats(std::string* value, Slice suffix);
@@ -437,6 +444,8 @@ class InternalStats {
 
   HistogramImpl* GetFileReadHist(int level) { return nullptr; }
 
+  ReadAmpStats* read_amp_stats() { return nullptr; }
+
   uint64_t GetBackgroundErrorCount() const { return 0; }
 
   uint64_t BumpAndGetBackgroundErrorCount() { return 0; }
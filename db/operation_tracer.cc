@@ -0,0 +1,149 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/operation_tracer.h"
+
+#include "util/random.h"
+#include "util/string_util.h"
+#include "vidardb/db.h"
+
+namespace vidardb {
+
+#ifdef VIDARDB_OPERATION_TRACER
+__thread OperationTracer* OperationTracer::current_ = nullptr;
+#endif
+
+OperationTracer::OperationTracer(Env* env, const DBOptions& db_options,
+                                 Operation operation,
+                                 ColumnFamilyHandle* column_family)
+    : env_(env),
+      db_options_(db_options),
+      operation_(operation),
+      sampled_(false),
+      start_nanos_(0),
+      prev_perf_level_(kDisable) {
+#ifdef VIDARDB_OPERATION_TRACER
+  // an operation within a traced one, e.g. from a listener, is not traced
+  if (db_options_.operation_trace_one_in == 0 ||
+      db_options_.listeners.empty() || current_ != nullptr ||
+      !Random::GetTLSInstance()->OneIn(db_options_.operation_trace_one_in)) {
+    return;
+  }
+  sampled_ = true;
+  current_ = this;
+  if (column_family != nullptr) {
+    cf_name_ = column_family->GetName();
+  }
+  prev_perf_level_ = GetPerfLevel();
+  if (prev_perf_level_ < kEnableTime) {
+    SetPerfLevel(kEnableTime);
+  }
+  perf_context_start_ = perf_context;
+  iostats_context_start_ = iostats_context;
+  start_nanos_ = env_->NowNanos();
+#endif
+}
+
+OperationTracer::~OperationTracer() {
+  if (!sampled_) {
+    return;
+  }
+#ifdef VIDARDB_OPERATION_TRACER
+  current_ = nullptr;
+  Report();
+  SetPerfLevel(prev_perf_level_);
+#endif
+}
+
+void OperationTracer::EndSpan(const char* name, uint64_t start) {
+  if (sampled_) {
+    spans_.emplace_back(name, env_->NowNanos() - start);
+  }
+}
+
+bool OperationTracer::Active() {
+#ifdef VIDARDB_OPERATION_TRACER
+  return current_ != nullptr;
+#else
+  return false;
+#endif
+}
+
+void OperationTracer::AddLevelTime(int level, uint64_t nanos) {
+#ifdef VIDARDB_OPERATION_TRACER
+  OperationTracer* tracer = current_;
+  if (tracer != nullptr && level >= 0) {
+    if (tracer->level_nanos_.size() <= static_cast<size_t>(level)) {
+      tracer->level_nanos_.resize(level + 1, 0);
+    }
+    tracer->level_nanos_[level] += nanos;
+  }
+#endif
+}
+
+void OperationTracer::Report() {
+#ifdef VIDARDB_OPERATION_TRACER
+  uint64_t total_nanos = env_->NowNanos() - start_nanos_;
+  if (total_nanos < db_options_.slow_operation_micros * 1000) {
+    return;
+  }
+
+  OperationTraceInfo info;
+  info.operation = operation_ == kGet ? "Get" : "Write";
+  info.cf_name = cf_name_;
+  info.total_nanos = total_nanos;
+  info.block_cache_hit_count = perf_context.block_cache_hit_count -
+                               perf_context_start_.block_cache_hit_count;
+  info.block_read_count =
+      perf_context.block_read_count - perf_context_start_.block_read_count;
+  info.spans = std::move(spans_);
+
+  // the stages of the perf and iostats contexts, in the order of the path
+  auto add_span = [&info](const char* name, uint64_t end, uint64_t start) {
+    if (end > start) {
+      info.spans.emplace_back(name, end - start);
+    }
+  };
+#define ADD_PERF_SPAN(name, metric) \
+  add_span(name, perf_context.metric, perf_context_start_.metric)
+#define ADD_IOSTATS_SPAN(name, metric) \
+  add_span(name, iostats_context.metric, iostats_context_start_.metric)
+  if (operation_ == kGet) {
+    ADD_PERF_SPAN("superversion", get_snapshot_time);
+    ADD_PERF_SPAN("memtable", get_from_memtable_time);
+    for (size_t level = 0; level < level_nanos_.size(); level++) {
+      if (level_nanos_[level] > 0) {
+        info.spans.emplace_back("level " + ToString(level),
+                                level_nanos_[level]);
+      }
+    }
+    ADD_PERF_SPAN("table cache", find_table_nanos);
+    ADD_PERF_SPAN("index block", read_index_block_nanos);
+    ADD_PERF_SPAN("filter block", read_filter_block_nanos);
+    ADD_PERF_SPAN("block seek", block_seek_nanos);
+    ADD_PERF_SPAN("block read", block_read_time);
+    ADD_IOSTATS_SPAN("file read", read_nanos);
+    ADD_PERF_SPAN("block checksum", block_checksum_time);
+    ADD_PERF_SPAN("decompression", block_decompress_time);
+    ADD_PERF_SPAN("post process", get_post_process_time);
+  } else {
+    ADD_PERF_SPAN("delay", write_delay_time);
+    ADD_PERF_SPAN("db mutex", db_mutex_lock_nanos);
+    ADD_PERF_SPAN("WAL", write_wal_time);
+    ADD_IOSTATS_SPAN("file write", write_nanos);
+    ADD_IOSTATS_SPAN("file sync", fsync_nanos);
+    ADD_PERF_SPAN("memtable", write_memtable_time);
+    ADD_PERF_SPAN("pre and post process", write_pre_and_post_process_time);
+  }
+#undef ADD_PERF_SPAN
+#undef ADD_IOSTATS_SPAN
+
+  for (auto listener : db_options_.listeners) {
+    listener->OnSlowOperation(info);
+  }
+#endif
+}
+
+}  // namespace vidardb
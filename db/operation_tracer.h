@@ -0,0 +1,80 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vidardb/env.h"
+#include "vidardb/iostats_context.h"
+#include "vidardb/listener.h"
+#include "vidardb/options.h"
+#include "vidardb/perf_context.h"
+#include "vidardb/perf_level.h"
+
+// The operations are traced through the thread local perf and iostats
+// contexts, so there is nothing to trace without them.
+#if !defined(VIDARDB_LITE) && !defined(NPERF_CONTEXT) && \
+    !defined(IOS_CROSS_COMPILE) && !defined(_WIN32)
+#define VIDARDB_OPERATION_TRACER
+#endif
+
+namespace vidardb {
+
+class ColumnFamilyHandle;
+
+// Times the stages of one in DBOptions::operation_trace_one_in reads or
+// writes, and reports the ones slower than DBOptions::slow_operation_micros
+// to EventListener::OnSlowOperation() when it goes out of scope. The stages
+// come from the perf and iostats contexts of the thread, whose timers are
+// turned on while an operation is traced, and from the spans added below.
+class OperationTracer {
+ public:
+  enum Operation { kGet, kWrite };
+
+  // column_family is nullptr for a write.
+  OperationTracer(Env* env, const DBOptions& db_options, Operation operation,
+                  ColumnFamilyHandle* column_family);
+  ~OperationTracer();
+
+  bool sampled() const { return sampled_; }
+
+  // Returns the start time of a span, 0 if the operation is not traced.
+  uint64_t StartSpan() const { return sampled_ ? env_->NowNanos() : 0; }
+  // Adds the span from start to now, if the operation is traced.
+  void EndSpan(const char* name, uint64_t start);
+
+  // Whether the current thread traces an operation.
+  static bool Active();
+  // Adds the time spent in a level of the LSM tree to the operation traced
+  // by the current thread, if any.
+  static void AddLevelTime(int level, uint64_t nanos);
+
+ private:
+  void Report();
+
+  Env* const env_;
+  const DBOptions& db_options_;
+  const Operation operation_;
+  bool sampled_;
+  std::string cf_name_;
+  uint64_t start_nanos_;
+  PerfLevel prev_perf_level_;
+  PerfContext perf_context_start_;
+  IOStatsContext iostats_context_start_;
+  std::vector<OperationSpan> spans_;
+  std::vector<uint64_t> level_nanos_;
+
+#ifdef VIDARDB_OPERATION_TRACER
+  static __thread OperationTracer* current_;
+#endif
+
+  // No copying allowed
+  OperationTracer(const OperationTracer&) = delete;
+  void operator=(const OperationTracer&) = delete;
+};
+
+}  // namespace vidardb
@@ -69,8 +69,14 @@ void AppendVarint64(IterKey* key, uint64_t v) {
 }  // namespace
 
 TableCache::TableCache(const ImmutableCFOptions& ioptions,
-                       const EnvOptions& env_options, Cache* const cache)
-    : ioptions_(ioptions), env_options_(env_options), cache_(cache) {
+                       const EnvOptions& env_options, Cache* const cache,
+                       Cache* const range_query_cache,
+                       ReadAmpStats* const read_amp_stats)
+    : ioptions_(ioptions),
+      env_options_(env_options),
+      cache_(cache),
+      range_query_cache_(range_query_cache),
+      read_amp_stats_(read_amp_stats) {
   if (ioptions_.row_cache) {
     // If the same cache is shared by multiple instances, we need to
     // disambiguate its entries.
@@ -94,7 +100,8 @@ Status TableCache::GetTableReader(
     const InternalKeyComparator& internal_comparator, const FileDescriptor& fd,
     bool sequential_mode, size_t readahead, bool record_read_stats,
     HistogramImpl* file_read_hist, unique_ptr<TableReader>* table_reader,
-    int level, const std::vector<uint32_t>& cols) {  // Shichao
+    int level, const std::vector<uint32_t>& cols,  // Shichao
+    bool for_compaction) {
   std::string fname =
       TableFileName(ioptions_.db_paths, fd.GetNumber(), fd.GetPathId());
   unique_ptr<RandomAccessFile> file;
@@ -113,11 +120,13 @@ Status TableCache::GetTableReader(
     std::unique_ptr<RandomAccessFileReader> file_reader(
         new RandomAccessFileReader(std::move(file), ioptions_.env,
                                    ioptions_.statistics, record_read_stats,
-                                   file_read_hist));
+                                   file_read_hist, ioptions_.rate_limiter,
+                                   for_compaction));
 
     s = ioptions_.table_factory->NewTableReader(
         TableReaderOptions(ioptions_, env_options, internal_comparator, level,
-                           cols),  // Shichao
+                           cols,  // Shichao
+                           for_compaction ? nullptr : read_amp_stats_),
         std::move(file_reader), fd.GetFileSize(), table_reader);
     TEST_SYNC_POINT("TableCache::GetTableReader:0");
   }
@@ -177,15 +186,11 @@ Status TableCache::FindTableForRangeQuery(
     Cache::Handle** handle, const bool no_io, bool record_read_stats,
     HistogramImpl* file_read_hist, int level, size_t readahead) {
   PERF_TIMER_GUARD(find_table_nanos);
+  assert(range_query_cache_ != nullptr);
   Status s;
   uint64_t number = fd.GetNumber();
-  // For range query, we set another half of number as the cache key to avoid
-  // the conflict of the original cache key, since their open file options are
-  // different, direct v.s. buffered read.
-  assert(number < (kFileNumberMask >> 1));
-  number = kFileNumberMask - number;
   Slice key = GetSliceForFileNumber(&number);
-  *handle = cache_->Lookup(key);
+  *handle = range_query_cache_->Lookup(key);
   TEST_SYNC_POINT_CALLBACK("TableCache::FindTable:0",
                            const_cast<bool*>(&no_io));
 
@@ -203,8 +208,8 @@ Status TableCache::FindTableForRangeQuery(
       // We do not cache error results so that if the error is transient,
       // or somebody repairs the file, we recover automatically.
     } else {
-      s = cache_->Insert(key, table_reader.get(), 1, &DeleteEntry<TableReader>,
-                         handle);
+      s = range_query_cache_->Insert(key, table_reader.get(), 1,
+                                     &DeleteEntry<TableReader>, handle);
       if (s.ok()) {
         // Release ownership of table reader.
         table_reader.release();
@@ -230,6 +235,8 @@ InternalIterator* TableCache::NewIterator(
 
   TableReader* table_reader = nullptr;
   Cache::Handle* handle = nullptr;
+  // A range query reader of its own, not shared with the point lookups.
+  bool range_query_reader = false;
 
   size_t readahead = 0;
   bool create_new_table_reader = false;
@@ -248,13 +255,13 @@ InternalIterator* TableCache::NewIterator(
     Status s = GetTableReader(
         env_options, icomparator, fd, true /* sequential_mode */, readahead,
         !for_compaction /* record stats */, nullptr, &table_reader_unique_ptr,
-        level, options.columns /*Shichao*/);
+        level, options.columns /*Shichao*/, for_compaction);
     if (!s.ok()) {
       return NewErrorInternalIterator(s, arena);
     }
     table_reader = table_reader_unique_ptr.release();
   } else {
-    if (for_range_query) {
+    if (for_range_query && range_query_cache_ != nullptr) {
       // For range query, we create another reader first time and cache it to
       // make tail index in memory.
       Status s = FindTableForRangeQuery(
@@ -265,7 +272,9 @@ InternalIterator* TableCache::NewIterator(
       if (!s.ok()) {
         return NewErrorInternalIterator(s, arena);
       }
-      table_reader = GetTableReaderFromHandle(handle);
+      table_reader =
+          reinterpret_cast<TableReader*>(range_query_cache_->Value(handle));
+      range_query_reader = true;
     } else {
       table_reader = fd.table_reader;
       if (table_reader == nullptr) {
@@ -288,10 +297,16 @@ InternalIterator* TableCache::NewIterator(
     assert(handle == nullptr);
     result->RegisterCleanup(&DeleteTableReader, table_reader, nullptr);
   } else if (handle != nullptr) {
-    result->RegisterCleanup(&UnrefEntry, cache_, handle);
+    result->RegisterCleanup(&UnrefEntry,
+                            range_query_reader ? range_query_cache_ : cache_,
+                            handle);
   }
 
-  if (for_compaction || for_range_query) {
+  // A range query on a reader shared with the point lookups keeps their
+  // random access hint.
+  bool shared_reader =
+      for_range_query && !create_new_table_reader && !range_query_reader;
+  if ((for_compaction || for_range_query) && !shared_reader) {
     table_reader->SetupForCompaction();
   }
   if (table_reader_ptr != nullptr) {
@@ -35,11 +35,17 @@ struct FileDescriptor;
 class GetContext;
 class HistogramImpl;
 class InternalIterator;
+class ReadAmpStats;
 
 class TableCache {
  public:
+  // The range queries keep their own table readers in range_query_cache, or
+  // share the ones of cache if it is nullptr. The table readers count their
+  // reads in read_amp_stats, if not nullptr.
   TableCache(const ImmutableCFOptions& ioptions,
-             const EnvOptions& storage_options, Cache* cache);
+             const EnvOptions& storage_options, Cache* cache,
+             Cache* range_query_cache = nullptr,
+             ReadAmpStats* read_amp_stats = nullptr);
   ~TableCache();
 
   // Return an iterator for the specified file number (the corresponding
@@ -117,10 +123,12 @@ class TableCache {
       const FileDescriptor& fd, bool sequential_mode, size_t readahead,
       bool record_read_stats, HistogramImpl* file_read_hist,
       unique_ptr<TableReader>* table_reader, int level = -1,
-      const std::vector<uint32_t>& cols = std::vector<uint32_t>());  // Shichao
+      const std::vector<uint32_t>& cols = std::vector<uint32_t>(),  // Shichao
+      bool for_compaction = false);
 
   /**************************** Shichao *****************************/
-  // Another version of FindTable built for range query.
+  // Another version of FindTable built for range query, which looks up the
+  // readers in range_query_cache_.
   Status FindTableForRangeQuery(
       const EnvOptions& env_options,
       const InternalKeyComparator& internal_comparator,
@@ -131,6 +139,8 @@ class TableCache {
   const ImmutableCFOptions& ioptions_;
   const EnvOptions& env_options_;
   Cache* const cache_;
+  Cache* const range_query_cache_;
+  ReadAmpStats* const read_amp_stats_;
   std::string row_cache_id_;
 };
 
@@ -28,6 +28,7 @@
 #include "db/table_cache.h"
 #include "db/version_set.h"
 #include "table/table_reader.h"
+#include "util/sync_point.h"
 
 namespace vidardb {
 
@@ -289,12 +290,21 @@ class VersionBuilder::Rep {
 
   void LoadTableHandlers(InternalStats* internal_stats, int max_threads) {
     assert(table_cache_ != nullptr);
-    // <file metadata, level>
+    // <file metadata, level>, the threads take the files in this order, so
+    // the upper levels, which every read may go through, are loaded first,
+    // and the newest files first in level 0.
     std::vector<std::pair<FileMetaData*, int>> files_meta;
     for (int level = 0; level < base_vstorage_->num_levels(); level++) {
+      std::vector<FileMetaData*> level_files;
       for (auto& file_meta_pair : levels_[level].added_files) {
         auto* file_meta = file_meta_pair.second;
         assert(!file_meta->table_reader_handle);
+        level_files.push_back(file_meta);
+      }
+      if (level == 0) {
+        std::sort(level_files.begin(), level_files.end(), NewestFirstBySeqNo);
+      }
+      for (auto* file_meta : level_files) {
         files_meta.emplace_back(file_meta, level);
       }
     }
@@ -309,6 +319,8 @@ class VersionBuilder::Rep {
 
         auto* file_meta = files_meta[file_idx].first;
         int level = files_meta[file_idx].second;
+        TEST_SYNC_POINT_CALLBACK("VersionBuilder::LoadTableHandlers:Load",
+                                 &files_meta[file_idx]);
         table_cache_->FindTable(
             env_options_, *(base_vstorage_->InternalComparator()),
             file_meta->fd, &file_meta->table_reader_handle, false /*no_io */,
@@ -322,11 +334,16 @@ class VersionBuilder::Rep {
       }
     };
 
-    if (max_threads <= 1) {
+    // no more threads than files, a flush adds a single one
+    size_t num_threads =
+        max_threads > 1
+            ? std::min(static_cast<size_t>(max_threads), files_meta.size())
+            : 1;
+    if (num_threads <= 1) {
       load_handlers_func();
     } else {
       std::vector<std::thread> threads;
-      for (int i = 0; i < max_threads; i++) {
+      for (size_t i = 0; i < num_threads; i++) {
         threads.emplace_back(load_handlers_func);
       }
 
@@ -33,6 +33,7 @@
 #include "db/internal_stats.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
+#include "db/operation_tracer.h"
 #include "memtable/memtable.h"
 #include "db/table_cache.h"
 #include "db/version_builder.h"
@@ -949,12 +950,18 @@ void Version::Get(const ReadOptions& read_options, const LookupKey& k,
                 storage_info_.num_non_empty_levels_,
                 &storage_info_.file_indexer_, user_comparator(),
                 internal_comparator());
+  bool traced = OperationTracer::Active();
   FdWithKeyRange* f = fp.GetNextFile();
   while (f != nullptr) {
+    uint64_t start = traced ? env_->NowNanos() : 0;
     *status = table_cache_->Get(
         read_options, *internal_comparator(), f->fd, ikey, &get_context,
         cfd_->internal_stats()->GetFileReadHist(fp.GetHitFileLevel()),
         fp.GetCurrentLevel());
+    if (traced) {
+      OperationTracer::AddLevelTime(fp.GetHitFileLevel(),
+                                    env_->NowNanos() - start);
+    }
     // TODO: examine the behavior for corrupted key
     if (!status->ok()) {
       return;
@@ -1982,10 +1989,11 @@ struct VersionSet::ManifestWriter {
 VersionSet::VersionSet(const std::string& dbname, const DBOptions* db_options,
                        const EnvOptions& storage_options, Cache* table_cache,
                        WriteBuffer* write_buffer,
-                       WriteController* write_controller)
+                       WriteController* write_controller,
+                       Cache* range_query_table_cache)
     : column_family_set_(new ColumnFamilySet(
           dbname, db_options, storage_options, table_cache,
-          write_buffer, write_controller)),
+          write_buffer, write_controller, range_query_table_cache)),
       env_(db_options->env),
       dbname_(dbname),
       db_options_(db_options),
@@ -1997,7 +2005,8 @@ VersionSet::VersionSet(const std::string& dbname, const DBOptions* db_options,
       current_version_number_(0),
       manifest_file_size_(0),
       env_options_(storage_options),
-      env_options_compactions_(env_options_) {}
+      env_options_compactions_(
+          env_->OptimizeForCompactionTableRead(env_options_, *db_options_)) {}
 
 void CloseTables(void* ptr, size_t) {
   TableReader* table_reader = reinterpret_cast<TableReader*>(ptr);
@@ -2142,7 +2151,8 @@ Status VersionSet::LogAndApply(ColumnFamilyData* column_family_data,
       // unlimited table cache. Pre-load table handle now.
       // Need to do it out of the mutex.
       builder_guard->version_builder()->LoadTableHandlers(
-          column_family_data->internal_stats());
+          column_family_data->internal_stats(),
+          db_options_->max_file_opening_threads);
     }
 
     // This is fine because everything inside of this block is serialized --
@@ -3230,7 +3240,7 @@ InternalIterator* VersionSet::MakeInputIterator(const Compaction* c) {
         // Create concatenating iterator for the files from this level
         list[num++] = NewTwoLevelIterator(
             new LevelFileIteratorState(
-                cfd->table_cache(), read_options, env_options_,
+                cfd->table_cache(), read_options, env_options_compactions_,
                 cfd->internal_comparator(),
                 nullptr /* no per level latency histogram */,
                 true /* for_compaction */, (int)which /* level */),
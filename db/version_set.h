@@ -567,9 +567,12 @@ class Version {
 
 class VersionSet {
  public:
+  // range_query_table_cache holds the table readers of the range queries,
+  // which share the ones of table_cache if it is nullptr.
   VersionSet(const std::string& dbname, const DBOptions* db_options,
              const EnvOptions& env_options, Cache* table_cache,
-             WriteBuffer* write_buffer, WriteController* write_controller);
+             WriteBuffer* write_buffer, WriteController* write_controller,
+             Cache* range_query_table_cache = nullptr);
   ~VersionSet();
 
   // Apply *edit to the current version to form a new descriptor that
@@ -759,7 +762,8 @@ class VersionSet {
   const EnvOptions& env_options_;
 
   // env options used for compactions. This is a copy of
-  // env_options_ but with readaheads set to readahead_compactions_.
+  // env_options_ but optimized for reading the compaction inputs, see
+  // Env::OptimizeForCompactionTableRead.
   const EnvOptions env_options_compactions_;
 
   // No copying allowed
@@ -0,0 +1,77 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/writebuffer.h"
+
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace vidardb {
+
+namespace {
+void DeleteDummyEntry(const Slice& key, void* value) {}
+}  // namespace
+
+WriteBuffer::WriteBuffer(size_t _buffer_size, std::shared_ptr<Cache> cache)
+    : buffer_size_(_buffer_size),
+      memory_used_(0),
+      memory_active_(0),
+      cache_(cache),
+      cache_charge_(0) {
+  if (cache_ != nullptr) {
+    PutVarint64(&cache_key_prefix_, cache_->NewId());
+  }
+}
+
+WriteBuffer::~WriteBuffer() {
+  std::string key;
+  for (size_t i = 0; i < dummy_handles_.size(); ++i) {
+    if (dummy_handles_[i] != nullptr) {
+      key = cache_key_prefix_;
+      PutVarint64(&key, i);
+      cache_->Release(dummy_handles_[i]);
+      cache_->Erase(key);
+    }
+  }
+}
+
+void WriteBuffer::UpdateCacheCharge() {
+  MutexLock l(&cache_mutex_);
+  size_t total = memory_used_.load(std::memory_order_relaxed);
+  size_t charge = cache_charge_.load(std::memory_order_relaxed);
+  std::string key;
+
+  while (charge < total) {
+    key = cache_key_prefix_;
+    PutVarint64(&key, dummy_handles_.size());
+    Cache::Handle* handle = nullptr;
+    // A cache with strict capacity limit may refuse the entry. It is still
+    // counted as charged so that we do not retry on every allocation.
+    if (!cache_->Insert(key, nullptr, kCacheDummyEntrySize, &DeleteDummyEntry,
+                        &handle).ok()) {
+      handle = nullptr;
+    }
+    dummy_handles_.push_back(handle);
+    charge += kCacheDummyEntrySize;
+  }
+
+  // keep one spare entry so that usage around a boundary does not flap
+  while (!dummy_handles_.empty() &&
+         charge >= total + 2 * kCacheDummyEntrySize) {
+    Cache::Handle* handle = dummy_handles_.back();
+    dummy_handles_.pop_back();
+    if (handle != nullptr) {
+      key = cache_key_prefix_;
+      PutVarint64(&key, dummy_handles_.size());
+      cache_->Release(handle);
+      cache_->Erase(key);
+    }
+    charge -= kCacheDummyEntrySize;
+  }
+
+  cache_charge_.store(charge, std::memory_order_relaxed);
+}
+
+}  // namespace vidardb
@@ -12,21 +12,41 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "port/port.h"
+#include "vidardb/cache.h"
 
 namespace vidardb {
 
 class WriteBuffer {
  public:
-  explicit WriteBuffer(size_t _buffer_size)
-      : buffer_size_(_buffer_size), memory_used_(0) {}
+  // If cache is not nullptr, the memory of all live memtables, mutable or
+  // not, is charged to it with pinned dummy entries, so that memtables and
+  // the block cache share one memory budget.
+  explicit WriteBuffer(size_t _buffer_size,
+                       std::shared_ptr<Cache> cache = nullptr);
 
-  ~WriteBuffer() {}
+  ~WriteBuffer();
 
+  // Memory of the mutable memtables
   size_t memory_usage() const {
+    return memory_active_.load(std::memory_order_relaxed);
+  }
+  // Memory of all memtables that are not freed yet, including the ones
+  // waiting to be flushed
+  size_t total_memory_usage() const {
     return memory_used_.load(std::memory_order_relaxed);
   }
   size_t buffer_size() const { return buffer_size_; }
 
+  // Memory charged to the cache, a multiple of kCacheDummyEntrySize
+  size_t cache_charge() const {
+    return cache_charge_.load(std::memory_order_relaxed);
+  }
+
   // Should only be called from write thread
   bool ShouldFlush() const {
     return buffer_size() > 0 && memory_usage() >= buffer_size();
@@ -34,15 +54,44 @@ class WriteBuffer {
 
   // Should only be called from write thread
   void ReserveMem(size_t mem) {
-    memory_used_.fetch_add(mem, std::memory_order_relaxed);
+    memory_active_.fetch_add(mem, std::memory_order_relaxed);
+    size_t total = memory_used_.fetch_add(mem, std::memory_order_relaxed) + mem;
+    if (cache_ != nullptr &&
+        total > cache_charge_.load(std::memory_order_relaxed)) {
+      UpdateCacheCharge();
+    }
   }
+  // The memtable became immutable, its memory no longer counts towards
+  // buffer_size() but stays charged until FreeMem()
+  void ScheduleFreeMem(size_t mem) {
+    memory_active_.fetch_sub(mem, std::memory_order_relaxed);
+  }
+  // The memtable is destroyed
   void FreeMem(size_t mem) {
-    memory_used_.fetch_sub(mem, std::memory_order_relaxed);
+    size_t total = memory_used_.fetch_sub(mem, std::memory_order_relaxed) - mem;
+    if (cache_ != nullptr &&
+        total + 2 * kCacheDummyEntrySize <
+            cache_charge_.load(std::memory_order_relaxed)) {
+      UpdateCacheCharge();
+    }
   }
 
+  static const size_t kCacheDummyEntrySize = 1 << 20;
+
  private:
+  // Inserts or releases dummy entries until the charge covers
+  // total_memory_usage(), keeping at most one spare entry
+  void UpdateCacheCharge();
+
   const size_t buffer_size_;
   std::atomic<size_t> memory_used_;
+  std::atomic<size_t> memory_active_;
+
+  std::shared_ptr<Cache> cache_;
+  port::Mutex cache_mutex_;
+  std::vector<Cache::Handle*> dummy_handles_;
+  std::atomic<size_t> cache_charge_;
+  std::string cache_key_prefix_;
 
   // No copying allowed
   WriteBuffer(const WriteBuffer&);
@@ -0,0 +1,63 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "vidardb/slice.h"
+#include "vidardb/status.h"
+
+namespace vidardb {
+
+class Env;
+
+// A lookup of a table reader in the block cache.
+struct BlockAccess {
+  enum Type : uint8_t {
+    kData = 0,
+    kIndex = 1,  // the index of a table, or a partition of it
+    kFilter = 2,
+  };
+
+  uint64_t micros = 0;  // when the lookup happened
+  Slice key;            // the block cache key of the block
+  uint64_t charge = 0;  // what the block takes, or would take, in the cache
+  Type type = kData;
+  bool hit = false;
+  bool fill_cache = true;  // whether a miss inserts the block in the cache
+};
+
+// BlockAccessTracer records the block cache lookups of the table readers to
+// a trace file, for tools/block_cache_sim to replay them against caches of
+// other sizes and policies. Set it in DBOptions::block_access_tracer, then
+// start and end the trace while the DB is open.
+class BlockAccessTracer {
+ public:
+  virtual ~BlockAccessTracer() {}
+
+  // Starts writing the lookups to trace_file. Only the blocks whose cache
+  // key hashes to one out of sample_one_in are traced, all their lookups
+  // then, so the trace replays in a cache sample_one_in times smaller.
+  // Fails if a trace is already going on.
+  virtual Status StartTrace(Env* env, const std::string& trace_file,
+                            uint32_t sample_one_in = 1) = 0;
+
+  // Flushes and closes the trace file.
+  virtual Status EndTrace() = 0;
+
+  // Whether StartTrace() was called without EndTrace().
+  virtual bool IsTracing() const = 0;
+
+  // Called by the table readers while tracing.
+  virtual void Record(const BlockAccess& access) = 0;
+};
+
+// Creates a tracer that writes nothing until StartTrace().
+std::shared_ptr<BlockAccessTracer> NewBlockAccessTracer();
+
+}  // namespace vidardb
@@ -37,13 +37,47 @@ class Cache;
 //
 // The parameter num_shard_bits defaults to 4, and strict_capacity_limit
 // defaults to false.
+//
+// high_pri_pool_ratio is the fraction of the capacity reserved for the
+// entries inserted with Priority::HIGH, e.g. the index and filter blocks.
+// They are evicted only after the low priority entries, unless the pool
+// overflows. It defaults to 0, which disables the pool. Returns nullptr for
+// a ratio out of [0, 1].
+//
+// tinylfu_admission puts a W-TinyLFU admission filter in front of each shard.
+// The new entries enter a small window, 1% of the capacity, and the ones
+// leaving it only get into the LRU list of a full cache if their keys were
+// looked up more often than the least recently used entry. So the one-off
+// reads of a scan don't push out the popular entries. It defaults to false,
+// and the high priority entries skip the filter.
 extern std::shared_ptr<Cache> NewLRUCache(size_t capacity);
 extern std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits);
 extern std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
                                           bool strict_capacity_limit);
+extern std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
+                                          bool strict_capacity_limit,
+                                          double high_pri_pool_ratio);
+extern std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
+                                          bool strict_capacity_limit,
+                                          double high_pri_pool_ratio,
+                                          bool tinylfu_admission);
+
+// Create a new cache with a fixed size capacity, which evicts the entries
+// with the CLOCK algorithm instead of LRU. Its lookups and releases don't
+// take the shard mutex, which suits the caches hit by many threads. It is
+// sharded like the LRU cache, num_shard_bits defaults to 6, and the entry
+// priority is ignored. Returns nullptr for num_shard_bits >= 20.
+extern std::shared_ptr<Cache> NewClockCache(size_t capacity);
+extern std::shared_ptr<Cache> NewClockCache(size_t capacity,
+                                            int num_shard_bits,
+                                            bool strict_capacity_limit);
 
 class Cache {
  public:
+  // Depending on the implementation, entries with high priority could be
+  // less likely to get evicted than low priority entries.
+  enum class Priority { HIGH, LOW };
+
   Cache() {}
 
   // Destroys all existing entries by calling the "deleter"
@@ -72,7 +106,8 @@ class Cache {
   // value will be passed to "deleter".
   virtual Status Insert(const Slice& key, void* value, size_t charge,
                         void (*deleter)(const Slice& key, void* value),
-                        Handle** handle = nullptr) = 0;
+                        Handle** handle = nullptr,
+                        Priority priority = Priority::LOW) = 0;
 
   // If the cache has no mapping for "key", returns nullptr.
   //
@@ -116,6 +151,13 @@ class Cache {
   // capacity.
   virtual bool HasStrictCapacityLimit() const = 0;
 
+  // Sets the fraction of the capacity reserved for high priority entries.
+  // The default implementation ignores priorities.
+  virtual void SetHighPriorityPoolRatio(double high_pri_pool_ratio) {}
+
+  // returns the fraction of the capacity reserved for high priority entries
+  virtual double GetHighPriorityPoolRatio() const { return 0.0; }
+
   // returns the maximum configured capacity of the cache
   virtual size_t GetCapacity() const = 0;
 
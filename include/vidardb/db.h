@@ -309,6 +309,14 @@ class DB {
     //      of files per level and total size of each level (MB).
     static const std::string kLevelStats;
 
+    //  "vidardb.read-amp-stats" - returns multi-line string containing the
+    //      number of data blocks read from the files (and their MB), found in
+    //      the block cache, and skipped by the range queries, per level and
+    //      per column of the column tables. The compactions are counted too
+    //      unless new_table_reader_for_compaction_inputs gives them their own
+    //      table readers.
+    static const std::string kReadAmpStats;
+
     //  "vidardb.num-immutable-mem-table" - returns number of immutable
     //      memtables that have not yet been flushed.
     static const std::string kNumImmutableMemTable;
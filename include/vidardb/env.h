@@ -42,6 +42,7 @@ namespace vidardb {
 class FileLock;
 class Logger;
 class RandomAccessFile;
+class RateLimiter;
 class SequentialFile;
 class Slice;
 class WritableFile;
@@ -78,6 +79,11 @@ struct EnvOptions {
   // If true, then use O_DIRECT for writing data
   bool use_direct_writes = false;
 
+  // If true, then MultiRead of random access files submits the reads
+  // together through io_uring where the kernel supports it, and falls back
+  // to one pread per request otherwise.
+  bool use_io_uring = false;
+
   // If false, fallocate() calls are bypassed
   bool allow_fallocate = true;
 
@@ -106,6 +112,9 @@ struct EnvOptions {
 
   // See DBOptions doc
   size_t writable_file_max_buffer_size = 1024 * 1024;
+
+  // If not nullptr, write rate limiting is enabled for flush and compaction
+  RateLimiter* rate_limiter = nullptr;
 };
 
 class Env {
@@ -356,6 +365,18 @@ class Env {
   virtual EnvOptions OptimizeForManifestWrite(const EnvOptions& env_options)
       const;
 
+  // OptimizeForCompactionTableWrite will create a new EnvOptions object that
+  // is a copy of the EnvOptions in the parameters, but is optimized for
+  // writing the table files of flushes and compactions.
+  virtual EnvOptions OptimizeForCompactionTableWrite(
+      const EnvOptions& env_options, const DBOptions& db_options) const;
+
+  // OptimizeForCompactionTableRead will create a new EnvOptions object that
+  // is a copy of the EnvOptions in the parameters, but is optimized for
+  // reading the input table files of compactions.
+  virtual EnvOptions OptimizeForCompactionTableRead(
+      const EnvOptions& env_options, const DBOptions& db_options) const;
+
   // Returns the status of all threads that belong to the current Env.
   virtual Status GetThreadList(std::vector<ThreadStatus>* thread_list) {
     return Status::NotSupported("Not supported.");
@@ -433,6 +454,24 @@ class SequentialFile {
   const std::string filename_;  // Shichao
 };
 
+// A read of RandomAccessFile::MultiRead.
+struct ReadRequest {
+  // File offset in bytes
+  uint64_t offset;
+
+  // Length to read in bytes
+  size_t len;
+
+  // A buffer of at least len bytes, result may point into it
+  char* scratch;
+
+  // Output: the data read, shorter than len at the end of the file
+  Slice result;
+
+  // Output: the status of this read
+  Status status;
+};
+
 // A file abstraction for randomly reading the contents of a file.
 class RandomAccessFile {
  public:
@@ -455,6 +494,14 @@ class RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const = 0;
 
+  // Reads the num_reqs requests of reqs, possibly all at once. Each request
+  // gets its own result and status, as if it were a Read. Returns a non-OK
+  // status only if the batch itself fails, in which case the statuses of
+  // the requests are not set.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs);
+
   // Used by the file_reader_writer to decide if the ReadAhead wrapper
   // should simply forward the call and do not enact buffering or locking.
   virtual bool ShouldForwardRawRequest() const {
@@ -506,6 +553,14 @@ class RandomAccessFile {
     return Status::NotSupported("InvalidateCache not supported.");
   }
 
+  // Start reading the range [offset, offset + n) of the file in the
+  // background, so that the later reads of the range don't wait for the
+  // device. Returns without waiting for the data. Returns NotSupported if
+  // the file can't read ahead this way.
+  virtual Status Prefetch(uint64_t offset, size_t n) {
+    return Status::NotSupported("Prefetch not supported.");
+  }
+
  protected:
   const std::string filename_;  // Shichao
 };
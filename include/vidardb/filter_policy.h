@@ -0,0 +1,93 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A database can be configured with a custom FilterPolicy object.
+// This object is responsible for creating a small filter from a set
+// of keys.  These filters are stored in vidardb and are consulted
+// automatically by vidardb to decide whether or not to read some
+// information from disk. In many cases, a filter can cut down the
+// number of disk seeks form a handful to a single disk seek per
+// DB::Get() call.
+//
+// Most people will want to use the builtin bloom filter support (see
+// NewBloomFilterPolicy() below).
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace vidardb {
+
+class Slice;
+
+// A class that takes a bunch of keys, then generates a filter covering all of
+// them. One filter is built for the whole table file.
+class FilterBitsBuilder {
+ public:
+  virtual ~FilterBitsBuilder() {}
+
+  // Add Key to filter. Keys arrive in sorted order, duplicated keys are
+  // possible.
+  virtual void AddKey(const Slice& key) = 0;
+
+  // Generate the filter using the keys that are added. The return value is
+  // the filter contents, whose memory is owned by buf.
+  virtual Slice Finish(std::unique_ptr<const char[]>* buf) = 0;
+};
+
+// A class that checks if a key can be in the filter built by the matching
+// FilterBitsBuilder. It must be safe to call from multiple threads.
+class FilterBitsReader {
+ public:
+  virtual ~FilterBitsReader() {}
+
+  // Check if the entry matches the bits in the filter. False positives are
+  // allowed, false negatives are not.
+  virtual bool MayMatch(const Slice& entry) const = 0;
+};
+
+class FilterPolicy {
+ public:
+  virtual ~FilterPolicy() {}
+
+  // Return the name of this policy.  Note that if the filter encoding
+  // changes in an incompatible way, the name returned by this method
+  // must be changed.  Otherwise, old incompatible filters may be
+  // passed to methods of this type.
+  virtual const char* Name() const = 0;
+
+  // Return a new FilterBitsBuilder, the caller owns the result.
+  virtual FilterBitsBuilder* GetFilterBitsBuilder() const = 0;
+
+  // Return a new FilterBitsReader for the filter contents, which must stay
+  // alive as long as the reader. The caller owns the result.
+  virtual FilterBitsReader* GetFilterBitsReader(
+      const Slice& contents) const = 0;
+};
+
+// Return a new filter policy that uses a bloom filter with approximately
+// the specified number of bits per key. The bits of one key are all set in
+// the same 64-byte cache line, so a lookup costs at most one cache miss.
+// A good value for bits_per_key is 10, which yields a filter with ~1% false
+// positive rate.
+//
+// Callers must delete the result after any database that is using the
+// result has been closed.
+//
+// Note: if you are using a custom comparator that ignores some parts
+// of the keys being compared, you must not use NewBloomFilterPolicy()
+// and must provide your own FilterPolicy that also ignores the
+// corresponding parts of the keys.  For example, if the comparator
+// ignores trailing spaces, it would be incorrect to use a
+// FilterPolicy (like NewBloomFilterPolicy) that does not ignore
+// trailing spaces in keys.
+extern const FilterPolicy* NewBloomFilterPolicy(double bits_per_key);
+
+}  // namespace vidardb
@@ -35,14 +35,20 @@ struct ImmutableCFOptions {
 
   const Splitter* splitter;
 
+  const SliceTransform* prefix_extractor;
+
   Logger* info_log;
 
   Statistics* statistics;
 
+  BlockAccessTracer* block_access_tracer;
+
   InfoLogLevel info_log_level;
 
   Env* env;
 
+  RateLimiter* rate_limiter;
+
   uint64_t delayed_write_rate;
 
   // Allow the OS to mmap file for reading sst tables. Default: false
@@ -55,6 +61,8 @@ struct ImmutableCFOptions {
 
   MemTableRepFactory* memtable_factory;
 
+  double memtable_prefix_bloom_size_ratio;
+
   TableFactory* table_factory;
 
   Options::TablePropertiesCollectorFactories
@@ -82,6 +90,8 @@ struct ImmutableCFOptions {
 
   int num_levels;
 
+  bool enable_pipelined_flush;
+
   // A vector of EventListeners which call-back functions will be called
   // when specific VidarDB event happens.
   std::vector<std::shared_ptr<EventListener>> listeners;
@@ -141,6 +141,28 @@ struct CompactionJobInfo {
   CompactionJobStats stats;
 };
 
+// The time spent in one stage of a traced operation.
+struct OperationSpan {
+  OperationSpan(const std::string& _name, uint64_t _nanos)
+      : name(_name), nanos(_nanos) {}
+
+  std::string name;
+  uint64_t nanos;
+};
+
+struct OperationTraceInfo {
+  // "Get" or "Write"
+  std::string operation;
+  // the name of the column family read, empty for a write
+  std::string cf_name;
+  uint64_t total_nanos;
+  uint64_t block_cache_hit_count;
+  uint64_t block_read_count;
+  // The stages the operation spent time in, in the order of its path. The
+  // stages of a table, e.g. "block read", are part of the "level N" ones.
+  std::vector<OperationSpan> spans;
+};
+
 struct MemTableInfo {
   // the name of the column family to which memtable belongs
   std::string cf_name;
@@ -269,6 +291,16 @@ class EventListener {
   virtual void OnMemTableSealed(
     const MemTableInfo& /*info*/) {}
 
+  // A call-back function for VidarDB which will be called after a traced
+  // read or write took at least DBOptions::slow_operation_micros, see
+  // DBOptions::operation_trace_one_in. It is called in the thread of the
+  // operation, before it returns to its caller.
+  //
+  // Note that this function must be implemented in a way such that
+  // it should not run for an extended period of time before the function
+  // returns.  Otherwise, VidarDB may be blocked.
+  virtual void OnSlowOperation(const OperationTraceInfo& /*info*/) {}
+
   virtual ~EventListener() {}
 };
 
@@ -32,7 +32,8 @@
 //  - VectorRep: This is backed by an unordered std::vector. On iteration, the
 // vector is sorted. It is intelligent about sorting; once the MarkReadOnly()
 // has been called, the vector will only be sorted once. It is optimized for
-// random-write-heavy workloads.
+// random-write-heavy workloads. Concurrent inserts are appended to per-core
+// buffers, and large vectors are sorted on multiple threads.
 //
 // The last four implementations are designed for situations in which
 // iteration over the entire collection is rare since doing so requires all the
@@ -49,6 +50,7 @@
 namespace vidardb {
 
 class Arena;
+class Env;
 class MemTableAllocator;
 class LookupKey;
 class Slice;
@@ -244,17 +246,24 @@ class SkipListFactory : public MemTableRepFactory {
 //   count: Passed to the constructor of the underlying std::vector of each
 //     VectorRep. On initialization, the underlying array will be at least count
 //     bytes reserved for usage.
+//   env: If not nullptr, large vectors are sorted in parallel by jobs in the
+//     LOW priority thread pool of env, together with the sorting thread.
+//     Otherwise they are sorted on the thread that iterates first.
 class VectorRepFactory : public MemTableRepFactory {
   const size_t count_;
+  Env* const env_;
 
  public:
-  explicit VectorRepFactory(size_t count = 0) : count_(count) {}
+  explicit VectorRepFactory(size_t count = 0, Env* env = nullptr)
+      : count_(count), env_(env) {}
   virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator&,
                                          MemTableAllocator*,
                                          Logger* logger) override;
   virtual const char* Name() const override {
     return "VectorRepFactory";
   }
+
+  bool IsInsertConcurrentlySupported() const override { return true; }
 };
 #endif  // VIDARDB_LITE
 }  // namespace vidardb
@@ -28,9 +28,11 @@
 
 namespace vidardb {
 
+class BlockAccessTracer;
 class Cache;
 class Comparator;
 class Env;
+class RateLimiter;
 enum InfoLogLevel : unsigned char;
 class SstFileManager;
 class Logger;
@@ -42,6 +44,7 @@ class Slice;
 class Statistics;
 class InternalKeyComparator;
 class Splitter;
+class SliceTransform;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -204,6 +207,21 @@ struct ColumnFamilyOptions {
   // for columnar storage.
   std::shared_ptr<Splitter> splitter;
 
+  // If non-nullptr, use the specified function to determine the
+  // prefixes for keys. The prefixes are added to the table filters (see
+  // BlockBasedTableOptions::filter_policy) and to the memtable bloom (see
+  // memtable_prefix_bloom_size_ratio), and an iterator Seek() skips the
+  // memtables and table files that do not contain the prefix of the target.
+  // The order of keys of different prefixes after such a Seek() is then
+  // undefined; set ReadOptions::prefix_same_as_start to stop at the end of
+  // the prefix, or ReadOptions::total_order_seek to disable the skipping.
+  //
+  // For keys like "tenant|entity|ts", NewDelimiterPrefixTransform('|')
+  // limits the seeks to a tenant.
+  //
+  // Default: nullptr
+  std::shared_ptr<const SliceTransform> prefix_extractor;
+
   // -------------------
   // Parameters that affect performance
 
@@ -419,6 +437,24 @@ struct ColumnFamilyOptions {
   // Dynamically changeable through SetOptions() API
   size_t arena_block_size;
 
+  // All writes will be slowed down to at least delayed_write_rate if estimated
+  // bytes needed to be compaction exceed this threshold. The closer the
+  // estimate gets to hard_pending_compaction_bytes_limit, the slower the
+  // writes become. 0 means it follows hard_pending_compaction_bytes_limit.
+  //
+  // Default: 64GB
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t soft_pending_compaction_bytes_limit;
+
+  // All writes are stopped if estimated bytes needed to be compaction exceed
+  // this threshold. 0 means no limit.
+  //
+  // Default: 256GB
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t hard_pending_compaction_bytes_limit;
+
   // Disable automatic compactions. Manual compactions can still
   // be issued on this column family
   //
@@ -449,6 +485,15 @@ struct ColumnFamilyOptions {
   // MemTableRep.
   std::shared_ptr<MemTableRepFactory> memtable_factory;
 
+  // If prefix_extractor is set and memtable_prefix_bloom_size_ratio is not 0,
+  // create a bloom filter of the key prefixes for each memtable, whose size
+  // is write_buffer_size * memtable_prefix_bloom_size_ratio. Get() and
+  // Seek() skip the memtables that do not contain the prefix. If it is
+  // larger than 0.25, it is sanitized to 0.25.
+  //
+  // Default: 0 (disable)
+  double memtable_prefix_bloom_size_ratio;
+
   // This is a factory that provides TableFactory objects.
   // Default: a block-based table factory that provides a default
   // implementation of TableBuilder and TableReader with default
@@ -549,6 +594,14 @@ struct DBOptions {
   // Default: nullptr
   std::shared_ptr<SstFileManager> sst_file_manager;
 
+  // Use to control write rate of flush and compaction, and read rate of
+  // compaction inputs. Flush has higher priority than compaction.
+  // Rate limiting is disabled if nullptr.
+  // If rate limiter is enabled, bytes_per_sync is set to 1MB by default, and
+  // new_table_reader_for_compaction_inputs is turned on.
+  // Default: nullptr
+  std::shared_ptr<RateLimiter> rate_limiter;
+
   // Any internal progress/error information generated by the db will
   // be written to info_log if it is non-nullptr, or to a file stored
   // in the same directory as the DB contents if info_log is nullptr.
@@ -566,10 +619,20 @@ struct DBOptions {
   int max_open_files;
 
   // If max_open_files is -1, DB will open all files on DB::Open(). You can
-  // use this option to increase the number of threads used to open the files.
+  // use this option to increase the number of threads used to open the files,
+  // and their index blocks. The files of the upper levels are opened first.
+  // Also used for the files added by the flushes and compactions.
   // Default: 16
   int max_file_opening_threads;
 
+  // Number of table readers kept open for the range queries, apart from the
+  // ones of max_open_files. A range query reader hints the OS for sequential
+  // reads, but opens the files of the table once more, and parses its footer
+  // and index again. If 0, the range queries share the readers of the point
+  // lookups instead, and open no file of their own.
+  // Default: 0
+  int max_range_query_table_readers;
+
   // Once write-ahead logs exceed this size, we will start forcing the flush of
   // column families whose memtables are backed by the oldest live WAL file
   // (i.e. the ones that are causing all the space amplification). If set to 0
@@ -766,6 +829,22 @@ struct DBOptions {
   // Allow the OS to mmap file for reading sst tables. Default: false
   bool allow_mmap_reads;
 
+  // Read the table files with O_DIRECT, bypassing the OS page cache. The
+  // reads of the iterators are only as large as a block then, so scans
+  // should set ReadOptions::readahead_size to read ahead in large aligned
+  // chunks. Not compatible with allow_mmap_reads.
+  // Default: false
+  bool use_direct_reads;
+
+  // Write the table files of flushes and compactions, and read the inputs
+  // of compactions, with O_DIRECT, so that the background I/O doesn't
+  // evict the pages of the foreground reads from the OS page cache.
+  // Compaction inputs are read ahead compaction_readahead_size at a time,
+  // which defaults to 2MB with this option. Not compatible with
+  // allow_mmap_writes.
+  // Default: false
+  bool use_direct_io_for_flush_and_compaction;
+
   // Allow the OS to mmap file for writing.
   // DB::SyncWAL() only works if this is set to false.
   // Default: false
@@ -798,6 +877,27 @@ struct DBOptions {
   // Default: 0 (disabled)
   size_t db_write_buffer_size;
 
+  // If true and db_write_buffer_size is set, db_write_buffer_size is shared
+  // among column families according to their recent write rates instead of
+  // letting every column family grow its memtable to write_buffer_size.
+  // Roughly once per second each column family gets a share of
+  // db_write_buffer_size proportional to its write rate, at least
+  // db_write_buffer_size / (4 * number of column families) and at most its
+  // write_buffer_size. The share is used as the size of its next memtable.
+  // When db_write_buffer_size is exceeded, the memtable that is furthest over
+  // its share is flushed first, so idle column families give their memory
+  // back to busy ones.
+  //
+  // Default: false
+  bool adaptive_write_buffer_sizing;
+
+  // If not nullptr, the memory of all memtables is charged to this cache,
+  // so that memtables and the block cache share one budget. Usually the same
+  // cache as BlockBasedTableOptions::block_cache.
+  //
+  // Default: nullptr
+  std::shared_ptr<Cache> write_buffer_cache;
+
   // Specify the file access pattern once a compaction is started.
   // It will be applied to all input files of a compaction.
   // Default: NORMAL
@@ -828,7 +928,7 @@ struct DBOptions {
   // When non-zero, we also force new_table_reader_for_compaction_inputs to
   // true.
   //
-  // Default: 0
+  // Default: 0, or 2MB with use_direct_io_for_flush_and_compaction
   size_t compaction_readahead_size;
 
   // This is a maximum buffer size that is used by WinMmapReadableFile in
@@ -891,6 +991,17 @@ struct DBOptions {
   // when specific VidarDB event happens.
   std::vector<std::shared_ptr<EventListener>> listeners;
 
+  // If positive, one in operation_trace_one_in of the reads and writes is
+  // timed stage by stage, and reported to EventListener::OnSlowOperation()
+  // if it took at least slow_operation_micros. The perf context timers of
+  // the thread are turned on for the duration of a traced operation.
+  // Default: 0, turned off
+  uint32_t operation_trace_one_in;
+
+  // See operation_trace_one_in.
+  // Default: 0, every traced operation is reported
+  uint64_t slow_operation_micros;
+
   // If true, then the status of the threads involved in this DB will
   // be tracked and available via GetThreadList() API.
   //
@@ -898,10 +1009,12 @@ struct DBOptions {
   bool enable_thread_tracking;
 
   // The limited write rate to DB if we are writing to the
-  // last mem table allowed and we allow more than 3 mem tables. It is
-  // calculated using size of user write requests before compression.
-  // VidarDB may decide to slow down more if the compaction still
-  // gets behind further.
+  // last mem table allowed and we allow more than 3 mem tables, or if
+  // soft_pending_compaction_bytes_limit is exceeded. It is calculated using
+  // size of user write requests before compression. VidarDB slows down
+  // further, in proportion to how close pending compaction bytes are to
+  // hard_pending_compaction_bytes_limit, if the compaction still gets
+  // behind further.
   // Unit: byte per second.
   //
   // Default: 2MB/s
@@ -918,6 +1031,15 @@ struct DBOptions {
   // Default: false
   bool allow_concurrent_memtable_write;
 
+  // If true, BuildTable hands the entries read from the memtables over to a
+  // job in the LOW priority thread pool that feeds the table builder, so that
+  // memtable iteration overlaps with block encoding, compression and file
+  // writes. If the job cannot start in time, the flush builds the table
+  // itself. This applies to flushes and to the tables built during recovery.
+  //
+  // Default: false
+  bool enable_pipelined_flush;
+
   // The latency in microseconds after which a std::this_thread::yield
   // call (sched_yield on Linux) is considered to be a signal that
   // other processes or threads would like to use the current core.
@@ -949,6 +1071,11 @@ struct DBOptions {
   // Not supported in VIDARDB_LITE mode!
   std::shared_ptr<Cache> row_cache;
 
+  // If non-null, the table readers record their block cache lookups to it
+  // while it traces, see NewBlockAccessTracer().
+  // Default: nullptr
+  std::shared_ptr<BlockAccessTracer> block_access_tracer;
+
   // If true, then DB::Open / CreateColumnFamily / DropColumnFamily
   // / SetOptions will fail if options file is not detected or properly
   // persisted.
@@ -1061,6 +1188,13 @@ struct ReadOptions {
   // changing implementation of prefix extractor.
   bool total_order_seek;
 
+  // Enforce that the iterator only iterates over the same prefix as the seek.
+  // This option is effective only for prefix seeks, i.e. prefix_extractor is
+  // non-null for the column family and total_order_seek is false. The
+  // iterator becomes invalid once it moves to a key of another prefix.
+  // Default: false
+  bool prefix_same_as_start;
+
   // Keep the blocks loaded by the iterator pinned in memory as long as the
   // iterator is not deleted, If used when reading from tables created with
   // BlockBasedTableOptions::use_delta_encoding = false,
@@ -1075,6 +1209,14 @@ struct ReadOptions {
   // Default: 0
   size_t readahead_size;
 
+  // If non-zero, an iterator that reads the data blocks of a table one after
+  // another prefetches the blocks ahead of it in the background, so a scan
+  // doesn't wait for each block read. The readahead starts at 8KB and
+  // doubles while the scan goes on, up to async_readahead_size. Only the
+  // files read through the OS page cache support it.
+  // Default: 0
+  size_t async_readahead_size;
+
   /***************************** Quanzhao *********************************/
   // If empty, RangeQuery will return all columns, else return the specified
   // index column.
@@ -0,0 +1,68 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "vidardb/slice.h"
+#include "vidardb/status.h"
+
+namespace vidardb {
+
+class Env;
+class Logger;
+
+// PersistentCache keeps the raw blocks of the table files on a device faster
+// than the one the tables live on, e.g. a local SSD in front of HDD or network
+// attached storage. The table readers look a block up here when it is missing
+// from the block caches, and insert the blocks they read from the files.
+//
+// Unlike Cache, the content outlives the process: the keys are derived from
+// the unique ids of the table files, so the blocks can be served again after
+// a restart.
+//
+// All PersistentCache public functions are thread-safe.
+class PersistentCache {
+ public:
+  virtual ~PersistentCache() {}
+
+  // Insert the page of size bytes at data under key. The cache keeps a copy.
+  // Inserting a key that is already in the cache is a no-op.
+  virtual Status Insert(const Slice& key, const char* data,
+                        const size_t size) = 0;
+
+  // Lookup the page of key. On success *data owns a copy of the page, and
+  // *size is its size. Returns NotFound if the key is not in the cache, and
+  // Corruption if the page failed its checksum, in which case it is dropped.
+  virtual Status Lookup(const Slice& key, std::unique_ptr<char[]>* data,
+                        size_t* size) = 0;
+
+  // The number of bytes of the cache files.
+  virtual uint64_t GetUsage() const = 0;
+
+  // The number of bytes the cache files may take.
+  virtual uint64_t GetCapacity() const = 0;
+
+  virtual std::string GetPrintableOptions() const = 0;
+};
+
+// Create a persistent cache of up to size bytes in the directory path, which
+// is created if it is missing. The pages are appended to log-structured cache
+// files, and the oldest file is dropped when the cache is full. The pages of
+// the cache files left in path by a previous instance are recovered, up to
+// the first page failing its checksum in each file.
+//
+// @param env: Pointer to Env object, please see "vidardb/env.h".
+// @param log: If not nullptr, log will be used to log the recovery and the
+//             errors.
+extern Status NewPersistentCache(Env* const env, const std::string& path,
+                                 const uint64_t size,
+                                 const std::shared_ptr<Logger>& log,
+                                 std::shared_ptr<PersistentCache>* cache);
+
+}  // namespace vidardb
@@ -0,0 +1,64 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Copyright (c) 2012 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Class for specifying user-defined functions which perform a
+// transformation on a slice.  It is not required that every slice
+// belong to the domain and/or range of a function.  Subclasses should
+// define InDomain and InRange to determine which slices are in either
+// of these sets respectively.
+
+#pragma once
+
+#include <string>
+
+namespace vidardb {
+
+class Slice;
+
+class SliceTransform {
+ public:
+  virtual ~SliceTransform() {}
+
+  // Return the name of this transformation. The name is stored in the table
+  // files, so the prefix filters of a file are only used by a transformation
+  // of the same name.
+  virtual const char* Name() const = 0;
+
+  // Extract a prefix from a specified key. It is only called on keys for
+  // which InDomain() returns true.
+  virtual Slice Transform(const Slice& key) const = 0;
+
+  // Determine whether the specified key is compatible with the logic
+  // specified in the Transform method. Keys out of the domain are never
+  // filtered by prefix.
+  //
+  // If all the keys sharing a prefix must be found by a prefix seek, then
+  // for any key k in the domain, every key that sorts between
+  // Transform(k) and k must be in the domain and share the prefix.
+  virtual bool InDomain(const Slice& key) const = 0;
+
+  // This is currently not used and remains here for backward compatibility.
+  virtual bool InRange(const Slice& dst) const { return false; }
+};
+
+// The first prefix_len bytes of the key. Shorter keys are out of the domain.
+extern const SliceTransform* NewFixedPrefixTransform(size_t prefix_len);
+
+// The first cap_len bytes of the key, or the whole key if it is shorter.
+extern const SliceTransform* NewCappedPrefixTransform(size_t cap_len);
+
+// The key up to and including the first occurrence of delimiter, e.g.
+// "tenant|" for the key "tenant|entity|ts" with delimiter '|'. Keys without
+// the delimiter are out of the domain.
+extern const SliceTransform* NewDelimiterPrefixTransform(char delimiter);
+
+// The whole key.
+extern const SliceTransform* NewNoopTransform();
+
+}  // namespace vidardb
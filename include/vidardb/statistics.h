@@ -207,6 +207,8 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {BLOCK_CACHE_BYTES_READ, "vidardb.block.cache.bytes.read"},
     {BLOCK_CACHE_BYTES_WRITE, "vidardb.block.cache.bytes.write"},
     {BLOOM_FILTER_USEFUL, "vidardb.bloom.filter.useful"},
+    {PERSISTENT_CACHE_HIT, "vidardb.persistent.cache.hit"},
+    {PERSISTENT_CACHE_MISS, "vidardb.persistent.cache.miss"},
     {MEMTABLE_HIT, "vidardb.memtable.hit"},
     {MEMTABLE_MISS, "vidardb.memtable.miss"},
     {GET_HIT_L0, "vidardb.l0.hit"},
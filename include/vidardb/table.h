@@ -28,7 +28,9 @@
 namespace vidardb {
 
 // -- Block-based Table
+class FilterPolicy;
 class FlushBlockPolicyFactory;
+class PersistentCache;
 class RandomAccessFile;
 struct TableReaderOptions;
 struct TableBuilderOptions;
@@ -62,6 +64,20 @@ struct BlockBasedTableOptions {
   // If NULL, vidardb will automatically create and use an 8MB internal cache.
   std::shared_ptr<Cache> block_cache = nullptr;
 
+  // If non-NULL use the specified cache for compressed blocks, as a second
+  // tier behind block_cache. A block missing from block_cache is looked up
+  // here and, if found, uncompressed and promoted to block_cache, without
+  // reading the file. Blocks stored uncompressed in the file never go here.
+  // If NULL, vidardb will not use a compressed block cache.
+  std::shared_ptr<Cache> block_cache_compressed = nullptr;
+
+  // If non-NULL use the specified persistent cache for the raw data blocks,
+  // e.g. on a local SSD when the tables are on HDD or network storage, see
+  // NewPersistentCache(). It is looked up when a block is missing from the
+  // block caches, before reading the file, and keeps the blocks read from
+  // the file across restarts.
+  std::shared_ptr<PersistentCache> persistent_cache = nullptr;
+
   // Approximate size of user data packed per block. Note that the
   // block size specified here corresponds to uncompressed data. The
   // actual size of the unit read from disk may be smaller if
@@ -83,6 +99,84 @@ struct BlockBasedTableOptions {
 
   // Same as block_restart_interval but used for the index block.
   int index_block_restart_interval = 1;
+
+  // If non-nullptr, use the specified filter policy to build one filter for
+  // all the keys of each table file. Get() consults it before seeking the
+  // index and reading any data block, which saves the reads for keys that
+  // are not in the file. The filter is loaded together with the index.
+  std::shared_ptr<const FilterPolicy> filter_policy = nullptr;
+
+  // If true, place whole keys in the filter. If false, only the prefixes of
+  // ColumnFamilyOptions::prefix_extractor are placed, which makes the filter
+  // smaller but only serves prefix seeks and the Get() of keys whose prefix
+  // is absent.
+  bool whole_key_filtering = true;
+
+  // The index type that will be used for this table.
+  enum IndexType : char {
+    // A space efficient index block that is optimized for
+    // binary-search-based index.
+    kBinarySearch,
+
+    // The hash index, if enabled, will do the hash lookup when
+    // ColumnFamilyOptions::prefix_extractor is provided: a seek only
+    // searches the index entries of the blocks holding the target's prefix,
+    // and misses an absent prefix without reading any data block. It serves
+    // the seeks with ReadOptions::total_order_seek false, so keys of other
+    // prefixes may not be found after the seeked one. A NewNoopTransform()
+    // extractor hashes the whole keys.
+    kHashSearch,
+
+    // A two-level index: the index is cut into partitions of about
+    // metadata_block_size, each read and cached like a data block, and only
+    // a small top-level index over the partitions is kept for the table.
+    // It bounds the memory and the block cache taken by the index of large
+    // files.
+    kTwoLevelIndexSearch,
+  };
+
+  IndexType index_type = kBinarySearch;
+
+  // Target size of an index partition, only used with kTwoLevelIndexSearch.
+  uint64_t metadata_block_size = 4096;
+
+  // Indicating if we'd put index and filter blocks to the block cache.
+  // If not specified, each table reader keeps them in its own memory as long
+  // as the table is open.
+  bool cache_index_and_filter_blocks = false;
+
+  // Cache the index and filter blocks, and the index partitions, with high
+  // priority. With a block cache created with a high_pri_pool_ratio, they
+  // are then evicted only after the data blocks.
+  bool cache_index_and_filter_blocks_with_high_priority = true;
+
+  // If cache_index_and_filter_blocks is true and this is true, the index
+  // (with all its partitions) and the filter of the level 0 tables are
+  // pinned in the block cache, and only released when the table is closed.
+  bool pin_l0_filter_and_index_blocks_in_cache = false;
+
+  // If cache_index_and_filter_blocks is true and this is true, the top-level
+  // index of kTwoLevelIndexSearch tables of all the levels is pinned in the
+  // block cache, while the partitions are cached like the data blocks.
+  bool pin_top_level_index = false;
+
+  // The index type of the data blocks.
+  enum DataBlockIndexType : char {
+    // The restart array of a data block is binary searched.
+    kDataBlockBinarySearch,
+
+    // A hash table from the user keys to the restart intervals is appended
+    // to the data blocks, so Get() usually skips the binary search. Blocks
+    // over 64KB or with more than 253 restart intervals are left without it.
+    kDataBlockBinaryAndHash,
+  };
+
+  DataBlockIndexType data_block_index_type = kDataBlockBinarySearch;
+
+  // Number of keys per bucket of the data block hash table, only used with
+  // kDataBlockBinaryAndHash. A smaller ratio takes more space, and has fewer
+  // collisions which fall back to the binary search.
+  double data_block_hash_table_util_ratio = 0.75;
 };
 
 // Create default block based table factory.
@@ -110,6 +204,20 @@ struct ColumnTableOptions {
   // If NULL, vidardb will automatically create and use an 8MB internal cache.
   std::shared_ptr<Cache> block_cache = nullptr;
 
+  // If non-NULL use the specified cache for compressed blocks, as a second
+  // tier behind block_cache. A block missing from block_cache is looked up
+  // here and, if found, uncompressed and promoted to block_cache, without
+  // reading the file. Blocks stored uncompressed in the file never go here.
+  // If NULL, vidardb will not use a compressed block cache.
+  std::shared_ptr<Cache> block_cache_compressed = nullptr;
+
+  // If non-NULL use the specified persistent cache for the raw data blocks,
+  // e.g. on a local SSD when the tables are on HDD or network storage, see
+  // NewPersistentCache(). It is looked up when a block is missing from the
+  // block caches, before reading the file, and keeps the blocks read from
+  // the file across restarts.
+  std::shared_ptr<PersistentCache> persistent_cache = nullptr;
+
   // Approximate size of user data packed per block. Note that the
   // block size specified here corresponds to uncompressed data. The
   // actual size of the unit read from disk may be smaller if
@@ -132,6 +240,54 @@ struct ColumnTableOptions {
   // Same as block_restart_interval but used for the index block.
   int index_block_restart_interval = 1;
 
+  // The index type of the main column and of each sub column.
+  enum IndexType : char {
+    // A single index block per column file, holding the min and max values
+    // of every block for the sub columns.
+    kBinarySearch,
+
+    // A two-level index: the index of each column file is cut into
+    // partitions of about metadata_block_size, each read and cached like a
+    // data block, and only a small top-level index over the partitions is
+    // kept for the table. The partitions of a sub column keep the min and
+    // max values of its blocks.
+    kTwoLevelIndexSearch,
+  };
+
+  IndexType index_type = kBinarySearch;
+
+  // Target size of an index partition, only used with kTwoLevelIndexSearch.
+  uint64_t metadata_block_size = 4096;
+
+  // Indicating if we'd put index and filter blocks to the block cache.
+  // If not specified, each table reader keeps them in its own memory as long
+  // as the table is open.
+  bool cache_index_and_filter_blocks = false;
+
+  // Cache the index and filter blocks, and the index partitions, with high
+  // priority. With a block cache created with a high_pri_pool_ratio, they
+  // are then evicted only after the data blocks.
+  bool cache_index_and_filter_blocks_with_high_priority = true;
+
+  // If cache_index_and_filter_blocks is true and this is true, the index
+  // (with all its partitions) and the filter of the level 0 tables are
+  // pinned in the block cache, and only released when the table is closed.
+  bool pin_l0_filter_and_index_blocks_in_cache = false;
+
+  // If cache_index_and_filter_blocks is true and this is true, the top-level
+  // index of kTwoLevelIndexSearch tables of all the levels is pinned in the
+  // block cache, while the partitions are cached like the data blocks.
+  bool pin_top_level_index = false;
+
+  // If non-nullptr, use the specified filter policy to build one filter for
+  // all the user keys of each table file, stored with the main column.
+  // Get() consults it before reading the main column or any sub column.
+  std::shared_ptr<const FilterPolicy> filter_policy = nullptr;
+
+  // If true, place whole keys in the filter. If false, only the prefixes of
+  // ColumnFamilyOptions::prefix_extractor are placed.
+  bool whole_key_filtering = true;
+
   // Total column attribute number (excluding key)
   uint32_t column_count = 0;
 
@@ -37,6 +37,8 @@ struct TablePropertiesNames {
   static const std::string kDataSize;
   static const std::string kRawDataSize;
   static const std::string kIndexSize;
+  static const std::string kIndexPartitions;
+  static const std::string kFilterSize;
   static const std::string kRawKeySize;
   static const std::string kRawValueSize;
   static const std::string kNumDataBlocks;
@@ -48,6 +50,9 @@ struct TablePropertiesNames {
   static const std::string kComparator;
   static const std::string kPropertyCollectors;
   static const std::string kCompression;
+  static const std::string kFilterPolicy;
+  static const std::string kWholeKeyFiltering;
+  static const std::string kPrefixExtractorName;
 };
 
 extern const std::string kPropertiesBlock;
@@ -138,6 +143,10 @@ struct TableProperties {
   uint64_t raw_data_size = 0;
   // the size of index block.
   uint64_t index_size = 0;
+  // the number of index partitions, 0 if the index is a single block.
+  uint64_t index_partitions = 0;
+  // the size of filter block.
+  uint64_t filter_size = 0;
   // total raw key size
   uint64_t raw_key_size = 0;
   // total raw value size
@@ -154,6 +163,9 @@ struct TableProperties {
   // by column_family_name.
   uint64_t column_family_id =
       vidardb::TablePropertiesCollectorFactory::Context::kUnknownColumnFamily;
+  // If 1, the filter block holds the whole user keys; if 0, it only holds
+  // their prefixes. Files without this property hold the whole keys.
+  uint64_t whole_key_filtering = 1;
 
   // Name of the column family with which this SST file is associated.
   // If column family is unknown, `column_family_name` will be an empty string.
@@ -170,6 +182,14 @@ struct TableProperties {
   // The compression algo used to compress the SST files.
   std::string compression_name;
 
+  // The name of the filter policy used in this table.
+  // If no filter policy is used, `filter_policy_name` will be an empty string.
+  std::string filter_policy_name;
+
+  // The name of the prefix extractor whose prefixes are in the filter block.
+  // If the filter holds no prefixes, it will be an empty string.
+  std::string prefix_extractor_name;
+
   // user collected properties
   UserCollectedProperties user_collected_properties;
   UserCollectedProperties readable_properties;
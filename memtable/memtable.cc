@@ -35,6 +35,7 @@
 #include "vidardb/comparator.h"
 #include "vidardb/env.h"
 #include "vidardb/iterator.h"
+#include "vidardb/slice_transform.h"
 #include "vidardb/splitter.h"
 #include "vidardb/table.h"
 
@@ -44,6 +45,10 @@ MemTableOptions::MemTableOptions(const ImmutableCFOptions& ioptions,
                                  const MutableCFOptions& mutable_cf_options)
     : write_buffer_size(mutable_cf_options.write_buffer_size),
       arena_block_size(mutable_cf_options.arena_block_size),
+      memtable_prefix_bloom_bits(static_cast<uint32_t>(std::min<double>(
+          static_cast<double>(mutable_cf_options.write_buffer_size) *
+              ioptions.memtable_prefix_bloom_size_ratio * 8,
+          std::numeric_limits<uint32_t>::max()))),
       statistics(ioptions.statistics),
       info_log(ioptions.info_log),
       splitter(ioptions.splitter) {}
@@ -60,6 +65,7 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
       allocator_(&arena_, write_buffer),
       table_(ioptions.memtable_factory->CreateMemTableRep(
           comparator_, &allocator_, ioptions.info_log)),
+      prefix_extractor_(ioptions.prefix_extractor),
       data_size_(0),
       num_entries_(0),
       num_deletes_(0),
@@ -72,6 +78,13 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
       min_prep_log_referenced_(0),
       flush_state_(FLUSH_NOT_REQUESTED),
       env_(ioptions.env) {
+  if (prefix_extractor_ != nullptr &&
+      moptions_.memtable_prefix_bloom_bits > 0) {
+    prefix_bloom_.reset(new DynamicBloom(&allocator_,
+                                         moptions_.memtable_prefix_bloom_bits,
+                                         6 /* num_probes */,
+                                         moptions_.info_log));
+  }
   UpdateFlushState();
   // something went wrong if we need to flush before inserting anything
   assert(!ShouldScheduleFlush());
@@ -199,9 +212,16 @@ const char* EncodeKey(std::string* scratch, const Slice& target) {
 
 class MemTableIterator : public InternalIterator {
  public:
-  MemTableIterator(const MemTable& mem, const std::vector<uint32_t>& columns,
+  MemTableIterator(const MemTable& mem, const ReadOptions& read_options,
                    Arena* arena)
-      : valid_(false), arena_mode_(arena != nullptr), columns_(columns) {
+      : bloom_(nullptr),
+        prefix_extractor_(mem.prefix_extractor_),
+        valid_(false),
+        arena_mode_(arena != nullptr),
+        columns_(read_options.columns) {
+    if (prefix_extractor_ != nullptr && !read_options.total_order_seek) {
+      bloom_ = mem.prefix_bloom_.get();
+    }
     iter_ = mem.table_->GetIterator(arena);
     splitter_ = mem.GetMemTableOptions()->splitter;
     num_entries_ = mem.num_entries_;
@@ -234,6 +254,17 @@ class MemTableIterator : public InternalIterator {
   virtual void Seek(const Slice& k) override {
     PERF_TIMER_GUARD(seek_on_memtable_time);
     PERF_COUNTER_ADD(seek_on_memtable_count, 1);
+    if (bloom_ != nullptr) {
+      Slice user_key = ExtractUserKey(k);
+      if (prefix_extractor_->InDomain(user_key)) {
+        if (!bloom_->MayContain(prefix_extractor_->Transform(user_key))) {
+          PERF_COUNTER_ADD(bloom_memtable_miss_count, 1);
+          valid_ = false;
+          return;
+        }
+        PERF_COUNTER_ADD(bloom_memtable_hit_count, 1);
+      }
+    }
     iter_->Seek(k, nullptr);
     valid_ = iter_->Valid();
   }
@@ -408,6 +439,8 @@ class MemTableIterator : public InternalIterator {
     return true;
   }
 
+  DynamicBloom* bloom_;
+  const SliceTransform* const prefix_extractor_;
   MemTableRep::Iterator* iter_;
   bool valid_;
   bool arena_mode_;
@@ -426,9 +459,9 @@ InternalIterator* MemTable::NewIterator(const ReadOptions& read_options,
                                         Arena* arena) {
   if (arena) {
     auto mem = arena->AllocateAligned(sizeof(MemTableIterator));
-    return new (mem) MemTableIterator(*this, read_options.columns, arena);
+    return new (mem) MemTableIterator(*this, read_options, arena);
   } else {
-    return new MemTableIterator(*this, read_options.columns, nullptr);
+    return new MemTableIterator(*this, read_options, nullptr);
   }
 }
 
@@ -481,6 +514,10 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   if (!allow_concurrent) {
     table_->Insert(handle);
 
+    if (prefix_bloom_ && prefix_extractor_->InDomain(key)) {
+      prefix_bloom_->Add(prefix_extractor_->Transform(key));
+    }
+
     // this is a bit ugly, but is the way to avoid locked instructions
     // when incrementing an atomic
     num_entries_.store(num_entries_.load(std::memory_order_relaxed) + 1,
@@ -506,6 +543,10 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   } else {
     table_->InsertConcurrently(handle);
 
+    if (prefix_bloom_ && prefix_extractor_->InDomain(key)) {
+      prefix_bloom_->AddConcurrently(prefix_extractor_->Transform(key));
+    }
+
     num_entries_.fetch_add(1, std::memory_order_relaxed);
     data_size_.fetch_add(encoded_len, std::memory_order_relaxed);
     if (type == kTypeDeletion) {
@@ -607,6 +648,15 @@ bool MemTable::Get(ReadOptions& read_options, const LookupKey& key,
   }
   PERF_TIMER_GUARD(get_from_memtable_time);
 
+  Slice user_key = key.user_key();
+  if (prefix_bloom_ && prefix_extractor_->InDomain(user_key)) {
+    if (!prefix_bloom_->MayContain(prefix_extractor_->Transform(user_key))) {
+      PERF_COUNTER_ADD(bloom_memtable_miss_count, 1);
+      return false;
+    }
+    PERF_COUNTER_ADD(bloom_memtable_hit_count, 1);
+  }
+
   bool found_final_value = false;
 
   Saver saver;
@@ -29,6 +29,7 @@
 #include "vidardb/splitter.h"
 #include "memtable/memtable_allocator.h"
 #include "util/concurrent_arena.h"
+#include "util/dynamic_bloom.h"
 #include "util/instrumented_mutex.h"
 #include "util/mutable_cf_options.h"
 
@@ -45,6 +46,7 @@ struct MemTableOptions {
       const MutableCFOptions& mutable_cf_options);
   size_t write_buffer_size;
   size_t arena_block_size;
+  uint32_t memtable_prefix_bloom_bits;
   Statistics* statistics;
   Logger* info_log;
   const Splitter* splitter;
@@ -176,6 +178,11 @@ class MemTable {
     return Get(read_options, key, value, s, &seq);
   }
 
+  // Total encoded size of the entries added so far
+  uint64_t data_size() const {
+    return data_size_.load(std::memory_order_relaxed);
+  }
+
   // Get total number of entries in the mem table.
   // REQUIRES: external synchronization to prevent simultaneous
   // operations on the same MemTable (unless this Memtable is immutable).
@@ -275,6 +282,10 @@ class MemTable {
   MemTableAllocator allocator_;
   unique_ptr<MemTableRep> table_;
 
+  // The prefixes of the keys, if a prefix extractor and a bloom size are set
+  const SliceTransform* const prefix_extractor_;
+  std::unique_ptr<DynamicBloom> prefix_bloom_;
+
   // Total data size of all data inserted
   std::atomic<uint64_t> data_size_;
   std::atomic<uint64_t> num_entries_;
@@ -17,9 +17,17 @@ namespace vidardb {
 
 MemTableAllocator::MemTableAllocator(Allocator* allocator,
                                      WriteBuffer* write_buffer)
-    : allocator_(allocator), write_buffer_(write_buffer), bytes_allocated_(0) {}
+    : allocator_(allocator),
+      write_buffer_(write_buffer),
+      bytes_allocated_(0),
+      done_allocating_(false) {}
 
-MemTableAllocator::~MemTableAllocator() { DoneAllocating(); }
+MemTableAllocator::~MemTableAllocator() {
+  DoneAllocating();
+  if (write_buffer_ != nullptr) {
+    write_buffer_->FreeMem(bytes_allocated_.load(std::memory_order_relaxed));
+  }
+}
 
 char* MemTableAllocator::Allocate(size_t bytes) {
   assert(write_buffer_ != nullptr);
@@ -37,9 +45,10 @@ char* MemTableAllocator::AllocateAligned(size_t bytes, size_t huge_page_size,
 }
 
 void MemTableAllocator::DoneAllocating() {
-  if (write_buffer_ != nullptr) {
-    write_buffer_->FreeMem(bytes_allocated_.load(std::memory_order_relaxed));
-    write_buffer_ = nullptr;
+  if (write_buffer_ != nullptr && !done_allocating_) {
+    write_buffer_->ScheduleFreeMem(
+        bytes_allocated_.load(std::memory_order_relaxed));
+    done_allocating_ = true;
   }
 }
 
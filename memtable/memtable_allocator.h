@@ -32,13 +32,15 @@ class MemTableAllocator : public Allocator {
   size_t BlockSize() const override;
 
   // Call when we're finished allocating memory so we can free it from
-  // the write buffer's limit.
+  // the write buffer's limit. The memory stays accounted in the write
+  // buffer's total usage until the allocator is destroyed.
   void DoneAllocating();
 
  private:
   Allocator* allocator_;
   WriteBuffer* write_buffer_;
   std::atomic<size_t> bytes_allocated_;
+  bool done_allocating_;
 
   // No copying allowed
   MemTableAllocator(const MemTableAllocator&);
@@ -8,12 +8,19 @@
 
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include "util/arena.h"
 #include "memtable/memtable.h"
+#include "vidardb/env.h"
+#include "port/likely.h"
 #include "port/port.h"
 #include "util/mutexlock.h"
+#include "util/random.h"
 
 namespace vidardb {
 namespace {
@@ -32,10 +39,101 @@ struct Compare : private Base {
   }
 };
 
+// Buckets smaller than this are sorted on the calling thread.
+const size_t kParallelSortThreshold = 64 * 1024;
+
+// Runs work(0) .. work(n - 1) on the calling thread and on up to n - 1 jobs
+// in the LOW priority pool of env. The calling thread takes whatever the jobs
+// have not started, so the pool being busy only costs the parallelism, and a
+// job that gets to run after everything is done returns right away.
+void RunInParallel(Env* env, size_t n,
+                   const std::function<void(size_t)>& work) {
+  struct Tasks {
+    const std::function<void(size_t)>* work;
+    size_t n;
+    std::atomic<size_t> next;
+    port::Mutex mu;
+    port::CondVar cv;
+    size_t done;
+
+    Tasks(const std::function<void(size_t)>* w, size_t num)
+        : work(w), n(num), next(0), cv(&mu), done(0) {}
+
+    // Runs the tasks left, returns once there are none to start.
+    void Run() {
+      size_t i;
+      while ((i = next.fetch_add(1)) < n) {
+        (*work)(i);
+        MutexLock l(&mu);
+        if (++done == n) {
+          cv.SignalAll();
+        }
+      }
+    }
+
+    static void BGWork(void* arg) {
+      std::unique_ptr<std::shared_ptr<Tasks>> tasks(
+          static_cast<std::shared_ptr<Tasks>*>(arg));
+      (*tasks)->Run();
+    }
+  };
+
+  auto tasks = std::make_shared<Tasks>(&work, n);
+  for (size_t i = 1; i < n; ++i) {
+    env->Schedule(&Tasks::BGWork, new std::shared_ptr<Tasks>(tasks));
+  }
+  tasks->Run();
+  MutexLock l(&tasks->mu);
+  while (tasks->done < n) {
+    tasks->cv.Wait();
+  }
+}
+
+// Sorts the bucket. With an env, large buckets are cut into one run per core
+// (at most 8), the runs are sorted in parallel and then merged pairwise, also
+// in parallel.
+void SortBucket(std::vector<const char*>* bucket,
+                const MemTableRep::KeyComparator& compare, Env* env) {
+  Compare cmp(compare);
+  size_t num_runs = std::min(std::thread::hardware_concurrency(), 8u);
+  if (env == nullptr || bucket->size() < kParallelSortThreshold ||
+      num_runs < 2) {
+    std::sort(bucket->begin(), bucket->end(), cmp);
+    return;
+  }
+
+  auto begin = bucket->begin();
+  size_t run_size = (bucket->size() + num_runs - 1) / num_runs;
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i < bucket->size(); i += run_size) {
+    bounds.push_back(i);
+  }
+  bounds.push_back(bucket->size());
+
+  RunInParallel(env, bounds.size() - 1, [&](size_t i) {
+    std::sort(begin + bounds[i], begin + bounds[i + 1], cmp);
+  });
+
+  // bounds[i] .. bounds[i + 1] are sorted runs, merge neighbours until only
+  // one run is left
+  while (bounds.size() > 2) {
+    RunInParallel(env, (bounds.size() - 1) / 2, [&](size_t i) {
+      std::inplace_merge(begin + bounds[2 * i], begin + bounds[2 * i + 1],
+                         begin + bounds[2 * i + 2], cmp);
+    });
+    std::vector<size_t> merged;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+      merged.push_back(bounds[i]);
+    }
+    merged.push_back(bounds.back());
+    bounds.swap(merged);
+  }
+}
+
 class VectorRep : public MemTableRep {
  public:
   VectorRep(const KeyComparator& compare, MemTableAllocator* allocator,
-            size_t count);
+            size_t count, Env* env);
 
   // Insert key into the collection. (The caller will pack key and value into a
   // single buffer and pass that in as the parameter to Insert)
@@ -43,6 +141,11 @@ class VectorRep : public MemTableRep {
   // collection.
   virtual void Insert(KeyHandle handle) override;
 
+  // Appends key to the buffer of the current core. The buffers are merged
+  // into the main bucket before the next read or when the memtable becomes
+  // read only, so concurrent writers never wait on rwlock_.
+  virtual void InsertConcurrently(KeyHandle handle) override;
+
   // Returns true iff an entry that compares equal to key is in the collection.
   virtual bool Contains(const char* key) const override;
 
@@ -54,20 +157,21 @@ class VectorRep : public MemTableRep {
                    bool (*callback_func)(void* arg,
                                          const char* entry)) override;
 
-  virtual ~VectorRep() override { }
+  virtual ~VectorRep() override;
 
   class Iterator : public MemTableRep::Iterator {
     class VectorRep* vrep_;
     std::shared_ptr<std::vector<const char*>> bucket_;
     std::vector<const char*>::const_iterator mutable cit_;
     const KeyComparator& compare_;
+    Env* env_;              // for SortBucket(), may be nullptr
     std::string tmp_;       // For passing to EncodeKey
     bool mutable sorted_;
     void DoSort() const;
    public:
     explicit Iterator(class VectorRep* vrep,
       std::shared_ptr<std::vector<const char*>> bucket,
-      const KeyComparator& compare);
+      const KeyComparator& compare, Env* env);
 
     // Initialize an iterator over the specified collection.
     // The returned iterator is not valid.
@@ -107,55 +211,149 @@ class VectorRep : public MemTableRep {
  private:
   friend class Iterator;
   typedef std::vector<const char*> Bucket;
+
+  // Append buffer of concurrent inserts
+  struct ShardData {
+    SpinMutex mutex;
+    Bucket entries;
+  };
+
+  // Padded to whole cache lines to avoid false sharing
+  struct Shard : public ShardData {
+    char padding[CACHE_LINE_SIZE - sizeof(ShardData) % CACHE_LINE_SIZE]
+        VIDARDB_FIELD_UNUSED;
+  };
+  static_assert(sizeof(Shard) % CACHE_LINE_SIZE == 0,
+                "shards should not share cache lines");
+
+  // Moves the keys of all shards into bucket_
+  void MergeShards() const;
+
   std::shared_ptr<Bucket> bucket_;
   mutable port::RWMutex rwlock_;
-  bool immutable_;
+  // written under rwlock_, atomic for the checks of InsertConcurrently()
+  std::atomic<bool> immutable_;
   bool sorted_;
   const KeyComparator& compare_;
+  Env* const env_;  // may be nullptr
+
+  // shards_[i & index_mask_] is valid
+  size_t index_mask_;
+  // the shards, aligned to a cache line in shards_buf_
+  Shard* shards_;
+  std::unique_ptr<char[]> shards_buf_;
+  // Number of keys sitting in shards_ and not yet merged into bucket_
+  mutable std::atomic<size_t> num_pending_;
 };
 
+void VectorRep::InsertConcurrently(KeyHandle handle) {
+  auto* key = static_cast<char*>(handle);
+  int cpuid = port::PhysicalCoreID();
+  if (UNLIKELY(cpuid < 0)) {
+    // cpu id unavailable, just pick randomly
+    cpuid =
+        Random::GetTLSInstance()->Uniform(static_cast<int>(index_mask_) + 1);
+  }
+  // another thread got scheduled on the same core in between, move on to the
+  // next shard rather than spin
+  Shard* s = &shards_[cpuid & index_mask_];
+  while (!s->mutex.try_lock()) {
+    s = &shards_[++cpuid & index_mask_];
+  }
+  assert(!immutable_.load(std::memory_order_relaxed));
+  s->entries.push_back(key);
+  num_pending_.fetch_add(1, std::memory_order_relaxed);
+  s->mutex.unlock();
+}
+
+void VectorRep::MergeShards() const {
+  if (num_pending_.load(std::memory_order_acquire) == 0) {
+    return;
+  }
+  WriteLock l(&rwlock_);
+  for (size_t i = 0; i <= index_mask_; ++i) {
+    Shard* s = &shards_[i];
+    std::lock_guard<SpinMutex> guard(s->mutex);
+    if (s->entries.empty()) {
+      continue;
+    }
+    bucket_->insert(bucket_->end(), s->entries.begin(), s->entries.end());
+    num_pending_.fetch_sub(s->entries.size(), std::memory_order_relaxed);
+    s->entries.clear();
+  }
+}
+
 void VectorRep::Insert(KeyHandle handle) {
   auto* key = static_cast<char*>(handle);
   WriteLock l(&rwlock_);
-  assert(!immutable_);
+  assert(!immutable_.load(std::memory_order_relaxed));
   bucket_->push_back(key);
 }
 
 // Returns true iff an entry that compares equal to key is in the collection.
 bool VectorRep::Contains(const char* key) const {
+  MergeShards();
   ReadLock l(&rwlock_);
   return std::find(bucket_->begin(), bucket_->end(), key) != bucket_->end();
 }
 
 void VectorRep::MarkReadOnly() {
+  MergeShards();
   WriteLock l(&rwlock_);
-  immutable_ = true;
+  immutable_.store(true, std::memory_order_relaxed);
 }
 
 size_t VectorRep::ApproximateMemoryUsage() {
   return
     sizeof(bucket_) + sizeof(*bucket_) +
-    bucket_->size() *
+    (bucket_->size() + num_pending_.load(std::memory_order_relaxed)) *
     sizeof(
       std::remove_reference<decltype(*bucket_)>::type::value_type
     );
 }
 
 VectorRep::VectorRep(const KeyComparator& compare, MemTableAllocator* allocator,
-                     size_t count)
+                     size_t count, Env* env)
   : MemTableRep(allocator),
     bucket_(new Bucket()),
     immutable_(false),
     sorted_(false),
-    compare_(compare) { bucket_.get()->reserve(count); }
+    compare_(compare),
+    env_(env),
+    num_pending_(0) {
+  bucket_.get()->reserve(count);
+  // find a power of two >= num_cpus and >= 8
+  auto num_cpus = std::thread::hardware_concurrency();
+  index_mask_ = 7;
+  while (index_mask_ + 1 < num_cpus) {
+    index_mask_ = index_mask_ * 2 + 1;
+  }
+  size_t num_shards = index_mask_ + 1;
+  shards_buf_.reset(new char[(num_shards + 1) * sizeof(Shard)]);
+  char* buf = shards_buf_.get();
+  size_t misalignment =
+      reinterpret_cast<uintptr_t>(buf) & (CACHE_LINE_SIZE - 1);
+  shards_ = reinterpret_cast<Shard*>(
+      misalignment == 0 ? buf : buf + CACHE_LINE_SIZE - misalignment);
+  for (size_t i = 0; i < num_shards; ++i) {
+    new (&shards_[i]) Shard();
+  }
+}
+
+VectorRep::~VectorRep() {
+  for (size_t i = 0; i <= index_mask_; ++i) {
+    shards_[i].~Shard();
+  }
+}
 
 VectorRep::Iterator::Iterator(class VectorRep* vrep,
                    std::shared_ptr<std::vector<const char*>> bucket,
-                   const KeyComparator& compare)
+                   const KeyComparator& compare, Env* env)
 : vrep_(vrep),
   bucket_(bucket),
   cit_(bucket_->end()),
   compare_(compare),
+  env_(env),
   sorted_(false) { }
 
 void VectorRep::Iterator::DoSort() const {
@@ -163,14 +361,14 @@ void VectorRep::Iterator::DoSort() const {
   if (!sorted_ && vrep_ != nullptr) {
     WriteLock l(&vrep_->rwlock_);
     if (!vrep_->sorted_) {
-      std::sort(bucket_->begin(), bucket_->end(), Compare(compare_));
+      SortBucket(bucket_.get(), compare_, env_);
       cit_ = bucket_->begin();
       vrep_->sorted_ = true;
     }
     sorted_ = true;
   }
   if (!sorted_) {
-    std::sort(bucket_->begin(), bucket_->end(), Compare(compare_));
+    SortBucket(bucket_.get(), compare_, env_);
     cit_ = bucket_->begin();
     sorted_ = true;
   }
@@ -249,6 +447,7 @@ void VectorRep::Iterator::SeekToLast() {
 
 void VectorRep::Get(const LookupKey& k, void* callback_args,
                     bool (*callback_func)(void* arg, const char* entry)) {
+  MergeShards();
   rwlock_.ReadLock();
   VectorRep* vector_rep;
   std::shared_ptr<Bucket> bucket;
@@ -258,7 +457,8 @@ void VectorRep::Get(const LookupKey& k, void* callback_args,
     vector_rep = nullptr;
     bucket.reset(new Bucket(*bucket_));  // make a copy
   }
-  VectorRep::Iterator iter(vector_rep, immutable_ ? bucket_ : bucket, compare_);
+  VectorRep::Iterator iter(vector_rep, immutable_ ? bucket_ : bucket, compare_,
+                           env_);
   rwlock_.ReadUnlock();
 
   for (iter.Seek(k.user_key(), k.memtable_key().data());
@@ -271,22 +471,23 @@ MemTableRep::Iterator* VectorRep::GetIterator(Arena* arena) {
   if (arena != nullptr) {
     mem = arena->AllocateAligned(sizeof(Iterator));
   }
+  MergeShards();
   ReadLock l(&rwlock_);
   // Do not sort here. The sorting would be done the first time
   // a Seek is performed on the iterator.
   if (immutable_) {
     if (arena == nullptr) {
-      return new Iterator(this, bucket_, compare_);
+      return new Iterator(this, bucket_, compare_, env_);
     } else {
-      return new (mem) Iterator(this, bucket_, compare_);
+      return new (mem) Iterator(this, bucket_, compare_, env_);
     }
   } else {
     std::shared_ptr<Bucket> tmp;
     tmp.reset(new Bucket(*bucket_)); // make a copy
     if (arena == nullptr) {
-      return new Iterator(nullptr, tmp, compare_);
+      return new Iterator(nullptr, tmp, compare_, env_);
     } else {
-      return new (mem) Iterator(nullptr, tmp, compare_);
+      return new (mem) Iterator(nullptr, tmp, compare_, env_);
     }
   }
 }
@@ -295,7 +496,7 @@ MemTableRep::Iterator* VectorRep::GetIterator(Arena* arena) {
 MemTableRep* VectorRepFactory::CreateMemTableRep(
     const MemTableRep::KeyComparator& compare, MemTableAllocator* allocator,
     Logger* logger) {
-  return new VectorRep(compare, allocator, count_);
+  return new VectorRep(compare, allocator, count_, env_);
 }
 } // namespace vidardb
 #endif  // VIDARDB_LITE
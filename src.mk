@@ -25,6 +25,8 @@ LIB_SOURCES =                                                   \
   db/internal_stats.cc                                          \
   db/log_reader.cc                                              \
   db/log_writer.cc                                              \
+  db/operation_tracer.cc                                        \
+  db/query_tracer.cc                                            \
   memtable/memtable_allocator.cc                                \
   memtable/memtable.cc                                          \
   memtable/memtable_list.cc                                     \
@@ -40,6 +42,7 @@ LIB_SOURCES =                                                   \
   db/write_batch.cc                                             \
   db/write_controller.cc                                        \
   db/write_thread.cc                                            \
+  db/writebuffer.cc                                             \
   memtable/skiplistrep.cc                                       \
   memtable/vectorrep.cc                                         \
   port/stack_trace.cc                                           \
@@ -53,21 +56,31 @@ LIB_SOURCES =                                                   \
   table/column_table_reader.cc                                  \
   table/block_builder.cc                                        \
   table/block.cc                                                \
+  table/block_prefetcher.cc                                     \
+  table/block_prefix_index.cc                                   \
+  table/data_block_hash_index.cc                                \
   table/main_column_block_builder.cc                            \
   table/sub_column_block_builder.cc                             \
   table/min_max_block_builder.cc                                \
   table/flush_block_policy.cc                                   \
   table/format.cc                                               \
+  table/full_filter_block.cc                                    \
   table/get_context.cc                                          \
   table/iterator.cc                                             \
   table/merger.cc                                               \
   table/meta_blocks.cc                                          \
+  table/persistent_cache_helper.cc                              \
+  table/read_amp_stats.cc                                       \
   table/sst_file_writer.cc                                      \
   table/table_properties.cc                                     \
   table/two_level_iterator.cc                                   \
   util/arena.cc                                                 \
+  util/block_access_tracer.cc                                   \
+  util/bloom.cc                                                 \
   util/build_version.cc                                         \
   util/cache.cc                                                 \
+  util/cache_simulator.cc                                       \
+  util/clock_cache.cc                                           \
   util/coding.cc                                                \
   util/comparator.cc                                            \
   util/splitter.cc                                              \
@@ -75,6 +88,7 @@ LIB_SOURCES =                                                   \
   util/concurrent_arena.cc                                      \
   util/crc32c.cc                                                \
   util/delete_scheduler.cc                                      \
+  util/dynamic_bloom.cc                                         \
   util/env.cc                                                   \
   util/env_posix.cc                                             \
   util/io_posix.cc                                              \
@@ -98,6 +112,7 @@ LIB_SOURCES =                                                   \
   util/perf_context.cc                                          \
   util/perf_level.cc                                            \
   util/random.cc                                                \
+  util/rate_limiter.cc                                          \
   util/slice.cc                                                 \
   util/statistics.cc                                            \
   util/status.cc                                                \
@@ -110,6 +125,7 @@ LIB_SOURCES =                                                   \
   util/thread_status_updater_debug.cc                           \
   util/thread_status_util.cc                                    \
   util/thread_status_util_debug.cc                              \
+  util/trace_file.cc                                            \
   utilities/write_batch_with_index/write_batch_with_index.cc    \
   utilities/write_batch_with_index/write_batch_with_index_internal.cc    \
   utilities/transactions/transaction_db_mutex_impl.cc           \
@@ -118,6 +134,7 @@ LIB_SOURCES =                                                   \
   utilities/transactions/transaction_impl.cc                    \
   utilities/transactions/transaction_lock_mgr.cc                \
   utilities/transactions/transaction_db_impl.cc                 \
+  utilities/persistent_cache/block_cache_tier.cc                \
 
 TOOL_SOURCES = \
 
@@ -152,6 +169,15 @@ TEST_BENCH_SOURCES =                                                         \
   test/db/db_tailing_iter_test.cc                                            \
   test/db/db_universal_compaction_test.cc                                    \
   test/db/db_wal_test.cc                                                     \
+  test/db/db_bloom_filter_test.cc                                            \
+  test/db/db_direct_io_test.cc                                               \
+  test/db/db_flush_test.cc                                                   \
+  test/db/db_pinning_test.cc                                                 \
+  test/db/db_write_test.cc                                                   \
+  test/db/db_range_query_test.cc                                             \
+  test/db/db_table_loading_test.cc                                           \
+  test/db/db_operation_trace_test.cc                                         \
+  test/db/db_read_amp_test.cc                                                \
   test/db/db_table_properties_test.cc                                        \
   test/db/deletefile_test.cc                                                 \
   test/db/fault_injection_test.cc                                            \
@@ -174,25 +200,36 @@ TEST_BENCH_SOURCES =                                                         \
   test/db/wal_manager_test.cc                                                \
   test/db/write_batch_test.cc                                                \
   test/db/write_controller_test.cc                                           \
+  test/db/writebuffer_test.cc                                                \
+  test/memtable/vectorrep_test.cc                                            \
   test/table/block_test.cc                                                   \
+  test/table/data_block_hash_index_test.cc                                   \
+  test/table/block_prefetcher_test.cc                                        \
   test/table/merger_test.cc                                                  \
+  test/table/partitioned_index_test.cc                                       \
   table/table_reader_bench.cc                                                \
   test/table/table_test.cc                                                   \
   test/tools/db_bench_tool_test.cc                                           \
   test/tools/db_sanity_test.cc                                               \
   test/util/arena_test.cc                                                    \
+  test/util/bloom_test.cc                                                    \
   test/util/cache_bench.cc                                                   \
   test/util/cache_test.cc                                                    \
+  test/util/persistent_cache_test.cc                                         \
   test/util/coding_test.cc                                                   \
   test/util/crc32c_test.cc                                                   \
+  test/util/dynamic_bloom_test.cc                                            \
   test/util/env_test.cc                                                      \
   test/util/filelock_test.cc                                                 \
   test/util/histogram_test.cc                                                \
+  test/util/statistics_test.cc                                               \
+  test/util/block_access_tracer_test.cc                                      \
   test/utilities/env_registry_test.cc                                        \
   test/util/iostats_context_test.cc                                          \
   util/log_write_bench.cc                                                    \
   test/util/mock_env_test.cc                                                 \
   test/util/options_test.cc                                                  \
+  test/util/rate_limiter_test.cc                                             \
   test/util/event_logger_test.cc                                             \
   test/util/testharness.cc                                                   \
   test/util/testutil.cc                                                      \
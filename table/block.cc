@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "vidardb/comparator.h"
+#include "table/block_prefix_index.h"
 #include "table/format.h"
 #include "util/coding.h"
 #include "util/logging.h"
@@ -31,7 +32,9 @@ BlockIter::BlockIter()
       num_restarts_(0),
       current_(0),
       restart_index_(0),
-      status_(Status::OK()) {}
+      status_(Status::OK()),
+      data_block_hash_index_(nullptr),
+      prefix_index_(nullptr) {}
 
 BlockIter::BlockIter(const Comparator* comparator, const char* data,
                      uint32_t restarts, uint32_t num_restarts)
@@ -40,7 +43,9 @@ BlockIter::BlockIter(const Comparator* comparator, const char* data,
 }
 
 void BlockIter::Initialize(const Comparator* comparator, const char* data,
-                           uint32_t restarts, uint32_t num_restarts) {
+                           uint32_t restarts, uint32_t num_restarts,
+                           const DataBlockHashIndex* data_block_hash_index,
+                           const BlockPrefixIndex* prefix_index) {
   //  assert(data_ == nullptr);  // Now we allow it to get called multiple times
   // as long as its resource is released
   assert(num_restarts > 0);  // Ensure the param is valid
@@ -51,6 +56,8 @@ void BlockIter::Initialize(const Comparator* comparator, const char* data,
   num_restarts_ = num_restarts;
   current_ = restarts_;
   restart_index_ = num_restarts_;
+  data_block_hash_index_ = data_block_hash_index;
+  prefix_index_ = prefix_index;
 }
 
 #ifndef NDEBUG
@@ -88,7 +95,9 @@ void BlockIter::Seek(const Slice& target) {
     return;
   }
   uint32_t index = 0;
-  bool ok = BinarySeek(target, 0, num_restarts_ - 1, &index);
+  bool ok = prefix_index_ != nullptr
+                ? PrefixSeek(target, &index)
+                : BinarySeek(target, 0, num_restarts_ - 1, &index);
   if (!ok) {
     return;
   }
@@ -102,6 +111,103 @@ void BlockIter::Seek(const Slice& target) {
   }
 }
 
+bool BlockIter::SeekForGet(const Slice& target) {
+  if (data_block_hash_index_ == nullptr) {
+    Seek(target);
+    return true;
+  }
+
+  PERF_TIMER_GUARD(block_seek_nanos);
+  if (data_ == nullptr) {  // Not init yet
+    return true;
+  }
+  Slice target_user_key = ExtractUserKey(target);
+  uint32_t map_offset = restarts_ + num_restarts_ * sizeof(uint32_t);
+  uint8_t entry =
+      data_block_hash_index_->Lookup(data_, map_offset, target_user_key);
+  if (entry == kCollision) {
+    // the hash table can't tell, fall back to the binary search
+    Seek(target);
+    return true;
+  }
+  if (entry == kNoEntry) {
+    // The user key is not in this block, but it may be in the next one if it
+    // is larger than all the keys here, so search the last restart interval.
+    entry = static_cast<uint8_t>(num_restarts_ - 1);
+  }
+  if (entry >= num_restarts_) {
+    CorruptionError();
+    return true;
+  }
+
+  // Since a user key in several restart intervals is a collision, the
+  // versions of the user key are all in the interval of entry, and the
+  // linear search stops in it unless they are all smaller than target.
+  SeekToRestartPoint(entry);
+  while (true) {
+    if (!ParseNextKey()) {
+      // the end of the block, the user key may be in the next block
+      return true;
+    }
+    if (Compare(key_.GetKey(), target) >= 0) {
+      break;
+    }
+  }
+  // a different user key stops the search in this block, so the target
+  // can't be in any following block either
+  return ExtractUserKey(key_.GetKey()) == target_user_key;
+}
+
+bool BlockIter::PrefixSeek(const Slice& target, uint32_t* index) {
+  assert(prefix_index_ != nullptr);
+  uint32_t left = 0, right = 0;
+  if (!prefix_index_->GetBlockRange(target, &left, &right) ||
+      left >= num_restarts_) {
+    // no key of the prefix in the table
+    current_ = restarts_;
+    restart_index_ = num_restarts_;
+    return false;
+  }
+  right = std::min(right, num_restarts_ - 1);
+
+  // Binary search for the first index entry >= target in [left, right]. The
+  // index block has one entry per restart interval, so no linear search.
+  while (true) {
+    uint32_t mid = left + (right - left) / 2;
+    uint32_t region_offset = GetRestartPoint(mid);
+    uint32_t shared, non_shared, value_length;
+    const char* key_ptr =
+        DecodeEntry(data_ + region_offset, data_ + restarts_, &shared,
+                    &non_shared, &value_length);
+    if (key_ptr == nullptr || (shared != 0)) {
+      CorruptionError();
+      return false;
+    }
+    int cmp = Compare(Slice(key_ptr, non_shared), target);
+    if (left == right) {
+      if (cmp < 0) {
+        // The keys of the prefix are all smaller than target, so the next
+        // index entry is the first one >= target.
+        left++;
+      }
+      break;
+    }
+    if (cmp < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+
+  if (left >= num_restarts_) {
+    current_ = restarts_;
+    restart_index_ = num_restarts_;
+    return false;
+  }
+  *index = left;
+  return true;
+}
+
 void BlockIter::SeekToFirst() {
   if (data_ == nullptr) {  // Not init yet
     return;
@@ -251,7 +357,7 @@ void MainColumnBlockIter::CorruptionError() {
   BlockIter::CorruptionError();
   has_val_ = false;
   int_val_ = 0;
-  str_val_.empty();
+  str_val_.clear();
 }
 
 // Binary search in restart array to find the first restart point
@@ -304,19 +410,38 @@ void MinMaxBlockIter::CorruptionError() {
 
 uint32_t Block::NumRestarts() const {
   assert(size_ >= 2 * sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+  uint32_t block_footer = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+  uint32_t num_restarts = 0;
+  UnPackIndexTypeAndNumRestarts(block_footer, nullptr, &num_restarts);
+  return num_restarts;
 }
 
 Block::Block(BlockContents&& contents)
     : contents_(std::move(contents)),
       data_(contents_.data.data()),
-      size_(contents_.data.size()) {
+      size_(contents_.data.size()),
+      restart_offset_(0),
+      num_restarts_(0) {
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
   } else {
-    restart_offset_ =
-        static_cast<uint32_t>(size_) - (1 + NumRestarts()) * sizeof(uint32_t);
-    if (restart_offset_ > size_ - sizeof(uint32_t)) {
+    uint32_t block_footer = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+    BlockIndexType index_type = kBinarySearchOnly;
+    UnPackIndexTypeAndNumRestarts(block_footer, &index_type, &num_restarts_);
+    uint32_t restarts_end = static_cast<uint32_t>(size_) - sizeof(uint32_t);
+    if (index_type == kBinaryAndHash) {
+      uint16_t map_offset = 0;
+      if (restarts_end >= kMaxBlockSizeSupportedByHashIndex ||
+          !data_block_hash_index_.Initialize(
+              data_, static_cast<uint16_t>(restarts_end), &map_offset)) {
+        size_ = 0;  // Error marker
+        return;
+      }
+      restarts_end = map_offset;
+    }
+    restart_offset_ = restarts_end - num_restarts_ * sizeof(uint32_t);
+    if (restart_offset_ > restarts_end ||
+        num_restarts_ > size_ / sizeof(uint32_t)) {
       // The size is too small for NumRestarts() and therefore
       // restart_offset_ wrapped around.
       size_ = 0;
@@ -325,7 +450,8 @@ Block::Block(BlockContents&& contents)
 }
 
 InternalIterator* Block::NewIterator(const Comparator* cmp, BlockIter* iter,
-                                     BlockType type) {
+                                     BlockType type,
+                                     const BlockPrefixIndex* prefix_index) {
   if (size_ < 2*sizeof(uint32_t)) {
     if (iter != nullptr) {
       iter->SetStatus(Status::Corruption("bad block contents"));
@@ -334,7 +460,7 @@ InternalIterator* Block::NewIterator(const Comparator* cmp, BlockIter* iter,
       return NewErrorInternalIterator(Status::Corruption("bad block contents"));
     }
   }
-  const uint32_t num_restarts = NumRestarts();
+  const uint32_t num_restarts = num_restarts_;
   if (num_restarts == 0) {
     if (iter != nullptr) {
       iter->SetStatus(Status::OK());
@@ -343,12 +469,19 @@ InternalIterator* Block::NewIterator(const Comparator* cmp, BlockIter* iter,
       return NewEmptyInternalIterator();
     }
   } else {
+    const DataBlockHashIndex* data_block_hash_index =
+        data_block_hash_index_.Valid() ? &data_block_hash_index_ : nullptr;
     if (iter != nullptr) {
-      iter->Initialize(cmp, data_, restart_offset_, num_restarts);
+      iter->Initialize(cmp, data_, restart_offset_, num_restarts,
+                       data_block_hash_index, prefix_index);
     } else {
       switch (type) {
-        case kTypeBlock:
-          return new BlockIter(cmp, data_, restart_offset_, num_restarts);
+        case kTypeBlock: {
+          BlockIter* block_iter = new BlockIter();
+          block_iter->Initialize(cmp, data_, restart_offset_, num_restarts,
+                                 data_block_hash_index, prefix_index);
+          return block_iter;
+        }
         case kTypeMainColumn:
           return new MainColumnBlockIter(cmp, data_, restart_offset_,
                                          num_restarts);
@@ -18,6 +18,7 @@
 #include "db/pinned_iterators_manager.h"
 #include "vidardb/iterator.h"
 #include "vidardb/options.h"
+#include "table/data_block_hash_index.h"
 #include "table/internal_iterator.h"
 
 #include "format.h"
@@ -27,6 +28,7 @@ namespace vidardb {
 struct BlockContents;
 class Comparator;
 class BlockIter;
+class BlockPrefixIndex;
 
 class Block {
  public:
@@ -65,9 +67,14 @@ class Block {
 
   // If iter is null, return new Iterator
   // If iter is not null, update this one and return it as Iterator*
+  //
+  // If prefix_index is not nullptr, the block is an index block of restart
+  // interval 1 and the iterator seeks the blocks of the target's prefix
+  // instead of binary searching all the index entries.
   InternalIterator* NewIterator(const Comparator* comparator,
                                 BlockIter* iter = nullptr,
-                                BlockType type = kTypeBlock);
+                                BlockType type = kTypeBlock,
+                                const BlockPrefixIndex* prefix_index = nullptr);
 
   // Report an approximation of how much memory has been used.
   size_t ApproximateMemoryUsage() const;
@@ -77,6 +84,8 @@ class Block {
   const char* data_;            // contents_.data.data()
   size_t size_;                 // contents_.data.size()
   uint32_t restart_offset_;     // Offset in data_ of restart array
+  uint32_t num_restarts_;
+  DataBlockHashIndex data_block_hash_index_;
 
   // No copying allowed
   Block(const Block&);
@@ -91,7 +100,9 @@ class BlockIter : public InternalIterator {
             uint32_t num_restarts);
 
   void Initialize(const Comparator* comparator, const char* data,
-                  uint32_t restarts, uint32_t num_restarts);
+                  uint32_t restarts, uint32_t num_restarts,
+                  const DataBlockHashIndex* data_block_hash_index = nullptr,
+                  const BlockPrefixIndex* prefix_index = nullptr);
 
   void SetStatus(Status s) { status_ = s; }
 
@@ -118,6 +129,13 @@ class BlockIter : public InternalIterator {
 
   virtual void Seek(const Slice& target) override;
 
+  // Seek for a point lookup of the internal key target. With the hash index
+  // of a data block, only the restart interval of the target's user key is
+  // searched. Returns false if the user key is known to be neither in this
+  // block nor in the following ones; otherwise the iterator is positioned
+  // as by Seek(), or is invalid if the user key may be in the next block.
+  bool SeekForGet(const Slice& target);
+
   virtual void SeekToFirst() override;
 
   virtual void SeekToLast() override;
@@ -147,6 +165,8 @@ class BlockIter : public InternalIterator {
   IterKey key_;
   Slice value_;
   Status status_;
+  const DataBlockHashIndex* data_block_hash_index_;
+  const BlockPrefixIndex* prefix_index_;
 
   int Compare(const Slice& a, const Slice& b) const {
     return comparator_->Compare(a, b);
@@ -214,6 +234,10 @@ class BlockIter : public InternalIterator {
   virtual bool BinarySeek(const Slice& target, uint32_t left, uint32_t right,
                           uint32_t* index);
 
+  // Find the first index entry >= target among the blocks of the target's
+  // prefix, see BlockPrefixIndex. Returns false if there is none.
+  bool PrefixSeek(const Slice& target, uint32_t* index);
+
   // Helper routine: decode the next block entry starting at "p",
   // storing the number of shared key bytes, non_shared key bytes,
   // and the length of the value in "*shared", "*non_shared", and
@@ -353,7 +377,7 @@ class MainColumnBlockIter final : public BlockIter {
 
     has_val_ = false;
     int_val_ = 0;
-    str_val_.empty();
+    str_val_.clear();
   }
 
   virtual void CorruptionError() override;
@@ -368,6 +392,7 @@ class MainColumnBlockIter final : public BlockIter {
       value_ = Slice(key_.GetKey().data() + key_.GetKey().size(), value_length);
       GetFixed32BigEndian(&value_, &int_val_);
     } else {
+      str_val_.clear();
       PutFixed32BigEndian(&str_val_, ++int_val_);
       value_ = Slice(str_val_);
     }
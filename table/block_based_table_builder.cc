@@ -24,6 +24,7 @@
 #include "table/block_based_table_reader.h"
 #include "table/block_builder.h"
 #include "table/format.h"
+#include "table/full_filter_block.h"
 #include "table/index_builder.h"
 #include "table/meta_blocks.h"
 #include "table/table_builder.h"
@@ -35,6 +36,7 @@
 #include "vidardb/cache.h"
 #include "vidardb/comparator.h"
 #include "vidardb/env.h"
+#include "vidardb/filter_policy.h"
 #include "vidardb/flush_block_policy.h"
 #include "vidardb/table.h"
 
@@ -45,8 +47,20 @@ namespace vidardb {
 namespace {
 
 // Create a index builder based on its type.
-IndexBuilder* CreateIndexBuilder(const Comparator* comparator,
-                                 int index_block_restart_interval) {
+IndexBuilder* CreateIndexBuilder(BlockBasedTableOptions::IndexType index_type,
+                                 const Comparator* comparator,
+                                 const SliceTransform* prefix_extractor,
+                                 int index_block_restart_interval,
+                                 uint64_t metadata_block_size) {
+  // the table factory rejects a hash index without a prefix extractor
+  if (index_type == BlockBasedTableOptions::kHashSearch &&
+      prefix_extractor != nullptr) {
+    return new HashIndexBuilder(comparator, prefix_extractor);
+  }
+  if (index_type == BlockBasedTableOptions::kTwoLevelIndexSearch) {
+    return new PartitionedIndexBuilder(comparator, index_block_restart_interval,
+                                       metadata_block_size);
+  }
   return new ShortenedIndexBuilder(comparator, index_block_restart_interval);
 }
 
@@ -122,6 +136,7 @@ struct BlockBasedTableBuilder::Rep {
   BlockBuilder data_block;
 
   std::unique_ptr<IndexBuilder> index_builder;
+  std::unique_ptr<FullFilterBlockBuilder> filter_builder;
 
   std::string last_key;
   const CompressionType compression_type;
@@ -155,10 +170,15 @@ struct BlockBasedTableBuilder::Rep {
         table_options(table_opt),
         internal_comparator(icomparator),
         file(f),
-        data_block(table_options.block_restart_interval),
-        index_builder(
-            CreateIndexBuilder(&internal_comparator,
-                               table_options.index_block_restart_interval)),
+        data_block(table_options.block_restart_interval,
+                   table_options.data_block_index_type ==
+                       BlockBasedTableOptions::kDataBlockBinaryAndHash,
+                   table_options.data_block_hash_table_util_ratio),
+        index_builder(CreateIndexBuilder(
+            table_options.index_type, &internal_comparator,
+            _ioptions.prefix_extractor,
+            table_options.index_block_restart_interval,
+            table_options.metadata_block_size)),
         compression_type(_compression_type),
         compression_opts(_compression_opts),
         compression_dict(_compression_dict),
@@ -167,6 +187,13 @@ struct BlockBasedTableBuilder::Rep {
                 table_options, data_block)),
         column_family_id(_column_family_id),
         column_family_name(_column_family_name) {
+    if (table_options.filter_policy != nullptr) {
+      filter_builder.reset(new FullFilterBlockBuilder(
+          ioptions.prefix_extractor,
+          table_options.whole_key_filtering ||
+              ioptions.prefix_extractor == nullptr,
+          table_options.filter_policy->GetFilterBitsBuilder()));
+    }
     for (auto& collector_factories : *int_tbl_prop_collector_factories) {
       table_properties_collectors.emplace_back(
           collector_factories->CreateIntTblPropCollector(column_family_id));
@@ -221,6 +248,10 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
     }
   }
 
+  if (r->filter_builder != nullptr) {
+    r->filter_builder->Add(ExtractUserKey(key));
+  }
+
   r->last_key.assign(key.data(), key.size());
   r->data_block.Add(key, value);
   r->props.num_entries++;
@@ -329,16 +360,38 @@ Status BlockBasedTableBuilder::Finish() {
 
   IndexBuilder::IndexBlocks index_blocks;
   auto s = r->index_builder->Finish(&index_blocks);
-  if (!s.ok()) {
+  if (!s.ok() && !s.IsIncomplete()) {
     return s;
   }
 
   // Write meta blocks and metaindex block with the following order.
-  //    1. [properties]
-  //    2. [compression_dict]
-  //    3. [meta_index_builder]
-  //    4. [index_blocks]
+  //    1. [meta block: index]
+  //    2. [filter]
+  //    3. [properties]
+  //    4. [compression_dict]
+  //    5. [meta_index_builder]
+  //    6. [index_blocks]
   MetaIndexBuilder meta_index_builder;
+  for (const auto& item : index_blocks.meta_blocks) {
+    BlockHandle block_handle;
+    WriteRawBlock(item.second, kNoCompression, &block_handle);
+    meta_index_builder.Add(item.first, block_handle);
+  }
+
+  if (ok() && r->filter_builder != nullptr && !r->filter_builder->IsEmpty()) {
+    BlockHandle filter_block_handle;
+    Slice filter_contents = r->filter_builder->Finish();
+    WriteRawBlock(filter_contents, kNoCompression, &filter_block_handle);
+    r->props.filter_size = filter_contents.size();
+    r->props.filter_policy_name = r->table_options.filter_policy->Name();
+    if (r->ioptions.prefix_extractor != nullptr) {
+      r->props.whole_key_filtering = r->table_options.whole_key_filtering;
+      r->props.prefix_extractor_name = r->ioptions.prefix_extractor->Name();
+    }
+    meta_index_builder.Add(
+        kFullFilterBlockPrefix + r->table_options.filter_policy->Name(),
+        filter_block_handle);
+  }
 
   if (ok()) {
     // Write properties and compression dictionary blocks.
@@ -348,6 +401,7 @@ Status BlockBasedTableBuilder::Finish() {
       r->props.column_family_name = r->column_family_name;
       r->props.index_size =
           r->index_builder->EstimatedSize() + kBlockTrailerSize;
+      r->props.index_partitions = r->index_builder->NumPartitions();
       r->props.comparator_name = r->ioptions.comparator != nullptr
                                      ? r->ioptions.comparator->Name()
                                      : "nullptr";
@@ -395,6 +449,16 @@ Status BlockBasedTableBuilder::Finish() {
     WriteRawBlock(meta_index_builder.Finish(), kNoCompression,
                   &metaindex_block_handle);
     WriteBlock(index_blocks.index_block_contents, &index_block_handle, false);
+    // the partitions of a partitioned index precede its top-level block
+    while (ok() && s.IsIncomplete()) {
+      s = r->index_builder->FinishNextPartition(&index_blocks,
+                                                index_block_handle);
+      if (!s.ok() && !s.IsIncomplete()) {
+        return s;
+      }
+      WriteBlock(index_blocks.index_block_contents, &index_block_handle,
+                 false);
+    }
   }
 
   // Write footer
@@ -30,6 +30,10 @@
 //     restarts: uint32[num_restarts]
 //     num_restarts: uint32
 // restarts[i] contains the offset within the block of the ith restart point.
+//
+// Data blocks may also have a hash table of their user keys between the
+// restart array and num_restarts, whose presence is flagged in the most
+// significant bit of num_restarts, see table/data_block_hash_index.h.
 
 #include "table/block_builder.h"
 
@@ -41,13 +45,19 @@
 
 namespace vidardb {
 
-BlockBuilder::BlockBuilder(int block_restart_interval)
+BlockBuilder::BlockBuilder(int block_restart_interval,
+                           bool use_data_block_hash_index,
+                           double data_block_hash_table_util_ratio)
     : block_restart_interval_(block_restart_interval),
       restarts_(),
       counter_(0),
       finished_(false) {
   assert(block_restart_interval_ >= 1);
   restarts_.push_back(0);       // First restart point is at offset 0
+  if (use_data_block_hash_index) {
+    data_block_hash_index_builder_.Initialize(
+        data_block_hash_table_util_ratio);
+  }
 }
 
 void BlockBuilder::Reset() {
@@ -57,12 +67,17 @@ void BlockBuilder::Reset() {
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
+  data_block_hash_index_builder_.Reset();
 }
 
 size_t BlockBuilder::CurrentSizeEstimate() const {
-  return (buffer_.size() +                        // Raw data buffer
-          restarts_.size() * sizeof(uint32_t) +   // Restart array
-          sizeof(uint32_t));                      // Restart array length
+  size_t estimate = buffer_.size() +                        // Raw data buffer
+                    restarts_.size() * sizeof(uint32_t) +   // Restart array
+                    sizeof(uint32_t);                       // Restart length
+  if (data_block_hash_index_builder_.Valid()) {
+    estimate += data_block_hash_index_builder_.EstimateSize();
+  }
+  return estimate;
 }
 
 size_t BlockBuilder::EstimateSizeAfterKV(const Slice& key, const Slice& value)
@@ -85,7 +100,15 @@ Slice BlockBuilder::Finish() {
   for (size_t i = 0; i < restarts_.size(); i++) {
     PutFixed32(&buffer_, restarts_[i]);
   }
-  PutFixed32(&buffer_, static_cast<uint32_t>(restarts_.size()));
+  BlockIndexType index_type = kBinarySearchOnly;
+  if (data_block_hash_index_builder_.Valid() &&
+      CurrentSizeEstimate() <= kMaxBlockSizeSupportedByHashIndex) {
+    data_block_hash_index_builder_.Finish(&buffer_);
+    index_type = kBinaryAndHash;
+  }
+  PutFixed32(&buffer_,
+             PackIndexTypeAndNumRestarts(
+                 index_type, static_cast<uint32_t>(restarts_.size())));
   finished_ = true;
   return Slice(buffer_);
 }
@@ -121,6 +144,11 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
   last_key_.append(key.data() + shared, non_shared);
   assert(Slice(last_key_) == key);
   counter_++;
+
+  if (data_block_hash_index_builder_.Valid()) {
+    data_block_hash_index_builder_.Add(ExtractUserKey(key),
+                                       restarts_.size() - 1);
+  }
 }
 
 }  // namespace vidardb
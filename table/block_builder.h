@@ -11,6 +11,7 @@
 #include <vector>
 
 #include <stdint.h>
+#include "table/data_block_hash_index.h"
 #include "vidardb/slice.h"
 
 namespace vidardb {
@@ -20,7 +21,12 @@ class BlockBuilder {
   BlockBuilder(const BlockBuilder&) = delete;
   void operator=(const BlockBuilder&) = delete;
 
-  explicit BlockBuilder(int block_restart_interval);
+  // If use_data_block_hash_index is true, the keys are internal keys and a
+  // hash table of their user keys is appended to the block, see
+  // table/data_block_hash_index.h.
+  explicit BlockBuilder(int block_restart_interval,
+                        bool use_data_block_hash_index = false,
+                        double data_block_hash_table_util_ratio = 0.75);
 
   virtual ~BlockBuilder() {}
 
@@ -61,6 +67,7 @@ class BlockBuilder {
   int                   counter_;   // Number of entries emitted since restart
   bool                  finished_;  // Has Finish() been called?
   std::string           last_key_;
+  DataBlockHashIndexBuilder data_block_hash_index_builder_;
 };
 
 }  // namespace vidardb
@@ -0,0 +1,73 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/block_prefetcher.h"
+
+#include <algorithm>
+
+#include "table/format.h"
+#include "util/file_reader_writer.h"
+
+namespace vidardb {
+
+const size_t BlockPrefetcher::kInitReadaheadSize;
+const int BlockPrefetcher::kMinSequentialReads;
+
+BlockPrefetcher::BlockPrefetcher(size_t max_readahead_size)
+    : max_readahead_size_(max_readahead_size),
+      readahead_size_(std::min(kInitReadaheadSize, max_readahead_size)),
+      next_offset_(0),
+      num_sequential_reads_(0),
+      prefetch_limit_(0) {}
+
+void BlockPrefetcher::OnBlockRead(RandomAccessFileReader* file,
+                                  const BlockHandle& handle) {
+  if (max_readahead_size_ == 0) {
+    return;
+  }
+  const uint64_t offset = handle.offset();
+  const uint64_t end = offset + handle.size() + kBlockTrailerSize;
+  if (offset == next_offset_) {
+    num_sequential_reads_++;
+  } else {
+    num_sequential_reads_ = 1;
+    readahead_size_ = std::min(kInitReadaheadSize, max_readahead_size_);
+    prefetch_limit_ = 0;
+  }
+  next_offset_ = end;
+  if (num_sequential_reads_ < kMinSequentialReads) {
+    return;
+  }
+
+  // keep at least half of the readahead in flight
+  if (prefetch_limit_ >= end + readahead_size_ / 2) {
+    return;
+  }
+  const uint64_t start = std::max(end, prefetch_limit_);
+  const uint64_t limit = end + readahead_size_;
+  Status s = file->Prefetch(start, static_cast<size_t>(limit - start));
+  if (s.IsNotSupported()) {
+    // the file reads synchronously anyway
+    max_readahead_size_ = 0;
+    return;
+  }
+  prefetch_limit_ = limit;
+  readahead_size_ = std::min(readahead_size_ * 2, max_readahead_size_);
+}
+
+void BlockPrefetcher::OnBlockRead(RandomAccessFileReader* file,
+                                  const Slice& index_value) {
+  if (max_readahead_size_ == 0) {
+    return;
+  }
+  BlockHandle handle;
+  Slice input = index_value;
+  // a corrupted handle fails the block read itself
+  if (handle.DecodeFrom(&input).ok()) {
+    OnBlockRead(file, handle);
+  }
+}
+
+}  // namespace vidardb
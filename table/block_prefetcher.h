@@ -0,0 +1,54 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Prefetches the data blocks ahead of an iterator scanning a table file
+// sequentially. The prefetch only starts the reads in the background, see
+// RandomAccessFile::Prefetch, so the iterator doesn't wait for the device
+// when it moves to the following blocks.
+//
+// The readahead starts at kInitReadaheadSize once kMinSequentialReads blocks
+// are read one after another, and doubles with every prefetch up to the
+// max readahead size. A read elsewhere, e.g. after a seek, starts over.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "vidardb/slice.h"
+
+namespace vidardb {
+
+class BlockHandle;
+class RandomAccessFileReader;
+
+class BlockPrefetcher {
+ public:
+  static const size_t kInitReadaheadSize = 8 * 1024;
+  static const int kMinSequentialReads = 2;
+
+  // max_readahead_size: the largest range prefetched at once, 0 disables
+  //                     the prefetch.
+  explicit BlockPrefetcher(size_t max_readahead_size);
+
+  // Records the read of the data block of handle in file, and prefetches
+  // the range following it if the reads are sequential.
+  void OnBlockRead(RandomAccessFileReader* file, const BlockHandle& handle);
+
+  // Same as above, with the encoded block handle of an index entry.
+  void OnBlockRead(RandomAccessFileReader* file, const Slice& index_value);
+
+  // The end of the range prefetched so far.
+  uint64_t prefetch_limit() const { return prefetch_limit_; }
+
+ private:
+  size_t max_readahead_size_;
+  size_t readahead_size_;
+  // The offset right after the last block read.
+  uint64_t next_offset_;
+  int num_sequential_reads_;
+  uint64_t prefetch_limit_;
+};
+
+}  // namespace vidardb
@@ -0,0 +1,123 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/block_prefix_index.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "db/dbformat.h"
+#include "util/coding.h"
+#include "util/hash.h"
+#include "vidardb/slice.h"
+#include "vidardb/slice_transform.h"
+
+namespace vidardb {
+
+const std::string kHashIndexPrefixesBlock = "vidardb.hashindex.prefixes";
+
+namespace {
+
+const uint32_t kNoBlock = std::numeric_limits<uint32_t>::max();
+
+inline uint32_t PrefixToBucket(const Slice& prefix, uint32_t num_buckets) {
+  return GetSliceHash(prefix) % num_buckets;
+}
+
+}  // namespace
+
+BlockPrefixIndexBuilder::BlockPrefixIndexBuilder(
+    const SliceTransform* prefix_extractor)
+    : prefix_extractor_(prefix_extractor), num_prefixes_(0) {
+  assert(prefix_extractor_ != nullptr);
+}
+
+void BlockPrefixIndexBuilder::Add(const Slice& prefix, uint32_t first_block,
+                                  uint32_t num_blocks) {
+  assert(num_blocks > 0);
+  PutLengthPrefixedSlice(&prefixes_, prefix);
+  PutVarint32(&prefixes_, first_block);
+  PutVarint32(&prefixes_, num_blocks);
+  num_prefixes_++;
+}
+
+Slice BlockPrefixIndexBuilder::Finish() {
+  buffer_.clear();
+  PutLengthPrefixedSlice(&buffer_, prefix_extractor_->Name());
+  PutVarint32(&buffer_, num_prefixes_);
+  buffer_.append(prefixes_);
+  return Slice(buffer_);
+}
+
+BlockPrefixIndex::BlockPrefixIndex(const SliceTransform* prefix_extractor,
+                                   uint32_t num_buckets)
+    : prefix_extractor_(prefix_extractor),
+      num_buckets_(num_buckets),
+      buckets_(new uint32_t[num_buckets * 2]) {
+  std::fill(buckets_.get(), buckets_.get() + num_buckets * 2, kNoBlock);
+}
+
+Status BlockPrefixIndex::Create(const SliceTransform* prefix_extractor,
+                                const Slice& prefixes_contents,
+                                BlockPrefixIndex** prefix_index) {
+  Slice input = prefixes_contents;
+  Slice name;
+  uint32_t num_prefixes = 0;
+  if (!GetLengthPrefixedSlice(&input, &name) ||
+      !GetVarint32(&input, &num_prefixes)) {
+    return Status::Corruption("bad hash index prefixes block");
+  }
+  if (prefix_extractor == nullptr || name != prefix_extractor->Name()) {
+    return Status::InvalidArgument(
+        "hash index built by another prefix extractor", name);
+  }
+
+  // twice as many buckets as prefixes keep the merged ranges few
+  std::unique_ptr<BlockPrefixIndex> index(
+      new BlockPrefixIndex(prefix_extractor, (num_prefixes * 2) | 1));
+  for (uint32_t i = 0; i < num_prefixes; i++) {
+    Slice prefix;
+    uint32_t first_block = 0, num_blocks = 0;
+    if (!GetLengthPrefixedSlice(&input, &prefix) ||
+        !GetVarint32(&input, &first_block) ||
+        !GetVarint32(&input, &num_blocks) || num_blocks == 0) {
+      return Status::Corruption("bad hash index prefixes block");
+    }
+    uint32_t last_block = first_block + num_blocks - 1;
+    uint32_t* bucket =
+        &index->buckets_[PrefixToBucket(prefix, index->num_buckets_) * 2];
+    if (bucket[0] == kNoBlock) {
+      bucket[0] = first_block;
+      bucket[1] = last_block;
+    } else {
+      bucket[0] = std::min(bucket[0], first_block);
+      bucket[1] = std::max(bucket[1], last_block);
+    }
+  }
+
+  *prefix_index = index.release();
+  return Status::OK();
+}
+
+bool BlockPrefixIndex::GetBlockRange(const Slice& internal_key,
+                                     uint32_t* first_block,
+                                     uint32_t* last_block) const {
+  Slice user_key = ExtractUserKey(internal_key);
+  if (!prefix_extractor_->InDomain(user_key)) {
+    *first_block = 0;
+    *last_block = kNoBlock;
+    return true;
+  }
+  Slice prefix = prefix_extractor_->Transform(user_key);
+  const uint32_t* bucket = &buckets_[PrefixToBucket(prefix, num_buckets_) * 2];
+  if (bucket[0] == kNoBlock) {
+    return false;
+  }
+  *first_block = bucket[0];
+  *last_block = bucket[1];
+  return true;
+}
+
+}  // namespace vidardb
@@ -0,0 +1,77 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "vidardb/status.h"
+
+namespace vidardb {
+
+class Slice;
+class SliceTransform;
+
+// Name of the meta block holding the prefixes of a hash index.
+extern const std::string kHashIndexPrefixesBlock;
+
+// Builds the contents of the kHashIndexPrefixesBlock meta block: the name of
+// the prefix extractor, followed by the range of the index entries (i.e. the
+// data blocks) holding the keys of each prefix.
+//
+// REQUIRES: the prefixes are added in key order, each one once.
+class BlockPrefixIndexBuilder {
+ public:
+  explicit BlockPrefixIndexBuilder(const SliceTransform* prefix_extractor);
+
+  void Add(const Slice& prefix, uint32_t first_block, uint32_t num_blocks);
+
+  Slice Finish();
+
+  size_t EstimatedSize() const { return buffer_.size() + prefixes_.size(); }
+
+ private:
+  const SliceTransform* prefix_extractor_;
+  uint32_t num_prefixes_;
+  std::string prefixes_;
+  std::string buffer_;
+};
+
+// A hash table from the key prefixes of a table to the index entries (i.e.
+// the data blocks) holding them. Prefixes hashed to the same bucket share the
+// union of their ranges, so a range may hold blocks of other prefixes, but
+// always all the blocks of its own.
+class BlockPrefixIndex {
+ public:
+  // Returns false if the prefix of internal_key is absent from the table.
+  // Otherwise [*first_block, *last_block] covers the index entries that may
+  // hold the keys of its prefix. Keys out of the domain of the prefix
+  // extractor are mapped to all the index entries.
+  bool GetBlockRange(const Slice& internal_key, uint32_t* first_block,
+                     uint32_t* last_block) const;
+
+  size_t ApproximateMemoryUsage() const {
+    return sizeof(BlockPrefixIndex) + num_buckets_ * 2 * sizeof(uint32_t);
+  }
+
+  // Create the index from the contents of the kHashIndexPrefixesBlock meta
+  // block. Fails if the block was built by another prefix extractor.
+  static Status Create(const SliceTransform* prefix_extractor,
+                       const Slice& prefixes_contents,
+                       BlockPrefixIndex** prefix_index);
+
+ private:
+  BlockPrefixIndex(const SliceTransform* prefix_extractor,
+                   uint32_t num_buckets);
+
+  const SliceTransform* prefix_extractor_;
+  uint32_t num_buckets_;
+  // first and last block of each bucket, kNoBlock for the empty ones
+  std::unique_ptr<uint32_t[]> buckets_;
+};
+
+}  // namespace vidardb
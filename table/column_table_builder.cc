@@ -20,6 +20,7 @@
 #include "table/column_table_factory.h"
 #include "table/column_table_reader.h"
 #include "table/format.h"
+#include "table/full_filter_block.h"
 #include "table/index_builder.h"
 #include "table/main_column_block_builder.h"
 #include "table/meta_blocks.h"
@@ -34,6 +35,7 @@
 #include "vidardb/cache.h"
 #include "vidardb/comparator.h"
 #include "vidardb/env.h"
+#include "vidardb/filter_policy.h"
 #include "vidardb/flush_block_policy.h"
 #include "vidardb/splitter.h"
 #include "vidardb/table.h"
@@ -44,9 +46,15 @@ namespace vidardb {
 namespace {
 
 // Create a index builder based on its type.
-IndexBuilder* CreateIndexBuilder(const Comparator* comparator,
+IndexBuilder* CreateIndexBuilder(ColumnTableOptions::IndexType index_type,
+                                 const Comparator* comparator,
                                  int index_block_restart_interval,
+                                 uint64_t metadata_block_size,
                                  const Comparator* value_comparator) {
+  if (index_type == ColumnTableOptions::kTwoLevelIndexSearch) {
+    return new PartitionedIndexBuilder(comparator, index_block_restart_interval,
+                                       metadata_block_size, value_comparator);
+  }
   if (value_comparator == nullptr) {
     return new ShortenedIndexBuilder(comparator, index_block_restart_interval);
   } else {
@@ -127,6 +135,8 @@ struct ColumnTableBuilder::Rep {
   std::unique_ptr<BlockBuilder> data_block;
 
   std::unique_ptr<IndexBuilder> index_builder;
+  // only the main column has a filter, over the user keys
+  std::unique_ptr<FullFilterBlockBuilder> filter_builder;
 
   std::string last_key;
   const CompressionType compression_type;
@@ -167,7 +177,9 @@ struct ColumnTableBuilder::Rep {
                                           : nullptr),
         file(f),
         index_builder(CreateIndexBuilder(
-            &internal_comparator, table_options.index_block_restart_interval,
+            table_options.index_type, &internal_comparator,
+            table_options.index_block_restart_interval,
+            table_options.metadata_block_size,
             (column_num == 0)
                 ? nullptr
                 : table_options.value_comparators[column_num - 1])),
@@ -189,6 +201,14 @@ struct ColumnTableBuilder::Rep {
       flush_block_policy.reset(nullptr);
     }
 
+    if (column_num == 0 && table_options.filter_policy != nullptr) {
+      filter_builder.reset(new FullFilterBlockBuilder(
+          ioptions.prefix_extractor,
+          table_options.whole_key_filtering ||
+              ioptions.prefix_extractor == nullptr,
+          table_options.filter_policy->GetFilterBitsBuilder()));
+    }
+
     if (column_num == 0 && int_tbl_prop_collector_factories) {
       for (auto& collector_factories : *int_tbl_prop_collector_factories) {
         table_properties_collectors.emplace_back(
@@ -313,6 +333,10 @@ void ColumnTableBuilder::Add(const Slice& key, const Slice& value) {
     }
   }
 
+  if (r->filter_builder != nullptr) {
+    r->filter_builder->Add(ExtractUserKey(key));
+  }
+
   r->last_key.assign(key.data(), key.size());
   // main column format (keyN, pos): (key0, 0), (key1, ) ...
   // pos is only stored at every restart
@@ -443,16 +467,17 @@ Status ColumnTableBuilder::Finish() {
 
   IndexBuilder::IndexBlocks index_blocks;
   auto s = r->index_builder->Finish(&index_blocks);
-  if (!s.ok()) {
+  if (!s.ok() && !s.IsIncomplete()) {
     return s;
   }
 
   // Write meta blocks and metaindex block with the following order.
   //    1. [format, col_num; col_file_size...]
-  //    2. [properties]
-  //    3. [compression_dict]
-  //    4. [meta_index_builder]
-  //    5. [index_blocks]
+  //    2. [filter]
+  //    3. [properties]
+  //    4. [compression_dict]
+  //    5. [meta_index_builder]
+  //    6. [index_blocks]
   MetaIndexBuilder meta_index_builder;
 
   if (ok()) {
@@ -471,6 +496,22 @@ Status ColumnTableBuilder::Finish() {
       meta_index_builder.Add(kColumnBlock, column_block_handle);
     }
 
+    // Write filter block.
+    if (r->filter_builder != nullptr && !r->filter_builder->IsEmpty()) {
+      BlockHandle filter_block_handle;
+      Slice filter_contents = r->filter_builder->Finish();
+      WriteRawBlock(filter_contents, kNoCompression, &filter_block_handle);
+      r->props.filter_size = filter_contents.size();
+      r->props.filter_policy_name = r->table_options.filter_policy->Name();
+      if (r->ioptions.prefix_extractor != nullptr) {
+        r->props.whole_key_filtering = r->table_options.whole_key_filtering;
+        r->props.prefix_extractor_name = r->ioptions.prefix_extractor->Name();
+      }
+      meta_index_builder.Add(
+          kFullFilterBlockPrefix + r->table_options.filter_policy->Name(),
+          filter_block_handle);
+    }
+
     // Write properties and compression dictionary blocks.
     {
       PropertyBlockBuilder property_block_builder;
@@ -478,6 +519,7 @@ Status ColumnTableBuilder::Finish() {
       r->props.column_family_name = r->column_family_name;
       r->props.index_size =
           r->index_builder->EstimatedSize() + kBlockTrailerSize;
+      r->props.index_partitions = r->index_builder->NumPartitions();
       r->props.comparator_name = r->ioptions.comparator != nullptr
                                      ? r->ioptions.comparator->Name()
                                      : "nullptr";
@@ -528,6 +570,16 @@ Status ColumnTableBuilder::Finish() {
     WriteRawBlock(meta_index_builder.Finish(), kNoCompression,
                   &metaindex_block_handle);
     WriteBlock(index_blocks.index_block_contents, &index_block_handle, false);
+    // the partitions of a partitioned index precede its top-level block
+    while (ok() && s.IsIncomplete()) {
+      s = r->index_builder->FinishNextPartition(&index_blocks,
+                                                index_block_handle);
+      if (!s.ok() && !s.IsIncomplete()) {
+        return s;
+      }
+      WriteBlock(index_blocks.index_block_contents, &index_block_handle,
+                 false);
+    }
   }
 
   // Write footer
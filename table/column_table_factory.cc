@@ -5,6 +5,11 @@
 
 #include "table/column_table_factory.h"
 
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
 #include <memory>
 #include <string>
 #include <stdint.h>
@@ -12,6 +17,8 @@
 #include "port/port.h"
 #include "vidardb/flush_block_policy.h"
 #include "vidardb/cache.h"
+#include "vidardb/filter_policy.h"
+#include "vidardb/persistent_cache.h"
 #include "table/column_table_builder.h"
 #include "table/column_table_reader.h"
 #include "table/format.h"
@@ -58,7 +65,7 @@ Status ColumnTableFactory::NewTableReader(
       table_reader_options.ioptions, table_reader_options.env_options,
       table_options_, table_reader_options.internal_comparator, std::move(file),
       file_size, table_reader, prefetch_enabled, table_reader_options.level,
-      table_reader_options.cols);
+      table_reader_options.cols, table_reader_options.read_amp_stats);
 }
 
 TableBuilder* ColumnTableFactory::NewTableBuilder(
@@ -109,6 +116,21 @@ std::string ColumnTableFactory::GetPrintableTableOptions() const {
              table_options_.block_cache->GetCapacity());
     ret.append(buffer);
   }
+  snprintf(buffer, kBufferSize, "  block_cache_compressed: %p\n",
+           static_cast<void*>(table_options_.block_cache_compressed.get()));
+  ret.append(buffer);
+  if (table_options_.block_cache_compressed) {
+    snprintf(buffer, kBufferSize,
+             "  block_cache_compressed_size: %" VIDARDB_PRIszt "\n",
+             table_options_.block_cache_compressed->GetCapacity());
+    ret.append(buffer);
+  }
+  snprintf(buffer, kBufferSize, "  persistent_cache: %p\n",
+           static_cast<void*>(table_options_.persistent_cache.get()));
+  ret.append(buffer);
+  if (table_options_.persistent_cache) {
+    ret.append(table_options_.persistent_cache->GetPrintableOptions());
+  }
   snprintf(buffer, kBufferSize, "  block_size: %" VIDARDB_PRIszt "\n",
            table_options_.block_size);
   ret.append(buffer);
@@ -121,6 +143,34 @@ std::string ColumnTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  index_block_restart_interval: %d\n",
            table_options_.index_block_restart_interval);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  index_type: %d\n",
+           table_options_.index_type);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  metadata_block_size: %" PRIu64 "\n",
+           table_options_.metadata_block_size);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  cache_index_and_filter_blocks: %d\n",
+           table_options_.cache_index_and_filter_blocks);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize,
+           "  cache_index_and_filter_blocks_with_high_priority: %d\n",
+           table_options_.cache_index_and_filter_blocks_with_high_priority);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize,
+           "  pin_l0_filter_and_index_blocks_in_cache: %d\n",
+           table_options_.pin_l0_filter_and_index_blocks_in_cache);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  pin_top_level_index: %d\n",
+           table_options_.pin_top_level_index);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  filter_policy: %s\n",
+           table_options_.filter_policy == nullptr
+               ? "nullptr"
+               : table_options_.filter_policy->Name());
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  whole_key_filtering: %d\n",
+           table_options_.whole_key_filtering);
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "  column count (excluding key): %d\n",
            table_options_.column_count);
   ret.append(buffer);
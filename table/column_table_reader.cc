@@ -14,13 +14,17 @@
 #include "table/block.h"
 #include "table/column_table_factory.h"
 #include "table/format.h"
+#include "table/full_filter_block.h"
 #include "table/get_context.h"
 #include "table/index_reader.h"
 #include "table/internal_iterator.h"
 #include "table/main_column_table_iterator.h"
 #include "table/meta_blocks.h"
+#include "table/persistent_cache_helper.h"
+#include "table/read_amp_stats.h"
 #include "table/sub_column_table_iterator.h"
 #include "table/two_level_iterator.h"
+#include "util/block_access_tracer.h"
 #include "util/coding.h"
 #include "util/file_reader_writer.h"
 #include "util/perf_context_imp.h"
@@ -29,8 +33,10 @@
 #include "vidardb/cache.h"
 #include "vidardb/comparator.h"
 #include "vidardb/env.h"
+#include "vidardb/filter_policy.h"
 #include "vidardb/iterator.h"
 #include "vidardb/options.h"
+#include "vidardb/slice_transform.h"
 #include "vidardb/splitter.h"
 #include "vidardb/statistics.h"
 #include "vidardb/table.h"
@@ -109,6 +115,23 @@ void DeleteCachedIndexEntry(const Slice& key, void* value) {
   delete index_reader;
 }
 
+void DeleteCachedFilterEntry(const Slice& key, void* value) {
+  FullFilterBlockReader* filter =
+      reinterpret_cast<FullFilterBlockReader*>(value);
+  if (filter->statistics() != nullptr) {
+    RecordTick(filter->statistics(), BLOCK_CACHE_FILTER_BYTES_EVICT,
+               filter->usable_size());
+  }
+  delete filter;
+}
+
+// The block cache priority of the index, filter and index partitions.
+Cache::Priority MetaBlockPriority(const ColumnTableOptions& table_options) {
+  return table_options.cache_index_and_filter_blocks_with_high_priority
+             ? Cache::Priority::HIGH
+             : Cache::Priority::LOW;
+}
+
 }  // anonymous namespace
 
 // CachableEntry represents the entries that *may* be fetched from block cache.
@@ -152,6 +175,9 @@ struct ColumnTable::Rep {
   unique_ptr<RandomAccessFileReader> file;
   char cache_key_prefix[kMaxCacheKeyPrefixSize];
   size_t cache_key_prefix_size = 0;
+  char compressed_cache_key_prefix[kMaxCacheKeyPrefixSize];
+  size_t compressed_cache_key_prefix_size = 0;
+  PersistentCacheOptions persistent_cache_options;
   uint64_t dummy_index_reader_offset = 0;  // ID unique for the block cache.
 
   // Footer contains the fixed table information
@@ -159,6 +185,20 @@ struct ColumnTable::Rep {
   // index_reader will be populated and used only when options.block_cache is
   // nullptr; otherwise we will get the index block via the block cache.
   unique_ptr<IndexReader> index_reader;
+  // filter is pre-loaded together with index_reader; otherwise we will get
+  // the filter block via the block cache. Only the main column has one.
+  unique_ptr<FullFilterBlockReader> filter;
+  bool has_filter = false;
+  BlockHandle filter_handle;
+  // The index and filter pinned in the block cache, and the pinned
+  // partitions of a partitioned index. They are released on Close().
+  CachableEntry<IndexReader> index_entry;
+  CachableEntry<FullFilterBlockReader> filter_entry;
+  std::vector<Cache::Handle*> pinned_partitions;
+  // What the filter holds: the whole user keys, and/or the prefixes of
+  // ioptions.prefix_extractor if it is the extractor that built the filter.
+  bool whole_key_filtering = true;
+  bool prefix_filtering = false;
 
   std::shared_ptr<const TableProperties> table_properties;
   // Block containing the data for the compression dictionary. We take ownership
@@ -169,6 +209,33 @@ struct ColumnTable::Rep {
 
   uint32_t column_num;
   std::vector<unique_ptr<ColumnTable>> tables;  // sub colum tables
+
+  // Counts a data block found in the block cache, or read from the file.
+  void RecordDataBlock(const BlockHandle& handle, bool cache_hit) {
+    for (TableReadStats* stats : {level_stats, column_stats}) {
+      if (stats == nullptr) {
+        continue;
+      }
+      if (cache_hit) {
+        stats->RecordCacheHit();
+      } else {
+        stats->RecordBlockRead(handle.size() + kBlockTrailerSize);
+      }
+    }
+  }
+
+  void RecordBlocksSkipped(uint64_t n) {
+    for (TableReadStats* stats : {level_stats, column_stats}) {
+      if (stats != nullptr && n > 0) {
+        stats->RecordBlocksSkipped(n);
+      }
+    }
+  }
+
+  // The read counters of the level and of the column of the table, nullptr
+  // if not counted.
+  TableReadStats* level_stats = nullptr;
+  TableReadStats* column_stats = nullptr;
 };
 
 // Load the meta-block from the file. On success, return the loaded meta block
@@ -218,6 +285,27 @@ void ColumnTable::SetupCacheKeyPrefix(Rep* rep, uint64_t file_size) {
     rep->dummy_index_reader_offset =
         file_size + rep->table_options.block_cache->NewId();
   }
+  if (rep->table_options.block_cache_compressed != nullptr) {
+    GenerateCachePrefix(rep->table_options.block_cache_compressed.get(),
+                        rep->file->file(), &rep->compressed_cache_key_prefix[0],
+                        &rep->compressed_cache_key_prefix_size);
+  }
+  if (rep->table_options.persistent_cache != nullptr) {
+    // Only the unique id of the file survives restarts, without it the
+    // blocks are not cached.
+    char persistent_cache_key_prefix[kMaxCacheKeyPrefixSize];
+    size_t persistent_cache_key_prefix_size = 0;
+    GenerateCachePrefix(nullptr, rep->file->file(),
+                        &persistent_cache_key_prefix[0],
+                        &persistent_cache_key_prefix_size);
+    if (persistent_cache_key_prefix_size > 0) {
+      rep->persistent_cache_options = PersistentCacheOptions(
+          rep->table_options.persistent_cache,
+          std::string(persistent_cache_key_prefix,
+                      persistent_cache_key_prefix_size),
+          rep->ioptions.statistics);
+    }
+  }
 }
 
 Slice ColumnTable::GetCacheKey(const char* cache_key_prefix,
@@ -233,19 +321,49 @@ Slice ColumnTable::GetCacheKey(const char* cache_key_prefix,
 }
 
 Status ColumnTable::PutDataBlockToCache(
-    const Slice& block_cache_key, Cache* block_cache, Statistics* statistics,
-    CachableEntry<Block>* block, Block* raw_block) {
-  assert(raw_block->compression_type() == kNoCompression);
+    const Slice& block_cache_key, const Slice& compressed_block_cache_key,
+    Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
+    CachableEntry<Block>* block, BlockContents* raw_block_contents,
+    const Slice& compression_dict, Cache::Priority priority) {
   Status s;
-  block->value = raw_block;
-  raw_block = nullptr;
+  BlockContents contents;
+  if (raw_block_contents->compression_type != kNoCompression) {
+    // the raw contents are followed by the block trailer, which tells the
+    // compression type to UncompressBlockContents()
+    s = UncompressBlockContents(raw_block_contents->data.data(),
+                                raw_block_contents->data.size(), &contents,
+                                compression_dict);
+    if (!s.ok()) {
+      return s;
+    }
+
+    // insert the compressed block into the compressed block cache
+    if (block_cache_compressed != nullptr && raw_block_contents->cachable) {
+      BlockContents* compressed =
+          new BlockContents(std::move(*raw_block_contents));
+      size_t charge = compressed->data.size();
+      Status cs = block_cache_compressed->Insert(
+          compressed_block_cache_key, compressed, charge,
+          &DeleteCachedEntry<BlockContents>);
+      if (cs.ok()) {
+        RecordTick(statistics, BLOCK_CACHE_COMPRESSED_ADD);
+      } else {
+        // the compressed cache deleted the entry on failure
+        RecordTick(statistics, BLOCK_CACHE_COMPRESSED_ADD_FAILURES);
+      }
+    }
+  } else {
+    contents = std::move(*raw_block_contents);
+  }
+  block->value = new Block(std::move(contents));
 
   // insert into uncompressed block cache
   assert((block->value->compression_type() == kNoCompression));
   if (block_cache != nullptr && block->value->cachable()) {
     s = block_cache->Insert(block_cache_key, block->value,
                             block->value->usable_size(),
-                            &DeleteCachedEntry<Block>, &(block->cache_handle));
+                            &DeleteCachedEntry<Block>, &(block->cache_handle),
+                            priority);
     if (s.ok()) {
       assert(block->cache_handle != nullptr);
       RecordTick(statistics, BLOCK_CACHE_ADD);
@@ -264,15 +382,18 @@ Status ColumnTable::PutDataBlockToCache(
 }
 
 Status ColumnTable::GetDataBlockFromCache(
-    const Slice& block_cache_key, Cache* block_cache, Statistics* statistics,
-    ColumnTable::CachableEntry<Block>* block) {
+    const Slice& block_cache_key, const Slice& compressed_block_cache_key,
+    Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
+    const ReadOptions& read_options, ColumnTable::CachableEntry<Block>* block,
+    const Slice& compression_dict, bool is_index, Cache::Priority priority) {
   Status s;
 
   // Lookup uncompressed cache first
   if (block_cache != nullptr) {
-    block->cache_handle =
-        GetEntryFromCache(block_cache, block_cache_key, BLOCK_CACHE_DATA_MISS,
-                          BLOCK_CACHE_DATA_HIT, statistics);
+    block->cache_handle = GetEntryFromCache(
+        block_cache, block_cache_key,
+        is_index ? BLOCK_CACHE_INDEX_MISS : BLOCK_CACHE_DATA_MISS,
+        is_index ? BLOCK_CACHE_INDEX_HIT : BLOCK_CACHE_DATA_HIT, statistics);
     if (block->cache_handle != nullptr) {
       block->value =
           reinterpret_cast<Block*>(block_cache->Value(block->cache_handle));
@@ -282,6 +403,50 @@ Status ColumnTable::GetDataBlockFromCache(
 
   assert(block->cache_handle == nullptr && block->value == nullptr);
 
+  // If not found, search from the compressed block cache.
+  if (block_cache_compressed == nullptr) {
+    return s;
+  }
+  assert(!compressed_block_cache_key.empty());
+  Cache::Handle* compressed_handle =
+      block_cache_compressed->Lookup(compressed_block_cache_key);
+  if (compressed_handle == nullptr) {
+    RecordTick(statistics, BLOCK_CACHE_COMPRESSED_MISS);
+    return s;
+  }
+  RecordTick(statistics, BLOCK_CACHE_COMPRESSED_HIT);
+
+  // found compressed block
+  BlockContents* compressed = reinterpret_cast<BlockContents*>(
+      block_cache_compressed->Value(compressed_handle));
+  assert(compressed->compression_type != kNoCompression);
+  BlockContents contents;
+  s = UncompressBlockContents(compressed->data.data(), compressed->data.size(),
+                              &contents, compression_dict);
+  block_cache_compressed->Release(compressed_handle);
+  if (!s.ok()) {
+    return s;
+  }
+
+  // promote the uncompressed block to the block cache
+  block->value = new Block(std::move(contents));
+  if (block_cache != nullptr && block->value->cachable() &&
+      read_options.fill_cache) {
+    s = block_cache->Insert(block_cache_key, block->value,
+                            block->value->usable_size(),
+                            &DeleteCachedEntry<Block>, &(block->cache_handle),
+                            priority);
+    if (s.ok()) {
+      RecordTick(statistics, BLOCK_CACHE_ADD);
+      RecordTick(statistics, BLOCK_CACHE_BYTES_WRITE,
+                 block->value->usable_size());
+    } else {
+      RecordTick(statistics, BLOCK_CACHE_ADD_FAILURES);
+      delete block->value;
+      block->value = nullptr;
+    }
+  }
+
   return s;
 }
 
@@ -291,7 +456,7 @@ Status ColumnTable::GetDataBlockFromCache(
 // If input_iter is not null, update this iter and return it
 InternalIterator* ColumnTable::NewDataBlockIterator(
     Rep* rep, const ReadOptions& read_options, const Slice& index_value,
-    BlockIter* input_iter, char** area) {
+    BlockIter* input_iter, char** area, bool is_index) {
   PERF_TIMER_GUARD(new_table_block_iter_nanos);
 
   BlockHandle handle;
@@ -315,33 +480,69 @@ InternalIterator* ColumnTable::NewDataBlockIterator(
 
   const bool no_io = (read_options.read_tier == kBlockCacheTier);
   Cache* block_cache = rep->table_options.block_cache.get();
+  Cache* block_cache_compressed =
+      rep->table_options.block_cache_compressed.get();
   CachableEntry<Block> block;
   // If block cache is enabled, we'll try to read from it.
   // But if area is specified, don't use block cache, since we would put data
   // block in the specified area.
-  if (block_cache != nullptr && area == nullptr) {
+  if ((block_cache != nullptr || block_cache_compressed != nullptr) &&
+      area == nullptr) {
     Statistics* statistics = rep->ioptions.statistics;
     char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
-    // create key for block cache
-    Slice key = GetCacheKey(rep->cache_key_prefix, rep->cache_key_prefix_size,
-                            handle, cache_key);
-
-    s = GetDataBlockFromCache(key, block_cache, statistics, &block);
-
-    if (block.value == nullptr && !no_io && read_options.fill_cache) {
-      std::unique_ptr<Block> raw_block;
+    char compressed_cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+    Slice key, compressed_key;
+    // create keys for the block caches
+    if (block_cache != nullptr) {
+      key = GetCacheKey(rep->cache_key_prefix, rep->cache_key_prefix_size,
+                        handle, cache_key);
+    }
+    if (block_cache_compressed != nullptr) {
+      compressed_key = GetCacheKey(rep->compressed_cache_key_prefix,
+                                   rep->compressed_cache_key_prefix_size,
+                                   handle, compressed_cache_key);
+    }
+    Cache::Priority priority = is_index ? MetaBlockPriority(rep->table_options)
+                                        : Cache::Priority::LOW;
+
+    s = GetDataBlockFromCache(key, compressed_key, block_cache,
+                              block_cache_compressed, statistics, read_options,
+                              &block, compression_dict, is_index, priority);
+    const bool cache_hit = s.ok() && block.value != nullptr;
+    if (cache_hit && !is_index) {
+      rep->RecordDataBlock(handle, true);
+    }
+
+    if (s.ok() && block.value == nullptr && !no_io &&
+        read_options.fill_cache) {
+      BlockContents raw_block_contents;
       {
         StopWatch sw(rep->ioptions.env, statistics, READ_BLOCK_GET_MICROS);
-        s = ReadBlockFromFile(rep->file.get(), read_options, handle, &raw_block,
-                              rep->ioptions.env, true, compression_dict,
-                              rep->ioptions.info_log);
+        // keep the block compressed if it goes to the compressed block cache
+        s = ReadBlockContents(rep->file.get(), read_options, handle,
+                              &raw_block_contents, rep->ioptions.env,
+                              block_cache_compressed == nullptr,
+                              compression_dict, rep->ioptions.info_log,
+                              nullptr, &rep->persistent_cache_options);
       }
 
       if (s.ok()) {
-        s = PutDataBlockToCache(key, block_cache, statistics, &block,
-                                raw_block.release());
+        if (!is_index) {
+          rep->RecordDataBlock(handle, false);
+        }
+        s = PutDataBlockToCache(key, compressed_key, block_cache,
+                                block_cache_compressed, statistics, &block,
+                                &raw_block_contents, compression_dict,
+                                priority);
       }
     }
+    if (s.ok() && block_cache != nullptr) {
+      TraceBlockAccess(
+          rep->ioptions, key,
+          is_index ? BlockAccess::kIndex : BlockAccess::kData,
+          block.value != nullptr ? block.value->usable_size() : handle.size(),
+          cache_hit, read_options.fill_cache && !no_io);
+    }
   }
 
   // Didn't get any data from block caches.
@@ -358,17 +559,28 @@ InternalIterator* ColumnTable::NewDataBlockIterator(
     std::unique_ptr<Block> block_value;
     s = ReadBlockFromFile(rep->file.get(), read_options, handle, &block_value,
                           rep->ioptions.env, true, compression_dict,
-                          rep->ioptions.info_log, area);
+                          rep->ioptions.info_log, area,
+                          &rep->persistent_cache_options);
     if (s.ok()) {
+      if (!is_index) {
+        rep->RecordDataBlock(handle, false);
+      }
       block.value = block_value.release();
     }
   }
 
   InternalIterator* iter;
   if (s.ok() && block.value != nullptr) {
-    iter = block.value->NewIterator(
-        &rep->internal_comparator, input_iter,
-        (rep->column_num == 0) ? Block::kTypeMainColumn : Block::kTypeSubColumn);
+    Block::BlockType block_type;
+    if (is_index) {
+      block_type =
+          (rep->column_num == 0) ? Block::kTypeBlock : Block::kTypeMinMax;
+    } else {
+      block_type = (rep->column_num == 0) ? Block::kTypeMainColumn
+                                          : Block::kTypeSubColumn;
+    }
+    iter = block.value->NewIterator(&rep->internal_comparator, input_iter,
+                                    block_type);
     if (block.cache_handle != nullptr) {
       iter->RegisterCleanup(&ReleaseCachedEntry, block_cache,
                             block.cache_handle);
@@ -393,6 +605,20 @@ Status ColumnTable::CreateIndexReader(IndexReader** index_reader) {
   const Footer& footer = rep_->footer;
   Statistics* stats = rep_->ioptions.statistics;
 
+  if (rep_->table_properties != nullptr &&
+      rep_->table_properties->index_partitions > 0) {
+    // the partitions are read like the data blocks, through the block cache
+    Rep* rep = rep_;
+    return PartitionIndexReader::Create(
+        file, footer.index_handle(), env, comparator,
+        (rep_->column_num == 0) ? Block::kTypeBlock : Block::kTypeMinMax,
+        [rep](const Slice& handle) {
+          return NewDataBlockIterator(rep, ReadOptions(), handle, nullptr,
+                                      nullptr, true /* is_index */);
+        },
+        index_reader, stats);
+  }
+
   if (rep_->column_num == 0) {
     return BinarySearchIndexReader::Create(file, footer.index_handle(), env,
                                            comparator, index_reader, stats);
@@ -413,6 +639,10 @@ InternalIterator* ColumnTable::NewIndexIterator(
   if (rep_->index_reader) {
     return rep_->index_reader->NewIterator(input_iter);
   }
+  // index reader is pinned in the block cache.
+  if (rep_->index_entry.IsSet()) {
+    return rep_->index_entry.value->NewIterator(input_iter);
+  }
 
   PERF_TIMER_GUARD(read_index_block_nanos);
 
@@ -426,6 +656,7 @@ InternalIterator* ColumnTable::NewIndexIterator(
   auto cache_handle = GetEntryFromCache(block_cache, key,
                                         BLOCK_CACHE_INDEX_MISS,
                                         BLOCK_CACHE_INDEX_HIT, statistics);
+  const bool cache_hit = cache_handle != nullptr;
 
   if (cache_handle == nullptr && no_io) {
     if (input_iter != nullptr) {
@@ -445,7 +676,8 @@ InternalIterator* ColumnTable::NewIndexIterator(
     Status s = CreateIndexReader(&index_reader);
     if (s.ok()) {
       s = block_cache->Insert(key, index_reader, index_reader->usable_size(),
-                              &DeleteCachedIndexEntry, &cache_handle);
+                              &DeleteCachedIndexEntry, &cache_handle,
+                              MetaBlockPriority(rep_->table_options));
     }
 
     if (s.ok()) {
@@ -466,6 +698,8 @@ InternalIterator* ColumnTable::NewIndexIterator(
   }
 
   assert(cache_handle);
+  TraceBlockAccess(rep_->ioptions, key, BlockAccess::kIndex,
+                   index_reader->usable_size(), cache_hit, true);
   auto* iter = index_reader->NewIterator(input_iter);
 
   // the caller would like to take ownership of the index block
@@ -479,6 +713,179 @@ InternalIterator* ColumnTable::NewIndexIterator(
   return iter;
 }
 
+ColumnTable::CachableEntry<FullFilterBlockReader> ColumnTable::GetFilter(
+    bool no_io) const {
+  // filter has already been pre-populated.
+  if (rep_->filter) {
+    return {rep_->filter.get(), nullptr};
+  }
+  // filter is pinned in the block cache, the caller doesn't release it.
+  if (rep_->filter_entry.IsSet()) {
+    return {rep_->filter_entry.value, nullptr};
+  }
+
+  Cache* block_cache = rep_->table_options.block_cache.get();
+  if (!rep_->has_filter || block_cache == nullptr) {
+    return CachableEntry<FullFilterBlockReader>();
+  }
+
+  PERF_TIMER_GUARD(read_filter_block_nanos);
+
+  char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+  auto key = GetCacheKey(rep_->cache_key_prefix, rep_->cache_key_prefix_size,
+                         rep_->filter_handle, cache_key);
+  Statistics* statistics = rep_->ioptions.statistics;
+  auto cache_handle = GetEntryFromCache(block_cache, key,
+                                        BLOCK_CACHE_FILTER_MISS,
+                                        BLOCK_CACHE_FILTER_HIT, statistics);
+  if (cache_handle != nullptr) {
+    auto* filter = reinterpret_cast<FullFilterBlockReader*>(
+        block_cache->Value(cache_handle));
+    TraceBlockAccess(rep_->ioptions, key, BlockAccess::kFilter,
+                     filter->usable_size(), true, true);
+    return {filter, cache_handle};
+  }
+  if (no_io) {
+    return CachableEntry<FullFilterBlockReader>();
+  }
+
+  // Create the filter and put it in the cache.
+  FullFilterBlockReader* filter = nullptr;
+  Status s = FullFilterBlockReader::Create(
+      rep_->file.get(), rep_->filter_handle, rep_->ioptions.env,
+      rep_->table_options.filter_policy.get(), statistics, &filter);
+  if (s.ok()) {
+    TraceBlockAccess(rep_->ioptions, key, BlockAccess::kFilter,
+                     filter->usable_size(), false, true);
+    s = block_cache->Insert(key, filter, filter->usable_size(),
+                            &DeleteCachedFilterEntry, &cache_handle,
+                            MetaBlockPriority(rep_->table_options));
+    if (s.ok()) {
+      size_t usable_size = filter->usable_size();
+      RecordTick(statistics, BLOCK_CACHE_ADD);
+      RecordTick(statistics, BLOCK_CACHE_BYTES_WRITE, usable_size);
+      RecordTick(statistics, BLOCK_CACHE_FILTER_BYTES_INSERT, usable_size);
+      return {filter, cache_handle};
+    }
+    RecordTick(statistics, BLOCK_CACHE_ADD_FAILURES);
+  }
+  // Without a filter the lookup just goes on to the index and data blocks.
+  return CachableEntry<FullFilterBlockReader>();
+}
+
+void ColumnTable::PrefetchFollowingBlocks(BlockPrefetcher* prefetcher,
+                                          const Slice& index_value) {
+  prefetcher->OnBlockRead(rep_->file.get(), index_value);
+}
+
+Status ColumnTable::PinIndexPartitions(IndexReader* index_reader) {
+  Cache* block_cache = rep_->table_options.block_cache.get();
+  assert(block_cache != nullptr);
+  Statistics* statistics = rep_->ioptions.statistics;
+  Slice compression_dict;
+  if (rep_->compression_dict_block) {
+    compression_dict = rep_->compression_dict_block->data;
+  }
+
+  std::unique_ptr<InternalIterator> iter(
+      static_cast<PartitionIndexReader*>(index_reader)->NewTopLevelIterator());
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    BlockHandle handle;
+    Slice input = iter->value();
+    Status s = handle.DecodeFrom(&input);
+    if (!s.ok()) {
+      return s;
+    }
+    char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+    Slice key = GetCacheKey(rep_->cache_key_prefix,
+                            rep_->cache_key_prefix_size, handle, cache_key);
+    CachableEntry<Block> block;
+    // the pinned partitions stay in the block cache, so the compressed block
+    // cache is not involved
+    GetDataBlockFromCache(key, Slice(), block_cache, nullptr, statistics,
+                          ReadOptions(), &block, compression_dict,
+                          true /* is_index */,
+                          MetaBlockPriority(rep_->table_options));
+    if (block.value == nullptr) {
+      BlockContents raw_block_contents;
+      s = ReadBlockContents(rep_->file.get(), ReadOptions(), handle,
+                            &raw_block_contents, rep_->ioptions.env, true,
+                            compression_dict, rep_->ioptions.info_log);
+      if (s.ok()) {
+        s = PutDataBlockToCache(key, Slice(), block_cache, nullptr, statistics,
+                                &block, &raw_block_contents, compression_dict,
+                                MetaBlockPriority(rep_->table_options));
+      }
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    if (block.cache_handle != nullptr) {
+      rep_->pinned_partitions.push_back(block.cache_handle);
+    } else {
+      // not cachable, the partition is read again on demand
+      delete block.value;
+    }
+  }
+  return iter->status();
+}
+
+bool ColumnTable::KeyMayMatch(const ReadOptions& read_options,
+                              const Slice& internal_key) {
+  if (!rep_->has_filter) {
+    return true;
+  }
+  if (!rep_->whole_key_filtering) {
+    // only the prefix of the key can be checked
+    return PrefixMayMatch(read_options, internal_key);
+  }
+
+  auto filter_entry = GetFilter(read_options.read_tier == kBlockCacheTier);
+  if (filter_entry.value == nullptr) {
+    return true;
+  }
+
+  bool may_match =
+      filter_entry.value->KeyMayMatch(ExtractUserKey(internal_key));
+  if (may_match) {
+    PERF_COUNTER_ADD(bloom_sst_hit_count, 1);
+  } else {
+    RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+    PERF_COUNTER_ADD(bloom_sst_miss_count, 1);
+  }
+  filter_entry.Release(rep_->table_options.block_cache.get());
+  return may_match;
+}
+
+bool ColumnTable::PrefixMayMatch(const ReadOptions& read_options,
+                                 const Slice& internal_key) {
+  if (!rep_->prefix_filtering || read_options.total_order_seek) {
+    return true;
+  }
+  const SliceTransform* prefix_extractor = rep_->ioptions.prefix_extractor;
+  Slice user_key = ExtractUserKey(internal_key);
+  if (!prefix_extractor->InDomain(user_key)) {
+    return true;
+  }
+
+  auto filter_entry = GetFilter(read_options.read_tier == kBlockCacheTier);
+  if (filter_entry.value == nullptr) {
+    return true;
+  }
+
+  RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_PREFIX_CHECKED);
+  bool may_match = filter_entry.value->PrefixMayMatch(
+      prefix_extractor->Transform(user_key));
+  if (may_match) {
+    PERF_COUNTER_ADD(bloom_sst_hit_count, 1);
+  } else {
+    RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_PREFIX_USEFUL);
+    PERF_COUNTER_ADD(bloom_sst_miss_count, 1);
+  }
+  filter_entry.Release(rep_->table_options.block_cache.get());
+  return may_match;
+}
+
 Status ColumnTable::DumpIndexBlock(WritableFile* out_file) {
   out_file->Append(
       "Index Details:\n"
@@ -610,7 +1017,8 @@ Status ColumnTable::Open(const ImmutableCFOptions& ioptions,
                          uint64_t file_size,
                          unique_ptr<TableReader>* table_reader,
                          const bool prefetch_index, const int level,
-                         const std::vector<uint32_t>& cols) {
+                         const std::vector<uint32_t>& cols,
+                         ReadAmpStats* read_amp_stats) {
   table_reader->reset();
 
   Footer footer;
@@ -656,6 +1064,10 @@ Status ColumnTable::Open(const ImmutableCFOptions& ioptions,
     if (!s.ok()) {
       return s;
     }
+    if (read_amp_stats != nullptr) {
+      rep->level_stats = read_amp_stats->ForLevel(level);
+      rep->column_stats = read_amp_stats->ForColumn(rep->column_num);
+    }
 
     rep->tables.resize(column_count);
     if (rep->column_num == 0 &&
@@ -687,11 +1099,14 @@ Status ColumnTable::Open(const ImmutableCFOptions& ioptions,
         col_file = NewReadaheadRandomAccessFile(std::move(col_file), readahead);
       }
       unique_ptr<RandomAccessFileReader> file_reader(
-          new RandomAccessFileReader(std::move(col_file), ioptions.env));
+          new RandomAccessFileReader(std::move(col_file), ioptions.env,
+                                     nullptr, 0, nullptr,
+                                     rep->file->rate_limiter(),
+                                     rep->file->for_compaction()));
       unique_ptr<TableReader> table;
       s = Open(ioptions, env_options, table_options, *(rep->column_comparator),
                std::move(file_reader), file_sizes[i], &table, prefetch_index,
-               level);
+               level, std::vector<uint32_t>(), read_amp_stats);
       if (!s.ok()) {
         return s;
       }
@@ -748,8 +1163,58 @@ Status ColumnTable::Open(const ImmutableCFOptions& ioptions,
     }
   }
 
+  // Find the filter block built with the configured filter policy
+  if (rep->column_num == 0 && rep->table_options.filter_policy != nullptr) {
+    std::string filter_block_name =
+        kFullFilterBlockPrefix + rep->table_options.filter_policy->Name();
+    rep->has_filter = FindMetaBlock(meta_iter.get(), filter_block_name,
+                                    &rep->filter_handle).ok();
+  }
+  if (rep->has_filter && rep->table_properties != nullptr) {
+    const TableProperties& props = *rep->table_properties;
+    rep->whole_key_filtering = props.whole_key_filtering != 0;
+    rep->prefix_filtering =
+        rep->ioptions.prefix_extractor != nullptr &&
+        props.prefix_extractor_name == rep->ioptions.prefix_extractor->Name();
+  }
+
   unique_ptr<ColumnTable> new_table(new ColumnTable(rep));
-  if (prefetch_index) {
+  Cache* block_cache = rep->table_options.block_cache.get();
+  if (prefetch_index && block_cache != nullptr &&
+      rep->table_options.cache_index_and_filter_blocks) {
+    // The index and filter are accessed through the block cache, so only
+    // warm it. Those of L0 tables, and the top-level index of a partitioned
+    // index if asked, are pinned in the cache until the table is closed.
+    const bool pin_all =
+        level == 0 &&
+        rep->table_options.pin_l0_filter_and_index_blocks_in_cache;
+    const bool partitioned = rep->table_properties != nullptr &&
+                             rep->table_properties->index_partitions > 0;
+    CachableEntry<IndexReader> index_entry;
+    std::unique_ptr<InternalIterator> iter(
+        new_table->NewIndexIterator(ReadOptions(), nullptr, &index_entry));
+    s = iter->status();
+    iter.reset();
+    if (s.ok() && pin_all && partitioned) {
+      s = new_table->PinIndexPartitions(index_entry.value);
+    }
+    if (s.ok() && (pin_all ||
+                   (partitioned && rep->table_options.pin_top_level_index))) {
+      rep->index_entry = index_entry;
+    } else {
+      index_entry.Release(block_cache);
+    }
+
+    if (s.ok() && rep->has_filter) {
+      CachableEntry<FullFilterBlockReader> filter_entry =
+          new_table->GetFilter(false /* no_io */);
+      if (pin_all) {
+        rep->filter_entry = filter_entry;
+      } else {
+        filter_entry.Release(block_cache);
+      }
+    }
+  } else if (prefetch_index) {
     // pre-fetching of blocks is turned on
     // If we don't use block cache for index blocks access, we'll
     // pre-load these blocks, which will kept in member variables in Rep
@@ -762,6 +1227,23 @@ Status ColumnTable::Open(const ImmutableCFOptions& ioptions,
     } else {
       delete index_reader;
     }
+
+    if (s.ok() && rep->has_filter) {
+      FullFilterBlockReader* filter = nullptr;
+      Status filter_s = FullFilterBlockReader::Create(
+          rep->file.get(), rep->filter_handle, rep->ioptions.env,
+          rep->table_options.filter_policy.get(), rep->ioptions.statistics,
+          &filter);
+      if (filter_s.ok()) {
+        rep->filter.reset(filter);
+      } else {
+        // the table is still readable, just without the filter
+        Log(InfoLogLevel::WARN_LEVEL, rep->ioptions.info_log,
+            "Encountered error while reading the filter block %s",
+            filter_s.ToString().c_str());
+        rep->has_filter = false;
+      }
+    }
   }
 
   if (s.ok()) {
@@ -919,12 +1401,13 @@ class ColumnTable::RangeQueryIterator : public InternalIterator {
       const std::vector<SubColumnTableIterator*>& sub_iters,
       const std::vector<uint32_t>& columns,
       std::vector<std::shared_ptr<const TableProperties>>& table_properties,
-      const Slice& smallest_user_key)
+      const Slice& smallest_user_key, const std::vector<Rep*>& reps)
       : main_iter_(main_iter),
         sub_iters_(sub_iters),
         columns_(columns),
         table_properties_(table_properties),
-        smallest_user_key_(smallest_user_key) {}
+        smallest_user_key_(smallest_user_key),
+        reps_(reps) {}
 
   virtual ~RangeQueryIterator() {
     delete main_iter_;
@@ -1009,12 +1492,14 @@ class ColumnTable::RangeQueryIterator : public InternalIterator {
     // If block_bits is empty, imply a full scan. No empty table case.
     // handle key column case
     size_t j = 0;
+    uint64_t skipped = 0;
     main_iter_->SetArea(forward);
     // block level
     for (main_iter_->SeekToFirst(); main_iter_->Valid();
          main_iter_->FirstLevelNext(true), j++) {
       assert(block_bits.empty() || j < block_bits.size());
       if (!block_bits.empty() && !block_bits[j]) {
+        skipped++;
         continue;
       }
       // within block
@@ -1037,6 +1522,7 @@ class ColumnTable::RangeQueryIterator : public InternalIterator {
       }
     }
     forward = main_iter_->GetArea();
+    reps_[0]->RecordBlocksSkipped(skipped);
     if (columns_.front() == 0) {
       limit -= segment_size;
       backward = reinterpret_cast<uint64_t*>(limit);
@@ -1045,12 +1531,14 @@ class ColumnTable::RangeQueryIterator : public InternalIterator {
     // handle other column cases
     for (size_t i = 0; i < sub_iters_.size(); i++) {
       j = 0;
+      skipped = 0;
       auto iter = sub_iters_[i];
       iter->SetArea(forward);
       // block level
       for (iter->SeekToFirst(); iter->Valid(); iter->FirstLevelNext(true), j++) {
         assert(block_bits.empty() || j < block_bits.size());
         if (!block_bits.empty() && !block_bits[j]) {
+          skipped++;
           continue;
         }
         // within block
@@ -1065,6 +1553,7 @@ class ColumnTable::RangeQueryIterator : public InternalIterator {
         }
       }
       forward = iter->GetArea();
+      reps_[i + 1]->RecordBlocksSkipped(skipped);
       limit -= segment_size;
       backward = reinterpret_cast<uint64_t*>(limit);
     }
@@ -1078,6 +1567,8 @@ class ColumnTable::RangeQueryIterator : public InternalIterator {
   const std::vector<uint32_t> columns_;
   std::vector<std::shared_ptr<const TableProperties>> table_properties_;
   Slice smallest_user_key_;
+  // the rep of the main column, then the ones of sub_iters_
+  const std::vector<Rep*> reps_;
 };
 
 // Note: Column index must be from 0 to MAX_COLUMN_INDEX.
@@ -1127,6 +1618,8 @@ InternalIterator* ColumnTable::NewIterator(const ReadOptions& read_options,
 
     std::vector<std::shared_ptr<const TableProperties>> table_properties;
     table_properties.push_back(rep_->table_properties);
+    std::vector<Rep*> reps;
+    reps.push_back(rep_);
 
     std::vector<SubColumnTableIterator*> sub_iters;  // sub column
     for (const auto& column_index : ro.columns) {  // sub column
@@ -1139,25 +1632,35 @@ InternalIterator* ColumnTable::NewIterator(const ReadOptions& read_options,
           new BlockEntryIteratorState(table.get(), ro)));
 
       table_properties.push_back(table->rep_->table_properties);
+      reps.push_back(table->rep_);
     }
 
     return new RangeQueryIterator(main_iter, sub_iters, ro.columns,
-                                  table_properties, smallest_user_key);
+                                  table_properties, smallest_user_key, reps);
   }
 }
 
 Status ColumnTable::Get(const ReadOptions& read_options, const Slice& key,
                         GetContext* get_context) {
+  Status s;
+  if (!KeyMayMatch(read_options, key)) {
+    return s;
+  }
+
   ReadOptions ro = SanitizeColumnReadOptions(
       rep_->table_options.column_count, read_options);
-  BlockIter iiter;
-  NewIndexIterator(ro, &iiter);
+  BlockIter iiter_on_stack;
+  InternalIterator* iiter = NewIndexIterator(ro, &iiter_on_stack);
+  std::unique_ptr<InternalIterator> iiter_unique_ptr;
+  if (iiter != &iiter_on_stack) {
+    // a partitioned index returns a two-level iterator
+    iiter_unique_ptr.reset(iiter);
+  }
 
-  Status s;
   bool done = false;
-  for (iiter.Seek(key); iiter.Valid() && !done; iiter.Next()) {
+  for (iiter->Seek(key); iiter->Valid() && !done; iiter->Next()) {
     std::unique_ptr<InternalIterator> biter;
-    biter.reset(NewDataBlockIterator(rep_, ro, iiter.value()));
+    biter.reset(NewDataBlockIterator(rep_, ro, iiter->value()));
     if (ro.read_tier == kBlockCacheTier && biter->status().IsIncomplete()) {
       // couldn't get block from block_cache
       // Update Saver.state to Found because we are only looking for whether
@@ -1225,7 +1728,7 @@ Status ColumnTable::Get(const ReadOptions& read_options, const Slice& key,
     }
   }
   if (s.ok()) {
-    s = iiter.status();
+    s = iiter->status();
   }
 
   return s;
@@ -1245,21 +1748,26 @@ Status ColumnTable::Prefetch(const Slice* const begin, const Slice* const end,
     return Status::InvalidArgument(*begin, *end);
   }
 
-  BlockIter iiter;
-  NewIndexIterator(ro, &iiter);
+  BlockIter iiter_on_stack;
+  InternalIterator* iiter = NewIndexIterator(ro, &iiter_on_stack);
+  std::unique_ptr<InternalIterator> iiter_unique_ptr;
+  if (iiter != &iiter_on_stack) {
+    // a partitioned index returns a two-level iterator
+    iiter_unique_ptr.reset(iiter);
+  }
 
-  if (!iiter.status().ok()) {
+  if (!iiter->status().ok()) {
     // error opening index iterator
-    return iiter.status();
+    return iiter->status();
   }
 
   // indicates if we are on the last page that need to be pre-fetched
   bool prefetching_boundary_page = false;
 
-  for (begin ? iiter.Seek(*begin) : iiter.SeekToFirst(); iiter.Valid();
-       iiter.Next()) {
+  for (begin ? iiter->Seek(*begin) : iiter->SeekToFirst(); iiter->Valid();
+       iiter->Next()) {
 
-    if (end && comparator.Compare(iiter.key(), *end) >= 0) {
+    if (end && comparator.Compare(iiter->key(), *end) >= 0) {
       if (prefetching_boundary_page) {
         break;
       }
@@ -1271,7 +1779,7 @@ Status ColumnTable::Prefetch(const Slice* const begin, const Slice* const end,
 
     // Load the block specified by the block_handle into the block cache
     std::unique_ptr<InternalIterator> biter;
-    biter.reset(NewDataBlockIterator(rep_, ro, iiter.value()));
+    biter.reset(NewDataBlockIterator(rep_, ro, iiter->value()));
     if (!biter->status().ok()) {
       // there was an unexpected error while pre-fetching
       return biter->status();
@@ -1400,6 +1908,9 @@ size_t ColumnTable::ApproximateMemoryUsage() const {
   if (rep_->index_reader) {
     usage += rep_->index_reader->ApproximateMemoryUsage();
   }
+  if (rep_->filter) {
+    usage += rep_->filter->ApproximateMemoryUsage();
+  }
   for (const auto& it : rep_->tables) {
     if (it) {
       usage += it->ApproximateMemoryUsage();
@@ -1438,6 +1949,10 @@ Status ColumnTable::DumpTable(WritableFile* out_file) {
         out_file->Append("  Compression dictionary block handle: ");
         out_file->Append(meta_iter->value().ToString(true).c_str());
         out_file->Append("\n");
+      } else if (meta_iter->key().starts_with(kFullFilterBlockPrefix)) {
+        out_file->Append("  Filter block handle: ");
+        out_file->Append(meta_iter->value().ToString(true).c_str());
+        out_file->Append("\n");
       }
     }
     out_file->Append("\n");
@@ -1470,6 +1985,17 @@ Status ColumnTable::DumpTable(WritableFile* out_file) {
 }
 
 void ColumnTable::Close() {
+  // release the pinned blocks, so the erase below frees them
+  Cache* block_cache = rep_->table_options.block_cache.get();
+  if (block_cache != nullptr) {
+    rep_->index_entry.Release(block_cache);
+    rep_->filter_entry.Release(block_cache);
+    for (Cache::Handle* handle : rep_->pinned_partitions) {
+      block_cache->Release(handle);
+    }
+    rep_->pinned_partitions.clear();
+  }
+
   // cleanup index blocks to avoid accessing dangling pointer
   if (!rep_->table_options.no_block_cache) {
     char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
@@ -1478,6 +2004,12 @@ void ColumnTable::Close() {
         rep_->cache_key_prefix, rep_->cache_key_prefix_size,
         rep_->dummy_index_reader_offset, cache_key);
     rep_->table_options.block_cache.get()->Erase(key);
+    // Get the filter block key
+    if (rep_->has_filter) {
+      key = GetCacheKey(rep_->cache_key_prefix, rep_->cache_key_prefix_size,
+                        rep_->filter_handle, cache_key);
+      rep_->table_options.block_cache.get()->Erase(key);
+    }
   }
   for (const auto& it : rep_->tables) {
     if (it) {
@@ -10,10 +10,12 @@
 #include <utility>
 #include <string>
 
+#include "vidardb/cache.h"
 #include "vidardb/options.h"
 #include "vidardb/statistics.h"
 #include "vidardb/status.h"
 #include "vidardb/table.h"
+#include "table/block_prefetcher.h"
 #include "table/table_properties_internal.h"
 #include "table/table_reader.h"
 #include "table/two_level_iterator.h"
@@ -25,6 +27,7 @@ namespace vidardb {
 class Block;
 class BlockIter;
 class BlockHandle;
+struct BlockContents;
 class Cache;
 class Footer;
 class InternalKeyComparator;
@@ -39,6 +42,8 @@ struct ReadOptions;
 class GetContext;
 class InternalIterator;
 class IndexReader;
+class FullFilterBlockReader;
+class ReadAmpStats;
 
 using std::unique_ptr;
 
@@ -62,6 +67,11 @@ class ColumnTable : public TableReader {
   //
   // @param file must remain live while this Table is in use.
   // @param prefetch_index sets prefetching of index blocks at startup.
+  // @param level is the level of the table in the LSM tree, -1 if unknown.
+  //        The index and filter blocks of L0 tables may be pinned in the
+  //        block cache, see ColumnTableOptions.
+  // @param read_amp_stats counts the data blocks read at the level and in the
+  //        columns of the table, if not nullptr.
   static Status Open(const ImmutableCFOptions& ioptions,
                      const EnvOptions& env_options,
                      const ColumnTableOptions& table_options,
@@ -70,7 +80,8 @@ class ColumnTable : public TableReader {
                      uint64_t file_size, unique_ptr<TableReader>* table_reader,
                      bool prefetch_index = true, int level = -1,
                      const std::vector<uint32_t>& cols =
-                             std::vector<uint32_t>());
+                             std::vector<uint32_t>(),
+                     ReadAmpStats* read_amp_stats = nullptr);
 
   // Returns a new iterator over the table contents.
   // The result of NewIterator() is initially invalid (caller must
@@ -118,18 +129,30 @@ class ColumnTable : public TableReader {
   class BlockEntryIteratorState : public TwoLevelIteratorState {
    public:
     BlockEntryIteratorState(ColumnTable* table, const ReadOptions& read_options)
-        : TwoLevelIteratorState(), table_(table), read_options_(read_options) {}
+        : TwoLevelIteratorState(!read_options.total_order_seek),
+          table_(table),
+          read_options_(read_options),
+          prefetcher_(read_options.read_tier == kBlockCacheTier
+                          ? 0
+                          : read_options.async_readahead_size) {}
 
     InternalIterator* NewSecondaryIterator(const Slice& index_value) override {
+      table_->PrefetchFollowingBlocks(&prefetcher_, index_value);
       return NewDataBlockIterator(table_->rep_, read_options_, index_value);
     }
 
+    // Only the main column has a filter; the others always match.
+    bool PrefixMayMatch(const Slice& internal_key) override {
+      return table_->PrefixMayMatch(read_options_, internal_key);
+    }
+
     InternalIterator* NewIndexIterator(BlockIter* input_iter) {
       return table_->NewIndexIterator(read_options_, input_iter);
     }
 
     InternalIterator* NewDataIterator(const Slice& index_value,
                                       BlockIter* input_iter, char** area) {
+      table_->PrefetchFollowingBlocks(&prefetcher_, index_value);
       return NewDataBlockIterator(table_->rep_, read_options_, index_value,
                                   input_iter, area);
     }
@@ -138,6 +161,7 @@ class ColumnTable : public TableReader {
     // Don't own table_
     ColumnTable* table_;
     const ReadOptions read_options_;
+    BlockPrefetcher prefetcher_;
   };
 
  private:
@@ -166,29 +190,42 @@ class ColumnTable : public TableReader {
                            const BlockHandle& handle, char* cache_key);
 
   // Put a raw block to the corresponding block caches.
-  // This method will populate the block caches.
+  // This method will populate the block caches: a compressed raw block goes
+  // to block_cache_compressed as it is, and uncompressed to block_cache.
   // On success, Status::OK will be returned; also @block will be populated with
   // uncompressed block and its cache handle.
   //
-  // REQUIRES: raw_block is heap-allocated. PutDataBlockToCache() will be
-  // responsible for releasing its memory if error occurs.
+  // REQUIRES: raw_block_contents is read from the file with its trailer, and
+  // is moved from if it goes to block_cache_compressed.
   static Status PutDataBlockToCache(
-      const Slice& block_cache_key, Cache* block_cache, Statistics* statistics,
-      CachableEntry<Block>* block, Block* raw_block);
-
-  // Read block cache from block caches (if set): block_cache.
+      const Slice& block_cache_key, const Slice& compressed_block_cache_key,
+      Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
+      CachableEntry<Block>* block, BlockContents* raw_block_contents,
+      const Slice& compression_dict,
+      Cache::Priority priority = Cache::Priority::LOW);
+
+  // Read block cache from block caches (if set): block_cache and
+  // block_cache_compressed. A block found compressed is uncompressed and
+  // promoted to block_cache if read_options.fill_cache is set.
   // On success, Status::OK with be returned and @block will be populated with
   // pointer to the block as well as its block handle.
+  // is_index: the block is an index partition, counted as an index access.
   static Status GetDataBlockFromCache(
-      const Slice& block_cache_key, Cache* block_cache, Statistics* statistics,
-      ColumnTable::CachableEntry<Block>* block);
+      const Slice& block_cache_key, const Slice& compressed_block_cache_key,
+      Cache* block_cache, Cache* block_cache_compressed, Statistics* statistics,
+      const ReadOptions& read_options,
+      ColumnTable::CachableEntry<Block>* block, const Slice& compression_dict,
+      bool is_index = false,
+      Cache::Priority priority = Cache::Priority::LOW);
 
   // input_iter: if it is not null, update this one and return it as Iterator
+  // is_index: the block is a partition of a partitioned index
   static InternalIterator* NewDataBlockIterator(Rep* rep,
                                                 const ReadOptions& read_options,
                                                 const Slice& index_value,
                                                 BlockIter* input_iter = nullptr,
-                                                char** area = nullptr);
+                                                char** area = nullptr,
+                                                bool is_index = false);
 
   // Create a index reader based on the index type stored in the table.
   Status CreateIndexReader(IndexReader** index_reader);
@@ -206,6 +243,30 @@ class ColumnTable : public TableReader {
       const ReadOptions& read_options, BlockIter* input_iter = nullptr,
       CachableEntry<IndexReader>* index_entry = nullptr);
 
+  // Get the filter of the main column, from the pre-loaded one or the block
+  // cache. The value is nullptr if there is no filter, or the filter is not
+  // in the block cache and no_io is set. The caller releases the entry.
+  CachableEntry<FullFilterBlockReader> GetFilter(bool no_io) const;
+
+  // Let prefetcher prefetch the blocks following the data block of the index
+  // entry index_value, read by one of the iterators of this column.
+  void PrefetchFollowingBlocks(BlockPrefetcher* prefetcher,
+                               const Slice& index_value);
+
+  // Read the partitions of a partitioned index into the block cache and keep
+  // them referenced by rep_ until the table is closed.
+  Status PinIndexPartitions(IndexReader* index_reader);
+
+  // Returns false if the filter says the user key of internal_key is not in
+  // the table.
+  bool KeyMayMatch(const ReadOptions& read_options, const Slice& internal_key);
+
+  // Returns false if the filter says no key with the prefix of internal_key
+  // is in the table. Always true for total order seeks, or if the filter was
+  // not built with the prefix extractor of the column family.
+  bool PrefixMayMatch(const ReadOptions& read_options,
+                      const Slice& internal_key);
+
   explicit ColumnTable(Rep* rep)
       : rep_(rep), compaction_optimized_(false) {}
 
@@ -0,0 +1,113 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/data_block_hash_index.h"
+
+#include <assert.h>
+
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace vidardb {
+
+namespace {
+const uint32_t kSeed = 54321;
+const uint32_t kIndexTypeBitShift = 31;
+const uint32_t kMaxNumRestarts = (1u << kIndexTypeBitShift) - 1u;
+const uint32_t kNumRestartsMask = (1u << kIndexTypeBitShift) - 1u;
+}  // namespace
+
+uint32_t PackIndexTypeAndNumRestarts(BlockIndexType index_type,
+                                     uint32_t num_restarts) {
+  assert(num_restarts <= kMaxNumRestarts);
+  uint32_t block_footer = num_restarts;
+  if (index_type == kBinaryAndHash) {
+    block_footer |= 1u << kIndexTypeBitShift;
+  }
+  return block_footer;
+}
+
+void UnPackIndexTypeAndNumRestarts(uint32_t block_footer,
+                                   BlockIndexType* index_type,
+                                   uint32_t* num_restarts) {
+  if (index_type != nullptr) {
+    *index_type = (block_footer & (1u << kIndexTypeBitShift))
+                      ? kBinaryAndHash
+                      : kBinarySearchOnly;
+  }
+  if (num_restarts != nullptr) {
+    *num_restarts = block_footer & kNumRestartsMask;
+  }
+}
+
+void DataBlockHashIndexBuilder::Add(const Slice& user_key,
+                                    const size_t restart_index) {
+  assert(Valid());
+  if (restart_index > kMaxRestartSupportedByHashIndex) {
+    valid_ = false;
+    return;
+  }
+
+  uint32_t hash_value = Hash(user_key.data(), user_key.size(), kSeed);
+  hash_and_restart_pairs_.emplace_back(hash_value,
+                                       static_cast<uint8_t>(restart_index));
+}
+
+void DataBlockHashIndexBuilder::Finish(std::string* buffer) {
+  assert(Valid());
+  uint16_t num_buckets =
+      static_cast<uint16_t>(hash_and_restart_pairs_.size() * bucket_per_key_);
+  // Maintain NUM_BUCKETS to be odd for a better distribution
+  num_buckets |= 1;
+
+  std::vector<uint8_t> buckets(num_buckets, kNoEntry);
+  for (auto& entry : hash_and_restart_pairs_) {
+    uint16_t buck_idx = static_cast<uint16_t>(entry.first % num_buckets);
+    uint8_t& bucket = buckets[buck_idx];
+    if (bucket == kNoEntry) {
+      bucket = entry.second;
+    } else if (bucket != entry.second) {
+      bucket = kCollision;
+    }
+  }
+
+  for (uint8_t restart_index : buckets) {
+    buffer->append(reinterpret_cast<const char*>(&restart_index),
+                   sizeof(restart_index));
+  }
+  PutFixed16(buffer, num_buckets);
+}
+
+void DataBlockHashIndexBuilder::Reset() {
+  hash_and_restart_pairs_.clear();
+  valid_ = bucket_per_key_ > 0;
+}
+
+bool DataBlockHashIndex::Initialize(const char* data, uint16_t size,
+                                    uint16_t* map_offset) {
+  num_buckets_ = 0;
+  if (size < sizeof(uint16_t)) {
+    return false;
+  }
+  uint16_t num_buckets = DecodeFixed16(data + size - sizeof(uint16_t));
+  if (num_buckets == 0 ||
+      size < sizeof(uint16_t) + num_buckets * sizeof(uint8_t)) {
+    return false;
+  }
+  num_buckets_ = num_buckets;
+  *map_offset = static_cast<uint16_t>(size - sizeof(uint16_t) -
+                                      num_buckets_ * sizeof(uint8_t));
+  return true;
+}
+
+uint8_t DataBlockHashIndex::Lookup(const char* data, uint32_t map_offset,
+                                   const Slice& user_key) const {
+  uint32_t hash_value = Hash(user_key.data(), user_key.size(), kSeed);
+  uint16_t idx = static_cast<uint16_t>(hash_value % num_buckets_);
+  const char* bucket_table = data + map_offset;
+  return static_cast<uint8_t>(*(bucket_table + idx * sizeof(uint8_t)));
+}
+
+}  // namespace vidardb
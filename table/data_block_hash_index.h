@@ -0,0 +1,108 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// A hash table appended to a data block, mapping the user keys of the block
+// to the restart intervals holding them, so that a point lookup goes to its
+// restart interval directly instead of binary searching the restart array.
+//
+// The block layout with the hash table:
+//
+//   [entries] [restarts: uint32 * num_restarts]
+//   [buckets: uint8 * num_buckets] [num_buckets: uint16]
+//   [num_restarts with the index type in its most significant bit: uint32]
+//
+// A bucket holds the restart index of the keys hashed to it, kNoEntry if no
+// key is hashed to it, or kCollision if keys of different restart intervals
+// are hashed to it. The restart index is a uint8, so the hash table is only
+// built for blocks of at most kMaxRestartSupportedByHashIndex restarts.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "vidardb/slice.h"
+
+namespace vidardb {
+
+const uint8_t kNoEntry = 255;
+const uint8_t kCollision = 254;
+const uint8_t kMaxRestartSupportedByHashIndex = 253;
+
+// Because the bucket count is a uint16, the hash table is only built for
+// blocks whose uncompressed size is at most 64KB.
+const size_t kMaxBlockSizeSupportedByHashIndex = 1u << 16;
+
+enum BlockIndexType : uint8_t {
+  kBinarySearchOnly = 0x00,
+  kBinaryAndHash = 0x01,
+};
+
+uint32_t PackIndexTypeAndNumRestarts(BlockIndexType index_type,
+                                     uint32_t num_restarts);
+
+void UnPackIndexTypeAndNumRestarts(uint32_t block_footer,
+                                   BlockIndexType* index_type,
+                                   uint32_t* num_restarts);
+
+class DataBlockHashIndexBuilder {
+ public:
+  DataBlockHashIndexBuilder() : bucket_per_key_(-1), valid_(false) {}
+
+  // util_ratio: the number of keys per bucket, in (0, 1].
+  void Initialize(double util_ratio) {
+    if (util_ratio <= 0) {
+      util_ratio = 0.75;  // sanity check
+    }
+    bucket_per_key_ = 1 / util_ratio;
+    valid_ = true;
+  }
+
+  // False if the builder is not initialized or the block got too many
+  // restarts to be indexed.
+  bool Valid() const { return valid_ && bucket_per_key_ > 0; }
+
+  void Add(const Slice& user_key, const size_t restart_index);
+
+  // Append the hash table to buffer. REQUIRES: Valid()
+  void Finish(std::string* buffer);
+
+  void Reset();
+
+  size_t EstimateSize() const {
+    size_t estimated_num_buckets =
+        static_cast<size_t>(hash_and_restart_pairs_.size() * bucket_per_key_);
+    // Maintain NUM_BUCKETS to be odd for a better distribution
+    estimated_num_buckets |= 1;
+    return sizeof(uint16_t) + estimated_num_buckets * sizeof(uint8_t);
+  }
+
+ private:
+  double bucket_per_key_;  // the inverse of the util ratio
+  bool valid_;
+  std::vector<std::pair<uint32_t, uint8_t>> hash_and_restart_pairs_;
+};
+
+class DataBlockHashIndex {
+ public:
+  DataBlockHashIndex() : num_buckets_(0) {}
+
+  // data/size: the block contents without the packed num_restarts footer.
+  // Sets *map_offset to the offset of the buckets in data. Returns false if
+  // the size can't hold the hash table.
+  bool Initialize(const char* data, uint16_t size, uint16_t* map_offset);
+
+  // Returns the restart index of user_key, kNoEntry or kCollision.
+  uint8_t Lookup(const char* data, uint32_t map_offset,
+                 const Slice& user_key) const;
+
+  bool Valid() const { return num_buckets_ != 0; }
+
+ private:
+  uint16_t num_buckets_;
+};
+
+}  // namespace vidardb
@@ -15,6 +15,7 @@
 #include "vidardb/env.h"
 #include "table/block.h"
 #include "table/block_based_table_reader.h"
+#include "table/persistent_cache_helper.h"
 #include "util/coding.h"
 #include "util/compression.h"
 #include "util/crc32c.h"
@@ -212,7 +213,8 @@ Status ReadBlockContents(RandomAccessFileReader* file,
                          const BlockHandle& handle, BlockContents* contents,
                          Env* env, bool decompression_requested,
                          const Slice& compression_dict, Logger* info_log,
-                         char** area) {  // Shichao
+                         char** area,  // Shichao
+                         const PersistentCacheOptions* cache_options) {
   Status status;
   Slice slice;
   size_t n = static_cast<size_t>(handle.size());
@@ -220,25 +222,47 @@ Status ReadBlockContents(RandomAccessFileReader* file,
   char stack_buf[DefaultStackBufferSize];
   char* used_buf = nullptr;
   vidardb::CompressionType compression_type;
+  const bool use_persistent_cache =
+      cache_options != nullptr && cache_options->persistent_cache != nullptr;
 
   status = Status::NotFound();
 
-  // cache miss read from device
-  if (decompression_requested &&
-          n + kBlockTrailerSize < DefaultStackBufferSize) {
-    // If we've got a small enough hunk of data, read it in to the
-    // trivially allocated stack buffer instead of needing a full malloc()
-    used_buf = &stack_buf[0];
-  } else {
-    heap_buf = std::unique_ptr<char[], BlockContents::Deleter>(
-        new char[n + kBlockTrailerSize]);  // Shichao
-    used_buf = heap_buf.get();
+  if (use_persistent_cache) {
+    // the persistent cache validates its own checksum of the raw block
+    std::unique_ptr<char[]> raw_data;
+    status = PersistentCacheHelper::LookupRawPage(*cache_options, handle,
+                                                  &raw_data,
+                                                  n + kBlockTrailerSize);
+    if (status.ok()) {
+      heap_buf.reset(raw_data.release());
+      used_buf = heap_buf.get();
+      slice = Slice(used_buf, n + kBlockTrailerSize);
+    }
   }
 
-  status = ReadBlock(file, read_options, handle, &slice, used_buf);
-
   if (!status.ok()) {
-    return status;
+    // cache miss read from device
+    if (decompression_requested &&
+            n + kBlockTrailerSize < DefaultStackBufferSize) {
+      // If we've got a small enough hunk of data, read it in to the
+      // trivially allocated stack buffer instead of needing a full malloc()
+      used_buf = &stack_buf[0];
+    } else {
+      heap_buf = std::unique_ptr<char[], BlockContents::Deleter>(
+          new char[n + kBlockTrailerSize]);  // Shichao
+      used_buf = heap_buf.get();
+    }
+
+    status = ReadBlock(file, read_options, handle, &slice, used_buf);
+
+    if (!status.ok()) {
+      return status;
+    }
+
+    if (use_persistent_cache) {
+      PersistentCacheHelper::InsertRawPage(*cache_options, handle,
+                                           slice.data(), slice.size());
+    }
   }
 
   PERF_TIMER_GUARD(block_decompress_time);
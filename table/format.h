@@ -21,6 +21,7 @@ namespace vidardb {
 
 class Block;
 class RandomAccessFile;
+struct PersistentCacheOptions;
 struct ReadOptions;
 
 // the length of the magic number in bytes.
@@ -199,11 +200,14 @@ struct BlockContents {
 
 // Read the block identified by "handle" from "file".  On failure
 // return non-OK.  On success fill *result and return OK.
+// If cache_options has a persistent cache, the raw block is looked up there
+// before reading the file, and inserted after.
 extern Status ReadBlockContents(
     RandomAccessFileReader* file, const ReadOptions& options,
     const BlockHandle& handle, BlockContents* contents, Env* env,
     bool do_uncompress = true, const Slice& compression_dict = Slice(),
-    Logger* info_log = nullptr, char** area = nullptr);  // Shichao
+    Logger* info_log = nullptr, char** area = nullptr,  // Shichao
+    const PersistentCacheOptions* cache_options = nullptr);
 
 // The 'data' points to the raw block contents read in from file.
 // This method allocates a new heap buffer and the raw block
@@ -0,0 +1,85 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/full_filter_block.h"
+
+#include "util/file_reader_writer.h"
+#include "vidardb/env.h"
+#include "vidardb/options.h"
+
+namespace vidardb {
+
+extern const std::string kFullFilterBlockPrefix = "fullfilter.";
+
+FullFilterBlockBuilder::FullFilterBlockBuilder(
+    const SliceTransform* prefix_extractor, bool whole_key_filtering,
+    FilterBitsBuilder* filter_bits_builder)
+    : prefix_extractor_(prefix_extractor),
+      whole_key_filtering_(whole_key_filtering),
+      filter_bits_builder_(filter_bits_builder),
+      last_prefix_recorded_(false),
+      num_added_(0) {
+  assert(filter_bits_builder_ != nullptr);
+  assert(whole_key_filtering_ || prefix_extractor_ != nullptr);
+}
+
+void FullFilterBlockBuilder::Add(const Slice& user_key) {
+  if (!last_key_.empty() && user_key == Slice(last_key_)) {
+    return;
+  }
+  if (whole_key_filtering_) {
+    filter_bits_builder_->AddKey(user_key);
+    num_added_++;
+  }
+  if (prefix_extractor_ != nullptr) {
+    AddPrefix(user_key);
+  }
+  last_key_.assign(user_key.data(), user_key.size());
+}
+
+void FullFilterBlockBuilder::AddPrefix(const Slice& user_key) {
+  if (!prefix_extractor_->InDomain(user_key)) {
+    return;
+  }
+  Slice prefix = prefix_extractor_->Transform(user_key);
+  // keys arrive in order, so the keys sharing a prefix are consecutive
+  if (last_prefix_recorded_ && prefix == Slice(last_prefix_)) {
+    return;
+  }
+  filter_bits_builder_->AddKey(prefix);
+  last_prefix_.assign(prefix.data(), prefix.size());
+  last_prefix_recorded_ = true;
+  num_added_++;
+}
+
+Slice FullFilterBlockBuilder::Finish() {
+  if (num_added_ == 0) {
+    return Slice();
+  }
+  return filter_bits_builder_->Finish(&filter_data_);
+}
+
+Status FullFilterBlockReader::Create(RandomAccessFileReader* file,
+                                     const BlockHandle& filter_handle,
+                                     Env* env,
+                                     const FilterPolicy* filter_policy,
+                                     Statistics* stats,
+                                     FullFilterBlockReader** filter_reader) {
+  assert(filter_policy != nullptr);
+  BlockContents contents;
+  Status s = ReadBlockContents(file, ReadOptions(), filter_handle, &contents,
+                               env, false /* decompress */);
+  if (!s.ok()) {
+    return s;
+  }
+
+  FilterBitsReader* bits_reader =
+      filter_policy->GetFilterBitsReader(contents.data);
+  *filter_reader =
+      new FullFilterBlockReader(std::move(contents), bits_reader, stats);
+  return s;
+}
+
+}  // namespace vidardb
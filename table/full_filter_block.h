@@ -0,0 +1,108 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// A full filter block covers all the user keys of a table file, and/or
+// their prefixes if a prefix extractor is set. It is stored as a meta block
+// named kFullFilterBlockPrefix + policy name, so a reader configured with
+// another policy simply does not find it.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "table/format.h"
+#include "vidardb/filter_policy.h"
+#include "vidardb/slice.h"
+#include "vidardb/slice_transform.h"
+#include "vidardb/statistics.h"
+#include "vidardb/status.h"
+
+namespace vidardb {
+
+class RandomAccessFileReader;
+class Env;
+
+extern const std::string kFullFilterBlockPrefix;
+
+class FullFilterBlockBuilder {
+ public:
+  // Takes the ownership of filter_bits_builder. prefix_extractor may be
+  // nullptr, in which case whole_key_filtering must be true.
+  FullFilterBlockBuilder(const SliceTransform* prefix_extractor,
+                         bool whole_key_filtering,
+                         FilterBitsBuilder* filter_bits_builder);
+
+  // Adds a user key and/or its prefix. Several versions of the same key, and
+  // the consecutive keys of the same prefix, are added once.
+  void Add(const Slice& user_key);
+
+  bool IsEmpty() const { return num_added_ == 0; }
+
+  // Returns the filter contents, valid until the builder is destroyed.
+  Slice Finish();
+
+ private:
+  void AddPrefix(const Slice& user_key);
+
+  const SliceTransform* prefix_extractor_;
+  bool whole_key_filtering_;
+  std::unique_ptr<FilterBitsBuilder> filter_bits_builder_;
+  std::string last_key_;
+  std::string last_prefix_;
+  bool last_prefix_recorded_;
+  uint64_t num_added_;
+  std::unique_ptr<const char[]> filter_data_;
+
+  // No copying allowed
+  FullFilterBlockBuilder(const FullFilterBlockBuilder&);
+  void operator=(const FullFilterBlockBuilder&);
+};
+
+class FullFilterBlockReader {
+ public:
+  // Reads the filter block from the file. On success, filter_reader will be
+  // populated; otherwise it will remain unmodified.
+  static Status Create(RandomAccessFileReader* file,
+                       const BlockHandle& filter_handle, Env* env,
+                       const FilterPolicy* filter_policy, Statistics* stats,
+                       FullFilterBlockReader** filter_reader);
+
+  // Returns false only if the user key is definitely not in the table.
+  // REQUIRES: the filter holds whole keys.
+  bool KeyMayMatch(const Slice& user_key) const {
+    return filter_bits_reader_->MayMatch(user_key);
+  }
+
+  // Returns false only if no key of the prefix is in the table.
+  // REQUIRES: the filter holds the prefixes of the same extractor.
+  bool PrefixMayMatch(const Slice& prefix) const {
+    return filter_bits_reader_->MayMatch(prefix);
+  }
+
+  size_t size() const { return contents_.data.size(); }
+  // Memory usage of the filter block
+  size_t usable_size() const {
+    return contents_.allocation ? contents_.data.size() : 0;
+  }
+  Statistics* statistics() const { return statistics_; }
+  size_t ApproximateMemoryUsage() const {
+    return usable_size() + sizeof(*this);
+  }
+
+ private:
+  FullFilterBlockReader(BlockContents&& contents,
+                        FilterBitsReader* filter_bits_reader,
+                        Statistics* stats)
+      : contents_(std::move(contents)),
+        filter_bits_reader_(filter_bits_reader),
+        statistics_(stats) {}
+
+  BlockContents contents_;
+  std::unique_ptr<FilterBitsReader> filter_bits_reader_;
+  Statistics* statistics_;
+};
+
+}  // namespace vidardb
@@ -5,9 +5,17 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "table/block_prefix_index.h"
 #include "table/min_max_block_builder.h"
 #include "table/format.h"
 #include "vidardb/comparator.h"
+#include "vidardb/slice_transform.h"
 
 namespace vidardb {
 
@@ -25,8 +33,11 @@ class IndexBuilder {
  public:
   // Index builder will construct a set of blocks which contain:
   //  1. One primary index block.
+  //  2. (Optional) a set of metablocks that contains the metadata of the
+  //     primary index.
   struct IndexBlocks {
     Slice index_block_contents;
+    std::unordered_map<std::string, Slice> meta_blocks;
   };
   explicit IndexBuilder(const Comparator* comparator)
       : comparator_(comparator) {}
@@ -57,9 +68,26 @@ class IndexBuilder {
   // REQUIRES: Finish() has not yet been called.
   virtual Status Finish(IndexBlocks* index_blocks) = 0;
 
+  // A partitioned index is written one block at a time: Finish() returns
+  // Status::Incomplete() with the first partition in index_block_contents,
+  // then FinishNextPartition() is called with the handle where the last
+  // partition was written, until it returns Status::OK() with the top-level
+  // index block.
+  //
+  // REQUIRES: the last Finish() or FinishNextPartition() returned
+  //           Status::Incomplete().
+  virtual Status FinishNextPartition(
+      IndexBlocks* index_blocks,
+      const BlockHandle& last_partition_block_handle) {
+    return Status::NotSupported("the index is not partitioned");
+  }
+
   // Get the estimated size for index block.
   virtual size_t EstimatedSize() const = 0;
 
+  // The number of index partitions, 0 if the index is a single block.
+  virtual uint64_t NumPartitions() const { return 0; }
+
  protected:
   const Comparator* comparator_;
 };
@@ -108,6 +136,86 @@ class ShortenedIndexBuilder : public IndexBuilder {
   BlockBuilder index_block_builder_;
 };
 
+// HashIndexBuilder contains a binary-searchable primary index and the
+// metadata for the secondary hash index construction.
+// The metadata for hash index consists of the prefixes of the keys, each
+// mapped to the range of data blocks holding them, which is written to the
+// meta block kHashIndexPrefixesBlock.
+//
+// The reader rebuilds the hash from the prefixes to the index entries, so a
+// seek only binary searches the few index entries of the target's prefix.
+class HashIndexBuilder : public IndexBuilder {
+ public:
+  explicit HashIndexBuilder(const Comparator* comparator,
+                            const SliceTransform* prefix_extractor)
+      // the restart interval must be 1 for an index entry per data block
+      : IndexBuilder(comparator),
+        primary_index_builder_(comparator, 1),
+        prefix_extractor_(prefix_extractor),
+        prefix_index_builder_(prefix_extractor) {}
+
+  virtual void AddIndexEntry(std::string* last_key_in_current_block,
+                             const Slice* first_key_in_next_block,
+                             const BlockHandle& block_handle) override {
+    ++current_block_;
+    primary_index_builder_.AddIndexEntry(last_key_in_current_block,
+                                         first_key_in_next_block, block_handle);
+  }
+
+  virtual void OnKeyAdded(const Slice& key) override {
+    Slice user_key = ExtractUserKey(key);
+    if (!prefix_extractor_->InDomain(user_key)) {
+      // keys out of the domain are found by the search of the whole index
+      return;
+    }
+    Slice key_prefix = prefix_extractor_->Transform(user_key);
+    if (has_pending_prefix_ && key_prefix == Slice(pending_prefix_)) {
+      pending_num_blocks_ = current_block_ - pending_first_block_ + 1;
+      return;
+    }
+    FlushPendingPrefix();
+    pending_prefix_.assign(key_prefix.data(), key_prefix.size());
+    pending_first_block_ = current_block_;
+    pending_num_blocks_ = 1;
+    has_pending_prefix_ = true;
+  }
+
+  virtual Status Finish(IndexBlocks* index_blocks) override {
+    FlushPendingPrefix();
+    Status s = primary_index_builder_.Finish(index_blocks);
+    if (s.ok()) {
+      index_blocks->meta_blocks.insert(
+          {kHashIndexPrefixesBlock, prefix_index_builder_.Finish()});
+    }
+    return s;
+  }
+
+  virtual size_t EstimatedSize() const override {
+    return primary_index_builder_.EstimatedSize() +
+           prefix_index_builder_.EstimatedSize();
+  }
+
+ private:
+  void FlushPendingPrefix() {
+    if (has_pending_prefix_) {
+      prefix_index_builder_.Add(pending_prefix_, pending_first_block_,
+                                pending_num_blocks_);
+      has_pending_prefix_ = false;
+    }
+  }
+
+  ShortenedIndexBuilder primary_index_builder_;
+  const SliceTransform* prefix_extractor_;
+  BlockPrefixIndexBuilder prefix_index_builder_;
+
+  // the index of the data block the next key goes to
+  uint32_t current_block_ = 0;
+  bool has_pending_prefix_ = false;
+  std::string pending_prefix_;
+  uint32_t pending_first_block_ = 0;
+  uint32_t pending_num_blocks_ = 0;
+};
+
 // This index builder builds space-efficient index block with min & max values.
 //
 // Optimizations:
@@ -172,4 +280,155 @@ class MinMaxShortenedIndexBuilder : public IndexBuilder {
   const Comparator* value_comparator_;
 };
 
+// PartitionedIndexBuilder cuts the index into partitions of about
+// metadata_block_size bytes, and indexes the partitions with a top-level
+// index block. Only the top-level index needs to stay in memory, the
+// partitions are read through the block cache like the data blocks.
+//
+// With a value comparator, the partitions and the top-level index keep the
+// min & max values of the blocks they cover, see MinMaxShortenedIndexBuilder.
+class PartitionedIndexBuilder : public IndexBuilder {
+ public:
+  explicit PartitionedIndexBuilder(const Comparator* comparator,
+                                   int index_block_restart_interval,
+                                   uint64_t metadata_block_size,
+                                   const Comparator* value_comparator = nullptr)
+      : IndexBuilder(comparator),
+        index_block_restart_interval_(index_block_restart_interval),
+        metadata_block_size_(metadata_block_size),
+        value_comparator_(value_comparator) {
+    // the top-level index is binary searched like the single-block index
+    if (value_comparator_ != nullptr) {
+      top_level_index_builder_.reset(
+          new MinMaxBlockBuilder(index_block_restart_interval_));
+    } else {
+      top_level_index_builder_.reset(
+          new BlockBuilder(index_block_restart_interval_));
+    }
+  }
+
+  virtual void AddIndexEntry(std::string* last_key_in_current_block,
+                             const Slice* first_key_in_next_block,
+                             const BlockHandle& block_handle) override {
+    if (sub_index_builder_ == nullptr) {
+      MakeNewSubIndexBuilder();
+    }
+    sub_index_builder_->AddIndexEntry(last_key_in_current_block,
+                                      first_key_in_next_block, block_handle);
+    // the separator of the last entry also separates the partitions
+    sub_index_last_key_ = *last_key_in_current_block;
+    if (first_key_in_next_block == nullptr ||
+        sub_index_builder_->EstimatedSize() >= metadata_block_size_) {
+      CutPartition();
+    }
+  }
+
+  virtual void OnKeyAdded(const Slice& key) override {
+    if (sub_index_builder_ == nullptr) {
+      MakeNewSubIndexBuilder();
+    }
+    sub_index_builder_->OnKeyAdded(key);
+    if (value_comparator_ != nullptr) {
+      if (min_partition_value_.empty() ||
+          value_comparator_->Compare(key, min_partition_value_) < 0) {
+        min_partition_value_.assign(key.data(), key.size());
+      }
+      if (max_partition_value_.empty() ||
+          value_comparator_->Compare(key, max_partition_value_) > 0) {
+        max_partition_value_.assign(key.data(), key.size());
+      }
+    }
+  }
+
+  virtual Status Finish(IndexBlocks* index_blocks) override {
+    // the last partition was cut by the index entry of the last data block
+    return FinishNextPartition(index_blocks, BlockHandle());
+  }
+
+  virtual Status FinishNextPartition(
+      IndexBlocks* index_blocks,
+      const BlockHandle& last_partition_block_handle) override {
+    if (next_partition_ > 0) {
+      // the partition returned by the last call has been written
+      Partition& partition = partitions_[next_partition_ - 1];
+      std::string handle_encoding;
+      last_partition_block_handle.EncodeTo(&handle_encoding);
+      if (value_comparator_ != nullptr) {
+        static_cast<MinMaxBlockBuilder*>(top_level_index_builder_.get())
+            ->Add(partition.key, handle_encoding, partition.min_value,
+                  partition.max_value);
+      } else {
+        top_level_index_builder_->Add(partition.key, handle_encoding);
+      }
+      std::string().swap(partition.contents);
+    }
+    if (next_partition_ < partitions_.size()) {
+      index_blocks->index_block_contents =
+          partitions_[next_partition_++].contents;
+      return Status::Incomplete();
+    }
+    index_blocks->index_block_contents = top_level_index_builder_->Finish();
+    return Status::OK();
+  }
+
+  virtual size_t EstimatedSize() const override {
+    size_t size = partitions_size_ +
+                  top_level_index_builder_->CurrentSizeEstimate();
+    if (sub_index_builder_ != nullptr) {
+      size += sub_index_builder_->EstimatedSize();
+    }
+    return size;
+  }
+
+  virtual uint64_t NumPartitions() const override { return partitions_.size(); }
+
+ private:
+  struct Partition {
+    std::string key;
+    std::string contents;
+    std::string min_value;
+    std::string max_value;
+  };
+
+  void MakeNewSubIndexBuilder() {
+    if (value_comparator_ != nullptr) {
+      sub_index_builder_.reset(new MinMaxShortenedIndexBuilder(
+          comparator_, index_block_restart_interval_, value_comparator_));
+    } else {
+      sub_index_builder_.reset(new ShortenedIndexBuilder(
+          comparator_, index_block_restart_interval_));
+    }
+  }
+
+  void CutPartition() {
+    IndexBlocks sub_index_blocks;
+    sub_index_builder_->Finish(&sub_index_blocks);
+    Partition partition;
+    partition.key.swap(sub_index_last_key_);
+    partition.contents = sub_index_blocks.index_block_contents.ToString();
+    partition.min_value.swap(min_partition_value_);
+    partition.max_value.swap(max_partition_value_);
+    partitions_size_ += partition.contents.size();
+    partitions_.push_back(std::move(partition));
+    sub_index_builder_.reset();
+    min_partition_value_.clear();
+    max_partition_value_.clear();
+  }
+
+  int index_block_restart_interval_;
+  uint64_t metadata_block_size_;
+  const Comparator* value_comparator_;
+
+  std::unique_ptr<IndexBuilder> sub_index_builder_;
+  std::string sub_index_last_key_;
+  std::string min_partition_value_;
+  std::string max_partition_value_;
+
+  std::vector<Partition> partitions_;
+  size_t partitions_size_ = 0;
+  // the partition the next call of Finish() returns
+  size_t next_partition_ = 0;
+  std::unique_ptr<BlockBuilder> top_level_index_builder_;
+};
+
 }  // namespace vidardb
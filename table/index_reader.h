@@ -5,8 +5,12 @@
 
 #pragma once
 
+#include <functional>
+
 #include "table/block.h"
+#include "table/block_prefix_index.h"
 #include "table/internal_iterator.h"
+#include "table/two_level_iterator.h"
 
 namespace vidardb {
 
@@ -22,11 +26,14 @@ Status ReadBlockFromFile(RandomAccessFileReader* file,
                          const ReadOptions& options, const BlockHandle& handle,
                          std::unique_ptr<Block>* result, Env* env,
                          bool do_uncompress, const Slice& compression_dict,
-                         Logger* info_log, char** area = nullptr) {  // Shichao
+                         Logger* info_log, char** area = nullptr,  // Shichao
+                         const PersistentCacheOptions* cache_options =
+                             nullptr) {
   BlockContents contents;
   Status s =
       ReadBlockContents(file, options, handle, &contents, env, do_uncompress,
-                        compression_dict, info_log, area);  // Shichao
+                        compression_dict, info_log, area,  // Shichao
+                        cache_options);
   if (s.ok()) {
     result->reset(new Block(std::move(contents)));
   }
@@ -48,7 +55,10 @@ class IndexReader {
   // Create an iterator for index access.
   // An iter is passed in, if it is not null, update this one and return it
   // If it is null, create a new Iterator
-  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr) = 0;
+  // If total_order_seek is false, the iterator may only serve the seeks of
+  // the keys sharing the target's prefix, see ReadOptions::total_order_seek.
+  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr,
+                                        bool total_order_seek = true) = 0;
 
   // The size of the index.
   virtual size_t size() const = 0;
@@ -94,7 +104,8 @@ class BinarySearchIndexReader : public IndexReader {
     return s;
   }
 
-  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr) override {
+  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr,
+                                        bool total_order_seek = true) override {
     return index_block_->NewIterator(comparator_, iter, Block::kTypeBlock);
   }
 
@@ -118,6 +129,82 @@ class BinarySearchIndexReader : public IndexReader {
   std::unique_ptr<Block> index_block_;
 };
 
+// Index that maps the key prefixes to the blocks holding them, so a seek only
+// binary searches the index entries of the target's prefix. It is built by
+// HashIndexBuilder, whose index block has one entry per restart interval.
+class HashIndexReader : public IndexReader {
+ public:
+  // Read the index block and the prefixes meta block from the file and
+  // create an instance for `HashIndexReader`.
+  // On success, index_reader will be populated; otherwise it will remain
+  // unmodified.
+  static Status Create(const SliceTransform* prefix_extractor,
+                       RandomAccessFileReader* file,
+                       const BlockHandle& index_handle,
+                       const BlockHandle& prefixes_handle, Env* env,
+                       const Comparator* comparator, IndexReader** index_reader,
+                       Statistics* statistics) {
+    std::unique_ptr<Block> index_block;
+    auto s = ReadBlockFromFile(file, ReadOptions(), index_handle, &index_block,
+                               env, true /* decompress */,
+                               Slice() /*compression dict*/,
+                               /*info_log*/ nullptr);
+    if (!s.ok()) {
+      return s;
+    }
+
+    BlockContents prefixes_contents;
+    s = ReadBlockContents(file, ReadOptions(), prefixes_handle,
+                          &prefixes_contents, env, true /* decompress */);
+    if (!s.ok()) {
+      return s;
+    }
+
+    BlockPrefixIndex* prefix_index = nullptr;
+    s = BlockPrefixIndex::Create(prefix_extractor, prefixes_contents.data,
+                                 &prefix_index);
+    if (s.ok()) {
+      *index_reader = new HashIndexReader(comparator, std::move(index_block),
+                                          prefix_index, statistics);
+    }
+
+    return s;
+  }
+
+  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr,
+                                        bool total_order_seek = true) override {
+    return index_block_->NewIterator(
+        comparator_, iter, Block::kTypeBlock,
+        total_order_seek ? nullptr : prefix_index_.get());
+  }
+
+  virtual size_t size() const override { return index_block_->size(); }
+  virtual size_t usable_size() const override {
+    return index_block_->usable_size() +
+           prefix_index_->ApproximateMemoryUsage();
+  }
+
+  virtual size_t ApproximateMemoryUsage() const override {
+    assert(index_block_);
+    return index_block_->ApproximateMemoryUsage() +
+           prefix_index_->ApproximateMemoryUsage();
+  }
+
+ private:
+  HashIndexReader(const Comparator* comparator,
+                  std::unique_ptr<Block>&& index_block,
+                  BlockPrefixIndex* prefix_index, Statistics* stats)
+      : IndexReader(comparator, stats),
+        index_block_(std::move(index_block)),
+        prefix_index_(prefix_index) {
+    assert(index_block_ != nullptr);
+    assert(prefix_index_ != nullptr);
+  }
+
+  std::unique_ptr<Block> index_block_;
+  std::unique_ptr<BlockPrefixIndex> prefix_index_;
+};
+
 // Index that allows binary search lookup for the first key of each block.
 // This class can be viewed as a thin wrapper for `Block` class which already
 // supports binary search.
@@ -146,7 +233,8 @@ class MinMaxBinarySearchIndexReader : public IndexReader {
     return s;
   }
 
-  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr) override {
+  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr,
+                                        bool total_order_seek = true) override {
     return index_block_->NewIterator(comparator_, iter, Block::kTypeMinMax);
   }
 
@@ -174,4 +262,97 @@ class MinMaxBinarySearchIndexReader : public IndexReader {
   std::unique_ptr<Block> index_block_;
   const Comparator* value_comparator_;
 };
+
+// Index of the partitions built by PartitionedIndexBuilder. Only the top-level
+// index block is held by the reader, the partitions are read by the table,
+// usually through the block cache, while the two-level iterator walks them.
+class PartitionIndexReader : public IndexReader {
+ public:
+  // Returns the iterator over the partition of the encoded block handle.
+  typedef std::function<InternalIterator*(const Slice& handle)>
+      PartitionIteratorFactory;
+
+  // Read the top-level index block from the file and create an instance for
+  // `PartitionIndexReader`. block_type is the type of the index entries, i.e.
+  // Block::kTypeMinMax for the indexes keeping min & max values.
+  // On success, index_reader will be populated; otherwise it will remain
+  // unmodified.
+  static Status Create(RandomAccessFileReader* file,
+                       const BlockHandle& index_handle, Env* env,
+                       const Comparator* comparator,
+                       Block::BlockType block_type,
+                       PartitionIteratorFactory new_partition_iterator,
+                       IndexReader** index_reader, Statistics* statistics) {
+    std::unique_ptr<Block> index_block;
+    auto s = ReadBlockFromFile(file, ReadOptions(), index_handle, &index_block,
+                               env, true /* decompress */,
+                               Slice() /*compression dict*/,
+                               /*info_log*/ nullptr);
+
+    if (s.ok()) {
+      *index_reader = new PartitionIndexReader(
+          comparator, std::move(index_block), block_type,
+          std::move(new_partition_iterator), statistics);
+    }
+
+    return s;
+  }
+
+  // The two-level iterator is always newly created, so iter is not used.
+  virtual InternalIterator* NewIterator(BlockIter* iter = nullptr,
+                                        bool total_order_seek = true) override {
+    return NewTwoLevelIterator(
+        new PartitionIteratorState(new_partition_iterator_),
+        index_block_->NewIterator(comparator_, nullptr, block_type_));
+  }
+
+  // Returns the iterator over the top-level index, whose values are the
+  // handles of the partitions.
+  InternalIterator* NewTopLevelIterator() {
+    return index_block_->NewIterator(comparator_, nullptr, block_type_);
+  }
+
+  virtual size_t size() const override { return index_block_->size(); }
+  virtual size_t usable_size() const override {
+    return index_block_->usable_size();
+  }
+
+  virtual size_t ApproximateMemoryUsage() const override {
+    assert(index_block_);
+    return index_block_->ApproximateMemoryUsage();
+  }
+
+ private:
+  class PartitionIteratorState : public TwoLevelIteratorState {
+   public:
+    explicit PartitionIteratorState(
+        const PartitionIteratorFactory& new_partition_iterator)
+        : new_partition_iterator_(new_partition_iterator) {}
+
+    virtual InternalIterator* NewSecondaryIterator(
+        const Slice& handle) override {
+      return new_partition_iterator_(handle);
+    }
+
+   private:
+    PartitionIteratorFactory new_partition_iterator_;
+  };
+
+  PartitionIndexReader(const Comparator* comparator,
+                       std::unique_ptr<Block>&& index_block,
+                       Block::BlockType block_type,
+                       PartitionIteratorFactory&& new_partition_iterator,
+                       Statistics* stats)
+      : IndexReader(comparator, stats),
+        index_block_(std::move(index_block)),
+        block_type_(block_type),
+        new_partition_iterator_(std::move(new_partition_iterator)) {
+    assert(index_block_ != nullptr);
+  }
+
+  std::unique_ptr<Block> index_block_;
+  Block::BlockType block_type_;
+  PartitionIteratorFactory new_partition_iterator_;
+};
+
 }  // namespace vidardb
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "table/block.h"
+#include "table/iterator_wrapper.h"
 
 namespace vidardb {
 
@@ -19,9 +20,15 @@ class MainColumnTableIterator {
         valid_second_level_iter_(false),
         area_(nullptr),
         last_area_(nullptr) {
-    state_->NewIndexIterator(&first_level_iter_);
+    first_level_iter_.Set(state_->NewIndexIterator(&index_block_iter_));
+  }
+  virtual ~MainColumnTableIterator() {
+    // a partitioned index returns a two-level iterator instead
+    if (first_level_iter_.iter() != &index_block_iter_) {
+      first_level_iter_.DeleteIter(false /* is_arena_mode */);
+    }
+    delete state_;
   }
-  virtual ~MainColumnTableIterator() { delete state_; }
 
   void SetArea(char* area) { area_ = area; }
   char* GetArea() const { return area_; }
@@ -126,7 +133,8 @@ class MainColumnTableIterator {
   }
 
   ColumnTable::BlockEntryIteratorState* state_;
-  BlockIter first_level_iter_;
+  BlockIter index_block_iter_;
+  IteratorWrapper first_level_iter_;
   MainColumnBlockIter second_level_iter_;  // May be not valid
   bool valid_second_level_iter_;
   Status status_;
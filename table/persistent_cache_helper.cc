@@ -0,0 +1,51 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/persistent_cache_helper.h"
+
+#include "table/format.h"
+#include "util/coding.h"
+#include "util/statistics.h"
+
+namespace vidardb {
+
+namespace {
+std::string PageKey(const PersistentCacheOptions& cache_options,
+                    const BlockHandle& handle) {
+  std::string key = cache_options.key_prefix;
+  PutVarint64(&key, handle.offset());
+  return key;
+}
+}  // namespace
+
+void PersistentCacheHelper::InsertRawPage(
+    const PersistentCacheOptions& cache_options, const BlockHandle& handle,
+    const char* raw_data, size_t raw_data_size) {
+  assert(cache_options.persistent_cache != nullptr);
+  cache_options.persistent_cache->Insert(PageKey(cache_options, handle),
+                                         raw_data, raw_data_size);
+}
+
+Status PersistentCacheHelper::LookupRawPage(
+    const PersistentCacheOptions& cache_options, const BlockHandle& handle,
+    std::unique_ptr<char[]>* raw_data, size_t raw_data_size) {
+  assert(cache_options.persistent_cache != nullptr);
+  size_t size = 0;
+  Status s = cache_options.persistent_cache->Lookup(
+      PageKey(cache_options, handle), raw_data, &size);
+  if (s.ok() && size != raw_data_size) {
+    // a page of another file which had the same unique id
+    raw_data->reset();
+    s = Status::Corruption("persistent cache page of unexpected size");
+  }
+  if (!s.ok()) {
+    RecordTick(cache_options.statistics, PERSISTENT_CACHE_MISS);
+    return s;
+  }
+  RecordTick(cache_options.statistics, PERSISTENT_CACHE_HIT);
+  return s;
+}
+
+}  // namespace vidardb
@@ -0,0 +1,52 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "vidardb/persistent_cache.h"
+#include "vidardb/statistics.h"
+
+namespace vidardb {
+
+class BlockHandle;
+
+// The persistent cache of a table file, and the prefix of the keys of its
+// blocks, which stays the same across restarts.
+struct PersistentCacheOptions {
+  PersistentCacheOptions() {}
+  PersistentCacheOptions(
+      const std::shared_ptr<PersistentCache>& _persistent_cache,
+      const std::string& _key_prefix, Statistics* _statistics)
+      : persistent_cache(_persistent_cache),
+        key_prefix(_key_prefix),
+        statistics(_statistics) {}
+
+  std::shared_ptr<PersistentCache> persistent_cache;
+  std::string key_prefix;
+  Statistics* statistics = nullptr;
+};
+
+// Stores and looks up the raw blocks of a table file, i.e. the contents read
+// from the file, followed by the block trailer, in its persistent cache.
+class PersistentCacheHelper {
+ public:
+  // Insert the raw block of handle, of raw_data_size bytes at raw_data.
+  // The failures are ignored, the block is just not cached.
+  static void InsertRawPage(const PersistentCacheOptions& cache_options,
+                            const BlockHandle& handle, const char* raw_data,
+                            size_t raw_data_size);
+
+  // Lookup the raw block of handle, which is expected to be raw_data_size
+  // bytes. On success *raw_data owns a copy of it.
+  static Status LookupRawPage(const PersistentCacheOptions& cache_options,
+                              const BlockHandle& handle,
+                              std::unique_ptr<char[]>* raw_data,
+                              size_t raw_data_size);
+};
+
+}  // namespace vidardb
@@ -0,0 +1,89 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "table/read_amp_stats.h"
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "util/mutexlock.h"
+#include "util/string_util.h"
+
+namespace vidardb {
+
+ReadAmpStats::ReadAmpStats(int num_levels) {
+  for (int level = 0; level < num_levels; level++) {
+    levels_.emplace_back(new TableReadStats());
+  }
+}
+
+TableReadStats* ReadAmpStats::ForLevel(int level) {
+  if (level < 0 || level >= static_cast<int>(levels_.size())) {
+    return nullptr;
+  }
+  return levels_[level].get();
+}
+
+TableReadStats* ReadAmpStats::ForColumn(uint32_t column) {
+  MutexLock l(&mutex_);
+  while (columns_.size() <= column) {
+    columns_.emplace_back(new TableReadStats());
+  }
+  return columns_[column].get();
+}
+
+namespace {
+
+void AppendHeader(std::string* value, const char* name) {
+  char buf[200];
+  snprintf(buf, sizeof(buf), "%8s %12s %12s %12s %8s %14s\n", name,
+           "BlockReads", "Read(MB)", "CacheHits", "Hit(%)", "BlocksSkipped");
+  value->append(buf);
+  value->append(strlen(buf) - 1, '-');
+  value->append("\n");
+}
+
+void AppendRow(std::string* value, const std::string& name,
+               const TableReadStats& stats) {
+  char buf[200];
+  uint64_t block_reads = stats.block_reads.load(std::memory_order_relaxed);
+  uint64_t cache_hits = stats.cache_hits.load(std::memory_order_relaxed);
+  uint64_t accesses = block_reads + cache_hits;
+  snprintf(buf, sizeof(buf),
+           "%8s %12" PRIu64 " %12.1f %12" PRIu64 " %8.1f %14" PRIu64 "\n",
+           name.c_str(), block_reads,
+           stats.bytes_read.load(std::memory_order_relaxed) / 1048576.0,
+           cache_hits, accesses == 0 ? 0.0 : 100.0 * cache_hits / accesses,
+           stats.blocks_skipped.load(std::memory_order_relaxed));
+  value->append(buf);
+}
+
+}  // namespace
+
+std::string ReadAmpStats::ToString() const {
+  std::string value;
+  AppendHeader(&value, "Level");
+  for (size_t level = 0; level < levels_.size(); level++) {
+    AppendRow(&value, "L" + vidardb::ToString(level), *levels_[level]);
+  }
+
+  MutexLock l(&mutex_);
+  if (!columns_.empty()) {
+    value.append("\n");
+    AppendHeader(&value, "Column");
+    for (size_t column = 0; column < columns_.size(); column++) {
+      AppendRow(&value, column == 0 ? "key" : vidardb::ToString(column),
+                *columns_[column]);
+    }
+  }
+  return value;
+}
+
+}  // namespace vidardb
@@ -0,0 +1,66 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "port/port.h"
+
+namespace vidardb {
+
+// Counters of the data blocks that the reads took from the tables of one
+// level, or from one column of the column tables.
+struct TableReadStats {
+  TableReadStats()
+      : block_reads(0), bytes_read(0), cache_hits(0), blocks_skipped(0) {}
+
+  void RecordBlockRead(uint64_t bytes) {
+    block_reads.fetch_add(1, std::memory_order_relaxed);
+    bytes_read.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  void RecordCacheHit() { cache_hits.fetch_add(1, std::memory_order_relaxed); }
+
+  void RecordBlocksSkipped(uint64_t n) {
+    blocks_skipped.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  // data blocks read from the files, and their bytes with the trailers
+  std::atomic<uint64_t> block_reads;
+  std::atomic<uint64_t> bytes_read;
+  // data blocks found in the block cache
+  std::atomic<uint64_t> cache_hits;
+  // data blocks that the range queries skipped by their MinMax
+  std::atomic<uint64_t> blocks_skipped;
+};
+
+// The read counters of the tables of a column family, by level and by
+// column. A table reader looks up its counters once, when it is opened.
+class ReadAmpStats {
+ public:
+  explicit ReadAmpStats(int num_levels);
+
+  // Returns nullptr if the level is unknown, e.g. -1.
+  TableReadStats* ForLevel(int level);
+  // The column 0 is the one of the keys, the values are from 1.
+  TableReadStats* ForColumn(uint32_t column);
+
+  // Returns a multi-line table of the counters per level, and per column
+  // if any column table was read.
+  std::string ToString() const;
+
+ private:
+  std::vector<std::unique_ptr<TableReadStats>> levels_;
+  mutable port::Mutex mutex_;
+  // grows with the columns met, guarded by mutex_
+  std::vector<std::unique_ptr<TableReadStats>> columns_;
+};
+
+}  // namespace vidardb
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "table/block.h"
+#include "table/iterator_wrapper.h"
 
 namespace vidardb {
 
@@ -19,9 +20,15 @@ class SubColumnTableIterator {
         valid_second_level_iter_(false),
         area_(nullptr),
         last_area_(nullptr) {
-    state_->NewIndexIterator(&first_level_iter_);
+    first_level_iter_.Set(state_->NewIndexIterator(&index_block_iter_));
+  }
+  virtual ~SubColumnTableIterator() {
+    // a partitioned index returns a two-level iterator instead
+    if (first_level_iter_.iter() != &index_block_iter_) {
+      first_level_iter_.DeleteIter(false /* is_arena_mode */);
+    }
+    delete state_;
   }
-  virtual ~SubColumnTableIterator() { delete state_; }
 
   void SetArea(char* area) { area_ = area; }
   char* GetArea() { return area_; }
@@ -134,7 +141,8 @@ class SubColumnTableIterator {
   }
 
   ColumnTable::BlockEntryIteratorState* state_;
-  MinMaxBlockIter first_level_iter_;
+  MinMaxBlockIter index_block_iter_;
+  IteratorWrapper first_level_iter_;
   SubColumnBlockIter second_level_iter_;  // May be not valid
   bool valid_second_level_iter_;
   Status status_;
@@ -26,6 +26,7 @@
 
 namespace vidardb {
 
+class ReadAmpStats;
 class Slice;
 class Status;
 
@@ -34,12 +35,14 @@ struct TableReaderOptions {
                      const EnvOptions& _env_options,
                      const InternalKeyComparator& _internal_comparator,
                      int _level = -1,
-                     const std::vector<uint32_t>& _cols = std::vector<uint32_t>())  // Shichao
+                     const std::vector<uint32_t>& _cols = std::vector<uint32_t>(),  // Shichao
+                     ReadAmpStats* _read_amp_stats = nullptr)
       : ioptions(_ioptions),
         env_options(_env_options),
         internal_comparator(_internal_comparator),
         level(_level),
-        cols(_cols) {}  // Shichao
+        cols(_cols),  // Shichao
+        read_amp_stats(_read_amp_stats) {}
 
   const ImmutableCFOptions& ioptions;
   const EnvOptions& env_options;
@@ -47,6 +50,8 @@ struct TableReaderOptions {
   // what level this table/file is on, -1 for "not set, don't know"
   int level;
   std::vector<uint32_t> cols;  // Shichao
+  // where the reads of the table are counted, nullptr if they are not
+  ReadAmpStats* read_amp_stats;
 };
 
 struct TableBuilderOptions {
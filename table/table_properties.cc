@@ -85,8 +85,14 @@ std::string TableProperties::ToString(
   AppendProperty(result, "raw data block size", raw_data_size, prop_delim,
                  kv_delim);
   AppendProperty(result, "index block size", index_size, prop_delim, kv_delim);
-  AppendProperty(result, "(estimated) table size", data_size + index_size,
-                 prop_delim, kv_delim);
+  if (index_partitions != 0) {
+    AppendProperty(result, "# index partitions", index_partitions, prop_delim,
+                   kv_delim);
+  }
+  AppendProperty(result, "filter block size", filter_size, prop_delim,
+                 kv_delim);
+  AppendProperty(result, "(estimated) table size",
+                 data_size + index_size + filter_size, prop_delim, kv_delim);
   AppendProperty(result, "column family ID",
                  column_family_id == vidardb::TablePropertiesCollectorFactory::
                                          Context::kUnknownColumnFamily
@@ -112,6 +118,16 @@ std::string TableProperties::ToString(
       compression_name.empty() ? std::string("N/A") : compression_name,
       prop_delim, kv_delim);
 
+  AppendProperty(
+      result, "filter policy name",
+      filter_policy_name.empty() ? std::string("N/A") : filter_policy_name,
+      prop_delim, kv_delim);
+
+  AppendProperty(result, "prefix extractor name",
+                 prefix_extractor_name.empty() ? std::string("N/A")
+                                               : prefix_extractor_name,
+                 prop_delim, kv_delim);
+
   return result;
 }
 
@@ -119,6 +135,8 @@ void TableProperties::Add(const TableProperties& tp) {
   data_size += tp.data_size;
   raw_data_size += tp.raw_data_size;
   index_size += tp.index_size;
+  index_partitions += tp.index_partitions;
+  filter_size += tp.filter_size;
   raw_key_size += tp.raw_key_size;
   raw_value_size += tp.raw_value_size;
   num_data_blocks += tp.num_data_blocks;
@@ -129,6 +147,10 @@ const std::string TablePropertiesNames::kDataSize = "vidardb.data.size";
 const std::string TablePropertiesNames::kRawDataSize = "vidardb.raw.data.size";
 const std::string TablePropertiesNames::kIndexSize =
     "vidardb.index.size";
+const std::string TablePropertiesNames::kIndexPartitions =
+    "vidardb.index.partitions";
+const std::string TablePropertiesNames::kFilterSize =
+    "vidardb.filter.size";
 const std::string TablePropertiesNames::kRawKeySize =
     "vidardb.raw.key.size";
 const std::string TablePropertiesNames::kRawValueSize =
@@ -149,6 +171,12 @@ const std::string TablePropertiesNames::kComparator = "vidardb.comparator";
 const std::string TablePropertiesNames::kPropertyCollectors =
     "vidardb.property.collectors";
 const std::string TablePropertiesNames::kCompression = "vidardb.compression";
+const std::string TablePropertiesNames::kFilterPolicy =
+    "vidardb.filter.policy";
+const std::string TablePropertiesNames::kWholeKeyFiltering =
+    "vidardb.filter.whole.key";
+const std::string TablePropertiesNames::kPrefixExtractorName =
+    "vidardb.prefix.extractor.name";
 
 extern const std::string kPropertiesBlock = "vidardb.properties";
 // Old property block name for backward compatibility
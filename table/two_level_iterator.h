@@ -24,10 +24,19 @@ class InternalKeyComparator;
 class Arena;
 
 struct TwoLevelIteratorState {
-  explicit TwoLevelIteratorState() {}
+  explicit TwoLevelIteratorState(bool _check_prefix_may_match = false)
+      : check_prefix_may_match(_check_prefix_may_match) {}
 
   virtual ~TwoLevelIteratorState() {}
   virtual InternalIterator* NewSecondaryIterator(const Slice& handle) = 0;
+
+  // Returns false if no key with the prefix of internal_key can be found,
+  // in which case Seek() leaves the iterator invalid without reading any
+  // second level block.
+  virtual bool PrefixMayMatch(const Slice& internal_key) { return true; }
+
+  // If true, Seek() consults PrefixMayMatch() first.
+  bool check_prefix_may_match;
 };
 
 class TwoLevelIterator : public InternalIterator {
@@ -86,6 +95,15 @@ class TwoLevelIterator : public InternalIterator {
     assert(Valid());
     return second_level_iter_.value();
   }
+  // the min & max of a partitioned index entry
+  virtual Slice min() const override {
+    assert(Valid());
+    return second_level_iter_.min();
+  }
+  virtual Slice max() const override {
+    assert(Valid());
+    return second_level_iter_.max();
+  }
   virtual Status status() const override;
 
   virtual void SetPinnedItersMgr(
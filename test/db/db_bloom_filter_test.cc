@@ -0,0 +1,160 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <memory>
+#include <string>
+
+#include "util/string_util.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/cache.h"
+#include "vidardb/comparator.h"
+#include "vidardb/db.h"
+#include "vidardb/filter_policy.h"
+#include "vidardb/splitter.h"
+#include "vidardb/statistics.h"
+#include "vidardb/table.h"
+
+namespace vidardb {
+
+// Runs with BlockBasedTable if the param is false, with ColumnTable if true.
+class DBBloomFilterTest : public testing::TestWithParam<bool> {
+ public:
+  DBBloomFilterTest()
+      : dbname_(test::TmpDir() + "/db_bloom_filter_test"), db_(nullptr) {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~DBBloomFilterTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  Options GetOptions(bool use_filter, bool cache_index_and_filter_blocks) {
+    Options options;
+    options.create_if_missing = true;
+    options.statistics = CreateDBStatistics();
+    std::shared_ptr<const FilterPolicy> filter_policy;
+    if (use_filter) {
+      filter_policy.reset(NewBloomFilterPolicy(10));
+    }
+    if (GetParam()) {
+      ColumnTableOptions table_options;
+      table_options.block_cache = NewLRUCache(8 << 20);
+      table_options.block_size = 4096;
+      table_options.cache_index_and_filter_blocks =
+          cache_index_and_filter_blocks;
+      table_options.filter_policy = filter_policy;
+      table_options.column_count = 2;
+      for (uint32_t i = 0; i < table_options.column_count; i++) {
+        table_options.value_comparators.push_back(BytewiseComparator());
+      }
+      options.splitter.reset(NewPipeSplitter());
+      options.table_factory.reset(NewColumnTableFactory(table_options));
+    } else {
+      BlockBasedTableOptions table_options;
+      table_options.block_cache = NewLRUCache(8 << 20);
+      table_options.cache_index_and_filter_blocks =
+          cache_index_and_filter_blocks;
+      table_options.filter_policy = filter_policy;
+      options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    }
+    return options;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  std::string Value(const Options& options, int i) {
+    std::string value = ToString(i) + std::string(20, 'v');
+    return GetParam() ? options.splitter->Stitch({value, value}) : value;
+  }
+
+  // Opens the db and flushes one table of the even keys below 2 * kNumKeys.
+  void OpenAndFlush(const Options& options) {
+    ASSERT_OK(DB::Open(options, dbname_, &db_));
+    for (int i = 0; i < kNumKeys; i++) {
+      ASSERT_OK(db_->Put(WriteOptions(), Key(2 * i), Value(options, 2 * i)));
+    }
+    ASSERT_OK(db_->Flush(FlushOptions()));
+  }
+
+  // The data blocks looked up in the block cache, each miss is a read.
+  uint64_t DataBlockAccesses(const Options& options) {
+    return options.statistics->getTickerCount(BLOCK_CACHE_DATA_MISS) +
+           options.statistics->getTickerCount(BLOCK_CACHE_DATA_HIT);
+  }
+
+  static const int kNumKeys = 5000;
+
+ protected:
+  std::string dbname_;
+  DB* db_;
+};
+
+const int DBBloomFilterTest::kNumKeys;
+
+TEST_P(DBBloomFilterTest, MissingKeySkipsDataBlocks) {
+  for (bool cache_index_and_filter_blocks : {false, true}) {
+    Options options = GetOptions(true, cache_index_and_filter_blocks);
+    OpenAndFlush(options);
+    Statistics* stats = options.statistics.get();
+
+    // the odd keys fall in the key range of the table, and are not in it
+    ReadOptions read_options;
+    uint64_t accesses = DataBlockAccesses(options);
+    for (int i = 0; i < kNumKeys; i++) {
+      std::string value;
+      ASSERT_TRUE(
+          db_->Get(read_options, Key(2 * i + 1), &value).IsNotFound());
+    }
+    uint64_t useful = stats->getTickerCount(BLOOM_FILTER_USEFUL);
+    // about 1% of false positives with 10 bits per key
+    ASSERT_GE(useful, static_cast<uint64_t>(kNumKeys * 95 / 100));
+    ASSERT_LE(useful, static_cast<uint64_t>(kNumKeys));
+    // only the false positives go on to the data blocks, a key past the
+    // last one of a block may look into the next block too
+    ASSERT_LE(DataBlockAccesses(options) - accesses, 2 * (kNumKeys - useful));
+
+    // no false negatives
+    for (int i = 0; i < kNumKeys; i++) {
+      std::string value;
+      ASSERT_OK(db_->Get(read_options, Key(2 * i), &value));
+      ASSERT_EQ(Value(options, 2 * i), value);
+    }
+    ASSERT_EQ(useful, stats->getTickerCount(BLOOM_FILTER_USEFUL));
+
+    delete db_;
+    db_ = nullptr;
+    ASSERT_OK(DestroyDB(dbname_, options));
+  }
+}
+
+TEST_P(DBBloomFilterTest, MissingKeyReadsDataBlockWithoutFilter) {
+  Options options = GetOptions(false, false);
+  OpenAndFlush(options);
+
+  ReadOptions read_options;
+  uint64_t accesses = DataBlockAccesses(options);
+  for (int i = 0; i < kNumKeys; i++) {
+    std::string value;
+    ASSERT_TRUE(db_->Get(read_options, Key(2 * i + 1), &value).IsNotFound());
+  }
+  ASSERT_EQ(0U, options.statistics->getTickerCount(BLOOM_FILTER_USEFUL));
+  ASSERT_GE(DataBlockAccesses(options) - accesses,
+            static_cast<uint64_t>(kNumKeys));
+}
+
+INSTANTIATE_TEST_CASE_P(DBBloomFilterTest, DBBloomFilterTest, testing::Bool());
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
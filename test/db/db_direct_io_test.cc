@@ -0,0 +1,139 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "util/string_util.h"
+#include "util/sync_point.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/db.h"
+#include "vidardb/env.h"
+
+namespace vidardb {
+
+class DBDirectIOTest : public testing::Test {
+ public:
+  DBDirectIOTest()
+      : env_(Env::Default()),
+        dbname_(test::TmpDir(env_) + "/db_direct_io_test") {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~DBDirectIOTest() { DestroyDB(dbname_, Options()); }
+
+  // Whether the file system under the test directory takes O_DIRECT.
+  bool IsDirectIOSupported() {
+    EnvOptions env_options;
+    env_options.use_direct_writes = true;
+    std::string fname = test::TmpDir(env_) + "/direct_io_probe";
+    std::unique_ptr<WritableFile> file;
+    Status s = env_->NewWritableFile(fname, &file, env_options);
+    file.reset();
+    env_->DeleteFile(fname);
+    return s.ok();
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  static std::string Value(int i, int round) {
+    return std::string(100 + i % 300, static_cast<char>('a' + round));
+  }
+
+  std::string NumFilesAtLevel(DB* db, int level) {
+    std::string num;
+    EXPECT_TRUE(db->GetProperty(
+        "vidardb.num-files-at-level" + ToString(level), &num));
+    return num;
+  }
+
+ protected:
+  Env* env_;
+  std::string dbname_;
+};
+
+TEST_F(DBDirectIOTest, FlushCompactAndRead) {
+  if (!IsDirectIOSupported()) {
+    fprintf(stderr, "O_DIRECT is not supported, skipping the test\n");
+    return;
+  }
+  std::atomic<int> direct_writes(0);
+  std::atomic<int> direct_reads(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "NewWritableFile:O_DIRECT", [&](void* arg) { direct_writes++; });
+  SyncPoint::GetInstance()->SetCallBack(
+      "NewRandomAccessFile:O_DIRECT", [&](void* arg) { direct_reads++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  Options options;
+  options.create_if_missing = true;
+  options.compression = kNoCompression;
+  options.use_direct_reads = true;
+  options.use_direct_io_for_flush_and_compaction = true;
+  DB* db;
+  ASSERT_OK(DB::Open(options, dbname_, &db));
+
+  // three overlapping tables, the last round of each key wins
+  const int kNumKeys = 3000;
+  for (int round = 0; round < 3; round++) {
+    for (int i = round; i < kNumKeys; i += round + 1) {
+      ASSERT_OK(db->Put(WriteOptions(), Key(i), Value(i, round)));
+    }
+    ASSERT_OK(db->Flush(FlushOptions()));
+  }
+  ASSERT_EQ("3", NumFilesAtLevel(db, 0));
+  ASSERT_GE(direct_writes.load(), 3);
+
+  int writes_before_compaction = direct_writes.load();
+  ASSERT_OK(db->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ("0", NumFilesAtLevel(db, 0));
+  ASSERT_GT(direct_writes.load(), writes_before_compaction);
+
+  auto verify = [&](DB* db) {
+    ReadOptions read_options;
+    for (int i = 0; i < kNumKeys; i++) {
+      int round = i % 3 == 2 ? 2 : i % 2 == 1 ? 1 : 0;
+      std::string value;
+      ASSERT_OK(db->Get(read_options, Key(i), &value));
+      ASSERT_EQ(Value(i, round), value);
+    }
+    std::string value;
+    ASSERT_TRUE(db->Get(read_options, Key(kNumKeys), &value).IsNotFound());
+
+    read_options.readahead_size = 256 << 10;
+    std::unique_ptr<Iterator> iter(db->NewIterator(read_options));
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ASSERT_EQ(Key(count), iter->key().ToString());
+      count++;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(kNumKeys, count);
+  };
+  verify(db);
+  ASSERT_GT(direct_reads.load(), 0);
+
+  // the files written with O_DIRECT are whole after a reopen
+  delete db;
+  ASSERT_OK(DB::Open(options, dbname_, &db));
+  verify(db);
+  delete db;
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
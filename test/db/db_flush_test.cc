@@ -0,0 +1,133 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "util/string_util.h"
+#include "util/sync_point.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/db.h"
+#include "vidardb/env.h"
+#include "vidardb/table_properties.h"
+
+namespace vidardb {
+
+class DBFlushTest : public testing::Test {
+ public:
+  DBFlushTest()
+      : env_(Env::Default()), dbname_(test::TmpDir(env_) + "/db_flush_test") {}
+
+  ~DBFlushTest() { DestroyDB(dbname_, Options()); }
+
+  // Flush the same entries into one table, and return its properties and the
+  // content of the table file.
+  void FlushTable(bool pipelined, TableProperties* props,
+                  std::string* contents) {
+    Options options;
+    options.create_if_missing = true;
+    options.compression = kNoCompression;
+    options.enable_pipelined_flush = pipelined;
+    ASSERT_OK(DestroyDB(dbname_, options));
+    DB* db;
+    ASSERT_OK(DB::Open(options, dbname_, &db));
+
+    Random rnd(301);
+    for (int i = 0; i < 20000; i++) {
+      std::string value;
+      test::RandomString(&rnd, 100, &value);
+      ASSERT_OK(db->Put(WriteOptions(), Key(i), value));
+      if (i % 7 == 0) {
+        ASSERT_OK(db->Delete(WriteOptions(), Key(i / 2)));
+      }
+    }
+    ASSERT_OK(db->Flush(FlushOptions()));
+
+    TablePropertiesCollection tables;
+    ASSERT_OK(db->GetPropertiesOfAllTables(&tables));
+    ASSERT_EQ(1U, tables.size());
+    *props = *tables.begin()->second;
+    ASSERT_OK(ReadFileToString(env_, tables.begin()->first, contents));
+    delete db;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+ protected:
+  Env* env_;
+  std::string dbname_;
+};
+
+TEST_F(DBFlushTest, PipelinedFlushBuildsSameTable) {
+  std::atomic<int> consumers(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "PipelinedTableBuilder::BGWork", [&](void* arg) { consumers++; });
+  SyncPoint::GetInstance()->SetCallBack(
+      "PipelinedTableBuilder::TakeOver", [&](void* arg) { consumers++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  TableProperties props, pipelined_props;
+  std::string contents, pipelined_contents;
+  FlushTable(false, &props, &contents);
+  ASSERT_EQ(0, consumers.load());
+  // built by the job, or by the flush if the job was too slow to start
+  FlushTable(true, &pipelined_props, &pipelined_contents);
+  ASSERT_EQ(1, consumers.load());
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_GT(props.num_entries, 0U);
+  ASSERT_EQ(props.num_entries, pipelined_props.num_entries);
+  ASSERT_EQ(props.num_data_blocks, pipelined_props.num_data_blocks);
+  ASSERT_EQ(props.raw_key_size, pipelined_props.raw_key_size);
+  ASSERT_EQ(props.raw_value_size, pipelined_props.raw_value_size);
+  ASSERT_EQ(props.data_size, pipelined_props.data_size);
+  ASSERT_EQ(props.index_size, pipelined_props.index_size);
+  ASSERT_EQ(props.filter_size, pipelined_props.filter_size);
+  ASSERT_TRUE(contents == pipelined_contents);
+}
+
+TEST_F(DBFlushTest, PipelinedFlushWithBusyPool) {
+  std::atomic<int> take_overs(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "PipelinedTableBuilder::TakeOver", [&](void* arg) { take_overs++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  TableProperties props, pipelined_props;
+  std::string contents, pipelined_contents;
+  FlushTable(false, &props, &contents);
+
+  // the only LOW thread is busy, the flush builds the table itself
+  env_->SetBackgroundThreads(1, Env::LOW);
+  test::SleepingBackgroundTask sleeping_task;
+  env_->Schedule(&test::SleepingBackgroundTask::DoSleepTask, &sleeping_task,
+                 Env::LOW);
+  sleeping_task.WaitUntilSleeping();
+  FlushTable(true, &pipelined_props, &pipelined_contents);
+  sleeping_task.WakeUp();
+  sleeping_task.WaitUntilDone();
+  ASSERT_EQ(1, take_overs.load());
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_EQ(props.num_entries, pipelined_props.num_entries);
+  ASSERT_EQ(props.data_size, pipelined_props.data_size);
+  ASSERT_TRUE(contents == pipelined_contents);
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
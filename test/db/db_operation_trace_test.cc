@@ -0,0 +1,176 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "port/port.h"
+#include "util/mutexlock.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/db.h"
+#include "vidardb/listener.h"
+#include "vidardb/perf_context.h"
+#include "vidardb/perf_level.h"
+
+namespace vidardb {
+
+#ifndef VIDARDB_LITE
+
+class TraceCollector : public EventListener {
+ public:
+  virtual void OnSlowOperation(const OperationTraceInfo& info) override {
+    MutexLock l(&mutex_);
+    traces_.push_back(info);
+  }
+
+  std::vector<OperationTraceInfo> Traces() {
+    MutexLock l(&mutex_);
+    return traces_;
+  }
+
+  void Clear() {
+    MutexLock l(&mutex_);
+    traces_.clear();
+  }
+
+ private:
+  port::Mutex mutex_;
+  std::vector<OperationTraceInfo> traces_;
+};
+
+class DBOperationTraceTest : public testing::Test {
+ public:
+  DBOperationTraceTest()
+      : dbname_(test::TmpDir() + "/db_operation_trace_test"),
+        db_(nullptr),
+        collector_(std::make_shared<TraceCollector>()) {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~DBOperationTraceTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  void Open(uint32_t operation_trace_one_in, uint64_t slow_operation_micros) {
+    Options options;
+    options.create_if_missing = true;
+    options.listeners.push_back(collector_);
+    options.operation_trace_one_in = operation_trace_one_in;
+    options.slow_operation_micros = slow_operation_micros;
+    ASSERT_OK(DB::Open(options, dbname_, &db_));
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  static bool HasSpan(const OperationTraceInfo& info, const std::string& name) {
+    for (const auto& span : info.spans) {
+      if (span.name == name) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ protected:
+  std::string dbname_;
+  DB* db_;
+  std::shared_ptr<TraceCollector> collector_;
+};
+
+TEST_F(DBOperationTraceTest, TraceEveryOperation) {
+  Open(1, 0);
+  PerfLevel perf_level = GetPerfLevel();
+
+  ASSERT_OK(db_->Put(WriteOptions(), Key(0), "value"));
+  std::vector<OperationTraceInfo> traces = collector_->Traces();
+  ASSERT_EQ(1U, traces.size());
+  ASSERT_EQ("Write", traces[0].operation);
+  ASSERT_EQ("", traces[0].cf_name);
+  ASSERT_TRUE(HasSpan(traces[0], "write thread"));
+  ASSERT_TRUE(HasSpan(traces[0], "memtable"));
+  for (const auto& span : traces[0].spans) {
+    ASSERT_GT(span.nanos, 0U);
+    ASSERT_LE(span.nanos, traces[0].total_nanos);
+  }
+  // the perf level of the thread is restored after the operation
+  ASSERT_EQ(perf_level, GetPerfLevel());
+
+  // a read from the memtable
+  collector_->Clear();
+  ReadOptions read_options;
+  std::string value;
+  ASSERT_OK(db_->Get(read_options, Key(0), &value));
+  traces = collector_->Traces();
+  ASSERT_EQ(1U, traces.size());
+  ASSERT_EQ("Get", traces[0].operation);
+  ASSERT_EQ(kDefaultColumnFamilyName, traces[0].cf_name);
+  ASSERT_TRUE(HasSpan(traces[0], "memtable"));
+  ASSERT_FALSE(HasSpan(traces[0], "level 0"));
+
+  // a read from a table, which is traced level by level
+  ASSERT_OK(db_->Flush(FlushOptions()));
+  collector_->Clear();
+  ASSERT_OK(db_->Get(read_options, Key(0), &value));
+  ASSERT_EQ("value", value);
+  traces = collector_->Traces();
+  ASSERT_EQ(1U, traces.size());
+  ASSERT_TRUE(HasSpan(traces[0], "level 0"));
+  ASSERT_GE(traces[0].block_cache_hit_count + traces[0].block_read_count, 1U);
+  ASSERT_EQ(perf_level, GetPerfLevel());
+
+  // only the traced operations turn the timers on
+  SetPerfLevel(kEnableCount);
+  perf_context.Reset();
+  delete db_;
+  db_ = nullptr;
+  Open(0, 0);
+  collector_->Clear();
+  ASSERT_OK(db_->Get(read_options, Key(0), &value));
+  ASSERT_TRUE(collector_->Traces().empty());
+  ASSERT_EQ(0U, perf_context.get_from_output_files_time);
+}
+
+TEST_F(DBOperationTraceTest, OnlySlowOperations) {
+  // no operation here takes an hour
+  Open(1, 3600ULL * 1000 * 1000);
+  ReadOptions read_options;
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(db_->Put(WriteOptions(), Key(i), "value"));
+    std::string value;
+    ASSERT_OK(db_->Get(read_options, Key(i), &value));
+  }
+  ASSERT_TRUE(collector_->Traces().empty());
+}
+
+TEST_F(DBOperationTraceTest, Sampling) {
+  Open(10, 0);
+  const int kNumOps = 2000;
+  ReadOptions read_options;
+  for (int i = 0; i < kNumOps; i++) {
+    std::string value;
+    ASSERT_TRUE(db_->Get(read_options, Key(i), &value).IsNotFound());
+  }
+  // about one in ten
+  size_t traced = collector_->Traces().size();
+  ASSERT_GT(traced, static_cast<size_t>(kNumOps / 20));
+  ASSERT_LT(traced, static_cast<size_t>(kNumOps / 5));
+}
+
+#endif  // !VIDARDB_LITE
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
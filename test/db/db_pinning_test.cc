@@ -0,0 +1,227 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <memory>
+#include <string>
+
+#include "util/string_util.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/cache.h"
+#include "vidardb/comparator.h"
+#include "vidardb/db.h"
+#include "vidardb/filter_policy.h"
+#include "vidardb/splitter.h"
+#include "vidardb/statistics.h"
+#include "vidardb/table.h"
+
+namespace vidardb {
+
+// Runs with BlockBasedTable if the param is false, with ColumnTable if true.
+class DBPinningTest : public testing::TestWithParam<bool> {
+ public:
+  DBPinningTest()
+      : dbname_(test::TmpDir() + "/db_pinning_test"), db_(nullptr) {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~DBPinningTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  struct CacheOptions {
+    std::shared_ptr<Cache> block_cache;
+    bool pin_l0 = false;
+    bool pin_top_level_index = false;
+  };
+
+  // A small block cache, and small data blocks and index partitions, so a
+  // scan evicts whatever is not pinned.
+  Options GetOptions(const CacheOptions& cache_options) {
+    Options options;
+    options.create_if_missing = true;
+    options.compression = kNoCompression;
+    options.statistics = CreateDBStatistics();
+    std::shared_ptr<const FilterPolicy> filter_policy(
+        NewBloomFilterPolicy(10));
+    if (GetParam()) {
+      ColumnTableOptions table_options;
+      table_options.block_cache = cache_options.block_cache;
+      table_options.block_size = 256;
+      table_options.index_type = ColumnTableOptions::kTwoLevelIndexSearch;
+      table_options.metadata_block_size = 256;
+      table_options.cache_index_and_filter_blocks = true;
+      table_options.pin_l0_filter_and_index_blocks_in_cache =
+          cache_options.pin_l0;
+      table_options.pin_top_level_index = cache_options.pin_top_level_index;
+      table_options.filter_policy = filter_policy;
+      table_options.column_count = 2;
+      for (uint32_t i = 0; i < table_options.column_count; i++) {
+        table_options.value_comparators.push_back(BytewiseComparator());
+      }
+      options.splitter.reset(NewPipeSplitter());
+      options.table_factory.reset(NewColumnTableFactory(table_options));
+    } else {
+      BlockBasedTableOptions table_options;
+      table_options.block_cache = cache_options.block_cache;
+      table_options.block_size = 256;
+      table_options.index_type = BlockBasedTableOptions::kTwoLevelIndexSearch;
+      table_options.metadata_block_size = 256;
+      table_options.cache_index_and_filter_blocks = true;
+      table_options.pin_l0_filter_and_index_blocks_in_cache =
+          cache_options.pin_l0;
+      table_options.pin_top_level_index = cache_options.pin_top_level_index;
+      table_options.filter_policy = filter_policy;
+      options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    }
+    return options;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  std::string Value(const Options& options, int i) {
+    std::string value = ToString(i) + std::string(50, 'v');
+    return GetParam() ? options.splitter->Stitch({value, value}) : value;
+  }
+
+  // Opens the db and flushes one L0 table of kNumKeys keys.
+  void OpenAndFlush(const Options& options) {
+    ASSERT_OK(DB::Open(options, dbname_, &db_));
+    for (int i = 0; i < kNumKeys; i++) {
+      ASSERT_OK(db_->Put(WriteOptions(), Key(i), Value(options, i)));
+    }
+    ASSERT_OK(db_->Flush(FlushOptions()));
+    std::string num;
+    ASSERT_TRUE(db_->GetProperty("vidardb.num-files-at-level0", &num));
+    ASSERT_EQ("1", num);
+  }
+
+  // Scans the whole table through the block cache.
+  void Scan() {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      count++;
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(kNumKeys, count);
+  }
+
+  // Looks up every key, and as many missing ones.
+  void GetAll(const Options& options) {
+    ReadOptions read_options;
+    for (int i = 0; i < kNumKeys; i++) {
+      std::string value;
+      ASSERT_OK(db_->Get(read_options, Key(i), &value));
+      ASSERT_EQ(Value(options, i), value);
+      ASSERT_TRUE(
+          db_->Get(read_options, Key(i) + "x", &value).IsNotFound());
+    }
+  }
+
+  static const int kNumKeys = 2000;
+
+ protected:
+  std::string dbname_;
+  DB* db_;
+};
+
+const int DBPinningTest::kNumKeys;
+
+TEST_P(DBPinningTest, PinL0IndexAndFilter) {
+  CacheOptions cache_options;
+  cache_options.block_cache = NewLRUCache(64 << 10, 0);
+  cache_options.pin_l0 = true;
+  Options options = GetOptions(cache_options);
+  OpenAndFlush(options);
+  Cache* cache = cache_options.block_cache.get();
+  size_t pinned_usage = cache->GetPinnedUsage();
+  ASSERT_GT(pinned_usage, 0U);
+
+  // the data blocks of a scan churn the cache, the index with its
+  // partitions and the filter stay
+  Scan();
+  ASSERT_EQ(pinned_usage, cache->GetPinnedUsage());
+  Statistics* stats = options.statistics.get();
+  uint64_t index_misses = stats->getTickerCount(BLOCK_CACHE_INDEX_MISS);
+  uint64_t filter_misses = stats->getTickerCount(BLOCK_CACHE_FILTER_MISS);
+  GetAll(options);
+  ASSERT_EQ(index_misses, stats->getTickerCount(BLOCK_CACHE_INDEX_MISS));
+  ASSERT_EQ(filter_misses, stats->getTickerCount(BLOCK_CACHE_FILTER_MISS));
+  ASSERT_EQ(pinned_usage, cache->GetPinnedUsage());
+
+  // released when the table is closed
+  delete db_;
+  db_ = nullptr;
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+}
+
+TEST_P(DBPinningTest, UnpinnedIndexIsEvicted) {
+  CacheOptions cache_options;
+  cache_options.block_cache = NewLRUCache(64 << 10, 0);
+  Options options = GetOptions(cache_options);
+  OpenAndFlush(options);
+  Cache* cache = cache_options.block_cache.get();
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+
+  Scan();
+  Statistics* stats = options.statistics.get();
+  uint64_t index_misses = stats->getTickerCount(BLOCK_CACHE_INDEX_MISS);
+  uint64_t filter_misses = stats->getTickerCount(BLOCK_CACHE_FILTER_MISS);
+  GetAll(options);
+  ASSERT_LT(index_misses, stats->getTickerCount(BLOCK_CACHE_INDEX_MISS));
+  ASSERT_LT(filter_misses, stats->getTickerCount(BLOCK_CACHE_FILTER_MISS));
+}
+
+TEST_P(DBPinningTest, PinTopLevelIndexOnly) {
+  // the usage of the index with its partitions and the filter, pinned
+  CacheOptions cache_options;
+  cache_options.block_cache = NewLRUCache(64 << 10, 0);
+  cache_options.pin_l0 = true;
+  OpenAndFlush(GetOptions(cache_options));
+  size_t pin_l0_usage = cache_options.block_cache->GetPinnedUsage();
+  delete db_;
+  db_ = nullptr;
+  ASSERT_OK(DestroyDB(dbname_, Options()));
+
+  cache_options.block_cache = NewLRUCache(64 << 10, 0);
+  cache_options.pin_l0 = false;
+  cache_options.pin_top_level_index = true;
+  Options options = GetOptions(cache_options);
+  OpenAndFlush(options);
+  Cache* cache = cache_options.block_cache.get();
+  size_t pinned_usage = cache->GetPinnedUsage();
+  ASSERT_GT(pinned_usage, 0U);
+  ASSERT_LT(pinned_usage, pin_l0_usage);
+
+  // the partitions and the filter are evicted by a scan and read again,
+  // the top-level index is not
+  Scan();
+  Statistics* stats = options.statistics.get();
+  uint64_t index_misses = stats->getTickerCount(BLOCK_CACHE_INDEX_MISS);
+  uint64_t filter_misses = stats->getTickerCount(BLOCK_CACHE_FILTER_MISS);
+  GetAll(options);
+  ASSERT_LT(index_misses, stats->getTickerCount(BLOCK_CACHE_INDEX_MISS));
+  ASSERT_LT(filter_misses, stats->getTickerCount(BLOCK_CACHE_FILTER_MISS));
+  ASSERT_EQ(pinned_usage, cache->GetPinnedUsage());
+
+  delete db_;
+  db_ = nullptr;
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+}
+
+INSTANTIATE_TEST_CASE_P(DBPinningTest, DBPinningTest, testing::Bool());
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
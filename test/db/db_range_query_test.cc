@@ -0,0 +1,168 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util/string_util.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/comparator.h"
+#include "vidardb/db.h"
+#include "vidardb/file_iter.h"
+#include "vidardb/splitter.h"
+#include "vidardb/statistics.h"
+#include "vidardb/table.h"
+
+namespace vidardb {
+
+class DBRangeQueryTest : public testing::Test {
+ public:
+  DBRangeQueryTest()
+      : dbname_(test::TmpDir() + "/db_range_query_test"), db_(nullptr) {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~DBRangeQueryTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  Options GetOptions(int max_open_files, int max_range_query_table_readers) {
+    Options options;
+    options.create_if_missing = true;
+    options.statistics = CreateDBStatistics();
+    options.max_open_files = max_open_files;
+    options.max_range_query_table_readers = max_range_query_table_readers;
+    ColumnTableOptions table_options;
+    table_options.column_count = 2;
+    for (uint32_t i = 0; i < table_options.column_count; i++) {
+      table_options.value_comparators.push_back(BytewiseComparator());
+    }
+    options.splitter.reset(NewPipeSplitter());
+    options.table_factory.reset(NewColumnTableFactory(table_options));
+    return options;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  // Opens the db and flushes kNumTables tables of kKeysPerTable keys.
+  void OpenAndFlush(const Options& options) {
+    ASSERT_OK(DB::Open(options, dbname_, &db_));
+    for (int t = 0; t < kNumTables; t++) {
+      for (int i = t * kKeysPerTable; i < (t + 1) * kKeysPerTable; i++) {
+        std::string value = ToString(i);
+        ASSERT_OK(db_->Put(WriteOptions(), Key(i),
+                           options.splitter->Stitch({value, value})));
+      }
+      ASSERT_OK(db_->Flush(FlushOptions()));
+    }
+  }
+
+  // Runs a full range query over the tables, and returns the rows found.
+  uint64_t RangeQuery() {
+    ReadOptions read_options;
+    read_options.columns = {0, 1};
+    std::unique_ptr<FileIter> iter(
+        dynamic_cast<FileIter*>(db_->NewFileIterator(read_options)));
+    uint64_t rows = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      std::vector<std::vector<MinMax>> v;
+      Status s = iter->GetMinMax(v);
+      if (s.IsNotFound()) {
+        continue;  // the memtable
+      }
+      EXPECT_OK(s);
+      uint64_t size =
+          iter->EstimateRangeQueryBufSize(read_options.columns.size());
+      std::unique_ptr<char[]> buf(new char[size]);
+      uint64_t valid_count, total_count;
+      EXPECT_OK(iter->RangeQuery(std::vector<bool>(), buf.get(), size,
+                                 &valid_count, &total_count));
+      rows += valid_count;
+    }
+    return rows;
+  }
+
+  static uint64_t FileOpens(const Options& options) {
+    return options.statistics->getTickerCount(NO_FILE_OPENS);
+  }
+
+  static const int kNumTables = 3;
+  static const int kKeysPerTable = 500;
+
+ protected:
+  std::string dbname_;
+  DB* db_;
+};
+
+const int DBRangeQueryTest::kNumTables;
+const int DBRangeQueryTest::kKeysPerTable;
+
+TEST_F(DBRangeQueryTest, SharePointLookupReaders) {
+  // the tables are opened once for all, when they are flushed
+  Options options = GetOptions(-1, 0);
+  OpenAndFlush(options);
+  uint64_t opens = FileOpens(options);
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(opens, FileOpens(options));
+
+  // the range queries find the readers of the point lookups in the table
+  // cache
+  delete db_;
+  db_ = nullptr;
+  options = GetOptions(100, 0);
+  ASSERT_OK(DB::Open(options, dbname_, &db_));
+  ReadOptions read_options;
+  for (int t = 0; t < kNumTables; t++) {
+    std::string value;
+    ASSERT_OK(db_->Get(read_options, Key(t * kKeysPerTable), &value));
+  }
+  opens = FileOpens(options);
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(opens, FileOpens(options));
+}
+
+TEST_F(DBRangeQueryTest, OwnReaders) {
+  Options options = GetOptions(-1, 10);
+  OpenAndFlush(options);
+
+  // a reader of its own per table, kept for the next range queries
+  uint64_t opens = FileOpens(options);
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(opens + kNumTables, FileOpens(options));
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(opens + kNumTables, FileOpens(options));
+
+  // the compacted table gets one too
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  opens = FileOpens(options);
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(opens + 1, FileOpens(options));
+}
+
+TEST_F(DBRangeQueryTest, OwnReadersAreBounded) {
+  // a single reader for the range queries, swapped between the tables
+  Options options = GetOptions(-1, 1);
+  options.table_cache_numshardbits = 0;
+  OpenAndFlush(options);
+  uint64_t opens = FileOpens(options);
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(static_cast<uint64_t>(kNumTables * kKeysPerTable), RangeQuery());
+  ASSERT_EQ(opens + 2 * kNumTables, FileOpens(options));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,219 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util/string_util.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/cache.h"
+#include "vidardb/comparator.h"
+#include "vidardb/db.h"
+#include "vidardb/file_iter.h"
+#include "vidardb/splitter.h"
+#include "vidardb/statistics.h"
+#include "vidardb/table.h"
+
+namespace vidardb {
+
+class DBReadAmpTest : public testing::Test {
+ public:
+  DBReadAmpTest()
+      : dbname_(test::TmpDir() + "/db_read_amp_test"), db_(nullptr) {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~DBReadAmpTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  Options GetOptions(bool column_table) {
+    Options options;
+    options.create_if_missing = true;
+    options.statistics = CreateDBStatistics();
+    if (column_table) {
+      ColumnTableOptions table_options;
+      table_options.block_cache = NewLRUCache(8 << 20);
+      table_options.block_size = 256;
+      table_options.column_count = 2;
+      for (uint32_t i = 0; i < table_options.column_count; i++) {
+        table_options.value_comparators.push_back(BytewiseComparator());
+      }
+      options.splitter.reset(NewPipeSplitter());
+      options.table_factory.reset(NewColumnTableFactory(table_options));
+    } else {
+      BlockBasedTableOptions table_options;
+      table_options.block_cache = NewLRUCache(8 << 20);
+      table_options.block_size = 256;
+      options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    }
+    return options;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  // Opens the db and flushes one table of kNumKeys keys.
+  void OpenAndFlush(const Options& options) {
+    ASSERT_OK(DB::Open(options, dbname_, &db_));
+    for (int i = 0; i < kNumKeys; i++) {
+      std::string value = ToString(i) + std::string(20, 'v');
+      if (options.splitter != nullptr) {
+        value = options.splitter->Stitch({value, value});
+      }
+      ASSERT_OK(db_->Put(WriteOptions(), Key(i), value));
+    }
+    ASSERT_OK(db_->Flush(FlushOptions()));
+  }
+
+  void GetAll(ReadOptions& read_options) {
+    for (int i = 0; i < kNumKeys; i++) {
+      std::string value;
+      ASSERT_OK(db_->Get(read_options, Key(i), &value));
+    }
+  }
+
+  struct Row {
+    uint64_t block_reads;
+    double read_mb;
+    uint64_t cache_hits;
+    double hit_percent;
+    uint64_t blocks_skipped;
+  };
+
+  // Finds the row of the level ("L1") or of the column ("key", "1") in the
+  // read-amp-stats property.
+  bool GetRow(const std::string& name, Row* row) {
+    std::string stats;
+    EXPECT_TRUE(db_->GetProperty(DB::Properties::kReadAmpStats, &stats));
+    std::vector<std::string> lines = StringSplit(stats, '\n');
+    for (const auto& line : lines) {
+      char row_name[16];
+      if (sscanf(line.c_str(),
+                 "%15s %" SCNu64 " %lf %" SCNu64 " %lf %" SCNu64, row_name,
+                 &row->block_reads, &row->read_mb, &row->cache_hits,
+                 &row->hit_percent, &row->blocks_skipped) == 6 &&
+          name == row_name) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static const int kNumKeys = 2000;
+
+ protected:
+  std::string dbname_;
+  DB* db_;
+};
+
+const int DBReadAmpTest::kNumKeys;
+
+TEST_F(DBReadAmpTest, PerLevel) {
+  Options options = GetOptions(false);
+  OpenAndFlush(options);
+  Statistics* stats = options.statistics.get();
+
+  // the first pass reads the data blocks, the second finds them cached
+  ReadOptions read_options;
+  GetAll(read_options);
+  GetAll(read_options);
+  Row row;
+  ASSERT_TRUE(GetRow("L0", &row));
+  ASSERT_GT(row.block_reads, 0U);
+  ASSERT_EQ(stats->getTickerCount(BLOCK_CACHE_DATA_MISS), row.block_reads);
+  ASSERT_EQ(stats->getTickerCount(BLOCK_CACHE_DATA_HIT), row.cache_hits);
+  ASSERT_GE(row.cache_hits, row.block_reads);
+  ASSERT_EQ(0U, row.blocks_skipped);
+  ASSERT_TRUE(GetRow("L1", &row));
+  ASSERT_EQ(0U, row.block_reads + row.cache_hits);
+  // no column table was read
+  ASSERT_FALSE(GetRow("key", &row));
+
+  // the compacted table is read at L1
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  std::string num;
+  ASSERT_TRUE(db_->GetProperty("vidardb.num-files-at-level1", &num));
+  ASSERT_EQ("1", num);
+  GetAll(read_options);
+  ASSERT_TRUE(GetRow("L1", &row));
+  ASSERT_GT(row.block_reads, 0U);
+  ASSERT_GT(row.read_mb, 0.0);
+}
+
+TEST_F(DBReadAmpTest, PerColumn) {
+  Options options = GetOptions(true);
+  OpenAndFlush(options);
+
+  // a projected Get reads the keys and the first column only
+  ReadOptions read_options;
+  read_options.columns = {1};
+  GetAll(read_options);
+  Row key, first, second;
+  ASSERT_TRUE(GetRow("key", &key));
+  ASSERT_TRUE(GetRow("1", &first));
+  ASSERT_TRUE(GetRow("2", &second));
+  ASSERT_GT(key.block_reads, 0U);
+  ASSERT_GT(first.block_reads, 0U);
+  ASSERT_EQ(0U, second.block_reads + second.cache_hits);
+  Row level;
+  ASSERT_TRUE(GetRow("L0", &level));
+  ASSERT_EQ(key.block_reads + first.block_reads, level.block_reads);
+
+  // a range query over every other block skips the others, in the key
+  // column and in the column it projects
+  read_options.columns = {0, 1};
+  std::unique_ptr<FileIter> iter(
+      dynamic_cast<FileIter*>(db_->NewFileIterator(read_options)));
+  uint64_t blocks = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    std::vector<std::vector<MinMax>> v;
+    Status s = iter->GetMinMax(v);
+    if (s.IsNotFound()) {
+      continue;  // the memtable
+    }
+    ASSERT_OK(s);
+    std::vector<bool> block_bits(v[0].size());
+    for (size_t j = 0; j < block_bits.size(); j += 2) {
+      block_bits[j] = true;
+    }
+    blocks += block_bits.size();
+    uint64_t size =
+        iter->EstimateRangeQueryBufSize(read_options.columns.size());
+    std::unique_ptr<char[]> buf(new char[size]);
+    uint64_t valid_count, total_count;
+    ASSERT_OK(iter->RangeQuery(block_bits, buf.get(), size, &valid_count,
+                               &total_count));
+    ASSERT_LT(valid_count, total_count);
+  }
+  ASSERT_GT(blocks, 1U);
+  ASSERT_TRUE(GetRow("key", &key));
+  ASSERT_TRUE(GetRow("1", &first));
+  ASSERT_TRUE(GetRow("2", &second));
+  ASSERT_EQ(blocks / 2, key.blocks_skipped);
+  ASSERT_EQ(blocks / 2, first.blocks_skipped);
+  ASSERT_EQ(0U, second.blocks_skipped);
+  ASSERT_TRUE(GetRow("L0", &level));
+  ASSERT_EQ(blocks / 2 * 2, level.blocks_skipped);
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,152 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "db/version_edit.h"
+#include "port/port.h"
+#include "util/string_util.h"
+#include "util/sync_point.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/db.h"
+#include "vidardb/statistics.h"
+
+namespace vidardb {
+
+class DBTableLoadingTest : public testing::Test {
+ public:
+  DBTableLoadingTest()
+      : dbname_(test::TmpDir() + "/db_table_loading_test"), db_(nullptr) {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~DBTableLoadingTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  Options GetOptions(int max_file_opening_threads) {
+    Options options;
+    options.create_if_missing = true;
+    options.disable_auto_compactions = true;
+    options.statistics = CreateDBStatistics();
+    options.max_open_files = -1;
+    options.max_file_opening_threads = max_file_opening_threads;
+    return options;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  // Leaves one table in level 2, and kNumL0Files tables in level 0.
+  void Populate(const Options& options) {
+    ASSERT_OK(DB::Open(options, dbname_, &db_));
+    for (int t = 0; t <= kNumL0Files; t++) {
+      for (int i = t * kKeysPerTable; i < (t + 1) * kKeysPerTable; i++) {
+        ASSERT_OK(db_->Put(WriteOptions(), Key(i), ToString(i)));
+      }
+      ASSERT_OK(db_->Flush(FlushOptions()));
+      if (t == 0) {
+        CompactRangeOptions compact_options;
+        compact_options.change_level = true;
+        compact_options.target_level = 2;
+        ASSERT_OK(db_->CompactRange(compact_options, nullptr, nullptr));
+      }
+    }
+    ASSERT_EQ(ToString(kNumL0Files), NumFilesAtLevel(0));
+    ASSERT_EQ("1", NumFilesAtLevel(2));
+    delete db_;
+    db_ = nullptr;
+  }
+
+  std::string NumFilesAtLevel(int level) {
+    std::string num;
+    EXPECT_TRUE(
+        db_->GetProperty("vidardb.num-files-at-level" + ToString(level), &num));
+    return num;
+  }
+
+  static const int kNumL0Files = 3;
+  static const int kKeysPerTable = 100;
+
+ protected:
+  std::string dbname_;
+  DB* db_;
+};
+
+const int DBTableLoadingTest::kNumL0Files;
+const int DBTableLoadingTest::kKeysPerTable;
+
+#ifndef NDEBUG
+TEST_F(DBTableLoadingTest, UpperLevelsFirst) {
+  Options options = GetOptions(1);
+  Populate(options);
+
+  // <level, largest seqno> of the tables in the order they are loaded
+  std::vector<std::pair<int, SequenceNumber>> loaded;
+  port::Mutex mutex;
+  SyncPoint::GetInstance()->SetCallBack(
+      "VersionBuilder::LoadTableHandlers:Load", [&](void* arg) {
+        auto* file = reinterpret_cast<std::pair<FileMetaData*, int>*>(arg);
+        MutexLock l(&mutex);
+        loaded.emplace_back(file->second, file->first->largest_seqno);
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_OK(DB::Open(options, dbname_, &db_));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_EQ(static_cast<size_t>(kNumL0Files + 1), loaded.size());
+  for (int i = 0; i < kNumL0Files; i++) {
+    ASSERT_EQ(0, loaded[i].first);
+    if (i > 0) {
+      // the newest tables of level 0 first
+      ASSERT_GT(loaded[i - 1].second, loaded[i].second);
+    }
+  }
+  ASSERT_EQ(2, loaded[kNumL0Files].first);
+}
+#endif  // !NDEBUG
+
+TEST_F(DBTableLoadingTest, ParallelLoading) {
+  Options options = GetOptions(16);
+  Populate(options);
+
+  // all the tables are opened by DB::Open, none by the reads
+  uint64_t opens = options.statistics->getTickerCount(NO_FILE_OPENS);
+  ASSERT_OK(DB::Open(options, dbname_, &db_));
+  ASSERT_EQ(opens + kNumL0Files + 1,
+            options.statistics->getTickerCount(NO_FILE_OPENS));
+  ReadOptions read_options;
+  for (int i = 0; i < (kNumL0Files + 1) * kKeysPerTable; i++) {
+    std::string value;
+    ASSERT_OK(db_->Get(read_options, Key(i), &value));
+    ASSERT_EQ(ToString(i), value);
+  }
+  ASSERT_EQ(opens + kNumL0Files + 1,
+            options.statistics->getTickerCount(NO_FILE_OPENS));
+
+  // and the tables of the flushes are opened in advance too
+  ASSERT_OK(db_->Put(WriteOptions(), Key(0), "new"));
+  ASSERT_OK(db_->Flush(FlushOptions()));
+  opens = options.statistics->getTickerCount(NO_FILE_OPENS);
+  std::string value;
+  ASSERT_OK(db_->Get(read_options, Key(0), &value));
+  ASSERT_EQ("new", value);
+  ASSERT_EQ(opens, options.statistics->getTickerCount(NO_FILE_OPENS));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,214 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "db/db_impl.h"
+#include "util/string_util.h"
+#include "util/sync_point.h"
+#include "util/testharness.h"
+#include "vidardb/db.h"
+#include "vidardb/write_batch.h"
+
+namespace vidardb {
+
+class DBWriteTest : public testing::Test {
+ public:
+  DBWriteTest() : dbname_(test::TmpDir() + "/db_write_test"), db_(nullptr) {
+    Options options;
+    options.create_if_missing = true;
+    DestroyDB(dbname_, options);
+    EXPECT_OK(DB::Open(options, dbname_, &db_));
+  }
+
+  ~DBWriteTest() {
+    delete db_;
+    DestroyDB(dbname_, Options());
+  }
+
+  DBImpl* dbfull() { return reinterpret_cast<DBImpl*>(db_); }
+
+  std::string Get(const std::string& key) {
+    ReadOptions read_options;
+    std::string value;
+    Status s = db_->Get(read_options, key, &value);
+    return s.IsNotFound() ? "NOT_FOUND" : s.ok() ? value : s.ToString();
+  }
+
+ protected:
+  std::string dbname_;
+  DB* db_;
+};
+
+TEST_F(DBWriteTest, PooledBatchIsReused) {
+  ASSERT_OK(db_->Put(WriteOptions(), "a", "1"));
+  const WriteBatch* batch = dbfull()->TEST_GetPooledWriteBatch();
+  const char* buffer = batch->Data().data();
+  size_t capacity = batch->Data().capacity();
+
+  for (int i = 0; i < 100; i++) {
+    std::string key = "k" + ToString(i);
+    ASSERT_OK(db_->Put(WriteOptions(), key, std::string(100, 'v')));
+    ASSERT_OK(db_->Delete(WriteOptions(), key));
+  }
+  // the same buffer is cleared and filled again
+  ASSERT_EQ(batch, dbfull()->TEST_GetPooledWriteBatch());
+  ASSERT_EQ(buffer, batch->Data().data());
+  ASSERT_EQ(capacity, batch->Data().capacity());
+  ASSERT_EQ(0, batch->Count());
+  ASSERT_EQ("1", Get("a"));
+  ASSERT_EQ("NOT_FOUND", Get("k0"));
+}
+
+TEST_F(DBWriteTest, OversizedBatchIsDropped) {
+  const WriteBatch* batch = dbfull()->TEST_GetPooledWriteBatch();
+  size_t capacity = batch->Data().capacity();
+  const std::string big_value(2 << 20, 'x');
+
+  ASSERT_OK(db_->Put(WriteOptions(), "big", big_value));
+  ASSERT_EQ(0, batch->Count());
+  ASSERT_EQ(capacity, batch->Data().capacity());
+
+  // Delete shrinks the batch the same way
+  ASSERT_OK(db_->Delete(WriteOptions(), big_value));
+  ASSERT_EQ(0, batch->Count());
+  ASSERT_EQ(capacity, batch->Data().capacity());
+  ASSERT_EQ(big_value, Get("big"));
+}
+
+TEST_F(DBWriteTest, ReentrantWriteFallsBack) {
+  dbfull()->TEST_SetPooledWriteBatchInUse(true);
+  const WriteBatch* batch = dbfull()->TEST_GetPooledWriteBatch();
+  // the writes go through a batch of their own, the pooled one is untouched
+  ASSERT_OK(db_->Put(WriteOptions(), "a", "1"));
+  ASSERT_OK(db_->Put(WriteOptions(), "b", "2"));
+  ASSERT_OK(db_->Delete(WriteOptions(), "a"));
+  ASSERT_EQ(0, batch->Count());
+  dbfull()->TEST_SetPooledWriteBatchInUse(false);
+
+  ASSERT_EQ("NOT_FOUND", Get("a"));
+  ASSERT_EQ("2", Get("b"));
+  ASSERT_OK(db_->Put(WriteOptions(), "a", "3"));
+  ASSERT_EQ("3", Get("a"));
+}
+
+TEST_F(DBWriteTest, ScratchFreedOnThreadExit) {
+  std::atomic<int> freed(0);
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::DeleteWriteScratch", [&](void* arg) { freed++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  ASSERT_OK(db_->Put(WriteOptions(), "main", "1"));
+  for (int i = 0; i < 4; i++) {
+    std::thread writer([&]() {
+      ASSERT_OK(db_->Put(WriteOptions(), "writer", ToString(i)));
+      ASSERT_OK(db_->Delete(WriteOptions(), "main"));
+    });
+    writer.join();
+    // the scratch of the writer is freed when the writer exits
+    ASSERT_EQ(i + 1, freed.load());
+  }
+  ASSERT_EQ("3", Get("writer"));
+
+  // the scratch of the main thread is freed when the db is closed
+  delete db_;
+  db_ = nullptr;
+  ASSERT_EQ(5, freed.load());
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
+namespace {
+// An Env whose clock only moves when told to.
+class ManualClockEnv : public EnvWrapper {
+ public:
+  explicit ManualClockEnv(Env* base) : EnvWrapper(base), now_micros_(1) {}
+
+  virtual uint64_t NowMicros() override { return now_micros_.load(); }
+
+  void Advance(uint64_t micros) { now_micros_ += micros; }
+
+ private:
+  std::atomic<uint64_t> now_micros_;
+};
+}  // namespace
+
+TEST_F(DBWriteTest, AdaptiveWriteBufferFlushesIdleColumnFamily) {
+  delete db_;
+  db_ = nullptr;
+  ManualClockEnv env(Env::Default());
+  Options options;
+  options.create_if_missing = true;
+  options.env = &env;
+  options.db_write_buffer_size = 2 << 20;
+  options.write_buffer_size = 4 << 20;
+  options.adaptive_write_buffer_sizing = true;
+  ASSERT_OK(DestroyDB(dbname_, options));
+  ASSERT_OK(DB::Open(options, dbname_, &db_));
+  ColumnFamilyHandle* idle;
+  ColumnFamilyHandle* hot;
+  ASSERT_OK(db_->CreateColumnFamily(options, "idle", &idle));
+  ASSERT_OK(db_->CreateColumnFamily(options, "hot", &hot));
+
+  auto num_l0_files = [&](ColumnFamilyHandle* cf) {
+    std::string num;
+    EXPECT_TRUE(db_->GetProperty(cf, "vidardb.num-files-at-level0", &num));
+    return num;
+  };
+  const std::string value(1000, 'v');
+  int key = 0;
+
+  // the idle column family takes a third of the budget, then stops writing
+  for (int i = 0; i < 700; i++) {
+    ASSERT_OK(db_->Put(WriteOptions(), idle, ToString(key++), value));
+  }
+  // the hot one keeps writing, which moves the budget over to it
+  while (num_l0_files(idle) == "0" && num_l0_files(hot) == "0") {
+    env.Advance(2000000);
+    for (int i = 0; i < 300; i++) {
+      ASSERT_OK(db_->Put(WriteOptions(), hot, ToString(key++), value));
+    }
+    ASSERT_OK(dbfull()->TEST_WaitForFlushMemTable(idle));
+    ASSERT_OK(dbfull()->TEST_WaitForFlushMemTable(hot));
+  }
+  // the memtable of the idle column family went over its shrunk budget and
+  // is flushed, even though the one of the hot column family is larger
+  ASSERT_EQ("1", num_l0_files(idle));
+  ASSERT_EQ("0", num_l0_files(hot));
+
+  // with every memtable within its budget, the largest one is flushed rather
+  // than the first one
+  ASSERT_OK(db_->Flush(FlushOptions(), hot));
+  ASSERT_EQ("1", num_l0_files(hot));
+  for (int i = 0; i < 120; i++) {
+    ASSERT_OK(db_->Put(WriteOptions(), idle, ToString(key++), value));
+  }
+  while (num_l0_files(hot) == "1") {
+    env.Advance(2000000);
+    for (int i = 0; i < 100; i++) {
+      ASSERT_OK(db_->Put(WriteOptions(), hot, ToString(key++), value));
+    }
+    ASSERT_OK(dbfull()->TEST_WaitForFlushMemTable(idle));
+    ASSERT_OK(dbfull()->TEST_WaitForFlushMemTable(hot));
+    ASSERT_EQ("1", num_l0_files(idle));
+  }
+  ASSERT_EQ("2", num_l0_files(hot));
+
+  delete idle;
+  delete hot;
+  delete db_;
+  db_ = nullptr;
+  ASSERT_OK(DestroyDB(dbname_, options));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,68 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/writebuffer.h"
+#include "vidardb/cache.h"
+#include "util/testharness.h"
+
+namespace vidardb {
+
+class WriteBufferTest : public testing::Test {};
+
+TEST_F(WriteBufferTest, ImmutableMemoryDoesNotTriggerFlush) {
+  WriteBuffer wb(10000);
+  wb.ReserveMem(8000);
+  ASSERT_FALSE(wb.ShouldFlush());
+  wb.ReserveMem(2000);
+  ASSERT_TRUE(wb.ShouldFlush());
+
+  // the memtable turns immutable, its memory is still held until it is freed
+  wb.ScheduleFreeMem(6000);
+  ASSERT_FALSE(wb.ShouldFlush());
+  ASSERT_EQ(4000U, wb.memory_usage());
+  ASSERT_EQ(10000U, wb.total_memory_usage());
+
+  wb.FreeMem(6000);
+  ASSERT_EQ(4000U, wb.memory_usage());
+  ASSERT_EQ(4000U, wb.total_memory_usage());
+}
+
+TEST_F(WriteBufferTest, ChargeCache) {
+  const size_t kDummy = WriteBuffer::kCacheDummyEntrySize;
+  std::shared_ptr<Cache> cache = NewLRUCache(64 * kDummy);
+  {
+    WriteBuffer wb(0, cache);
+    wb.ReserveMem(kDummy / 2);
+    ASSERT_EQ(kDummy, wb.cache_charge());
+    ASSERT_GE(cache->GetUsage(), kDummy);
+
+    wb.ReserveMem(10 * kDummy);
+    ASSERT_EQ(11 * kDummy, wb.cache_charge());
+    ASSERT_GE(cache->GetPinnedUsage(), 11 * kDummy);
+
+    // immutable memtables stay charged
+    wb.ScheduleFreeMem(10 * kDummy);
+    ASSERT_EQ(11 * kDummy, wb.cache_charge());
+
+    // one spare entry is kept after memtables are freed
+    wb.FreeMem(10 * kDummy);
+    ASSERT_EQ(2 * kDummy, wb.cache_charge());
+    ASSERT_LT(cache->GetUsage(), 3 * kDummy);
+
+    // the pinned entries cannot be evicted by other users of the cache
+    cache->SetCapacity(kDummy);
+    ASSERT_GE(cache->GetUsage(), 2 * kDummy);
+  }
+  // everything is released together with the write buffer
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+  ASSERT_LE(cache->GetUsage(), cache->GetCapacity());
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,164 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "vidardb/comparator.h"
+#include "vidardb/env.h"
+#include "vidardb/memtablerep.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+#include "util/testharness.h"
+
+namespace vidardb {
+
+namespace {
+// Compares length prefixed keys bytewise
+class TestKeyComparator : public MemTableRep::KeyComparator {
+ public:
+  virtual int operator()(const char* prefix_len_key1,
+                         const char* prefix_len_key2) const override {
+    return BytewiseComparator()->Compare(GetLengthPrefixedSlice(prefix_len_key1),
+                                         GetLengthPrefixedSlice(prefix_len_key2));
+  }
+
+  virtual int operator()(const char* prefix_len_key,
+                         const Slice& key) const override {
+    return BytewiseComparator()->Compare(GetLengthPrefixedSlice(prefix_len_key),
+                                         key);
+  }
+};
+}  // namespace
+
+class VectorRepTest : public testing::Test {
+ public:
+  VectorRepTest() : rep_(factory_.CreateMemTableRep(cmp_, nullptr, nullptr)) {}
+
+  // Builds a length prefixed key for i that sorts in numeric order
+  const char* MakeKey(uint64_t i) {
+    char buf[8];
+    EncodeFixed64(buf, i);
+    std::reverse(buf, buf + sizeof(buf));  // big endian
+    char* key;
+    {
+      MutexLock l(&arena_mutex_);
+      key = arena_.Allocate(VarintLength(sizeof(buf)) + sizeof(buf));
+    }
+    char* p = EncodeVarint32(key, sizeof(buf));
+    memcpy(p, buf, sizeof(buf));
+    return key;
+  }
+
+  uint64_t DecodeKey(const char* key) {
+    Slice s = GetLengthPrefixedSlice(key);
+    char buf[8];
+    memcpy(buf, s.data(), sizeof(buf));
+    std::reverse(buf, buf + sizeof(buf));
+    return DecodeFixed64(buf);
+  }
+
+  // Verifies that the rep holds exactly 0 .. n - 1 in order
+  void CheckOrdered(uint64_t n) {
+    std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator(nullptr));
+    uint64_t expected = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      ASSERT_EQ(expected, DecodeKey(iter->key()));
+      expected++;
+    }
+    ASSERT_EQ(n, expected);
+  }
+
+  TestKeyComparator cmp_;
+  VectorRepFactory factory_;
+  std::unique_ptr<MemTableRep> rep_;
+  port::Mutex arena_mutex_;
+  Arena arena_;
+};
+
+TEST_F(VectorRepTest, SupportsConcurrentInsert) {
+  ASSERT_TRUE(factory_.IsInsertConcurrentlySupported());
+}
+
+TEST_F(VectorRepTest, ConcurrentInsert) {
+  const int kThreads = 8;
+  const uint64_t kPerThread = 20000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      // interleave the threads so the final order has to come from sorting
+      for (uint64_t i = 0; i < kPerThread; ++i) {
+        rep_->InsertConcurrently(
+            const_cast<char*>(MakeKey(i * kThreads + t)));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  const uint64_t n = kThreads * kPerThread;
+  CheckOrdered(n);
+
+  // mutable reads see later inserts too
+  const char* key = MakeKey(n);
+  rep_->InsertConcurrently(const_cast<char*>(key));
+  ASSERT_TRUE(rep_->Contains(key));
+  CheckOrdered(n + 1);
+
+  // keys are merged before the rep turns read only
+  rep_->InsertConcurrently(const_cast<char*>(MakeKey(n + 1)));
+  rep_->MarkReadOnly();
+  CheckOrdered(n + 2);
+  CheckOrdered(n + 2);
+}
+
+TEST_F(VectorRepTest, SortWithEnv) {
+  // the runs of large buckets are sorted by jobs of the env
+  VectorRepFactory factory(0, Env::Default());
+  rep_.reset(factory.CreateMemTableRep(cmp_, nullptr, nullptr));
+  const uint64_t n = 100000;
+  for (uint64_t i = 0; i < n; ++i) {
+    // a permutation of 0 .. n - 1
+    rep_->Insert(const_cast<char*>(MakeKey((i * 7919) % n)));
+  }
+  CheckOrdered(n);
+  rep_->MarkReadOnly();
+  CheckOrdered(n);
+}
+
+TEST_F(VectorRepTest, SeekAfterConcurrentInsert) {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t]() {
+      for (uint64_t i = t; i < 1000; i += 4) {
+        rep_->InsertConcurrently(const_cast<char*>(MakeKey(i * 2)));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  rep_->MarkReadOnly();
+
+  std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator(nullptr));
+  const char* target = MakeKey(501);
+  iter->Seek(Slice(), target);
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(502U, DecodeKey(iter->key()));
+  iter->SeekToLast();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(1998U, DecodeKey(iter->key()));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "table/block_prefetcher.h"
+#include "table/format.h"
+#include "util/file_reader_writer.h"
+#include "util/testharness.h"
+#include "vidardb/env.h"
+
+namespace vidardb {
+
+namespace {
+// Records the prefetched ranges.
+class PrefetchRecordingFile : public RandomAccessFile {
+ public:
+  explicit PrefetchRecordingFile(
+      std::vector<std::pair<uint64_t, size_t>>* prefetches,
+      bool supported = true)
+      : prefetches_(prefetches), supported_(supported) {}
+
+  virtual Status Read(uint64_t offset, size_t n, Slice* result,
+                      char* scratch) const override {
+    *result = Slice();
+    return Status::OK();
+  }
+
+  virtual Status Prefetch(uint64_t offset, size_t n) override {
+    if (!supported_) {
+      return RandomAccessFile::Prefetch(offset, n);
+    }
+    prefetches_->emplace_back(offset, n);
+    return Status::OK();
+  }
+
+ private:
+  std::vector<std::pair<uint64_t, size_t>>* prefetches_;
+  bool supported_;
+};
+
+const uint64_t kBlockSize = 4096 - kBlockTrailerSize;
+const uint64_t kStride = kBlockSize + kBlockTrailerSize;
+}  // namespace
+
+class BlockPrefetcherTest : public testing::Test {
+ public:
+  BlockPrefetcherTest()
+      : file_(std::unique_ptr<RandomAccessFile>(
+            new PrefetchRecordingFile(&prefetches_))) {}
+
+  void ReadBlock(BlockPrefetcher* prefetcher, uint64_t i) {
+    prefetcher->OnBlockRead(&file_, BlockHandle(i * kStride, kBlockSize));
+  }
+
+ protected:
+  std::vector<std::pair<uint64_t, size_t>> prefetches_;
+  RandomAccessFileReader file_;
+};
+
+TEST_F(BlockPrefetcherTest, SequentialScan) {
+  const size_t kMaxReadahead = 64 * 1024;
+  BlockPrefetcher prefetcher(kMaxReadahead);
+  ReadBlock(&prefetcher, 10);
+  // a single read doesn't prefetch
+  ASSERT_TRUE(prefetches_.empty());
+  ReadBlock(&prefetcher, 11);
+  ASSERT_EQ(1U, prefetches_.size());
+  ASSERT_EQ(12 * kStride, prefetches_[0].first);
+  ASSERT_EQ(BlockPrefetcher::kInitReadaheadSize, prefetches_[0].second);
+
+  // the ranges follow each other and grow up to the max readahead
+  uint64_t limit = prefetcher.prefetch_limit();
+  for (uint64_t i = 12; i < 200; i++) {
+    ReadBlock(&prefetcher, i);
+    // the block being read is always prefetched already
+    ASSERT_GE(prefetcher.prefetch_limit(), (i + 1) * kStride);
+  }
+  for (size_t i = 1; i < prefetches_.size(); i++) {
+    ASSERT_EQ(prefetches_[i - 1].first + prefetches_[i - 1].second,
+              prefetches_[i].first);
+    ASSERT_LE(prefetches_[i].second, kMaxReadahead);
+  }
+  ASSERT_GT(prefetcher.prefetch_limit(), limit);
+  ASSERT_GE(prefetcher.prefetch_limit(), 200 * kStride + kMaxReadahead / 2);
+
+  // a seek starts over
+  prefetches_.clear();
+  ReadBlock(&prefetcher, 1000);
+  ASSERT_TRUE(prefetches_.empty());
+  ReadBlock(&prefetcher, 1001);
+  ASSERT_EQ(1U, prefetches_.size());
+  ASSERT_EQ(BlockPrefetcher::kInitReadaheadSize, prefetches_[0].second);
+}
+
+TEST_F(BlockPrefetcherTest, Disabled) {
+  BlockPrefetcher prefetcher(0);
+  for (uint64_t i = 0; i < 10; i++) {
+    ReadBlock(&prefetcher, i);
+  }
+  ASSERT_TRUE(prefetches_.empty());
+
+  // files without the support are not asked again
+  std::vector<std::pair<uint64_t, size_t>> prefetches;
+  RandomAccessFileReader file(std::unique_ptr<RandomAccessFile>(
+      new PrefetchRecordingFile(&prefetches, false)));
+  BlockPrefetcher unsupported(64 * 1024);
+  for (uint64_t i = 0; i < 10; i++) {
+    unsupported.OnBlockRead(&file, BlockHandle(i * kStride, kBlockSize));
+  }
+  ASSERT_EQ(0U, unsupported.prefetch_limit());
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
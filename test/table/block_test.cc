@@ -17,6 +17,8 @@
 #include "table/block.h"
 #include "table/block_builder.h"
 #include "table/format.h"
+#include "table/main_column_block_builder.h"
+#include "util/coding.h"
 #include "util/random.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
@@ -211,6 +213,42 @@ TEST_F(BlockTest, IndexHashWithSharedPrefix) {
   CheckBlockContents(std::move(contents), kMaxKey, keys, values);
 }
 
+// The main column stores the position only at the restart points, the
+// iterator derives the others.
+TEST_F(BlockTest, MainColumnPositions) {
+  const int kNumKeys = 100;
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  GenerateRandomKVs(&keys, &values, 0, kNumKeys);
+
+  MainColumnBlockBuilder builder(16);
+  std::vector<std::string> positions(kNumKeys);
+  for (int i = 0; i < kNumKeys; i++) {
+    PutFixed32BigEndian(&positions[i], i);
+    builder.Add(keys[i], positions[i]);
+  }
+  BlockContents contents;
+  contents.data = builder.Finish();
+  contents.cachable = false;
+  Block reader(std::move(contents));
+
+  std::unique_ptr<InternalIterator> iter(reader.NewIterator(
+      BytewiseComparator(), nullptr, Block::kTypeMainColumn));
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(keys[count], iter->key().ToString());
+    ASSERT_EQ(positions[count], iter->value().ToString());
+    count++;
+  }
+  ASSERT_EQ(kNumKeys, count);
+
+  for (int i = 0; i < kNumKeys; i++) {
+    iter->Seek(keys[i]);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(positions[i], iter->value().ToString());
+  }
+}
+
 }  // namespace vidardb
 
 int main(int argc, char **argv) {
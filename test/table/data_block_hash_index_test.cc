@@ -0,0 +1,229 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "table/block.h"
+#include "table/block_builder.h"
+#include "table/block_prefix_index.h"
+#include "table/data_block_hash_index.h"
+#include "table/format.h"
+#include "util/testharness.h"
+#include "vidardb/comparator.h"
+#include "vidardb/slice_transform.h"
+
+namespace vidardb {
+
+namespace {
+std::string UserKey(int i) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "key%06d", i);
+  return buf;
+}
+
+std::string IKey(const std::string& user_key, SequenceNumber seq) {
+  return InternalKey(user_key, seq, kTypeValue).Encode().ToString();
+}
+
+std::string Lookup(BlockIter* iter, const std::string& user_key) {
+  std::string ikey = IKey(user_key, kMaxSequenceNumber);
+  if (!iter->SeekForGet(ikey)) {
+    return "NOT_IN_LATER_BLOCKS";
+  }
+  if (!iter->Valid()) {
+    return "END";
+  }
+  if (ExtractUserKey(iter->key()) != user_key) {
+    return "NOT_FOUND";
+  }
+  return iter->value().ToString();
+}
+}  // namespace
+
+class DataBlockHashIndexTest : public testing::Test {
+ public:
+  DataBlockHashIndexTest() : icmp_(BytewiseComparator()) {}
+
+ protected:
+  InternalKeyComparator icmp_;
+};
+
+TEST_F(DataBlockHashIndexTest, PackUnpack) {
+  BlockIndexType index_type;
+  uint32_t num_restarts;
+  for (uint32_t n : {1u, 253u, (1u << 31) - 1u}) {
+    UnPackIndexTypeAndNumRestarts(
+        PackIndexTypeAndNumRestarts(kBinaryAndHash, n), &index_type,
+        &num_restarts);
+    ASSERT_EQ(kBinaryAndHash, index_type);
+    ASSERT_EQ(n, num_restarts);
+    UnPackIndexTypeAndNumRestarts(
+        PackIndexTypeAndNumRestarts(kBinarySearchOnly, n), &index_type,
+        &num_restarts);
+    ASSERT_EQ(kBinarySearchOnly, index_type);
+    ASSERT_EQ(n, num_restarts);
+  }
+}
+
+TEST_F(DataBlockHashIndexTest, BuilderAndLookup) {
+  DataBlockHashIndexBuilder builder;
+  builder.Initialize(0.75);
+  ASSERT_TRUE(builder.Valid());
+
+  const int kKeys = 100;
+  std::unordered_map<std::string, uint8_t> index;
+  for (int i = 0; i < kKeys; i++) {
+    std::string key = UserKey(i);
+    index[key] = static_cast<uint8_t>(i / 2);
+    builder.Add(key, i / 2);
+  }
+  size_t estimate = builder.EstimateSize();
+  std::string buffer("block data");
+  size_t map_start = buffer.size();
+  builder.Finish(&buffer);
+  ASSERT_EQ(estimate, buffer.size() - map_start);
+
+  DataBlockHashIndex hash_index;
+  uint16_t map_offset = 0;
+  ASSERT_TRUE(hash_index.Initialize(buffer.data(),
+                                    static_cast<uint16_t>(buffer.size()),
+                                    &map_offset));
+  ASSERT_EQ(map_start, map_offset);
+  for (auto& kv : index) {
+    uint8_t entry = hash_index.Lookup(buffer.data(), map_offset, kv.first);
+    ASSERT_TRUE(entry == kv.second || entry == kCollision);
+  }
+
+  // restart intervals beyond what a bucket holds disable the hash table
+  builder.Reset();
+  builder.Add("a", kMaxRestartSupportedByHashIndex + 1);
+  ASSERT_TRUE(!builder.Valid());
+  builder.Reset();
+  ASSERT_TRUE(builder.Valid());
+}
+
+TEST_F(DataBlockHashIndexTest, BlockSeekForGet) {
+  for (int restart_interval : {1, 4, 16}) {
+    BlockBuilder builder(restart_interval, true /* use hash index */);
+    // even keys only, with two versions of every 10th one
+    for (int i = 0; i < 400; i += 2) {
+      std::string user_key = UserKey(i);
+      if (i % 10 == 0) {
+        builder.Add(IKey(user_key, 2), "new" + user_key);
+        builder.Add(IKey(user_key, 1), "old" + user_key);
+      } else {
+        builder.Add(IKey(user_key, 1), "new" + user_key);
+      }
+    }
+    BlockContents contents;
+    contents.data = builder.Finish();
+    contents.cachable = false;
+    Block block(std::move(contents));
+
+    BlockIndexType index_type;
+    UnPackIndexTypeAndNumRestarts(
+        DecodeFixed32(block.data() + block.size() - sizeof(uint32_t)),
+        &index_type, nullptr);
+    ASSERT_EQ(kBinaryAndHash, index_type);
+
+    BlockIter iter;
+    block.NewIterator(&icmp_, &iter);
+    for (int i = 0; i < 400; i += 2) {
+      ASSERT_EQ("new" + UserKey(i), Lookup(&iter, UserKey(i)));
+      // the older version follows
+      if (i % 10 == 0) {
+        iter.Next();
+        ASSERT_EQ("old" + UserKey(i), iter.value().ToString());
+      }
+    }
+    for (int i = 1; i < 398; i += 2) {
+      std::string result = Lookup(&iter, UserKey(i));
+      ASSERT_TRUE(result == "NOT_IN_LATER_BLOCKS" || result == "NOT_FOUND")
+          << result;
+    }
+    // keys larger than the block may be in the next one
+    ASSERT_EQ("END", Lookup(&iter, UserKey(1000)));
+    ASSERT_OK(iter.status());
+
+    // the iterator still seeks and iterates in order
+    iter.Seek(IKey(UserKey(101), kMaxSequenceNumber));
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(UserKey(102), ExtractUserKey(iter.key()).ToString());
+  }
+}
+
+TEST_F(DataBlockHashIndexTest, BlockWithoutHashIndex) {
+  BlockBuilder builder(16, false /* use hash index */);
+  builder.Add(IKey(UserKey(1), 1), "v1");
+  BlockContents contents;
+  contents.data = builder.Finish();
+  contents.cachable = false;
+  Block block(std::move(contents));
+  ASSERT_EQ(1U, block.NumRestarts());
+
+  BlockIter iter;
+  block.NewIterator(&icmp_, &iter);
+  ASSERT_EQ("v1", Lookup(&iter, UserKey(1)));
+  ASSERT_EQ("END", Lookup(&iter, UserKey(2)));
+}
+
+TEST_F(DataBlockHashIndexTest, BlockPrefixIndex) {
+  std::unique_ptr<const SliceTransform> prefix_extractor(
+      NewDelimiterPrefixTransform('|'));
+  BlockPrefixIndexBuilder builder(prefix_extractor.get());
+  builder.Add("a|", 0, 2);
+  builder.Add("b|", 1, 1);
+  builder.Add("c|", 3, 4);
+  std::string contents = builder.Finish().ToString();
+
+  BlockPrefixIndex* raw_index = nullptr;
+  ASSERT_OK(BlockPrefixIndex::Create(prefix_extractor.get(), contents,
+                                     &raw_index));
+  std::unique_ptr<BlockPrefixIndex> index(raw_index);
+
+  uint32_t first = 0, last = 0;
+  ASSERT_TRUE(index->GetBlockRange(IKey("a|1", 1), &first, &last));
+  ASSERT_LE(first, 0U);
+  ASSERT_GE(last, 1U);
+  ASSERT_TRUE(index->GetBlockRange(IKey("c|9", 1), &first, &last));
+  ASSERT_LE(first, 3U);
+  ASSERT_GE(last, 6U);
+  // an absent prefix is missed unless it collides with a present one
+  int num_missed = 0;
+  for (char c = 'd'; c <= 'z'; c++) {
+    std::string key = std::string(1, c) + "|1";
+    if (!index->GetBlockRange(IKey(key, 1), &first, &last)) {
+      num_missed++;
+    }
+  }
+  ASSERT_GT(num_missed, 0);
+  // keys out of the domain go to all the blocks
+  ASSERT_TRUE(index->GetBlockRange(IKey("nodelimiter", 1), &first, &last));
+  ASSERT_EQ(0U, first);
+
+  // another extractor can't use the prefixes
+  std::unique_ptr<const SliceTransform> other(NewFixedPrefixTransform(2));
+  raw_index = nullptr;
+  ASSERT_TRUE(
+      BlockPrefixIndex::Create(other.get(), contents, &raw_index)
+          .IsInvalidArgument());
+  ASSERT_TRUE(raw_index == nullptr);
+  ASSERT_TRUE(BlockPrefixIndex::Create(prefix_extractor.get(),
+                                       contents.substr(0, contents.size() - 1),
+                                       &raw_index)
+                  .IsCorruption());
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
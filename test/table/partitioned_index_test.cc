@@ -0,0 +1,201 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <stdio.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "table/block.h"
+#include "table/format.h"
+#include "table/index_builder.h"
+#include "table/two_level_iterator.h"
+#include "util/testharness.h"
+#include "vidardb/comparator.h"
+
+namespace vidardb {
+
+namespace {
+std::string IKey(int i) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "key%06d", i);
+  return InternalKey(buf, 1, kTypeValue).Encode().ToString();
+}
+
+std::string Value(int i) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%06d", i);
+  return buf;
+}
+
+// Serves the partitions written by the builder from memory.
+class MemoryPartitionState : public TwoLevelIteratorState {
+ public:
+  MemoryPartitionState(const Comparator* comparator,
+                       const std::map<uint64_t, std::unique_ptr<Block>>* blocks,
+                       Block::BlockType block_type)
+      : comparator_(comparator), blocks_(blocks), block_type_(block_type) {}
+
+  virtual InternalIterator* NewSecondaryIterator(const Slice& handle) override {
+    Slice input = handle;
+    BlockHandle block_handle;
+    Status s = block_handle.DecodeFrom(&input);
+    if (!s.ok()) {
+      return NewErrorInternalIterator(s);
+    }
+    auto it = blocks_->find(block_handle.offset());
+    if (it == blocks_->end()) {
+      return NewErrorInternalIterator(Status::Corruption("no partition"));
+    }
+    return it->second->NewIterator(comparator_, nullptr, block_type_);
+  }
+
+ private:
+  const Comparator* comparator_;
+  const std::map<uint64_t, std::unique_ptr<Block>>* blocks_;
+  Block::BlockType block_type_;
+};
+}  // namespace
+
+class PartitionedIndexTest : public testing::Test {
+ public:
+  PartitionedIndexTest() : icmp_(BytewiseComparator()) {}
+
+  // Adds the index entries of num_blocks data blocks of 3 keys each, and
+  // writes the partitions and the top-level block to blocks_.
+  void Build(PartitionedIndexBuilder* builder, int num_blocks) {
+    for (int b = 0; b < num_blocks; b++) {
+      for (int k = 3 * b; k < 3 * b + 3; k++) {
+        builder->OnKeyAdded(value_comparator_ ? Slice(Value(k))
+                                              : Slice(IKey(k)));
+      }
+      std::string last_key = IKey(3 * b + 2);
+      std::string next_key = IKey(3 * b + 3);
+      Slice next(next_key);
+      builder->AddIndexEntry(&last_key, b + 1 < num_blocks ? &next : nullptr,
+                             BlockHandle(1000 * b, 100 + b));
+    }
+
+    uint64_t num_partitions = builder->NumPartitions();
+    IndexBuilder::IndexBlocks index_blocks;
+    Status s = builder->Finish(&index_blocks);
+    uint64_t offset = 0;
+    uint64_t num_written = 0;
+    for (;;) {
+      ASSERT_TRUE(s.ok() || s.IsIncomplete());
+      // the blocks point into the buffers
+      std::string* data =
+          new std::string(index_blocks.index_block_contents.ToString());
+      buffers_.emplace_back(data);
+      BlockContents contents;
+      contents.data = *data;
+      contents.cachable = false;
+      BlockHandle handle(offset, data->size());
+      offset += data->size() + kBlockTrailerSize;
+      if (s.ok()) {
+        top_level_.reset(new Block(std::move(contents)));
+        break;
+      }
+      blocks_[handle.offset()].reset(new Block(std::move(contents)));
+      num_written++;
+      s = builder->FinishNextPartition(&index_blocks, handle);
+    }
+    ASSERT_EQ(num_partitions, num_written);
+  }
+
+  InternalIterator* NewIndexIterator(Block::BlockType block_type) {
+    return NewTwoLevelIterator(
+        new MemoryPartitionState(&icmp_, &blocks_, block_type),
+        top_level_->NewIterator(&icmp_, nullptr, block_type));
+  }
+
+ protected:
+  InternalKeyComparator icmp_;
+  const Comparator* value_comparator_ = nullptr;
+  std::vector<std::unique_ptr<std::string>> buffers_;
+  std::map<uint64_t, std::unique_ptr<Block>> blocks_;
+  std::unique_ptr<Block> top_level_;
+};
+
+TEST_F(PartitionedIndexTest, SeekAndScan) {
+  const int kBlocks = 200;
+  PartitionedIndexBuilder builder(&icmp_, 1, 256 /* metadata_block_size */);
+  Build(&builder, kBlocks);
+  ASSERT_GT(builder.NumPartitions(), 1U);
+  ASSERT_EQ(builder.NumPartitions(), blocks_.size());
+
+  std::unique_ptr<InternalIterator> iter(NewIndexIterator(Block::kTypeBlock));
+  int b = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), b++) {
+    Slice input = iter->value();
+    BlockHandle handle;
+    ASSERT_OK(handle.DecodeFrom(&input));
+    ASSERT_EQ(1000U * b, handle.offset());
+    ASSERT_EQ(100U + b, handle.size());
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(kBlocks, b);
+
+  // every key is found in the index entry of its data block
+  for (int k = 0; k < 3 * kBlocks; k++) {
+    iter->Seek(IKey(k));
+    ASSERT_TRUE(iter->Valid());
+    Slice input = iter->value();
+    BlockHandle handle;
+    ASSERT_OK(handle.DecodeFrom(&input));
+    ASSERT_EQ(1000U * (k / 3), handle.offset());
+  }
+  // the last index key is a short successor of the last key in the table
+  iter->Seek(InternalKey("z", 1, kTypeValue).Encode());
+  ASSERT_TRUE(!iter->Valid());
+}
+
+TEST_F(PartitionedIndexTest, MinMax) {
+  const int kBlocks = 100;
+  value_comparator_ = BytewiseComparator();
+  PartitionedIndexBuilder builder(&icmp_, 1, 256 /* metadata_block_size */,
+                                  value_comparator_);
+  Build(&builder, kBlocks);
+  ASSERT_GT(builder.NumPartitions(), 1U);
+
+  // the second level keeps the min & max of every data block
+  std::unique_ptr<InternalIterator> iter(NewIndexIterator(Block::kTypeMinMax));
+  int b = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), b++) {
+    ASSERT_EQ(Value(3 * b), iter->min().ToString());
+    ASSERT_EQ(Value(3 * b + 2), iter->max().ToString());
+  }
+  ASSERT_EQ(kBlocks, b);
+
+  // the top level keeps the min & max of every partition
+  std::unique_ptr<InternalIterator> top_iter(
+      top_level_->NewIterator(&icmp_, nullptr, Block::kTypeMinMax));
+  std::string last_max;
+  int num_partitions = 0;
+  for (top_iter->SeekToFirst(); top_iter->Valid(); top_iter->Next()) {
+    ASSERT_LT(last_max, top_iter->min().ToString());
+    ASSERT_LT(top_iter->min().ToString(), top_iter->max().ToString());
+    last_max = top_iter->max().ToString();
+    num_partitions++;
+  }
+  ASSERT_EQ(Value(3 * kBlocks - 1), last_max);
+  ASSERT_EQ(builder.NumPartitions(), static_cast<uint64_t>(num_partitions));
+}
+
+TEST_F(PartitionedIndexTest, Empty) {
+  PartitionedIndexBuilder builder(&icmp_, 1, 256 /* metadata_block_size */);
+  IndexBuilder::IndexBlocks index_blocks;
+  ASSERT_OK(builder.Finish(&index_blocks));
+  ASSERT_EQ(0U, builder.NumPartitions());
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
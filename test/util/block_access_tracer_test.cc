@@ -0,0 +1,233 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "util/block_access_tracer.h"
+#include "util/cache_simulator.h"
+#include "util/random.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "vidardb/cache.h"
+#include "vidardb/comparator.h"
+#include "vidardb/db.h"
+#include "vidardb/splitter.h"
+#include "vidardb/statistics.h"
+#include "vidardb/table.h"
+
+namespace vidardb {
+
+class BlockAccessTracerTest : public testing::Test {
+ public:
+  BlockAccessTracerTest()
+      : env_(Env::Default()),
+        trace_file_(test::TmpDir(env_) + "/block_access_trace") {}
+
+  ~BlockAccessTracerTest() { env_->DeleteFile(trace_file_); }
+
+  // Returns the lookups of the trace, by block cache key.
+  std::map<std::string, std::vector<BlockAccess>> ReadTrace() {
+    std::map<std::string, std::vector<BlockAccess>> accesses;
+    BlockAccessTraceReader reader;
+    EXPECT_OK(reader.Open(env_, trace_file_));
+    BlockAccess access;
+    Status s;
+    while ((s = reader.Next(&access)).ok()) {
+      accesses[access.key.ToString()].push_back(access);
+    }
+    EXPECT_TRUE(s.IsNotFound());
+    return accesses;
+  }
+
+ protected:
+  Env* env_;
+  std::string trace_file_;
+};
+
+TEST_F(BlockAccessTracerTest, WriteAndRead) {
+  std::shared_ptr<BlockAccessTracer> tracer = NewBlockAccessTracer();
+  BlockAccess access;
+  access.key = "key";
+  tracer->Record(access);  // not tracing yet
+  ASSERT_FALSE(tracer->IsTracing());
+  ASSERT_TRUE(tracer->EndTrace().IsInvalidArgument());
+
+  ASSERT_OK(tracer->StartTrace(env_, trace_file_));
+  ASSERT_TRUE(tracer->IsTracing());
+  ASSERT_TRUE(tracer->StartTrace(env_, trace_file_).IsInvalidArgument());
+  for (int i = 0; i < 3; i++) {
+    access.micros = 100 + i;
+    access.key = "block" + ToString(i);
+    access.charge = 4096 * i;
+    access.type = static_cast<BlockAccess::Type>(i);
+    access.hit = i == 1;
+    access.fill_cache = i != 2;
+    tracer->Record(access);
+  }
+  ASSERT_OK(tracer->EndTrace());
+  ASSERT_FALSE(tracer->IsTracing());
+
+  BlockAccessTraceReader reader;
+  ASSERT_OK(reader.Open(env_, trace_file_));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(reader.Next(&access));
+    ASSERT_EQ(100U + i, access.micros);
+    ASSERT_EQ("block" + ToString(i), access.key.ToString());
+    ASSERT_EQ(4096U * i, access.charge);
+    ASSERT_EQ(i, static_cast<int>(access.type));
+    ASSERT_EQ(i == 1, access.hit);
+    ASSERT_EQ(i != 2, access.fill_cache);
+  }
+  ASSERT_TRUE(reader.Next(&access).IsNotFound());
+}
+
+TEST_F(BlockAccessTracerTest, SampleByBlock) {
+  std::shared_ptr<BlockAccessTracer> tracer = NewBlockAccessTracer();
+  ASSERT_OK(tracer->StartTrace(env_, trace_file_, 4));
+  const int kNumBlocks = 4000;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < kNumBlocks; i++) {
+      BlockAccess access;
+      std::string key = "block" + ToString(i);
+      access.key = key;
+      tracer->Record(access);
+    }
+  }
+  ASSERT_OK(tracer->EndTrace());
+
+  // about a fourth of the blocks, with all their lookups
+  auto accesses = ReadTrace();
+  ASSERT_GT(accesses.size(), kNumBlocks / 4 * 8 / 10);
+  ASSERT_LT(accesses.size(), kNumBlocks / 4 * 12 / 10);
+  for (const auto& block : accesses) {
+    ASSERT_EQ(3U, block.second.size());
+  }
+}
+
+// Runs with BlockBasedTable if the param is false, with ColumnTable if true.
+class BlockAccessTraceDBTest : public BlockAccessTracerTest,
+                               public testing::WithParamInterface<bool> {
+ public:
+  BlockAccessTraceDBTest()
+      : dbname_(test::TmpDir() + "/block_access_tracer_test") {
+    DestroyDB(dbname_, Options());
+  }
+
+  ~BlockAccessTraceDBTest() { DestroyDB(dbname_, Options()); }
+
+  Options GetOptions(const std::shared_ptr<Cache>& block_cache) {
+    Options options;
+    options.create_if_missing = true;
+    options.statistics = CreateDBStatistics();
+    options.block_access_tracer = NewBlockAccessTracer();
+    if (GetParam()) {
+      ColumnTableOptions table_options;
+      table_options.block_cache = block_cache;
+      table_options.block_size = 1024;
+      table_options.cache_index_and_filter_blocks = true;
+      table_options.column_count = 2;
+      for (uint32_t i = 0; i < table_options.column_count; i++) {
+        table_options.value_comparators.push_back(BytewiseComparator());
+      }
+      options.splitter.reset(NewPipeSplitter());
+      options.table_factory.reset(NewColumnTableFactory(table_options));
+    } else {
+      BlockBasedTableOptions table_options;
+      table_options.block_cache = block_cache;
+      table_options.block_size = 1024;
+      table_options.cache_index_and_filter_blocks = true;
+      options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    }
+    return options;
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+ protected:
+  std::string dbname_;
+};
+
+TEST_P(BlockAccessTraceDBTest, TraceMatchesBlockCache) {
+  const size_t kCapacity = 64 << 10;
+  Options options = GetOptions(NewLRUCache(kCapacity, 0));
+  DB* db;
+  ASSERT_OK(DB::Open(options, dbname_, &db));
+  const int kNumKeys = 5000;
+  for (int i = 0; i < kNumKeys; i++) {
+    std::string value = ToString(i) + std::string(50, 'v');
+    if (options.splitter != nullptr) {
+      value = options.splitter->Stitch({value, value});
+    }
+    ASSERT_OK(db->Put(WriteOptions(), Key(i), value));
+  }
+  ASSERT_OK(db->Flush(FlushOptions()));
+
+  // random reads over a table larger than the cache
+  Statistics* stats = options.statistics.get();
+  uint64_t hits = stats->getTickerCount(BLOCK_CACHE_HIT);
+  uint64_t misses = stats->getTickerCount(BLOCK_CACHE_MISS);
+  ASSERT_OK(options.block_access_tracer->StartTrace(env_, trace_file_));
+  Random rnd(301);
+  ReadOptions read_options;
+  for (int i = 0; i < 5000; i++) {
+    std::string value;
+    ASSERT_OK(db->Get(read_options, Key(rnd.Skewed(12) % kNumKeys), &value));
+  }
+  ASSERT_OK(options.block_access_tracer->EndTrace());
+  hits = stats->getTickerCount(BLOCK_CACHE_HIT) - hits;
+  misses = stats->getTickerCount(BLOCK_CACHE_MISS) - misses;
+  delete db;
+
+  // every lookup is in the trace
+  uint64_t trace_hits = 0, trace_misses = 0, data = 0, index = 0;
+  for (const auto& block : ReadTrace()) {
+    for (const auto& access : block.second) {
+      (access.hit ? trace_hits : trace_misses)++;
+      data += access.type == BlockAccess::kData ? 1 : 0;
+      index += access.type == BlockAccess::kIndex ? 1 : 0;
+      ASSERT_GT(access.charge, 0U);
+    }
+  }
+  ASSERT_EQ(hits, trace_hits);
+  ASSERT_EQ(misses, trace_misses);
+  ASSERT_GT(trace_misses, 0U);
+  ASSERT_GT(data, 0U);
+  ASSERT_GT(index, 0U);
+
+  // the simulation of the same cache misses like it, and a larger cache
+  // misses less
+  std::vector<double> miss_ratios;
+  for (size_t capacity : {kCapacity, 16 * kCapacity}) {
+    CacheSimulator simulator(NewSimulatedCache("lru", capacity, 0));
+    BlockAccessTraceReader reader;
+    ASSERT_OK(reader.Open(env_, trace_file_));
+    BlockAccess access;
+    while (reader.Next(&access).ok()) {
+      simulator.Access(access);
+    }
+    ASSERT_EQ(hits + misses, simulator.accesses());
+    miss_ratios.push_back(simulator.MissRatio());
+  }
+  double traced_miss_ratio = static_cast<double>(misses) / (hits + misses);
+  ASSERT_NEAR(traced_miss_ratio, miss_ratios[0], 0.05);
+  ASSERT_LT(miss_ratios[1], miss_ratios[0]);
+}
+
+INSTANTIATE_TEST_CASE_P(BlockAccessTraceDBTest, BlockAccessTraceDBTest,
+                        testing::Bool());
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,183 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Copyright (c) 2012 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include <memory>
+#include <string>
+#include "table/full_filter_block.h"
+#include "util/coding.h"
+#include "util/testharness.h"
+#include "vidardb/filter_policy.h"
+#include "vidardb/slice_transform.h"
+
+namespace vidardb {
+
+namespace {
+Slice Key(int i, char* buffer) {
+  EncodeFixed32(buffer, i);
+  return Slice(buffer, sizeof(uint32_t));
+}
+}  // namespace
+
+class BloomTest : public testing::Test {
+ public:
+  BloomTest() : policy_(NewBloomFilterPolicy(10)) { Reset(); }
+
+  void Reset() {
+    bits_builder_.reset(policy_->GetFilterBitsBuilder());
+    bits_reader_.reset();
+    buf_.reset();
+  }
+
+  void Add(const Slice& s) { bits_builder_->AddKey(s); }
+
+  void Build() {
+    filter_ = bits_builder_->Finish(&buf_);
+    bits_reader_.reset(policy_->GetFilterBitsReader(filter_));
+  }
+
+  size_t FilterSize() const { return filter_.size(); }
+
+  bool Matches(const Slice& s) {
+    if (bits_reader_ == nullptr) {
+      Build();
+    }
+    return bits_reader_->MayMatch(s);
+  }
+
+  double FalsePositiveRate() {
+    char buffer[sizeof(int)];
+    int result = 0;
+    for (int i = 0; i < 10000; i++) {
+      if (Matches(Key(i + 1000000000, buffer))) {
+        result++;
+      }
+    }
+    return result / 10000.0;
+  }
+
+ protected:
+  std::unique_ptr<const FilterPolicy> policy_;
+  std::unique_ptr<FilterBitsBuilder> bits_builder_;
+  std::unique_ptr<FilterBitsReader> bits_reader_;
+  std::unique_ptr<const char[]> buf_;
+  Slice filter_;
+};
+
+TEST_F(BloomTest, EmptyFilter) {
+  ASSERT_TRUE(!Matches("hello"));
+  ASSERT_TRUE(!Matches("world"));
+}
+
+TEST_F(BloomTest, Small) {
+  Add("hello");
+  Add("world");
+  ASSERT_TRUE(Matches("hello"));
+  ASSERT_TRUE(Matches("world"));
+  ASSERT_TRUE(!Matches("x"));
+  ASSERT_TRUE(!Matches("foo"));
+}
+
+TEST_F(BloomTest, VaryingLengths) {
+  char buffer[sizeof(int)];
+
+  // Count number of filters that significantly exceed the false positive rate
+  int mediocre_filters = 0;
+  int good_filters = 0;
+
+  for (int length = 1; length <= 10000; length = length * 5 / 4 + 1) {
+    Reset();
+    for (int i = 0; i < length; i++) {
+      Add(Key(i, buffer));
+    }
+    Build();
+
+    // the filter is made of whole cache lines plus a small trailer
+    ASSERT_LE(FilterSize(),
+              static_cast<size_t>((length * 10 / 8) + 64 + 6)) << length;
+
+    // All added keys must match
+    for (int i = 0; i < length; i++) {
+      ASSERT_TRUE(Matches(Key(i, buffer)))
+          << "Length " << length << "; key " << i;
+    }
+
+    // Check false positive rate
+    double rate = FalsePositiveRate();
+    fprintf(stderr, "False positives: %5.2f%% @ length = %6d ; bytes = %6d\n",
+            rate * 100.0, length, static_cast<int>(FilterSize()));
+    ASSERT_LE(rate, 0.02);  // Must not be over 2%
+    if (rate > 0.0125) {
+      mediocre_filters++;  // Allowed, but not too often
+    } else {
+      good_filters++;
+    }
+  }
+  fprintf(stderr, "Filters: %d good, %d mediocre\n", good_filters,
+          mediocre_filters);
+  ASSERT_LE(mediocre_filters, good_filters / 5);
+}
+
+TEST_F(BloomTest, UnknownContentsMatchEverything) {
+  std::unique_ptr<FilterBitsReader> reader(
+      policy_->GetFilterBitsReader(Slice("abc")));
+  ASSERT_TRUE(reader->MayMatch("hello"));
+
+  Add("hello");
+  Build();
+  // a filter of a newer format is not trusted
+  std::string contents = filter_.ToString();
+  contents[contents.size() - 6] = 1;
+  reader.reset(policy_->GetFilterBitsReader(contents));
+  ASSERT_TRUE(reader->MayMatch("world"));
+}
+
+TEST_F(BloomTest, FullFilterBlockBuilder) {
+  FullFilterBlockBuilder builder(nullptr, true,
+                                 policy_->GetFilterBitsBuilder());
+  ASSERT_TRUE(builder.IsEmpty());
+  ASSERT_TRUE(builder.Finish().empty());
+
+  // versions of the same user key are added once
+  builder.Add("bar");
+  builder.Add("bar");
+  builder.Add("box");
+  ASSERT_TRUE(!builder.IsEmpty());
+  Slice contents = builder.Finish();
+  std::unique_ptr<FilterBitsReader> reader(
+      policy_->GetFilterBitsReader(contents));
+  ASSERT_TRUE(reader->MayMatch("bar"));
+  ASSERT_TRUE(reader->MayMatch("box"));
+  ASSERT_TRUE(!reader->MayMatch("hello"));
+}
+
+TEST_F(BloomTest, FullFilterBlockBuilderPrefix) {
+  std::unique_ptr<const SliceTransform> prefix_extractor(
+      NewDelimiterPrefixTransform('|'));
+  FullFilterBlockBuilder builder(prefix_extractor.get(), false,
+                                 policy_->GetFilterBitsBuilder());
+  builder.Add("t1|e1|1");
+  builder.Add("t1|e2|2");
+  builder.Add("t2|e1|1");
+  builder.Add("nodelimiter");
+  Slice contents = builder.Finish();
+  std::unique_ptr<FilterBitsReader> reader(
+      policy_->GetFilterBitsReader(contents));
+  ASSERT_TRUE(reader->MayMatch("t1|"));
+  ASSERT_TRUE(reader->MayMatch("t2|"));
+  ASSERT_TRUE(!reader->MayMatch("t3|"));
+  // whole keys are not added
+  ASSERT_TRUE(!reader->MayMatch("t1|e1|1"));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
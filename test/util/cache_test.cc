@@ -9,11 +9,14 @@
 
 #include "vidardb/cache.h"
 
+#include <atomic>
 #include <forward_list>
+#include <thread>
 #include <vector>
 #include <string>
 #include <iostream>
 #include "util/coding.h"
+#include "util/random.h"
 #include "util/string_util.h"
 #include "util/testharness.h"
 
@@ -326,6 +329,126 @@ TEST_F(CacheTest, EvictionPolicyRef) {
   cache_->Release(h204);
 }
 
+TEST_F(CacheTest, HighPriorityPool) {
+  // a single shard of 10 entries, half of them reserved for high priority
+  std::shared_ptr<Cache> cache = NewLRUCache(10, 0, false, 0.5);
+  ASSERT_EQ(0.5, cache->GetHighPriorityPoolRatio());
+  for (int i = 0; i < 5; i++) {
+    cache->Insert(EncodeKey(i), EncodeValue(i), 1, &CacheTest::Deleter,
+                  nullptr, Cache::Priority::HIGH);
+  }
+  // a scan of low priority entries doesn't evict the high priority ones
+  for (int i = 100; i < 200; i++) {
+    Insert(cache, i, i);
+  }
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(i, Lookup(cache, i));
+  }
+  ASSERT_EQ(-1, Lookup(cache, 100));
+  ASSERT_EQ(199, Lookup(cache, 199));
+
+  // the oldest high priority entries overflow to the low-pri pool
+  for (int i = 5; i < 10; i++) {
+    cache->Insert(EncodeKey(i), EncodeValue(i), 1, &CacheTest::Deleter,
+                  nullptr, Cache::Priority::HIGH);
+  }
+  Insert(cache, 200, 200);
+  ASSERT_EQ(-1, Lookup(cache, 0));
+  for (int i = 5; i < 10; i++) {
+    ASSERT_EQ(i, Lookup(cache, i));
+  }
+
+  // without the pool the priority is ignored
+  cache->SetHighPriorityPoolRatio(0.0);
+  for (int i = 300; i < 310; i++) {
+    Insert(cache, i, i);
+  }
+  for (int i = 5; i < 10; i++) {
+    ASSERT_EQ(-1, Lookup(cache, i));
+  }
+
+  ASSERT_TRUE(NewLRUCache(10, 0, false, 1.5) == nullptr);
+}
+
+TEST_F(CacheTest, TinyLFUAdmissionResistsScan) {
+  for (bool tinylfu_admission : {false, true}) {
+    // a single shard of 100 entries
+    std::shared_ptr<Cache> cache =
+        NewLRUCache(100, 0, false, 0.0, tinylfu_admission);
+    // 50 popular keys, looked up 10 times each
+    for (int i = 0; i < 50; i++) {
+      ASSERT_EQ(-1, Lookup(cache, i));
+      Insert(cache, i, i);
+    }
+    for (int round = 0; round < 9; round++) {
+      for (int i = 0; i < 50; i++) {
+        ASSERT_EQ(i, Lookup(cache, i));
+      }
+    }
+    // a scan reads 300 other keys once
+    for (int i = 1000; i < 1300; i++) {
+      ASSERT_EQ(-1, Lookup(cache, i));
+      Insert(cache, i, i);
+    }
+    ASSERT_LE(cache->GetUsage(), 100U);
+
+    int hits = 0;
+    for (int i = 0; i < 50; i++) {
+      if (Lookup(cache, i) == i) {
+        hits++;
+      }
+    }
+    if (tinylfu_admission) {
+      ASSERT_EQ(50, hits);
+      ASSERT_EQ(1299, Lookup(cache, 1299));  // the window
+    } else {
+      ASSERT_EQ(0, hits);
+    }
+  }
+}
+
+TEST_F(CacheTest, TinyLFUAdmitsFrequentKeys) {
+  // a single shard of 10 entries, too small for a window
+  std::shared_ptr<Cache> cache = NewLRUCache(10, 0, false, 0.0, true);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(-1, Lookup(cache, i));
+    Insert(cache, i, i);
+  }
+
+  // a key looked up once is not more popular than the oldest entry
+  ASSERT_EQ(-1, Lookup(cache, 100));
+  Insert(cache, 100, 100);
+  ASSERT_EQ(1U, deleted_keys_.size());
+  ASSERT_EQ(100, deleted_keys_[0]);
+  ASSERT_EQ(0, Lookup(cache, 0));
+
+  // a key looked up three times is, and pushes out the oldest entry
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(-1, Lookup(cache, 200));
+  }
+  Insert(cache, 200, 200);
+  ASSERT_EQ(200, Lookup(cache, 200));
+  ASSERT_EQ(-1, Lookup(cache, 1));
+  ASSERT_EQ(10U, cache->GetUsage());
+
+  // the high priority entries are always admitted
+  cache->Insert(EncodeKey(300), EncodeValue(300), 1, &CacheTest::Deleter,
+                nullptr, Cache::Priority::HIGH);
+  ASSERT_EQ(300, Lookup(cache, 300));
+  ASSERT_EQ(10U, cache->GetUsage());
+
+  // an entry pinned at insertion takes the room of the oldest entry, and
+  // passes the window once released
+  Cache::Handle* handle = nullptr;
+  ASSERT_OK(cache->Insert(EncodeKey(400), EncodeValue(400), 1,
+                          &CacheTest::Deleter, &handle));
+  ASSERT_EQ(10U, cache->GetUsage());
+  ASSERT_EQ(1U, cache->GetPinnedUsage());
+  cache->Release(handle);
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+  ASSERT_EQ(400, Lookup(cache, 400));
+}
+
 TEST_F(CacheTest, ErasedHandleState) {
   // insert a key and get two handles
   Insert(100, 1000);
@@ -559,6 +682,185 @@ TEST_F(CacheTest, ApplyToAllCacheEntiresTest) {
   ASSERT_TRUE(inserted == callback_state);
 }
 
+TEST_F(CacheTest, ClockCacheHitAndMiss) {
+  std::shared_ptr<Cache> cache = NewClockCache(kCacheSize, kNumShardBits, false);
+  ASSERT_EQ(-1, Lookup(cache, 100));
+
+  Insert(cache, 100, 101);
+  ASSERT_EQ(101, Lookup(cache, 100));
+  ASSERT_EQ(-1, Lookup(cache, 200));
+
+  Insert(cache, 200, 201);
+  ASSERT_EQ(101, Lookup(cache, 100));
+  ASSERT_EQ(201, Lookup(cache, 200));
+
+  // the replaced entry is deleted
+  Insert(cache, 100, 102);
+  ASSERT_EQ(102, Lookup(cache, 100));
+  ASSERT_EQ(201, Lookup(cache, 200));
+  ASSERT_EQ(1U, deleted_keys_.size());
+  ASSERT_EQ(100, deleted_keys_[0]);
+  ASSERT_EQ(101, deleted_values_[0]);
+
+  Erase(cache, 200);
+  ASSERT_EQ(-1, Lookup(cache, 200));
+  ASSERT_EQ(102, Lookup(cache, 100));
+  ASSERT_EQ(2U, deleted_keys_.size());
+  ASSERT_EQ(200, deleted_keys_[1]);
+  ASSERT_EQ(201, deleted_values_[1]);
+  ASSERT_EQ(1U, cache->GetUsage());
+
+  ASSERT_TRUE(NewClockCache(10, 20, false) == nullptr);
+}
+
+TEST_F(CacheTest, ClockCacheManyEntries) {
+  // enough entries in a single shard to grow its hash table several times
+  std::shared_ptr<Cache> cache = NewClockCache(kCacheSize, 0, false);
+  for (int i = 0; i < kCacheSize; i++) {
+    Insert(cache, i, i + 1000);
+  }
+  for (int i = 0; i < kCacheSize; i++) {
+    ASSERT_EQ(i + 1000, Lookup(cache, i));
+  }
+  // erase every other entry, the rest is still found
+  for (int i = 0; i < kCacheSize; i += 2) {
+    Erase(cache, i);
+  }
+  for (int i = 0; i < kCacheSize; i++) {
+    ASSERT_EQ(i % 2 == 0 ? -1 : i + 1000, Lookup(cache, i));
+  }
+  ASSERT_EQ(static_cast<size_t>(kCacheSize / 2), cache->GetUsage());
+  ASSERT_EQ(static_cast<size_t>(kCacheSize / 2), deleted_keys_.size());
+}
+
+TEST_F(CacheTest, ClockCacheSecondChance) {
+  // a single shard of 3 entries
+  std::shared_ptr<Cache> cache = NewClockCache(3, 0, false);
+  Insert(cache, 1, 101);
+  Insert(cache, 2, 102);
+  Insert(cache, 3, 103);
+  ASSERT_EQ(101, Lookup(cache, 1));
+
+  // 1 was used since it was inserted, and survives the sweep
+  Insert(cache, 4, 104);
+  ASSERT_EQ(101, Lookup(cache, 1));
+  ASSERT_EQ(-1, Lookup(cache, 2));
+  ASSERT_EQ(103, Lookup(cache, 3));
+  ASSERT_EQ(104, Lookup(cache, 4));
+  ASSERT_EQ(3U, cache->GetUsage());
+  ASSERT_EQ(1U, deleted_keys_.size());
+  ASSERT_EQ(2, deleted_keys_[0]);
+}
+
+TEST_F(CacheTest, ClockCachePinnedEntries) {
+  std::shared_ptr<Cache> cache = NewClockCache(2, 0, false);
+  Cache::Handle* h1 = nullptr;
+  Cache::Handle* h2 = nullptr;
+  ASSERT_OK(cache->Insert(EncodeKey(1), EncodeValue(101), 1,
+                          &CacheTest::Deleter, &h1));
+  ASSERT_OK(cache->Insert(EncodeKey(2), EncodeValue(102), 1,
+                          &CacheTest::Deleter, &h2));
+  ASSERT_EQ(2U, cache->GetPinnedUsage());
+
+  // the pinned entries are not evicted, the cache goes over capacity
+  Cache::Handle* h3 = nullptr;
+  ASSERT_OK(cache->Insert(EncodeKey(3), EncodeValue(103), 1,
+                          &CacheTest::Deleter, &h3));
+  ASSERT_EQ(3U, cache->GetUsage());
+  ASSERT_EQ(3U, cache->GetPinnedUsage());
+  ASSERT_EQ(101, DecodeValue(cache->Value(h1)));
+
+  // unless the limit is strict
+  cache->SetStrictCapacityLimit(true);
+  Cache::Handle* h4 = nullptr;
+  Status s = cache->Insert(EncodeKey(4), EncodeValue(104), 1,
+                           &CacheTest::Deleter, &h4);
+  ASSERT_TRUE(s.IsIncomplete());
+  ASSERT_TRUE(h4 == nullptr);
+  cache->SetStrictCapacityLimit(false);
+
+  // an entry erased while pinned is deleted by its last release
+  Erase(cache, 1);
+  ASSERT_EQ(-1, Lookup(cache, 1));
+  ASSERT_EQ(0U, deleted_keys_.size());
+  cache->Release(h1);
+  ASSERT_EQ(1U, deleted_keys_.size());
+  ASSERT_EQ(1, deleted_keys_[0]);
+
+  cache->Release(h2);
+  cache->Release(h3);
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+  ASSERT_EQ(2U, cache->GetUsage());
+
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0U, cache->GetUsage());
+  ASSERT_EQ(3U, deleted_keys_.size());
+}
+
+TEST_F(CacheTest, ClockCacheApplyToAllCacheEntries) {
+  std::shared_ptr<Cache> cache = NewClockCache(kCacheSize, kNumShardBits, false);
+  std::vector<std::pair<int, int>> inserted;
+  callback_state.clear();
+
+  for (int i = 0; i < 10; ++i) {
+    Insert(cache, i, i * 2, i + 1);
+    inserted.push_back({i * 2, i + 1});
+  }
+  cache->ApplyToAllCacheEntries(callback, true);
+
+  std::sort(inserted.begin(), inserted.end());
+  std::sort(callback_state.begin(), callback_state.end());
+  ASSERT_TRUE(inserted == callback_state);
+}
+
+namespace {
+std::atomic<int> clock_deleted_count(0);
+void ClockDeleter(const Slice& key, void* v) {
+  ASSERT_EQ(DecodeKey(key), DecodeValue(v));
+  clock_deleted_count++;
+}
+}  // namespace
+
+TEST_F(CacheTest, ClockCacheConcurrentAccess) {
+  const int kNumThreads = 8;
+  const int kNumKeys = 1000;
+  const int kOpsPerThread = 20000;
+  std::atomic<int> inserted(0);
+  clock_deleted_count = 0;
+  {
+    // a quarter of the keys fit, the lookups race with the evictions
+    const size_t kCapacity = 256;
+    std::shared_ptr<Cache> cache = NewClockCache(kCapacity, 2, false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kNumThreads; t++) {
+      threads.emplace_back([&, t]() {
+        Random rnd(301 + t);
+        for (int i = 0; i < kOpsPerThread; i++) {
+          int k = rnd.Uniform(kNumKeys);
+          Cache::Handle* h = cache->Lookup(EncodeKey(k));
+          if (h != nullptr) {
+            ASSERT_EQ(k, DecodeValue(cache->Value(h)));
+            cache->Release(h);
+          } else if (rnd.OneIn(8)) {
+            cache->Erase(EncodeKey(k));
+          } else {
+            inserted++;
+            ASSERT_OK(cache->Insert(EncodeKey(k), EncodeValue(k), 1,
+                                    &ClockDeleter, nullptr));
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    ASSERT_LE(cache->GetUsage(), kCapacity);
+    ASSERT_EQ(0U, cache->GetPinnedUsage());
+  }
+  // every value is deleted exactly once
+  ASSERT_EQ(inserted.load(), clock_deleted_count.load());
+}
+
 }  // namespace vidardb
 
 int main(int argc, char** argv) {
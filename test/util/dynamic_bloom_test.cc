@@ -0,0 +1,124 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/dynamic_bloom.h"
+#include "util/testharness.h"
+#include "vidardb/slice_transform.h"
+
+namespace vidardb {
+
+namespace {
+Slice Key(uint64_t i, char* buffer) {
+  EncodeFixed64(buffer, i);
+  return Slice(buffer, sizeof(uint64_t));
+}
+}  // namespace
+
+class DynamicBloomTest : public testing::Test {};
+
+TEST_F(DynamicBloomTest, EmptyFilter) {
+  Arena arena;
+  DynamicBloom bloom(&arena, 100);
+  ASSERT_TRUE(!bloom.MayContain("hello"));
+  ASSERT_TRUE(!bloom.MayContain("world"));
+  ASSERT_EQ(1U, bloom.GetNumLines());
+}
+
+TEST_F(DynamicBloomTest, Small) {
+  Arena arena;
+  DynamicBloom bloom(&arena, 100);
+  bloom.Add("hello");
+  bloom.Add("world");
+  ASSERT_TRUE(bloom.MayContain("hello"));
+  ASSERT_TRUE(bloom.MayContain("world"));
+  ASSERT_TRUE(!bloom.MayContain("x"));
+  ASSERT_TRUE(!bloom.MayContain("foo"));
+}
+
+TEST_F(DynamicBloomTest, VaryingLengths) {
+  char buffer[sizeof(uint64_t)];
+  for (uint32_t length = 1; length <= 100000; length = length * 5 / 4 + 1) {
+    Arena arena;
+    DynamicBloom bloom(&arena, length * 10);
+    for (uint64_t i = 0; i < length; i++) {
+      bloom.Add(Key(i, buffer));
+    }
+
+    // All added keys must match
+    for (uint64_t i = 0; i < length; i++) {
+      ASSERT_TRUE(bloom.MayContain(Key(i, buffer)))
+          << "Length " << length << "; key " << i;
+    }
+
+    // Check false positive rate
+    int result = 0;
+    for (uint64_t i = 0; i < 10000; i++) {
+      if (bloom.MayContain(Key(i + 1000000000, buffer))) {
+        result++;
+      }
+    }
+    double rate = result / 10000.0;
+    ASSERT_LE(rate, 0.03) << "Length " << length;
+  }
+}
+
+TEST_F(DynamicBloomTest, ConcurrentAdd) {
+  const uint64_t kNumThreads = 4;
+  const uint64_t kKeysPerThread = 10000;
+  Arena arena;
+  DynamicBloom bloom(&arena, kNumThreads * kKeysPerThread * 10);
+
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&bloom, t, kKeysPerThread]() {
+      char buffer[sizeof(uint64_t)];
+      for (uint64_t i = t; i < kNumThreads * kKeysPerThread;
+           i += kNumThreads) {
+        bloom.AddConcurrently(Key(i, buffer));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  char buffer[sizeof(uint64_t)];
+  for (uint64_t i = 0; i < kNumThreads * kKeysPerThread; i++) {
+    ASSERT_TRUE(bloom.MayContain(Key(i, buffer))) << i;
+  }
+}
+
+TEST_F(DynamicBloomTest, SliceTransform) {
+  std::unique_ptr<const SliceTransform> fixed(NewFixedPrefixTransform(3));
+  ASSERT_TRUE(fixed->InDomain("abcd"));
+  ASSERT_TRUE(!fixed->InDomain("ab"));
+  ASSERT_EQ("abc", fixed->Transform("abcd").ToString());
+
+  std::unique_ptr<const SliceTransform> capped(NewCappedPrefixTransform(3));
+  ASSERT_TRUE(capped->InDomain("ab"));
+  ASSERT_EQ("ab", capped->Transform("ab").ToString());
+  ASSERT_EQ("abc", capped->Transform("abcd").ToString());
+
+  std::unique_ptr<const SliceTransform> delimiter(
+      NewDelimiterPrefixTransform('|'));
+  ASSERT_TRUE(delimiter->InDomain("tenant|entity|ts"));
+  ASSERT_TRUE(!delimiter->InDomain("tenant"));
+  ASSERT_EQ("tenant|", delimiter->Transform("tenant|entity|ts").ToString());
+  ASSERT_NE(std::string(fixed->Name()), std::string(delimiter->Name()));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
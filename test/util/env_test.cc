@@ -20,6 +20,8 @@
 #include <unordered_set>
 #include <atomic>
 #include <list>
+#include <vector>
+#include <algorithm>
 
 #ifdef OS_LINUX
 #include <fcntl.h>
@@ -800,6 +802,46 @@ TEST_F(EnvPosixTest, RandomAccessUniqueIDDeletes) {
   }
 }
 
+TEST_P(EnvPosixTestWithParam, MultiRead) {
+  std::string fname = test::TmpDir(env_) + "/" + "testfile";
+  const size_t kFileSize = 1 << 20;
+  std::string data;
+  Random rnd(301);
+  test::RandomString(&rnd, static_cast<int>(kFileSize), &data);
+  {
+    unique_ptr<WritableFile> wfile;
+    ASSERT_OK(env_->NewWritableFile(fname, &wfile, EnvOptions()));
+    ASSERT_OK(wfile->Append(data));
+    ASSERT_OK(wfile->Close());
+  }
+
+  for (bool use_io_uring : {false, true}) {
+    EnvOptions soptions;
+    soptions.use_io_uring = use_io_uring;
+    unique_ptr<RandomAccessFile> file;
+    ASSERT_OK(env_->NewRandomAccessFile(fname, &file, soptions));
+
+    // more requests than a batch, the last one past the end of the file
+    const size_t kNumReqs = 200;
+    const size_t kLen = 4096;
+    std::vector<std::string> scratches(kNumReqs, std::string(kLen, 0));
+    std::vector<ReadRequest> reqs(kNumReqs);
+    for (size_t i = 0; i < kNumReqs; i++) {
+      reqs[i].offset = (i * 7919 * kLen) % kFileSize + i;
+      reqs[i].len = kLen;
+      reqs[i].scratch = &scratches[i][0];
+    }
+    reqs.back().offset = kFileSize - 100;
+    ASSERT_OK(file->MultiRead(reqs.data(), reqs.size()));
+    for (size_t i = 0; i < kNumReqs; i++) {
+      ASSERT_OK(reqs[i].status);
+      size_t len = std::min(kLen, kFileSize - reqs[i].offset);
+      ASSERT_EQ(data.substr(reqs[i].offset, len), reqs[i].result.ToString());
+    }
+  }
+  ASSERT_OK(env_->DeleteFile(fname));
+}
+
 // Only works in linux platforms
 TEST_P(EnvPosixTestWithParam, InvalidateCache) {
   vidardb::SyncPoint::GetInstance()->EnableProcessing();
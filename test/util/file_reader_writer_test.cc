@@ -3,6 +3,9 @@
 //  LICENSE file in the root directory of this source tree. An additional grant
 //  of patent rights can be found in the PATENTS file in the same directory.
 //
+#include <string.h>
+#include <algorithm>
+#include <string>
 #include <vector>
 #include "util/file_reader_writer.h"
 #include "util/random.h"
@@ -125,6 +128,105 @@ TEST_F(WritableFileWriterTest, AppendStatusReturn) {
   ASSERT_NOK(writer->Append(std::string(2 * kMb, 'b')));
 }
 
+class ReadaheadRandomAccessFileTest : public testing::Test {};
+
+TEST_F(ReadaheadRandomAccessFileTest, AlignedReadahead) {
+  // Serves the file from memory, and checks the reads are aligned the way
+  // direct I/O needs them.
+  class FakeRAF : public RandomAccessFile {
+   public:
+    explicit FakeRAF(const std::string& data, int* num_reads)
+        : data_(data), num_reads_(num_reads) {}
+
+    Status Read(uint64_t offset, size_t n, Slice* result,
+                char* scratch) const override {
+      EXPECT_EQ(0U, offset % 4096);
+      EXPECT_EQ(0U, n % 4096);
+      EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(scratch) % 4096);
+      (*num_reads_)++;
+      size_t len = 0;
+      if (offset < data_.size()) {
+        len = std::min(n, data_.size() - static_cast<size_t>(offset));
+        memcpy(scratch, data_.data() + offset, len);
+      }
+      *result = Slice(scratch, len);
+      return Status::OK();
+    }
+
+   private:
+    const std::string& data_;
+    int* num_reads_;
+  };
+
+  Random rnd(301);
+  std::string data;
+  for (int i = 0; i < 100000; i++) {
+    data.push_back(static_cast<char>(rnd.Uniform(256)));
+  }
+  int num_reads = 0;
+  const size_t kReadahead = 16 * 1024;
+  std::unique_ptr<RandomAccessFile> file = NewReadaheadRandomAccessFile(
+      std::unique_ptr<RandomAccessFile>(new FakeRAF(data, &num_reads)),
+      kReadahead);
+
+  // unaligned sequential reads are served from the buffer
+  char scratch[1000];
+  Slice result;
+  size_t offset = 123;
+  while (offset < data.size()) {
+    ASSERT_OK(file->Read(offset, sizeof(scratch), &result, scratch));
+    size_t len = std::min(sizeof(scratch), data.size() - offset);
+    ASSERT_EQ(data.substr(offset, len), result.ToString());
+    offset += len;
+  }
+  ASSERT_LE(num_reads, static_cast<int>(data.size() / kReadahead + 2));
+
+  ASSERT_OK(file->Read(data.size() + 10, sizeof(scratch), &result, scratch));
+  ASSERT_EQ(0U, result.size());
+}
+
+TEST_F(ReadaheadRandomAccessFileTest, ForwardMultiRead) {
+  // Counts the batches it gets, and fills the reads with their offsets.
+  class FakeRAF : public RandomAccessFile {
+   public:
+    explicit FakeRAF(int* num_batches) : num_batches_(num_batches) {}
+
+    Status Read(uint64_t offset, size_t n, Slice* result,
+                char* scratch) const override {
+      memset(scratch, static_cast<char>(offset), n);
+      *result = Slice(scratch, n);
+      return Status::OK();
+    }
+
+    Status MultiRead(ReadRequest* reqs, size_t num_reqs) override {
+      (*num_batches_)++;
+      return RandomAccessFile::MultiRead(reqs, num_reqs);
+    }
+
+   private:
+    int* num_batches_;
+  };
+
+  int num_batches = 0;
+  std::unique_ptr<RandomAccessFile> file = NewReadaheadRandomAccessFile(
+      std::unique_ptr<RandomAccessFile>(new FakeRAF(&num_batches)), 4096);
+  char scratch[3][100];
+  ReadRequest reqs[3];
+  for (int i = 0; i < 3; i++) {
+    reqs[i].offset = 1000 * (i + 1);
+    reqs[i].len = sizeof(scratch[i]);
+    reqs[i].scratch = scratch[i];
+  }
+  // the batch reaches the file in one piece
+  ASSERT_OK(file->MultiRead(reqs, 3));
+  ASSERT_EQ(1, num_batches);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(reqs[i].status);
+    ASSERT_EQ(std::string(100, static_cast<char>(1000 * (i + 1))),
+              reqs[i].result.ToString());
+  }
+}
+
 }  // namespace vidardb
 
 int main(int argc, char** argv) {
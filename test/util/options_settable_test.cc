@@ -187,6 +187,8 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
       {offsetof(struct DBOptions, listeners),
        sizeof(std::vector<std::shared_ptr<EventListener>>)},
       {offsetof(struct DBOptions, row_cache), sizeof(std::shared_ptr<Cache>)},
+      {offsetof(struct DBOptions, block_access_tracer),
+       sizeof(std::shared_ptr<BlockAccessTracer>)},
       {offsetof(struct DBOptions, wal_filter), sizeof(const WalFilter*)},
   };
 
@@ -257,6 +259,8 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "allow_mmap_writes=false;"
                              "stats_dump_period_sec=70127;"
                              "allow_fallocate=true;"
+                             "use_direct_reads=false;"
+                             "use_direct_io_for_flush_and_compaction=false;"
                              "allow_mmap_reads=false;"
                              "max_log_file_size=4607;"
                              "random_access_max_buffer_size=1048576;"
@@ -0,0 +1,206 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <stdio.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util/random.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+#include "utilities/persistent_cache/block_cache_tier.h"
+#include "vidardb/env.h"
+#include "vidardb/persistent_cache.h"
+
+namespace vidardb {
+
+namespace {
+std::string PageKey(int i) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "page%06d", i);
+  return buf;
+}
+}  // namespace
+
+class PersistentCacheTest : public testing::Test {
+ public:
+  PersistentCacheTest()
+      : env_(Env::Default()), path_(test::TmpDir(env_) + "/persistent_cache") {
+    DestroyDir();
+  }
+
+  ~PersistentCacheTest() { DestroyDir(); }
+
+  void DestroyDir() {
+    cache_.reset();
+    std::vector<std::string> children;
+    if (env_->GetChildren(path_, &children).ok()) {
+      for (const auto& child : children) {
+        env_->DeleteFile(path_ + "/" + child);
+      }
+    }
+    env_->DeleteDir(path_);
+  }
+
+  void Open(uint64_t size) {
+    cache_.reset();
+    ASSERT_OK(NewPersistentCache(env_, path_, size, nullptr, &cache_));
+  }
+
+  std::string Page(int i) {
+    Random rnd(i);
+    std::string page;
+    test::RandomString(&rnd, 100 + i % 50, &page);
+    return page;
+  }
+
+  void Insert(int i) {
+    std::string page = Page(i);
+    ASSERT_OK(cache_->Insert(PageKey(i), page.data(), page.size()));
+  }
+
+  // "NOT_FOUND", "CORRUPTION" or "OK" if the page of i is found unchanged.
+  std::string Lookup(int i) {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    Status s = cache_->Lookup(PageKey(i), &data, &size);
+    if (s.IsNotFound()) {
+      return "NOT_FOUND";
+    }
+    if (s.IsCorruption()) {
+      return "CORRUPTION";
+    }
+    EXPECT_OK(s);
+    return Slice(data.get(), size) == Page(i) ? "OK" : "WRONG";
+  }
+
+  std::vector<std::string> CacheFiles() {
+    std::vector<std::string> children, files;
+    EXPECT_OK(env_->GetChildren(path_, &children));
+    for (const auto& child : children) {
+      if (child != "." && child != "..") {
+        files.push_back(path_ + "/" + child);
+      }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+ protected:
+  Env* env_;
+  std::string path_;
+  std::shared_ptr<PersistentCache> cache_;
+};
+
+TEST_F(PersistentCacheTest, InsertAndLookup) {
+  Open(1 << 20);
+  for (int i = 0; i < 100; i++) {
+    Insert(i);
+  }
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ("OK", Lookup(i));
+  }
+  ASSERT_EQ("NOT_FOUND", Lookup(100));
+
+  // the same key is not added twice
+  uint64_t usage = cache_->GetUsage();
+  Insert(7);
+  ASSERT_EQ(usage, cache_->GetUsage());
+  ASSERT_EQ("OK", Lookup(7));
+
+  std::string big(2 << 20, 'x');
+  ASSERT_TRUE(
+      cache_->Insert("big", big.data(), big.size()).IsInvalidArgument());
+}
+
+TEST_F(PersistentCacheTest, EvictOldestFile) {
+  const uint64_t kCapacity = 64 << 10;
+  Open(kCapacity);
+  const int kPages = 2000;
+  for (int i = 0; i < kPages; i++) {
+    Insert(i);
+  }
+  // one file of kCapacity / 16 may go over the capacity
+  ASSERT_LE(cache_->GetUsage(), kCapacity + kCapacity / 16 + 256);
+  ASSERT_GT(cache_->GetUsage(), kCapacity / 2);
+  ASSERT_LE(
+      static_cast<BlockCacheTier*>(cache_.get())->TEST_NumFiles(), 18U);
+  ASSERT_LE(CacheFiles().size(), 18U);
+
+  // the oldest pages are gone, the newest ones are kept
+  ASSERT_EQ("NOT_FOUND", Lookup(0));
+  ASSERT_EQ("NOT_FOUND", Lookup(kPages / 2));
+  for (int i = kPages - 100; i < kPages; i++) {
+    ASSERT_EQ("OK", Lookup(i));
+  }
+}
+
+TEST_F(PersistentCacheTest, Recovery) {
+  Open(1 << 20);
+  for (int i = 0; i < 200; i++) {
+    Insert(i);
+  }
+  uint64_t usage = cache_->GetUsage();
+
+  // reopen, the pages are back
+  Open(1 << 20);
+  ASSERT_EQ(usage, cache_->GetUsage());
+  for (int i = 0; i < 200; i++) {
+    ASSERT_EQ("OK", Lookup(i));
+  }
+  // the new pages go to a new file
+  size_t num_files = CacheFiles().size();
+  Insert(200);
+  ASSERT_EQ(num_files + 1, CacheFiles().size());
+  cache_.reset();
+
+  // a partially written page at the end of the last file is ignored
+  std::string last = CacheFiles().back();
+  std::string contents;
+  ASSERT_OK(ReadFileToString(env_, last, &contents));
+  ASSERT_OK(WriteStringToFile(env_, contents + "vdbc", last));
+  Open(1 << 20);
+  for (int i = 0; i <= 200; i++) {
+    ASSERT_EQ("OK", Lookup(i));
+  }
+}
+
+TEST_F(PersistentCacheTest, ChecksumMismatch) {
+  Open(1 << 20);
+  Insert(0);
+  Insert(1);
+  cache_.reset();
+
+  // flip the last byte of the file, in the page of 1
+  std::string fname = CacheFiles().back();
+  std::string contents;
+  ASSERT_OK(ReadFileToString(env_, fname, &contents));
+  contents.back() ^= 0x1;
+  ASSERT_OK(WriteStringToFile(env_, contents, fname));
+
+  // the recovery stops at the corrupted page
+  Open(1 << 20);
+  ASSERT_EQ("OK", Lookup(0));
+  ASSERT_EQ("NOT_FOUND", Lookup(1));
+
+  // a page corrupted after the recovery is dropped on lookup
+  Insert(2);
+  std::string last = CacheFiles().back();
+  ASSERT_OK(ReadFileToString(env_, last, &contents));
+  contents.back() ^= 0x1;
+  // rewritten in place, the cache still reads the same file
+  ASSERT_OK(WriteStringToFile(env_, contents, last));
+  ASSERT_EQ("CORRUPTION", Lookup(2));
+  ASSERT_EQ("NOT_FOUND", Lookup(2));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,70 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <thread>
+#include <vector>
+
+#include "util/statistics.h"
+#include "util/testharness.h"
+
+namespace vidardb {
+
+class StatisticsTest : public testing::Test {};
+
+TEST_F(StatisticsTest, ConcurrentRecordTick) {
+  std::shared_ptr<Statistics> stats = CreateDBStatistics();
+  const int kNumThreads = 8;
+  const int kNumTicks = 100000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < kNumTicks; i++) {
+        stats->recordTick(NUMBER_KEYS_READ, 1);
+        stats->recordTick(BYTES_READ, 2);
+        stats->measureTime(DB_GET, i % 1000);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // the shards of all the cores add up
+  ASSERT_EQ(static_cast<uint64_t>(kNumThreads * kNumTicks),
+            stats->getTickerCount(NUMBER_KEYS_READ));
+  ASSERT_EQ(static_cast<uint64_t>(2 * kNumThreads * kNumTicks),
+            stats->getTickerCount(BYTES_READ));
+  ASSERT_EQ(0U, stats->getTickerCount(NUMBER_KEYS_WRITTEN));
+
+  HistogramData data;
+  stats->histogramData(DB_GET, &data);
+  ASSERT_GT(data.median, 400.0);
+  ASSERT_LT(data.median, 600.0);
+  ASSERT_GE(data.percentile99, data.percentile95);
+  ASSERT_GE(data.percentile95, data.median);
+  ASSERT_NE(std::string::npos,
+            stats->getHistogramString(DB_GET).find(
+                "Count: " + std::to_string(kNumThreads * kNumTicks)));
+}
+
+TEST_F(StatisticsTest, SetTickerCount) {
+  std::shared_ptr<Statistics> stats = CreateDBStatistics();
+  std::thread([&]() { stats->recordTick(NUMBER_KEYS_READ, 10); }).join();
+  stats->recordTick(NUMBER_KEYS_READ, 5);
+  ASSERT_EQ(15U, stats->getTickerCount(NUMBER_KEYS_READ));
+
+  // overrides the counts of all the cores
+  stats->setTickerCount(NUMBER_KEYS_READ, 3);
+  ASSERT_EQ(3U, stats->getTickerCount(NUMBER_KEYS_READ));
+  stats->recordTick(NUMBER_KEYS_READ, 1);
+  ASSERT_EQ(4U, stats->getTickerCount(NUMBER_KEYS_READ));
+}
+
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
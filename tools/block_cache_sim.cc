@@ -0,0 +1,161 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+#ifndef GFLAGS
+#include <cstdio>
+int main() {
+  fprintf(stderr, "Please install gflags to run vidardb tools\n");
+  return 1;
+}
+#else
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <gflags/gflags.h>
+#include <string>
+#include <vector>
+
+#include "util/block_access_tracer.h"
+#include "util/cache_simulator.h"
+#include "util/string_util.h"
+#include "vidardb/env.h"
+
+using GFLAGS::ParseCommandLineFlags;
+using GFLAGS::SetUsageMessage;
+
+DEFINE_string(trace_file, "",
+              "The block access trace, see DBOptions::block_access_tracer.");
+DEFINE_string(cache_sizes, "64M,256M,1G,4G",
+              "Comma separated capacities to simulate, with an optional K, M "
+              "or G suffix.");
+DEFINE_string(policies, "lru,clock,tinylfu",
+              "Comma separated cache policies among lru, clock and tinylfu.");
+DEFINE_int32(num_shard_bits, 0, "The shards of the simulated caches.");
+DEFINE_int32(sample_one_in, 1,
+             "The sample_one_in the trace was recorded with. The capacities "
+             "are scaled down by it.");
+
+namespace vidardb {
+namespace {
+
+bool ParseCapacity(const std::string& s, uint64_t* capacity) {
+  char* end = nullptr;
+  uint64_t value = strtoull(s.c_str(), &end, 10);
+  if (end == s.c_str()) {
+    return false;
+  }
+  switch (*end) {
+    case 'G': case 'g': value <<= 30; end++; break;
+    case 'M': case 'm': value <<= 20; end++; break;
+    case 'K': case 'k': value <<= 10; end++; break;
+    default: break;
+  }
+  *capacity = value;
+  return *end == '\0' && value > 0;
+}
+
+std::string FormatCapacity(uint64_t capacity) {
+  char buf[32];
+  if (capacity % (1ull << 30) == 0) {
+    snprintf(buf, sizeof(buf), "%" PRIu64 "G", capacity >> 30);
+  } else if (capacity % (1ull << 20) == 0) {
+    snprintf(buf, sizeof(buf), "%" PRIu64 "M", capacity >> 20);
+  } else if (capacity % (1ull << 10) == 0) {
+    snprintf(buf, sizeof(buf), "%" PRIu64 "K", capacity >> 10);
+  } else {
+    snprintf(buf, sizeof(buf), "%" PRIu64, capacity);
+  }
+  return buf;
+}
+
+// Replays the whole trace against the cache.
+Status Replay(Env* env, CacheSimulator* simulator, uint64_t* trace_hits) {
+  BlockAccessTraceReader reader;
+  Status s = reader.Open(env, FLAGS_trace_file);
+  *trace_hits = 0;
+  BlockAccess access;
+  while (s.ok() && (s = reader.Next(&access)).ok()) {
+    simulator->Access(access);
+    *trace_hits += access.hit ? 1 : 0;
+  }
+  return s.IsNotFound() ? Status::OK() : s;
+}
+
+int Run() {
+  std::vector<uint64_t> capacities;
+  for (const auto& size : StringSplit(FLAGS_cache_sizes, ',')) {
+    uint64_t capacity;
+    if (!ParseCapacity(size, &capacity)) {
+      fprintf(stderr, "Bad cache size: %s\n", size.c_str());
+      return 1;
+    }
+    capacities.push_back(capacity);
+  }
+  std::vector<std::string> policies = StringSplit(FLAGS_policies, ',');
+  for (const auto& policy : policies) {
+    if (NewSimulatedCache(policy, 1 << 20, 0) == nullptr) {
+      fprintf(stderr, "Unknown cache policy: %s\n", policy.c_str());
+      return 1;
+    }
+  }
+  if (FLAGS_sample_one_in <= 0) {
+    fprintf(stderr, "sample_one_in <= 0\n");
+    return 1;
+  }
+
+  // the miss ratio curve, a row per capacity and a column per policy
+  Env* env = Env::Default();
+  printf("Miss ratio (%%) of %s\n", FLAGS_trace_file.c_str());
+  printf("%10s", "Capacity");
+  for (const auto& policy : policies) {
+    printf(" %10s", policy.c_str());
+  }
+  printf("\n");
+  uint64_t accesses = 0;
+  uint64_t trace_hits = 0;
+  for (uint64_t capacity : capacities) {
+    printf("%10s", FormatCapacity(capacity).c_str());
+    for (const auto& policy : policies) {
+      CacheSimulator simulator(NewSimulatedCache(
+          policy, static_cast<size_t>(capacity / FLAGS_sample_one_in),
+          FLAGS_num_shard_bits));
+      Status s = Replay(env, &simulator, &trace_hits);
+      if (!s.ok()) {
+        fprintf(stderr, "\nCannot replay %s: %s\n", FLAGS_trace_file.c_str(),
+                s.ToString().c_str());
+        return 1;
+      }
+      accesses = simulator.accesses();
+      printf(" %10.2f", 100.0 * simulator.MissRatio());
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+  if (accesses > 0) {
+    printf("%" PRIu64 " lookups, %.2f%% missed in the traced cache\n",
+           accesses, 100.0 * (accesses - trace_hits) / accesses);
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace vidardb
+
+int main(int argc, char** argv) {
+  SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
+                  " --trace_file=<file> [OPTIONS]...");
+  ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_trace_file.empty()) {
+    fprintf(stderr, "--trace_file is required\n");
+    return 1;
+  }
+  return vidardb::Run();
+}
+
+#endif  // GFLAGS
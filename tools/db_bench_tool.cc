@@ -41,10 +41,14 @@
 #include "vidardb/cache.h"
 #include "vidardb/db.h"
 #include "vidardb/env.h"
+#include "vidardb/filter_policy.h"
 #include "vidardb/memtablerep.h"
 #include "vidardb/options.h"
 #include "vidardb/perf_context.h"
+#include "vidardb/persistent_cache.h"
+#include "vidardb/rate_limiter.h"
 #include "vidardb/slice.h"
+#include "vidardb/slice_transform.h"
 #include "vidardb/write_batch.h"
 #include "util/compression.h"
 #include "util/crc32c.h"
@@ -245,6 +249,12 @@ DEFINE_bool(enable_numa, false,
 DEFINE_int64(db_write_buffer_size, vidardb::Options().db_write_buffer_size,
              "Number of bytes to buffer in all memtables before compacting");
 
+DEFINE_bool(adaptive_write_buffer_sizing, false,
+            "Share db_write_buffer_size among column families by write rate");
+
+DEFINE_bool(cost_write_buffer_to_cache, false,
+            "Charge the memory of memtables to the block cache");
+
 DEFINE_int64(write_buffer_size, vidardb::Options().write_buffer_size,
              "Number of bytes to buffer in memtable before compacting");
 
@@ -337,6 +347,14 @@ DEFINE_bool(cache_index_and_filter_blocks, false,
 DEFINE_bool(pin_l0_filter_and_index_blocks_in_cache, false,
             "Pin index/filter blocks of L0 files in block cache.");
 
+DEFINE_bool(pin_top_level_index, false,
+            "Pin the top-level index of partitioned index in block cache.");
+
+DEFINE_double(cache_high_pri_pool_ratio, 0.0,
+              "Ratio of block cache reserved for high pri blocks. "
+              "If > 0.0, we also enable "
+              "cache_index_and_filter_blocks_with_high_priority.");
+
 DEFINE_int32(block_size,
              static_cast<int32_t>(vidardb::BlockBasedTableOptions().block_size),
              "Number of bytes in a block.");
@@ -346,6 +364,18 @@ DEFINE_int32(block_restart_interval,
              "Number of keys between restart points "
              "for delta encoding of keys in data block.");
 
+DEFINE_bool(use_data_block_hash_index, false,
+            "if use kDataBlockBinaryAndHash "
+            "instead of kDataBlockBinarySearch. "
+            "This is valid if only we use BlockTable");
+
+DEFINE_double(data_block_hash_table_util_ratio,
+              vidardb::BlockBasedTableOptions()
+                  .data_block_hash_table_util_ratio,
+              "util ratio for data block hash index table. "
+              "This is only valid if use_data_block_hash_index is "
+              "set to true");
+
 DEFINE_int32(index_block_restart_interval,
              vidardb::BlockBasedTableOptions().index_block_restart_interval,
              "Number of keys between restart points "
@@ -354,6 +384,13 @@ DEFINE_int32(index_block_restart_interval,
 DEFINE_int64(compressed_cache_size, -1,
              "Number of bytes to use as a cache of compressed data.");
 
+DEFINE_string(persistent_cache_path, "",
+              "Directory of the persistent cache of the data blocks, e.g. on "
+              "a local SSD. Empty means no persistent cache.");
+
+DEFINE_int64(persistent_cache_size, 1024LL * 1024 * 1024,
+             "Number of bytes the persistent cache may take.");
+
 DEFINE_int64(row_cache_size, 0,
              "Number of bytes to use as a cache of individual rows"
              " (0 = disabled).");
@@ -380,8 +417,8 @@ DEFINE_int32(writable_file_max_buffer_size, 1024 * 1024,
 DEFINE_int32(skip_table_builder_flush, false, "Skip flushing block in "
              "table builder ");
 
-DEFINE_int32(bloom_bits, -1, "Bloom filter bits per key. Negative means"
-             " use default settings.");
+DEFINE_int32(bloom_bits, -1, "Bloom filter bits per key of the table files. "
+             "Zero or negative means no bloom filter.");
 DEFINE_int32(memtable_bloom_bits, 0, "Bloom filter bits per key for memtable. "
              "Negative means no bloom filter.");
 
@@ -408,6 +445,12 @@ DEFINE_int32(cache_numshardbits, -1, "Number of shards for the block cache"
              " is 2 ** cache_numshardbits. Negative means use default settings."
              " This is applied only if FLAGS_cache_size is non-negative.");
 
+DEFINE_bool(use_clock_cache, false, "Replace the default LRU block cache, "
+            "compressed cache and row cache with CLOCK caches.");
+
+DEFINE_bool(cache_tinylfu_admission, false, "Filter the new entries of the "
+            "LRU caches by the frequency of their keys (W-TinyLFU).");
+
 DEFINE_bool(verify_checksum, false, "Verify checksum for every block read"
             " from storage");
 
@@ -648,12 +691,15 @@ DEFINE_uint64(hard_pending_compaction_bytes_limit, 128ull * 1024 * 1024 * 1024,
               "Stop writes if pending compaction bytes exceed this number");
 
 DEFINE_uint64(delayed_write_rate, 8388608u,
-              "Limited bytes allowed to DB when soft_rate_limit or "
-              "level0_slowdown_writes_trigger triggers");
+              "Limited bytes allowed to DB when the last memtable is in use or "
+              "soft_pending_compaction_bytes_limit triggers");
 
 DEFINE_bool(allow_concurrent_memtable_write, false,
             "Allow multi-writers to update mem tables in parallel.");
 
+DEFINE_bool(enable_pipelined_flush, false,
+            "Overlap memtable iteration with table building during flush.");
+
 DEFINE_bool(enable_write_thread_adaptive_yield, false,
             "Use a yielding spin loop for brief writer thread waits.");
 
@@ -704,6 +750,13 @@ DEFINE_bool(mmap_read, vidardb::EnvOptions().use_mmap_reads,
 DEFINE_bool(mmap_write, vidardb::EnvOptions().use_mmap_writes,
             "Allow writes to occur via mmap-ing files");
 
+DEFINE_bool(use_direct_reads, vidardb::Options().use_direct_reads,
+            "Read the table files with O_DIRECT");
+
+DEFINE_bool(use_direct_io_for_flush_and_compaction,
+            vidardb::Options().use_direct_io_for_flush_and_compaction,
+            "Use O_DIRECT for the table files of flushes and compactions");
+
 DEFINE_bool(advise_random_on_open, vidardb::Options().advise_random_on_open,
             "Advise random access on table file open");
 
@@ -720,6 +773,10 @@ DEFINE_string(flashcache_dev, "", "Path to flashcache device");
 DEFINE_bool(use_tailing_iterator, false,
             "Use tailing iterator to access a series of keys instead of get");
 
+DEFINE_uint64(async_readahead_size, 0,
+              "Max size of the background readahead of the data blocks "
+              "following a scan, for readseq and seekrandom. 0 disables it.");
+
 DEFINE_bool(use_adaptive_mutex, vidardb::Options().use_adaptive_mutex,
             "Use adaptive mutex");
 
@@ -755,7 +812,14 @@ static bool ValidatePrefixSize(const char* flagname, int32_t value) {
   return true;
 }
 DEFINE_int32(prefix_size, 0, "control the prefix size for HashSkipList and "
-             "plain table");
+             "plain table. If non-zero, a fixed prefix extractor of this "
+             "size is also set, enabling the prefix blooms");
+DEFINE_double(memtable_bloom_size_ratio, 0, "Ratio of memtable size used for "
+              "the memtable prefix bloom. 0 means no memtable bloom.");
+DEFINE_bool(total_order_seek, false, "Seek iterators in total order, "
+            "ignoring the prefix blooms");
+DEFINE_bool(prefix_same_as_start, false, "Stop the seek iterators at the end "
+            "of the prefix of the seek key");
 DEFINE_int64(keys_per_prefix, 0, "control average number of keys generated "
              "per prefix, 0 means no special handling of the prefix, "
              "i.e. use the prefix comes with the generated random number.");
@@ -793,6 +857,12 @@ DEFINE_double(cuckoo_hash_ratio, 0.9, "Hash ratio for Cuckoo SST table.");
 DEFINE_bool(use_hash_search, false, "if use kHashSearch "
             "instead of kBinarySearch. "
             "This is valid if only we use BlockTable");
+DEFINE_bool(partition_index, false, "if use kTwoLevelIndexSearch "
+            "instead of kBinarySearch. "
+            "This is valid if only we use BlockTable");
+DEFINE_uint64(metadata_block_size,
+              vidardb::BlockBasedTableOptions().metadata_block_size,
+              "Max partition size when partitioning index");
 DEFINE_bool(use_block_based_filter, false, "if use kBlockBasedFilter "
             "instead of kFullFilter for filter block. "
             "This is valid if only we use BlockTable");
@@ -1533,6 +1603,26 @@ class Duration {
   uint64_t start_at_;
 };
 
+static std::shared_ptr<Cache> NewCache(int64_t capacity) {
+  if (capacity < 0) {
+    return nullptr;
+  }
+  if (FLAGS_use_clock_cache) {
+    return FLAGS_cache_numshardbits >= 1
+               ? NewClockCache(capacity, FLAGS_cache_numshardbits, false)
+               : NewClockCache(capacity);
+  }
+  if (FLAGS_cache_tinylfu_admission) {
+    // 6 shard bits is the default of NewLRUCache
+    return NewLRUCache(
+        capacity, FLAGS_cache_numshardbits >= 1 ? FLAGS_cache_numshardbits : 6,
+        false, 0.0, true);
+  }
+  return FLAGS_cache_numshardbits >= 1
+             ? NewLRUCache(capacity, FLAGS_cache_numshardbits)
+             : NewLRUCache(capacity);
+}
+
 class Benchmark {
  private:
   std::shared_ptr<Cache> cache_;
@@ -1715,18 +1805,8 @@ class Benchmark {
 
  public:
   Benchmark()
-      : cache_(
-            FLAGS_cache_size >= 0
-                ? (FLAGS_cache_numshardbits >= 1
-                       ? NewLRUCache(FLAGS_cache_size, FLAGS_cache_numshardbits)
-                       : NewLRUCache(FLAGS_cache_size))
-                : nullptr),
-        compressed_cache_(FLAGS_compressed_cache_size >= 0
-                              ? (FLAGS_cache_numshardbits >= 1
-                                     ? NewLRUCache(FLAGS_compressed_cache_size,
-                                                   FLAGS_cache_numshardbits)
-                                     : NewLRUCache(FLAGS_compressed_cache_size))
-                              : nullptr),
+      : cache_(NewCache(FLAGS_cache_size)),
+        compressed_cache_(NewCache(FLAGS_compressed_cache_size)),
         num_(FLAGS_num),
         value_size_(FLAGS_value_size),
         key_size_(FLAGS_key_size),
@@ -1759,6 +1839,15 @@ class Benchmark {
       exit(1);
     }
 
+    if (FLAGS_cache_high_pri_pool_ratio < 0.0 ||
+        FLAGS_cache_high_pri_pool_ratio > 1.0) {
+      fprintf(stderr, "cache_high_pri_pool_ratio must be in [0, 1]\n");
+      exit(1);
+    }
+    if (cache_ != nullptr) {
+      cache_->SetHighPriorityPoolRatio(FLAGS_cache_high_pri_pool_ratio);
+    }
+
     std::vector<std::string> files;
     FLAGS_env->GetChildren(FLAGS_db, &files);
     for (size_t i = 0; i < files.size(); i++) {
@@ -2241,6 +2330,10 @@ class Benchmark {
     options.create_missing_column_families = FLAGS_num_column_families > 1;
     options.max_open_files = FLAGS_open_files;
     options.db_write_buffer_size = FLAGS_db_write_buffer_size;
+    options.adaptive_write_buffer_sizing = FLAGS_adaptive_write_buffer_sizing;
+    if (FLAGS_cost_write_buffer_to_cache) {
+      options.write_buffer_cache = cache_;
+    }
     options.write_buffer_size = FLAGS_write_buffer_size;
     options.max_write_buffer_number = FLAGS_max_write_buffer_number;
     options.min_write_buffer_number_to_merge =
@@ -2273,6 +2366,11 @@ class Benchmark {
     options.max_bytes_for_level_base = FLAGS_max_bytes_for_level_base;
     options.max_bytes_for_level_multiplier =
         FLAGS_max_bytes_for_level_multiplier;
+    if (FLAGS_prefix_size > 0) {
+      options.prefix_extractor.reset(
+          NewFixedPrefixTransform(FLAGS_prefix_size));
+    }
+    options.memtable_prefix_bloom_size_ratio = FLAGS_memtable_bloom_size_ratio;
     if ((FLAGS_prefix_size == 0) && (FLAGS_rep_factory == kPrefixHash)) {
       fprintf(stderr, "prefix_size should be non-zero if PrefixHash or "
                       "HashLinkedList memtablerep is used\n");
@@ -2293,10 +2391,50 @@ class Benchmark {
         block_based_options.no_block_cache = true;
       }
       block_based_options.block_cache = cache_;
+      block_based_options.block_cache_compressed = compressed_cache_;
+      if (!FLAGS_persistent_cache_path.empty()) {
+        Status s = NewPersistentCache(
+            FLAGS_env, FLAGS_persistent_cache_path, FLAGS_persistent_cache_size,
+            nullptr, &block_based_options.persistent_cache);
+        if (!s.ok()) {
+          fprintf(stderr, "Error in creating the persistent cache: %s\n",
+                  s.ToString().c_str());
+          exit(1);
+        }
+      }
       block_based_options.block_size = FLAGS_block_size;
       block_based_options.block_restart_interval = FLAGS_block_restart_interval;
       block_based_options.index_block_restart_interval =
           FLAGS_index_block_restart_interval;
+      if (FLAGS_use_hash_search) {
+        if (FLAGS_prefix_size == 0) {
+          fprintf(stderr,
+                  "prefix_size not assigned when enable use_hash_search \n");
+          exit(1);
+        }
+        block_based_options.index_type = BlockBasedTableOptions::kHashSearch;
+      } else if (FLAGS_partition_index) {
+        block_based_options.index_type =
+            BlockBasedTableOptions::kTwoLevelIndexSearch;
+      }
+      block_based_options.metadata_block_size = FLAGS_metadata_block_size;
+      block_based_options.cache_index_and_filter_blocks =
+          FLAGS_cache_index_and_filter_blocks;
+      block_based_options.cache_index_and_filter_blocks_with_high_priority =
+          FLAGS_cache_high_pri_pool_ratio > 0.0;
+      block_based_options.pin_l0_filter_and_index_blocks_in_cache =
+          FLAGS_pin_l0_filter_and_index_blocks_in_cache;
+      block_based_options.pin_top_level_index = FLAGS_pin_top_level_index;
+      if (FLAGS_use_data_block_hash_index) {
+        block_based_options.data_block_index_type =
+            BlockBasedTableOptions::kDataBlockBinaryAndHash;
+        block_based_options.data_block_hash_table_util_ratio =
+            FLAGS_data_block_hash_table_util_ratio;
+      }
+      if (FLAGS_bloom_bits > 0) {
+        block_based_options.filter_policy.reset(
+            NewBloomFilterPolicy(FLAGS_bloom_bits));
+      }
       options.table_factory.reset(
           NewBlockBasedTableFactory(block_based_options));
 
@@ -2331,8 +2469,17 @@ class Benchmark {
       }
     }
     options.delayed_write_rate = FLAGS_delayed_write_rate;
+    options.soft_pending_compaction_bytes_limit =
+        FLAGS_soft_pending_compaction_bytes_limit;
+    options.hard_pending_compaction_bytes_limit =
+        FLAGS_hard_pending_compaction_bytes_limit;
+    if (FLAGS_rate_limiter_bytes_per_sec > 0) {
+      options.rate_limiter.reset(
+          NewGenericRateLimiter(FLAGS_rate_limiter_bytes_per_sec));
+    }
     options.allow_concurrent_memtable_write =
         FLAGS_allow_concurrent_memtable_write;
+    options.enable_pipelined_flush = FLAGS_enable_pipelined_flush;
     options.write_thread_slow_yield_usec = FLAGS_write_thread_slow_yield_usec;
     options.table_cache_numshardbits = FLAGS_table_cache_numshardbits;
     options.max_grandparent_overlap_factor =
@@ -2344,6 +2491,9 @@ class Benchmark {
     options.allow_os_buffer = FLAGS_bufferedio;
     options.allow_mmap_reads = FLAGS_mmap_read;
     options.allow_mmap_writes = FLAGS_mmap_write;
+    options.use_direct_reads = FLAGS_use_direct_reads;
+    options.use_direct_io_for_flush_and_compaction =
+        FLAGS_use_direct_io_for_flush_and_compaction;
     options.advise_random_on_open = FLAGS_advise_random_on_open;
     options.access_hint_on_compaction_start = FLAGS_compaction_fadvice_e;
     options.use_adaptive_mutex = FLAGS_use_adaptive_mutex;
@@ -2376,12 +2526,7 @@ class Benchmark {
     options.create_if_missing = !FLAGS_use_existing_db;
 
     if (FLAGS_row_cache_size) {
-      if (FLAGS_cache_numshardbits >= 1) {
-        options.row_cache =
-            NewLRUCache(FLAGS_row_cache_size, FLAGS_cache_numshardbits);
-      } else {
-        options.row_cache = NewLRUCache(FLAGS_row_cache_size);
-      }
+      options.row_cache = NewCache(FLAGS_row_cache_size);
     }
     if (FLAGS_enable_io_prio) {
       FLAGS_env->LowerThreadPoolIOPriority(Env::LOW);
@@ -2621,6 +2766,7 @@ class Benchmark {
   void ReadSequential(ThreadState* thread, DB* db) {
     ReadOptions options(FLAGS_verify_checksum, true);
     options.tailing = FLAGS_use_tailing_iterator;
+    options.async_readahead_size = FLAGS_async_readahead_size;
 
     Iterator* iter = db->NewIterator(options);
     int64_t i = 0;
@@ -2798,6 +2944,9 @@ class Benchmark {
     int64_t bytes = 0;
     ReadOptions options(FLAGS_verify_checksum, true);
     options.tailing = FLAGS_use_tailing_iterator;
+    options.total_order_seek = FLAGS_total_order_seek;
+    options.prefix_same_as_start = FLAGS_prefix_same_as_start;
+    options.async_readahead_size = FLAGS_async_readahead_size;
 
     Iterator* single_iter = nullptr;
     std::vector<Iterator*> multi_iters;
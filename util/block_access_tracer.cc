@@ -0,0 +1,108 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/block_access_tracer.h"
+
+#include "util/coding.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace vidardb {
+
+const uint64_t BlockAccessTracerImpl::kBlockAccessTraceMagic;
+const uint32_t BlockAccessTracerImpl::kVersion;
+const uint8_t BlockAccessTracerImpl::kHitFlag;
+const uint8_t BlockAccessTracerImpl::kFillCacheFlag;
+
+BlockAccessTracerImpl::BlockAccessTracerImpl()
+    : tracing_(false), sample_one_in_(1) {}
+
+BlockAccessTracerImpl::~BlockAccessTracerImpl() {
+  if (IsTracing()) {
+    EndTrace();
+  }
+}
+
+Status BlockAccessTracerImpl::StartTrace(Env* env,
+                                         const std::string& trace_file,
+                                         uint32_t sample_one_in) {
+  MutexLock l(&mutex_);
+  if (tracing_.load(std::memory_order_relaxed)) {
+    return Status::InvalidArgument("a block access trace is going on");
+  }
+  Status s = writer_.Open(env, trace_file, kBlockAccessTraceMagic, kVersion);
+  if (!s.ok()) {
+    return s;
+  }
+  sample_one_in_.store(sample_one_in == 0 ? 1 : sample_one_in,
+                       std::memory_order_relaxed);
+  tracing_.store(true, std::memory_order_release);
+  return s;
+}
+
+Status BlockAccessTracerImpl::EndTrace() {
+  MutexLock l(&mutex_);
+  if (!tracing_.load(std::memory_order_relaxed)) {
+    return Status::InvalidArgument("no block access trace is going on");
+  }
+  tracing_.store(false, std::memory_order_relaxed);
+  return writer_.Close();
+}
+
+void BlockAccessTracerImpl::Record(const BlockAccess& access) {
+  uint32_t sample_one_in = sample_one_in_.load(std::memory_order_relaxed);
+  if (sample_one_in > 1 &&
+      GetSliceHash(access.key) % sample_one_in != 0) {
+    return;
+  }
+  std::string record;
+  PutFixed64(&record, access.micros);
+  PutLengthPrefixedSlice(&record, access.key);
+  PutVarint64(&record, access.charge);
+  record.push_back(static_cast<char>(access.type));
+  record.push_back(static_cast<char>((access.hit ? kHitFlag : 0) |
+                                     (access.fill_cache ? kFillCacheFlag : 0)));
+
+  MutexLock l(&mutex_);
+  if (!tracing_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  writer_.AddRecord(record);
+}
+
+Status BlockAccessTraceReader::Open(Env* env, const std::string& trace_file) {
+  return reader_.Open(env, trace_file,
+                      BlockAccessTracerImpl::kBlockAccessTraceMagic,
+                      BlockAccessTracerImpl::kVersion);
+}
+
+Status BlockAccessTraceReader::Next(BlockAccess* access) {
+  Slice record;
+  Status s = reader_.ReadRecord(&record);
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (record.size() < 8) {
+    return Status::Corruption("bad block access record");
+  }
+  access->micros = DecodeFixed64(record.data());
+  record.remove_prefix(8);
+  if (!GetLengthPrefixedSlice(&record, &access->key) ||
+      !GetVarint64(&record, &access->charge) || record.size() != 2) {
+    return Status::Corruption("bad block access record");
+  }
+  access->type = static_cast<BlockAccess::Type>(record[0]);
+  uint8_t flags = static_cast<uint8_t>(record[1]);
+  access->hit = (flags & BlockAccessTracerImpl::kHitFlag) != 0;
+  access->fill_cache = (flags & BlockAccessTracerImpl::kFillCacheFlag) != 0;
+  return s;
+}
+
+std::shared_ptr<BlockAccessTracer> NewBlockAccessTracer() {
+  return std::make_shared<BlockAccessTracerImpl>();
+}
+
+}  // namespace vidardb
@@ -0,0 +1,81 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "port/port.h"
+#include "util/trace_file.h"
+#include "vidardb/block_access_tracer.h"
+#include "vidardb/env.h"
+#include "vidardb/immutable_options.h"
+
+namespace vidardb {
+
+// A trace file of kBlockAccessTraceMagic holds one record per lookup:
+//   fixed64 micros, length prefixed key, varint64 charge, type byte,
+//   flags byte (kHitFlag, kFillCacheFlag)
+class BlockAccessTracerImpl : public BlockAccessTracer {
+ public:
+  static const uint64_t kBlockAccessTraceMagic = 0x6b636f6c42726456ull;
+  static const uint32_t kVersion = 1;
+  static const uint8_t kHitFlag = 1;
+  static const uint8_t kFillCacheFlag = 2;
+
+  BlockAccessTracerImpl();
+  ~BlockAccessTracerImpl();
+
+  Status StartTrace(Env* env, const std::string& trace_file,
+                    uint32_t sample_one_in) override;
+  Status EndTrace() override;
+  bool IsTracing() const override {
+    return tracing_.load(std::memory_order_relaxed);
+  }
+  void Record(const BlockAccess& access) override;
+
+ private:
+  std::atomic<bool> tracing_;
+  std::atomic<uint32_t> sample_one_in_;
+  port::Mutex mutex_;
+  TraceFileWriter writer_;  // guarded by mutex_
+};
+
+// Reads back the lookups of a trace file, in the order they were recorded.
+class BlockAccessTraceReader {
+ public:
+  Status Open(Env* env, const std::string& trace_file);
+
+  // Reads the next lookup into *access, whose key stays valid until the next
+  // call. Returns NotFound at the end of the trace.
+  Status Next(BlockAccess* access);
+
+ private:
+  TraceFileReader reader_;
+};
+
+// Records a lookup in the block cache of a table reader, if the DB has a
+// tracer that traces.
+inline void TraceBlockAccess(const ImmutableCFOptions& ioptions,
+                             const Slice& key, BlockAccess::Type type,
+                             uint64_t charge, bool hit, bool fill_cache) {
+  BlockAccessTracer* tracer = ioptions.block_access_tracer;
+  if (tracer == nullptr || !tracer->IsTracing()) {
+    return;
+  }
+  BlockAccess access;
+  access.micros = ioptions.env->NowMicros();
+  access.key = key;
+  access.charge = charge;
+  access.type = type;
+  access.hit = hit;
+  access.fill_cache = fill_cache;
+  tracer->Record(access);
+}
+
+}  // namespace vidardb
@@ -0,0 +1,202 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Copyright (c) 2012 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "vidardb/filter_policy.h"
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "util/coding.h"
+#include "util/hash.h"
+#include "vidardb/slice.h"
+
+namespace vidardb {
+
+namespace {
+
+// All the probes of one key go to the same cache line, so that a query
+// touches a single cache line of the filter.
+const uint32_t kCacheLineSize = 64;
+const uint32_t kCacheLineBits = kCacheLineSize * 8;
+
+// Filter layout:
+//    [cache lines: num_lines * kCacheLineSize bytes]
+//    [kind: 1 byte][num_probes: 1 byte][num_lines: fixed32]
+const size_t kMetadataSize = 6;
+const char kBlockedBloomKind = 0;
+
+// Maps hash uniformly to [0, range) without a division.
+inline uint32_t FastRange32(uint32_t hash, uint32_t range) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(hash) * range) >> 32);
+}
+
+// Picks the probe count for the given accuracy. Blocked filters favour fewer
+// probes than the standard ln(2) * bits_per_key, since the keys in a cache
+// line are less evenly spread.
+int ChooseNumProbes(int millibits_per_key) {
+  if (millibits_per_key <= 2080) {
+    return 1;
+  } else if (millibits_per_key <= 3580) {
+    return 2;
+  } else if (millibits_per_key <= 5100) {
+    return 3;
+  } else if (millibits_per_key <= 6640) {
+    return 4;
+  } else if (millibits_per_key <= 8300) {
+    return 5;
+  } else if (millibits_per_key <= 10070) {
+    return 6;
+  } else if (millibits_per_key <= 11720) {
+    return 7;
+  } else if (millibits_per_key <= 14001) {
+    return 8;
+  } else if (millibits_per_key <= 16050) {
+    return 9;
+  } else if (millibits_per_key <= 18300) {
+    return 10;
+  } else if (millibits_per_key <= 22001) {
+    return 11;
+  } else if (millibits_per_key <= 25501) {
+    return 12;
+  } else if (millibits_per_key > 50000) {
+    return 24;
+  } else {
+    return (millibits_per_key - 1) / 2000 - 1;
+  }
+}
+
+class BlockedBloomBitsBuilder : public FilterBitsBuilder {
+ public:
+  explicit BlockedBloomBitsBuilder(int millibits_per_key)
+      : millibits_per_key_(millibits_per_key),
+        num_probes_(ChooseNumProbes(millibits_per_key)) {}
+
+  virtual void AddKey(const Slice& key) override {
+    uint32_t hash = BloomHash(key);
+    // duplicated keys are adjacent
+    if (hash_entries_.empty() || hash != hash_entries_.back()) {
+      hash_entries_.push_back(hash);
+    }
+  }
+
+  virtual Slice Finish(std::unique_ptr<const char[]>* buf) override {
+    uint64_t total_bits =
+        static_cast<uint64_t>(hash_entries_.size()) * millibits_per_key_ / 1000;
+    uint32_t num_lines = static_cast<uint32_t>(
+        std::max<uint64_t>((total_bits + kCacheLineBits - 1) / kCacheLineBits,
+                           1));
+    size_t len = static_cast<size_t>(num_lines) * kCacheLineSize;
+
+    char* data = new char[len + kMetadataSize];
+    memset(data, 0, len);
+    for (uint32_t hash : hash_entries_) {
+      AddHash(hash, num_lines, data);
+    }
+    data[len] = kBlockedBloomKind;
+    data[len + 1] = static_cast<char>(num_probes_);
+    EncodeFixed32(data + len + 2, num_lines);
+
+    hash_entries_.clear();
+    buf->reset(data);
+    return Slice(data, len + kMetadataSize);
+  }
+
+ private:
+  void AddHash(uint32_t hash, uint32_t num_lines, char* data) const {
+    char* line = data + FastRange32(hash, num_lines) * kCacheLineSize;
+    // the multiplication spreads the lower bits of the hash, which differ
+    // among the keys sharing a line, into every probe position
+    uint32_t h = hash * 0x9e3779b9;
+    for (int i = 0; i < num_probes_; ++i) {
+      uint32_t bitpos = h >> (32 - 9);
+      line[bitpos >> 3] |= static_cast<char>(1 << (bitpos & 7));
+      h *= 0x9e3779b9;
+    }
+  }
+
+  const int millibits_per_key_;
+  const int num_probes_;
+  std::vector<uint32_t> hash_entries_;
+};
+
+class BlockedBloomBitsReader : public FilterBitsReader {
+ public:
+  BlockedBloomBitsReader(const char* data, int num_probes, uint32_t num_lines)
+      : data_(data), num_probes_(num_probes), num_lines_(num_lines) {}
+
+  virtual bool MayMatch(const Slice& key) const override {
+    uint32_t hash = BloomHash(key);
+    const char* line = data_ + FastRange32(hash, num_lines_) * kCacheLineSize;
+    uint32_t h = hash * 0x9e3779b9;
+    for (int i = 0; i < num_probes_; ++i) {
+      uint32_t bitpos = h >> (32 - 9);
+      if ((line[bitpos >> 3] & (1 << (bitpos & 7))) == 0) {
+        return false;
+      }
+      h *= 0x9e3779b9;
+    }
+    return true;
+  }
+
+ private:
+  const char* data_;
+  const int num_probes_;
+  const uint32_t num_lines_;
+};
+
+// Used for filters that cannot be understood, e.g. written by a newer
+// version or corrupted, so that no key is wrongly reported missing.
+class AlwaysTrueFilterBitsReader : public FilterBitsReader {
+ public:
+  virtual bool MayMatch(const Slice& key) const override { return true; }
+};
+
+class BloomFilterPolicy : public FilterPolicy {
+ public:
+  explicit BloomFilterPolicy(double bits_per_key)
+      : millibits_per_key_(static_cast<int>(
+            std::min(std::max(bits_per_key, 1.0), 100.0) * 1000.0 + 0.5)) {}
+
+  virtual const char* Name() const override {
+    return "vidardb.BuiltinBloomFilter";
+  }
+
+  virtual FilterBitsBuilder* GetFilterBitsBuilder() const override {
+    return new BlockedBloomBitsBuilder(millibits_per_key_);
+  }
+
+  virtual FilterBitsReader* GetFilterBitsReader(
+      const Slice& contents) const override {
+    if (contents.size() < kMetadataSize) {
+      return new AlwaysTrueFilterBitsReader();
+    }
+    size_t len = contents.size() - kMetadataSize;
+    const char* metadata = contents.data() + len;
+    int num_probes = static_cast<unsigned char>(metadata[1]);
+    uint32_t num_lines = DecodeFixed32(metadata + 2);
+    if (metadata[0] != kBlockedBloomKind || num_probes == 0 ||
+        num_lines == 0 ||
+        static_cast<uint64_t>(num_lines) * kCacheLineSize != len) {
+      return new AlwaysTrueFilterBitsReader();
+    }
+    return new BlockedBloomBitsReader(contents.data(), num_probes, num_lines);
+  }
+
+ private:
+  const int millibits_per_key_;
+};
+
+}  // namespace
+
+const FilterPolicy* NewBloomFilterPolicy(double bits_per_key) {
+  return new BloomFilterPolicy(bits_per_key);
+}
+
+}  // namespace vidardb
@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <vector>
 
 #include "port/port.h"
@@ -85,6 +86,8 @@ class HandleTable {
     return result;
   }
 
+  uint32_t Size() const { return elems_; }
+
  private:
   // The table consists of an array of buckets where each bucket is
   // a linked list of cache entries that hash into the bucket.
@@ -130,6 +133,80 @@ class HandleTable {
   }
 };
 
+// A count-min sketch of how often the keys are looked up, for the TinyLFU
+// admission. Each key bumps one 8-bit counter, saturating at 15, in each of
+// the 4 rows, and its frequency is the smallest of them. Once the counted
+// lookups reach 10 times the width, all the counters are halved so that the
+// old popularity fades out.
+class FrequencySketch {
+ public:
+  FrequencySketch() : width_(0), increments_(0) {}
+
+  // Widens the sketch for num_entries keys. A counter of the wider rows
+  // starts from the one its keys used to share.
+  void EnsureCapacity(size_t num_entries) {
+    if (width_ > 0 && 2 * num_entries <= width_) {
+      return;
+    }
+    uint32_t width = 16;
+    while (width < 2 * num_entries) {
+      width *= 2;
+    }
+    std::vector<uint8_t> counters(kDepth * width, 0);
+    if (width_ > 0) {
+      for (uint32_t i = 0; i < kDepth; i++) {
+        for (uint32_t j = 0; j < width; j++) {
+          counters[i * width + j] = counters_[i * width_ + (j & (width_ - 1))];
+        }
+      }
+    }
+    counters_.swap(counters);
+    width_ = width;
+  }
+
+  void Increment(uint32_t hash) {
+    bool added = false;
+    // Use double-hashing to pick a counter in each row, like the bloom
+    // filter does for its probes.
+    uint32_t h = hash;
+    const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
+    for (uint32_t i = 0; i < kDepth; i++) {
+      uint8_t& counter = counters_[i * width_ + (h & (width_ - 1))];
+      if (counter < kMaxCount) {
+        counter++;
+        added = true;
+      }
+      h += delta;
+    }
+    if (added && ++increments_ >= 10 * width_) {
+      for (auto& counter : counters_) {
+        counter >>= 1;
+      }
+      increments_ /= 2;
+    }
+  }
+
+  uint32_t Estimate(uint32_t hash) const {
+    uint32_t frequency = kMaxCount;
+    uint32_t h = hash;
+    const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
+    for (uint32_t i = 0; i < kDepth; i++) {
+      frequency = std::min<uint32_t>(
+          frequency, counters_[i * width_ + (h & (width_ - 1))]);
+      h += delta;
+    }
+    return frequency;
+  }
+
+ private:
+  static const uint32_t kDepth = 4;
+  static const uint8_t kMaxCount = 15;
+
+  std::vector<uint8_t> counters_;
+  uint32_t width_;
+  uint32_t increments_;
+};
+
 // A single shard of sharded cache.
 class LRUCache {
  public:
@@ -144,10 +221,16 @@ class LRUCache {
   // Set the flag to reject insertion if cache if full.
   void SetStrictCapacityLimit(bool strict_capacity_limit);
 
+  // Set the fraction of the capacity reserved for high priority entries.
+  void SetHighPriorityPoolRatio(double high_pri_pool_ratio);
+
+  // Turn on the TinyLFU admission of the new entries.
+  void SetTinyLFUAdmission(bool tinylfu_admission);
+
   // Like Cache methods, but with an extra "hash" parameter.
   Status Insert(const Slice& key, uint32_t hash, void* value, size_t charge,
                 void (*deleter)(const Slice& key, void* value),
-                Cache::Handle** handle);
+                Cache::Handle** handle, Cache::Priority priority);
   Cache::Handle* Lookup(const Slice& key, uint32_t hash);
   void Release(Cache::Handle* handle);
   void Erase(const Slice& key, uint32_t hash);
@@ -174,13 +257,24 @@ class LRUCache {
 
  private:
   void LRU_Remove(LRUHandle* e);
-  void LRU_Append(LRUHandle* e);
+  // Insert "e" at the head of its pool: the high-pri pool for a high
+  // priority entry when the pool is enabled, the low-pri pool otherwise.
+  void LRU_Insert(LRUHandle* e);
+  // Overflow the oldest entries of the high-pri pool to the low-pri pool
+  // until the pool fits in high_pri_pool_capacity_.
+  void MaintainPoolSize();
+  // Move the oldest entries of the admission window to the LRU list until
+  // the window fits in window_capacity_. When the cache is full, such an
+  // entry only gets in if it was looked up more often than the oldest one of
+  // the LRU list, which is evicted next. Otherwise it is evicted itself.
+  void MaintainWindowSize(std::vector<LRUHandle*>* deleted);
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(LRUHandle* e);
 
   // Free some space following strict LRU policy until enough space
-  // to hold (usage_ + charge) is freed or the lru list is empty
+  // to hold (usage_ + charge) is freed or the lru list is empty, then
+  // from the admission window
   // This function is not thread safe - it needs to be executed while
   // holding the mutex_
   void EvictFromLRU(size_t charge, std::vector<LRUHandle*>* deleted);
@@ -191,12 +285,32 @@ class LRUCache {
   // Memory size for entries residing in the cache
   size_t usage_;
 
-  // Memory size for entries residing only in the LRU list
+  // Memory size for entries residing only in the LRU list or the window
   size_t lru_usage_;
 
   // Whether to reject insertion if cache reaches its full capacity.
   bool strict_capacity_limit_;
 
+  // Memory size for entries in the high-pri pool of the LRU list
+  size_t high_pri_pool_usage_;
+
+  // Ratio of capacity reserved for high priority entries
+  double high_pri_pool_ratio_;
+
+  // High-pri pool size, equals to capacity * high_pri_pool_ratio.
+  // Remember the value to avoid recomputing each time.
+  size_t high_pri_pool_capacity_;
+
+  // Whether the new entries go through the admission window and the
+  // frequency sketch before they reach the LRU list.
+  bool tinylfu_admission_;
+
+  // Memory size for entries in the admission window
+  size_t window_usage_;
+
+  // Window size, equals to capacity * kWindowRatio.
+  size_t window_capacity_;
+
   // mutex_ protects the following state.
   // We don't count mutex_ as the cache's internal state so semantically we
   // don't mind mutex_ invoking the non-const actions.
@@ -207,13 +321,38 @@ class LRUCache {
   // LRU contains items which can be evicted, ie reference only by cache
   LRUHandle lru_;
 
+  // Pointer to head of low-pri pool in LRU list. The entries after it, up
+  // to lru.prev, form the high-pri pool.
+  LRUHandle* lru_low_pri_;
+
+  // Dummy head of the admission window, ordered like lru_. The new low
+  // priority entries wait here before they try to enter the LRU list.
+  LRUHandle window_;
+
+  FrequencySketch sketch_;
+
   HandleTable table_;
 };
 
-LRUCache::LRUCache() : usage_(0), lru_usage_(0) {
+// The share of the capacity of the admission window, as in W-TinyLFU.
+static const double kWindowRatio = 0.01;
+
+LRUCache::LRUCache()
+    : capacity_(0),
+      usage_(0),
+      lru_usage_(0),
+      high_pri_pool_usage_(0),
+      high_pri_pool_ratio_(0),
+      high_pri_pool_capacity_(0),
+      tinylfu_admission_(false),
+      window_usage_(0),
+      window_capacity_(0) {
   // Make empty circular linked list
   lru_.next = &lru_;
   lru_.prev = &lru_;
+  lru_low_pri_ = &lru_;
+  window_.next = &window_;
+  window_.prev = &window_;
 }
 
 LRUCache::~LRUCache() {}
@@ -230,8 +369,8 @@ void LRUCache::EraseUnRefEntries() {
   std::vector<LRUHandle*> last_reference_list;
   {
     MutexLock l(&mutex_);
-    while (lru_.next != &lru_) {
-      LRUHandle* old = lru_.next;
+    while (lru_.next != &lru_ || window_.next != &window_) {
+      LRUHandle* old = lru_.next != &lru_ ? lru_.next : window_.next;
       assert(old->in_cache);
       assert(old->refs ==
              1);  // LRU list contains elements which may be evicted
@@ -264,26 +403,90 @@ void LRUCache::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
 void LRUCache::LRU_Remove(LRUHandle* e) {
   assert(e->next != nullptr);
   assert(e->prev != nullptr);
+  if (lru_low_pri_ == e) {
+    lru_low_pri_ = e->prev;
+  }
   e->next->prev = e->prev;
   e->prev->next = e->next;
   e->prev = e->next = nullptr;
   lru_usage_ -= e->charge;
+  if (e->in_high_pri_pool) {
+    assert(high_pri_pool_usage_ >= e->charge);
+    high_pri_pool_usage_ -= e->charge;
+  }
+  if (e->in_window) {
+    assert(window_usage_ >= e->charge);
+    window_usage_ -= e->charge;
+  }
 }
 
-void LRUCache::LRU_Append(LRUHandle* e) {
-  // Make "e" newest entry by inserting just before lru_
+void LRUCache::LRU_Insert(LRUHandle* e) {
   assert(e->next == nullptr);
   assert(e->prev == nullptr);
-  e->next = &lru_;
-  e->prev = lru_.prev;
-  e->prev->next = e;
-  e->next->prev = e;
+  if (e->in_window) {
+    // Make "e" newest entry of the window
+    e->next = &window_;
+    e->prev = window_.prev;
+    e->prev->next = e;
+    e->next->prev = e;
+    e->in_high_pri_pool = false;
+    window_usage_ += e->charge;
+  } else if (high_pri_pool_ratio_ > 0 && e->is_high_pri) {
+    // Make "e" newest entry by inserting just before lru_
+    e->next = &lru_;
+    e->prev = lru_.prev;
+    e->prev->next = e;
+    e->next->prev = e;
+    e->in_high_pri_pool = true;
+    high_pri_pool_usage_ += e->charge;
+    MaintainPoolSize();
+  } else {
+    // Insert "e" to the head of low-pri pool. When the high-pri pool is
+    // disabled, the head of low-pri pool is also the head of the LRU list.
+    e->next = lru_low_pri_->next;
+    e->prev = lru_low_pri_;
+    e->prev->next = e;
+    e->next->prev = e;
+    e->in_high_pri_pool = false;
+    lru_low_pri_ = e;
+  }
   lru_usage_ += e->charge;
 }
 
+void LRUCache::MaintainPoolSize() {
+  while (high_pri_pool_usage_ > high_pri_pool_capacity_) {
+    // Overflow last entry in high-pri pool to low-pri pool.
+    lru_low_pri_ = lru_low_pri_->next;
+    assert(lru_low_pri_ != &lru_);
+    lru_low_pri_->in_high_pri_pool = false;
+    high_pri_pool_usage_ -= lru_low_pri_->charge;
+  }
+}
+
+void LRUCache::MaintainWindowSize(std::vector<LRUHandle*>* deleted) {
+  while (window_usage_ > window_capacity_) {
+    LRUHandle* candidate = window_.next;
+    LRU_Remove(candidate);
+    candidate->in_window = false;
+    LRUHandle* victim = lru_.next;
+    if (usage_ > capacity_ && victim != &lru_ &&
+        sketch_.Estimate(candidate->hash) <= sketch_.Estimate(victim->hash)) {
+      // not admitted
+      table_.Remove(candidate->key(), candidate->hash);
+      candidate->in_cache = false;
+      Unref(candidate);
+      usage_ -= candidate->charge;
+      deleted->push_back(candidate);
+    } else {
+      LRU_Insert(candidate);
+    }
+  }
+}
+
 void LRUCache::EvictFromLRU(size_t charge, std::vector<LRUHandle*>* deleted) {
-  while (usage_ + charge > capacity_ && lru_.next != &lru_) {
-    LRUHandle* old = lru_.next;
+  while (usage_ + charge > capacity_ &&
+         (lru_.next != &lru_ || window_.next != &window_)) {
+    LRUHandle* old = lru_.next != &lru_ ? lru_.next : window_.next;
     assert(old->in_cache);
     assert(old->refs == 1);  // LRU list contains elements which may be evicted
     LRU_Remove(old);
@@ -300,6 +503,10 @@ void LRUCache::SetCapacity(size_t capacity) {
   {
     MutexLock l(&mutex_);
     capacity_ = capacity;
+    high_pri_pool_capacity_ =
+        static_cast<size_t>(capacity_ * high_pri_pool_ratio_);
+    window_capacity_ = static_cast<size_t>(capacity_ * kWindowRatio);
+    MaintainWindowSize(&last_reference_list);
     EvictFromLRU(0, &last_reference_list);
   }
   // we free the entries here outside of mutex for
@@ -314,8 +521,28 @@ void LRUCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
   strict_capacity_limit_ = strict_capacity_limit;
 }
 
+void LRUCache::SetHighPriorityPoolRatio(double high_pri_pool_ratio) {
+  MutexLock l(&mutex_);
+  high_pri_pool_ratio_ = high_pri_pool_ratio;
+  high_pri_pool_capacity_ =
+      static_cast<size_t>(capacity_ * high_pri_pool_ratio_);
+  MaintainPoolSize();
+}
+
+void LRUCache::SetTinyLFUAdmission(bool tinylfu_admission) {
+  MutexLock l(&mutex_);
+  tinylfu_admission_ = tinylfu_admission;
+  if (tinylfu_admission_) {
+    sketch_.EnsureCapacity(table_.Size());
+  }
+}
+
 Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash) {
   MutexLock l(&mutex_);
+  if (tinylfu_admission_) {
+    // the misses count too, a key looked up often deserves admission
+    sketch_.Increment(hash);
+  }
   LRUHandle* e = table_.Lookup(key, hash);
   if (e != nullptr) {
     assert(e->in_cache);
@@ -333,6 +560,7 @@ void LRUCache::Release(Cache::Handle* handle) {
   }
   LRUHandle* e = reinterpret_cast<LRUHandle*>(handle);
   bool last_reference = false;
+  std::vector<LRUHandle*> last_reference_list;
   {
     MutexLock l(&mutex_);
     last_reference = Unref(e);
@@ -353,7 +581,8 @@ void LRUCache::Release(Cache::Handle* handle) {
         last_reference = true;
       } else {
         // put the item on the list to be potentially freed
-        LRU_Append(e);
+        LRU_Insert(e);
+        MaintainWindowSize(&last_reference_list);
       }
     }
   }
@@ -362,12 +591,15 @@ void LRUCache::Release(Cache::Handle* handle) {
   if (last_reference) {
     e->Free();
   }
+  for (auto entry : last_reference_list) {
+    entry->Free();
+  }
 }
 
 Status LRUCache::Insert(const Slice& key, uint32_t hash, void* value,
                         size_t charge,
                         void (*deleter)(const Slice& key, void* value),
-                        Cache::Handle** handle) {
+                        Cache::Handle** handle, Cache::Priority priority) {
   // Allocate the memory here outside of the mutex
   // If the cache is full, we'll have to release it
   // It shouldn't happen very often though.
@@ -386,14 +618,21 @@ Status LRUCache::Insert(const Slice& key, uint32_t hash, void* value,
                  : 2);  // One from LRUCache, one for the returned handle
   e->next = e->prev = nullptr;
   e->in_cache = true;
+  e->is_high_pri = (priority == Cache::Priority::HIGH);
+  e->in_high_pri_pool = false;
   memcpy(e->key_data, key.data(), key.size());
 
   {
     MutexLock l(&mutex_);
 
-    // Free the space following strict LRU policy until enough space
-    // is freed or the lru list is empty
-    EvictFromLRU(charge, &last_reference_list);
+    // The high priority entries skip the admission, the others wait in the
+    // window first.
+    e->in_window = tinylfu_admission_ && !e->is_high_pri;
+    if (!tinylfu_admission_) {
+      // Free the space following strict LRU policy until enough space
+      // is freed or the lru list is empty
+      EvictFromLRU(charge, &last_reference_list);
+    }
 
     if (strict_capacity_limit_ && usage_ - lru_usage_ + charge > capacity_) {
       if (handle == nullptr) {
@@ -420,10 +659,17 @@ Status LRUCache::Insert(const Slice& key, uint32_t hash, void* value,
         }
       }
       if (handle == nullptr) {
-        LRU_Append(e);
+        LRU_Insert(e);
       } else {
         *handle = reinterpret_cast<Cache::Handle*>(e);
       }
+      if (tinylfu_admission_) {
+        sketch_.EnsureCapacity(table_.Size());
+        // the overflow of the window competes with the oldest entries
+        // before anything is evicted
+        MaintainWindowSize(&last_reference_list);
+        EvictFromLRU(0, &last_reference_list);
+      }
       s = Status::OK();
     }
   }
@@ -473,6 +719,7 @@ class ShardedLRUCache : public Cache {
   int num_shard_bits_;
   size_t capacity_;
   bool strict_capacity_limit_;
+  double high_pri_pool_ratio_;
 
   static inline uint32_t HashSlice(const Slice& s) {
     return Hash(s.data(), s.size(), 0);
@@ -485,17 +732,21 @@ class ShardedLRUCache : public Cache {
 
  public:
   ShardedLRUCache(size_t capacity, int num_shard_bits,
-                  bool strict_capacity_limit)
+                  bool strict_capacity_limit, double high_pri_pool_ratio,
+                  bool tinylfu_admission)
       : last_id_(0),
         num_shard_bits_(num_shard_bits),
         capacity_(capacity),
-        strict_capacity_limit_(strict_capacity_limit) {
+        strict_capacity_limit_(strict_capacity_limit),
+        high_pri_pool_ratio_(high_pri_pool_ratio) {
     int num_shards = 1 << num_shard_bits_;
     shards_ = new LRUCache[num_shards];
     const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
     for (int s = 0; s < num_shards; s++) {
-      shards_[s].SetCapacity(per_shard);
       shards_[s].SetStrictCapacityLimit(strict_capacity_limit);
+      shards_[s].SetHighPriorityPoolRatio(high_pri_pool_ratio);
+      shards_[s].SetTinyLFUAdmission(tinylfu_admission);
+      shards_[s].SetCapacity(per_shard);
     }
   }
   virtual ~ShardedLRUCache() { delete[] shards_; }
@@ -515,12 +766,22 @@ class ShardedLRUCache : public Cache {
     }
     strict_capacity_limit_ = strict_capacity_limit;
   }
+  virtual void SetHighPriorityPoolRatio(double high_pri_pool_ratio) override {
+    int num_shards = 1 << num_shard_bits_;
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].SetHighPriorityPoolRatio(high_pri_pool_ratio);
+    }
+    high_pri_pool_ratio_ = high_pri_pool_ratio;
+  }
+  virtual double GetHighPriorityPoolRatio() const override {
+    return high_pri_pool_ratio_;
+  }
   virtual Status Insert(const Slice& key, void* value, size_t charge,
                         void (*deleter)(const Slice& key, void* value),
-                        Handle** handle) override {
+                        Handle** handle, Priority priority) override {
     const uint32_t hash = HashSlice(key);
     return shards_[Shard(hash)].Insert(key, hash, value, charge, deleter,
-                                       handle);
+                                       handle, priority);
   }
   virtual Handle* Lookup(const Slice& key) override {
     const uint32_t hash = HashSlice(key);
@@ -601,11 +862,30 @@ std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits) {
 
 std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
                                    bool strict_capacity_limit) {
+  return NewLRUCache(capacity, num_shard_bits, strict_capacity_limit, 0.0);
+}
+
+std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
+                                   bool strict_capacity_limit,
+                                   double high_pri_pool_ratio) {
+  return NewLRUCache(capacity, num_shard_bits, strict_capacity_limit,
+                     high_pri_pool_ratio, false);
+}
+
+std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
+                                   bool strict_capacity_limit,
+                                   double high_pri_pool_ratio,
+                                   bool tinylfu_admission) {
   if (num_shard_bits >= 20) {
     return nullptr;  // the cache cannot be sharded into too many fine pieces
   }
+  if (high_pri_pool_ratio < 0.0 || high_pri_pool_ratio > 1.0) {
+    return nullptr;  // invalid high_pri_pool_ratio
+  }
   return std::make_shared<ShardedLRUCache>(capacity, num_shard_bits,
-                                           strict_capacity_limit);
+                                           strict_capacity_limit,
+                                           high_pri_pool_ratio,
+                                           tinylfu_admission);
 }
 
 }  // namespace vidardb
@@ -0,0 +1,39 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/cache_simulator.h"
+
+namespace vidardb {
+
+namespace {
+void DeleteNothing(const Slice& key, void* value) {}
+}  // namespace
+
+void CacheSimulator::Access(const BlockAccess& access) {
+  accesses_++;
+  Cache::Handle* handle = cache_->Lookup(access.key);
+  if (handle != nullptr) {
+    cache_->Release(handle);
+    return;
+  }
+  misses_++;
+  if (access.fill_cache) {
+    cache_->Insert(access.key, nullptr, access.charge, &DeleteNothing);
+  }
+}
+
+std::shared_ptr<Cache> NewSimulatedCache(const std::string& policy,
+                                         size_t capacity, int num_shard_bits) {
+  if (policy == "lru") {
+    return NewLRUCache(capacity, num_shard_bits);
+  } else if (policy == "clock") {
+    return NewClockCache(capacity, num_shard_bits, false);
+  } else if (policy == "tinylfu") {
+    return NewLRUCache(capacity, num_shard_bits, false, 0.0, true);
+  }
+  return nullptr;
+}
+
+}  // namespace vidardb
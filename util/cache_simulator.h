@@ -0,0 +1,44 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "vidardb/block_access_tracer.h"
+#include "vidardb/cache.h"
+
+namespace vidardb {
+
+// Replays the block cache lookups of a trace against a cache holding no
+// values, only the charges of the blocks. A lookup that misses inserts the
+// block, unless the traced lookup did not fill the cache.
+class CacheSimulator {
+ public:
+  explicit CacheSimulator(std::shared_ptr<Cache> cache)
+      : cache_(cache), accesses_(0), misses_(0) {}
+
+  void Access(const BlockAccess& access);
+
+  uint64_t accesses() const { return accesses_; }
+  uint64_t misses() const { return misses_; }
+  double MissRatio() const {
+    return accesses_ == 0 ? 0.0 : static_cast<double>(misses_) / accesses_;
+  }
+
+ private:
+  std::shared_ptr<Cache> cache_;
+  uint64_t accesses_;
+  uint64_t misses_;
+};
+
+// The cache of the policy "lru", "clock" or "tinylfu" (an LRU cache with the
+// W-TinyLFU admission), nullptr for an unknown policy.
+std::shared_ptr<Cache> NewSimulatedCache(const std::string& policy,
+                                         size_t capacity, int num_shard_bits);
+
+}  // namespace vidardb
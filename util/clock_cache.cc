@@ -0,0 +1,647 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <assert.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "port/port.h"
+#include "vidardb/cache.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace vidardb {
+
+namespace {
+
+// CLOCK cache implementation
+//
+// The state of a handle is a single atomic word:
+//   bit 0:  in cache, i.e. reachable from the hash table
+//   bit 1:  usage, set by every lookup and cleared by the clock hand
+//   bit 2+: the number of external references
+// Lookup and Release only read the hash table and update that word, without
+// taking the shard mutex, except for the Release of the last reference to an
+// erased entry, which frees it. Insert, Erase and the eviction are serialized
+// by the mutex.
+//
+// The handles of a shard live in a deque, so they never move, and the freed
+// ones are recycled instead of deallocated. A lookup that races with the
+// recycling can only take a reference to a handle in cache, and then checks
+// its key, so at worst it misses.
+//
+// The hash table is open addressed with linear probing, and removes the
+// entries by shifting the following ones back. It grows by publishing a
+// bigger table, the old ones are kept until the shard is destroyed, so a
+// lookup racing with a writer reads a stale but valid table and at worst
+// misses too.
+
+const uint32_t kInCacheBit = 1;
+const uint32_t kUsageBit = 2;
+const uint32_t kRefsOffset = 2;
+const uint32_t kOneRef = 1 << kRefsOffset;
+
+inline bool InCache(uint32_t flags) { return flags & kInCacheBit; }
+inline uint32_t CountRefs(uint32_t flags) { return flags >> kRefsOffset; }
+
+struct ClockHandle {
+  std::atomic<uint32_t> flags;
+  std::atomic<uint32_t> hash;
+  std::string key;
+  void* value;
+  size_t charge;
+  void (*deleter)(const Slice&, void* value);
+
+  ClockHandle()
+      : flags(0), hash(0), value(nullptr), charge(0), deleter(nullptr) {}
+};
+
+struct ClockTable {
+  explicit ClockTable(size_t length)
+      : mask(length - 1), slots(new std::atomic<ClockHandle*>[length]) {
+    assert((length & mask) == 0);
+    for (size_t i = 0; i < length; i++) {
+      slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  size_t Length() const { return mask + 1; }
+
+  const size_t mask;
+  std::unique_ptr<std::atomic<ClockHandle*>[]> slots;
+};
+
+// What is left to do for a freed entry once the mutex is released.
+struct CleanupEntry {
+  std::string key;
+  void* value;
+  void (*deleter)(const Slice&, void* value);
+};
+
+// A single shard of sharded cache.
+class ClockCache {
+ public:
+  ClockCache();
+  ~ClockCache();
+
+  // Separate from constructor so caller can easily make an array of
+  // ClockCache. If current usage is more than new capacity, the function
+  // will attempt to free the needed space.
+  void SetCapacity(size_t capacity);
+
+  // Set the flag to reject insertion if cache is full.
+  void SetStrictCapacityLimit(bool strict_capacity_limit);
+
+  // Like Cache methods, but with an extra "hash" parameter.
+  Status Insert(const Slice& key, uint32_t hash, void* value, size_t charge,
+                void (*deleter)(const Slice& key, void* value),
+                Cache::Handle** handle);
+  Cache::Handle* Lookup(const Slice& key, uint32_t hash);
+  void Release(Cache::Handle* handle);
+  void Erase(const Slice& key, uint32_t hash);
+
+  size_t GetUsage() const { return usage_.load(std::memory_order_relaxed); }
+
+  size_t GetPinnedUsage() const {
+    return pinned_usage_.load(std::memory_order_relaxed);
+  }
+
+  void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                              bool thread_safe);
+
+  void EraseUnRefEntries();
+
+ private:
+  // Takes a reference to h if it is in cache, and marks it as used.
+  bool Ref(ClockHandle* h);
+
+  // Drops a reference to h, and returns true if h is no longer in cache and
+  // nobody else refers to it, i.e. the caller has to free it.
+  bool Unref(ClockHandle* h);
+
+  // Moves the key, value and deleter of h out to the cleanup list, and
+  // recycles h. REQUIRES: mutex_ held, h neither in cache nor referenced.
+  void Recycle(ClockHandle* h, std::vector<CleanupEntry>* cleanup);
+
+  // Evicts h if it is in cache, unreferenced and was not used since the
+  // clock hand passed it last. REQUIRES: mutex_ held.
+  bool TryEvict(ClockHandle* h, std::vector<CleanupEntry>* cleanup);
+
+  // Sweeps the clock hand until charge more bytes fit in the capacity, or
+  // every handle was passed twice. REQUIRES: mutex_ held.
+  void EvictFromClock(size_t charge, std::vector<CleanupEntry>* cleanup);
+
+  // Removes h from the hash table. REQUIRES: mutex_ held.
+  void RemoveFromTable(ClockHandle* h);
+
+  // Publishes a table twice as long as the current one. REQUIRES: mutex_
+  // held.
+  void GrowTable();
+
+  static void Cleanup(const std::vector<CleanupEntry>& cleanup);
+
+  // Initialized before use.
+  size_t capacity_;
+  bool strict_capacity_limit_;
+
+  // Charge of the entries in cache or referenced.
+  std::atomic<size_t> usage_;
+
+  // Charge of the referenced entries.
+  std::atomic<size_t> pinned_usage_;
+
+  // mutex_ protects the following state, and the writes to the table.
+  port::Mutex mutex_;
+  std::deque<ClockHandle> handles_;
+  std::vector<ClockHandle*> recycled_;
+  size_t clock_hand_;
+  size_t num_entries_;
+  // All the tables ever published, the last one is the current table.
+  std::vector<std::unique_ptr<ClockTable>> tables_;
+
+  std::atomic<ClockTable*> table_;
+};
+
+ClockCache::ClockCache()
+    : capacity_(0),
+      strict_capacity_limit_(false),
+      usage_(0),
+      pinned_usage_(0),
+      clock_hand_(0),
+      num_entries_(0) {
+  tables_.emplace_back(new ClockTable(16));
+  table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+ClockCache::~ClockCache() {
+  for (auto& h : handles_) {
+    uint32_t flags = h.flags.load(std::memory_order_relaxed);
+    assert(CountRefs(flags) == 0);
+    if (InCache(flags)) {
+      (*h.deleter)(h.key, h.value);
+    }
+  }
+}
+
+void ClockCache::SetCapacity(size_t capacity) {
+  std::vector<CleanupEntry> cleanup;
+  {
+    MutexLock l(&mutex_);
+    capacity_ = capacity;
+    EvictFromClock(0, &cleanup);
+  }
+  Cleanup(cleanup);
+}
+
+void ClockCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
+  MutexLock l(&mutex_);
+  strict_capacity_limit_ = strict_capacity_limit;
+}
+
+bool ClockCache::Ref(ClockHandle* h) {
+  uint32_t flags = h->flags.load(std::memory_order_relaxed);
+  do {
+    if (!InCache(flags)) {
+      return false;
+    }
+  } while (!h->flags.compare_exchange_weak(flags,
+                                           (flags + kOneRef) | kUsageBit,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed));
+  if (CountRefs(flags) == 0) {
+    pinned_usage_.fetch_add(h->charge, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool ClockCache::Unref(ClockHandle* h) {
+  // h may be recycled as soon as the reference is dropped
+  size_t charge = h->charge;
+  uint32_t flags =
+      h->flags.fetch_sub(kOneRef, std::memory_order_acq_rel) - kOneRef;
+  if (CountRefs(flags) > 0) {
+    return false;
+  }
+  pinned_usage_.fetch_sub(charge, std::memory_order_relaxed);
+  return !InCache(flags);
+}
+
+void ClockCache::Recycle(ClockHandle* h, std::vector<CleanupEntry>* cleanup) {
+  mutex_.AssertHeld();
+  assert((h->flags.load(std::memory_order_relaxed) & ~kUsageBit) == 0);
+  h->flags.store(0, std::memory_order_relaxed);
+  cleanup->push_back({std::move(h->key), h->value, h->deleter});
+  usage_.fetch_sub(h->charge, std::memory_order_relaxed);
+  recycled_.push_back(h);
+}
+
+bool ClockCache::TryEvict(ClockHandle* h, std::vector<CleanupEntry>* cleanup) {
+  mutex_.AssertHeld();
+  uint32_t flags = h->flags.load(std::memory_order_relaxed);
+  if (!InCache(flags) || CountRefs(flags) > 0) {
+    return false;
+  }
+  if (flags & kUsageBit) {
+    // second chance, a lookup in between takes it away again
+    h->flags.compare_exchange_strong(flags, flags & ~kUsageBit,
+                                     std::memory_order_relaxed);
+    return false;
+  }
+  // no lookup can take a reference once the in cache bit is cleared
+  if (!h->flags.compare_exchange_strong(flags, 0,
+                                        std::memory_order_acquire)) {
+    return false;
+  }
+  RemoveFromTable(h);
+  Recycle(h, cleanup);
+  return true;
+}
+
+void ClockCache::EvictFromClock(size_t charge,
+                                std::vector<CleanupEntry>* cleanup) {
+  mutex_.AssertHeld();
+  const size_t num_handles = handles_.size();
+  for (size_t i = 0; i < 2 * num_handles &&
+                     usage_.load(std::memory_order_relaxed) + charge >
+                         capacity_;
+       i++) {
+    ClockHandle* h = &handles_[clock_hand_];
+    clock_hand_ = (clock_hand_ + 1) % num_handles;
+    TryEvict(h, cleanup);
+  }
+}
+
+void ClockCache::RemoveFromTable(ClockHandle* h) {
+  mutex_.AssertHeld();
+  ClockTable* table = tables_.back().get();
+  const size_t mask = table->mask;
+  size_t hole = h->hash.load(std::memory_order_relaxed) & mask;
+  while (table->slots[hole].load(std::memory_order_relaxed) != h) {
+    assert(table->slots[hole].load(std::memory_order_relaxed) != nullptr);
+    hole = (hole + 1) & mask;
+  }
+  num_entries_--;
+
+  // Shift back the following entries of the probe sequence, each one is
+  // copied to the hole before its slot is cleared.
+  for (size_t i = (hole + 1) & mask;; i = (i + 1) & mask) {
+    ClockHandle* next = table->slots[i].load(std::memory_order_relaxed);
+    if (next == nullptr) {
+      break;
+    }
+    size_t home = next->hash.load(std::memory_order_relaxed) & mask;
+    // next stays if its home is cyclically in (hole, i]
+    if (hole <= i ? (hole < home && home <= i) : (hole < home || home <= i)) {
+      continue;
+    }
+    table->slots[hole].store(next, std::memory_order_release);
+    hole = i;
+  }
+  table->slots[hole].store(nullptr, std::memory_order_release);
+}
+
+void ClockCache::GrowTable() {
+  mutex_.AssertHeld();
+  ClockTable* old_table = tables_.back().get();
+  std::unique_ptr<ClockTable> table(new ClockTable(2 * old_table->Length()));
+  for (size_t i = 0; i < old_table->Length(); i++) {
+    ClockHandle* h = old_table->slots[i].load(std::memory_order_relaxed);
+    if (h == nullptr) {
+      continue;
+    }
+    size_t idx = h->hash.load(std::memory_order_relaxed) & table->mask;
+    while (table->slots[idx].load(std::memory_order_relaxed) != nullptr) {
+      idx = (idx + 1) & table->mask;
+    }
+    table->slots[idx].store(h, std::memory_order_relaxed);
+  }
+  table_.store(table.get(), std::memory_order_release);
+  tables_.push_back(std::move(table));
+}
+
+void ClockCache::Cleanup(const std::vector<CleanupEntry>& cleanup) {
+  for (const auto& entry : cleanup) {
+    (*entry.deleter)(entry.key, entry.value);
+  }
+}
+
+Status ClockCache::Insert(const Slice& key, uint32_t hash, void* value,
+                          size_t charge,
+                          void (*deleter)(const Slice& key, void* value),
+                          Cache::Handle** handle) {
+  Status s;
+  std::vector<CleanupEntry> cleanup;
+  {
+    MutexLock l(&mutex_);
+    EvictFromClock(charge, &cleanup);
+    if (usage_.load(std::memory_order_relaxed) + charge > capacity_ &&
+        (strict_capacity_limit_ || handle == nullptr)) {
+      if (handle == nullptr) {
+        // Don't insert the entry but still return ok, as if the entry
+        // inserted into cache and get evicted immediately.
+        cleanup.push_back({key.ToString(), value, deleter});
+      } else {
+        s = Status::Incomplete("Insert failed due to CLOCK cache being full.");
+      }
+    } else {
+      ClockHandle* h;
+      if (recycled_.empty()) {
+        handles_.emplace_back();
+        h = &handles_.back();
+      } else {
+        h = recycled_.back();
+        recycled_.pop_back();
+      }
+      h->key.assign(key.data(), key.size());
+      h->hash.store(hash, std::memory_order_relaxed);
+      h->value = value;
+      h->charge = charge;
+      h->deleter = deleter;
+      usage_.fetch_add(charge, std::memory_order_relaxed);
+      if (handle != nullptr) {
+        pinned_usage_.fetch_add(charge, std::memory_order_relaxed);
+      }
+
+      if (2 * (num_entries_ + 1) > tables_.back()->Length()) {
+        GrowTable();
+      }
+      ClockTable* table = tables_.back().get();
+      size_t idx = hash & table->mask;
+      ClockHandle* old = nullptr;
+      for (;; idx = (idx + 1) & table->mask) {
+        old = table->slots[idx].load(std::memory_order_relaxed);
+        if (old == nullptr ||
+            (old->hash.load(std::memory_order_relaxed) == hash &&
+             old->key == h->key)) {
+          break;
+        }
+      }
+      // the key, value and charge of h are visible to a lookup that sees
+      // the in cache bit
+      h->flags.store(kInCacheBit | (handle != nullptr ? kOneRef : 0),
+                     std::memory_order_release);
+      table->slots[idx].store(h, std::memory_order_release);
+      if (old == nullptr) {
+        num_entries_++;
+      } else {
+        // replaced, the old entry is freed by its last reference
+        uint32_t flags =
+            old->flags.fetch_and(~kInCacheBit, std::memory_order_acq_rel);
+        if (CountRefs(flags) == 0) {
+          Recycle(old, &cleanup);
+        }
+      }
+      if (handle != nullptr) {
+        *handle = reinterpret_cast<Cache::Handle*>(h);
+      }
+    }
+  }
+  Cleanup(cleanup);
+  return s;
+}
+
+Cache::Handle* ClockCache::Lookup(const Slice& key, uint32_t hash) {
+  ClockTable* table = table_.load(std::memory_order_acquire);
+  size_t idx = hash & table->mask;
+  for (size_t i = 0; i < table->Length(); i++, idx = (idx + 1) & table->mask) {
+    ClockHandle* h = table->slots[idx].load(std::memory_order_acquire);
+    if (h == nullptr) {
+      break;
+    }
+    if (h->hash.load(std::memory_order_relaxed) != hash || !Ref(h)) {
+      continue;
+    }
+    // the key is stable while h is referenced
+    if (Slice(h->key) == key) {
+      return reinterpret_cast<Cache::Handle*>(h);
+    }
+    Release(reinterpret_cast<Cache::Handle*>(h));
+  }
+  return nullptr;
+}
+
+void ClockCache::Release(Cache::Handle* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+  ClockHandle* h = reinterpret_cast<ClockHandle*>(handle);
+  if (Unref(h)) {
+    std::vector<CleanupEntry> cleanup;
+    {
+      MutexLock l(&mutex_);
+      Recycle(h, &cleanup);
+    }
+    Cleanup(cleanup);
+  }
+}
+
+void ClockCache::Erase(const Slice& key, uint32_t hash) {
+  std::vector<CleanupEntry> cleanup;
+  {
+    MutexLock l(&mutex_);
+    ClockTable* table = tables_.back().get();
+    for (size_t idx = hash & table->mask;; idx = (idx + 1) & table->mask) {
+      ClockHandle* h = table->slots[idx].load(std::memory_order_relaxed);
+      if (h == nullptr) {
+        break;
+      }
+      if (h->hash.load(std::memory_order_relaxed) == hash &&
+          Slice(h->key) == key) {
+        RemoveFromTable(h);
+        uint32_t flags =
+            h->flags.fetch_and(~kInCacheBit, std::memory_order_acq_rel);
+        if (CountRefs(flags) == 0) {
+          Recycle(h, &cleanup);
+        }
+        break;
+      }
+    }
+  }
+  Cleanup(cleanup);
+}
+
+void ClockCache::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                        bool thread_safe) {
+  if (thread_safe) {
+    mutex_.Lock();
+  }
+  ClockTable* table = tables_.back().get();
+  for (size_t i = 0; i < table->Length(); i++) {
+    ClockHandle* h = table->slots[i].load(std::memory_order_relaxed);
+    if (h != nullptr) {
+      callback(h->value, h->charge);
+    }
+  }
+  if (thread_safe) {
+    mutex_.Unlock();
+  }
+}
+
+void ClockCache::EraseUnRefEntries() {
+  std::vector<CleanupEntry> cleanup;
+  {
+    MutexLock l(&mutex_);
+    for (auto& h : handles_) {
+      uint32_t flags = h.flags.load(std::memory_order_relaxed);
+      if (InCache(flags) && CountRefs(flags) == 0 &&
+          h.flags.compare_exchange_strong(flags, 0,
+                                          std::memory_order_acquire)) {
+        RemoveFromTable(&h);
+        Recycle(&h, &cleanup);
+      }
+    }
+  }
+  Cleanup(cleanup);
+}
+
+static int kNumShardBits = 6;  // default values, can be overridden
+
+class ShardedClockCache : public Cache {
+ private:
+  ClockCache* shards_;
+  port::Mutex id_mutex_;
+  port::Mutex capacity_mutex_;
+  uint64_t last_id_;
+  int num_shard_bits_;
+  size_t capacity_;
+  bool strict_capacity_limit_;
+
+  static inline uint32_t HashSlice(const Slice& s) {
+    return Hash(s.data(), s.size(), 0);
+  }
+
+  uint32_t Shard(uint32_t hash) {
+    // Note, hash >> 32 yields hash in gcc, not the zero we expect!
+    return (num_shard_bits_ > 0) ? (hash >> (32 - num_shard_bits_)) : 0;
+  }
+
+ public:
+  ShardedClockCache(size_t capacity, int num_shard_bits,
+                    bool strict_capacity_limit)
+      : last_id_(0),
+        num_shard_bits_(num_shard_bits),
+        capacity_(capacity),
+        strict_capacity_limit_(strict_capacity_limit) {
+    int num_shards = 1 << num_shard_bits_;
+    shards_ = new ClockCache[num_shards];
+    const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].SetStrictCapacityLimit(strict_capacity_limit);
+      shards_[s].SetCapacity(per_shard);
+    }
+  }
+  virtual ~ShardedClockCache() { delete[] shards_; }
+  virtual void SetCapacity(size_t capacity) override {
+    int num_shards = 1 << num_shard_bits_;
+    const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
+    MutexLock l(&capacity_mutex_);
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].SetCapacity(per_shard);
+    }
+    capacity_ = capacity;
+  }
+  virtual void SetStrictCapacityLimit(bool strict_capacity_limit) override {
+    int num_shards = 1 << num_shard_bits_;
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].SetStrictCapacityLimit(strict_capacity_limit);
+    }
+    strict_capacity_limit_ = strict_capacity_limit;
+  }
+  // The priority is ignored, the clock gives every entry the same chance.
+  virtual void SetHighPriorityPoolRatio(double high_pri_pool_ratio) override {
+  }
+  virtual double GetHighPriorityPoolRatio() const override { return 0.0; }
+  virtual Status Insert(const Slice& key, void* value, size_t charge,
+                        void (*deleter)(const Slice& key, void* value),
+                        Handle** handle, Priority priority) override {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)].Insert(key, hash, value, charge, deleter,
+                                       handle);
+  }
+  virtual Handle* Lookup(const Slice& key) override {
+    const uint32_t hash = HashSlice(key);
+    return shards_[Shard(hash)].Lookup(key, hash);
+  }
+  virtual void Release(Handle* handle) override {
+    ClockHandle* h = reinterpret_cast<ClockHandle*>(handle);
+    shards_[Shard(h->hash.load(std::memory_order_relaxed))].Release(handle);
+  }
+  virtual void Erase(const Slice& key) override {
+    const uint32_t hash = HashSlice(key);
+    shards_[Shard(hash)].Erase(key, hash);
+  }
+  virtual void* Value(Handle* handle) override {
+    return reinterpret_cast<ClockHandle*>(handle)->value;
+  }
+  virtual uint64_t NewId() override {
+    MutexLock l(&id_mutex_);
+    return ++(last_id_);
+  }
+  virtual size_t GetCapacity() const override { return capacity_; }
+
+  virtual bool HasStrictCapacityLimit() const override {
+    return strict_capacity_limit_;
+  }
+
+  virtual size_t GetUsage() const override {
+    int num_shards = 1 << num_shard_bits_;
+    size_t usage = 0;
+    for (int s = 0; s < num_shards; s++) {
+      usage += shards_[s].GetUsage();
+    }
+    return usage;
+  }
+
+  virtual size_t GetUsage(Handle* handle) const override {
+    return reinterpret_cast<ClockHandle*>(handle)->charge;
+  }
+
+  virtual size_t GetPinnedUsage() const override {
+    int num_shards = 1 << num_shard_bits_;
+    size_t usage = 0;
+    for (int s = 0; s < num_shards; s++) {
+      usage += shards_[s].GetPinnedUsage();
+    }
+    return usage;
+  }
+
+  virtual void DisownData() override { shards_ = nullptr; }
+
+  virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                      bool thread_safe) override {
+    int num_shards = 1 << num_shard_bits_;
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].ApplyToAllCacheEntries(callback, thread_safe);
+    }
+  }
+
+  virtual void EraseUnRefEntries() override {
+    int num_shards = 1 << num_shard_bits_;
+    for (int s = 0; s < num_shards; s++) {
+      shards_[s].EraseUnRefEntries();
+    }
+  }
+};
+
+}  // end anonymous namespace
+
+std::shared_ptr<Cache> NewClockCache(size_t capacity) {
+  return NewClockCache(capacity, kNumShardBits, false);
+}
+
+std::shared_ptr<Cache> NewClockCache(size_t capacity, int num_shard_bits,
+                                     bool strict_capacity_limit) {
+  if (num_shard_bits >= 20) {
+    return nullptr;  // the cache cannot be sharded into too many fine pieces
+  }
+  return std::make_shared<ShardedClockCache>(capacity, num_shard_bits,
+                                             strict_capacity_limit);
+}
+
+}  // namespace vidardb
@@ -0,0 +1,82 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "port/likely.h"
+#include "port/port.h"
+#include "util/random.h"
+
+namespace vidardb {
+
+// An array of one element per core, so the threads of different cores do
+// not bounce a shared cache line. A thread may move to another core while it
+// holds an element, so the elements still need synchronization, just rarely
+// contended.
+template <typename T>
+class CoreLocalArray {
+ public:
+  CoreLocalArray();
+
+  size_t Size() const;
+  // Returns the element of the current core.
+  T* Access() const;
+  // Returns the element of the current core, and its index.
+  std::pair<T*, size_t> AccessElementAndIndex() const;
+  // Returns the element at the index, 0 <= core_idx < Size().
+  T* AccessAtCore(size_t core_idx) const;
+
+ private:
+  std::unique_ptr<T[]> data_;
+  int size_shift_;
+};
+
+template <typename T>
+CoreLocalArray<T>::CoreLocalArray() {
+  // find a power of two >= num_cpus and >= 8
+  int num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+  size_shift_ = 3;
+  while (1 << size_shift_ < num_cpus) {
+    ++size_shift_;
+  }
+  data_.reset(new T[static_cast<size_t>(1) << size_shift_]);
+}
+
+template <typename T>
+size_t CoreLocalArray<T>::Size() const {
+  return static_cast<size_t>(1) << size_shift_;
+}
+
+template <typename T>
+T* CoreLocalArray<T>::Access() const {
+  return AccessElementAndIndex().first;
+}
+
+template <typename T>
+std::pair<T*, size_t> CoreLocalArray<T>::AccessElementAndIndex() const {
+  int cpuid = port::PhysicalCoreID();
+  size_t core_idx;
+  if (UNLIKELY(cpuid < 0)) {
+    // cpu id unavailable, just pick randomly
+    core_idx = Random::GetTLSInstance()->Uniform(1 << size_shift_);
+  } else {
+    core_idx = static_cast<size_t>(cpuid & ((1 << size_shift_) - 1));
+  }
+  return {AccessAtCore(core_idx), core_idx};
+}
+
+template <typename T>
+T* CoreLocalArray<T>::AccessAtCore(size_t core_idx) const {
+  assert(core_idx < Size());
+  return &data_[core_idx];
+}
+
+}  // namespace vidardb
@@ -0,0 +1,91 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/dynamic_bloom.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "port/port.h"
+#include "util/allocator.h"
+
+namespace vidardb {
+
+namespace {
+
+const uint32_t kLineBits = CACHE_LINE_SIZE * 8;
+
+// Maps hash uniformly to [0, range) without a division.
+inline uint32_t FastRange32(uint32_t hash, uint32_t range) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(hash) * range) >> 32);
+}
+
+}  // namespace
+
+DynamicBloom::DynamicBloom(Allocator* allocator, uint32_t total_bits,
+                           uint32_t num_probes, Logger* logger)
+    : num_lines_(std::max<uint32_t>((total_bits + kLineBits - 1) / kLineBits,
+                                    1)),
+      num_probes_(num_probes) {
+  assert(allocator != nullptr);
+  assert(num_probes_ > 0);
+  size_t sz = static_cast<size_t>(num_lines_) * CACHE_LINE_SIZE;
+  // over-allocate to align the bits to a cache line
+  char* raw = allocator->AllocateAligned(sz + CACHE_LINE_SIZE - 1, 0, logger);
+  uintptr_t misalignment =
+      reinterpret_cast<uintptr_t>(raw) & (CACHE_LINE_SIZE - 1);
+  if (misalignment != 0) {
+    raw += CACHE_LINE_SIZE - misalignment;
+  }
+  memset(raw, 0, sz);
+  static_assert(sizeof(std::atomic<uint8_t>) == sizeof(uint8_t),
+                "std::atomic<uint8_t> must be lock free and byte sized");
+  data_ = reinterpret_cast<std::atomic<uint8_t>*>(raw);
+}
+
+void DynamicBloom::AddHash(uint32_t hash, bool concurrent) {
+  std::atomic<uint8_t>* line =
+      data_ + FastRange32(hash, num_lines_) * CACHE_LINE_SIZE;
+  // the multiplication spreads the lower bits of the hash, which differ
+  // among the keys sharing a line, into every probe position
+  uint32_t h = hash * 0x9e3779b9;
+  for (uint32_t i = 0; i < num_probes_; ++i) {
+    uint32_t bitpos = h >> (32 - 9);
+    uint8_t mask = static_cast<uint8_t>(1 << (bitpos & 7));
+    std::atomic<uint8_t>& byte = line[bitpos >> 3];
+    if (concurrent) {
+      // skip the locked instruction if the bit is already set
+      if ((byte.load(std::memory_order_relaxed) & mask) != mask) {
+        byte.fetch_or(mask, std::memory_order_relaxed);
+      }
+    } else {
+      byte.store(byte.load(std::memory_order_relaxed) | mask,
+                 std::memory_order_relaxed);
+    }
+    h *= 0x9e3779b9;
+  }
+}
+
+bool DynamicBloom::MayContain(const Slice& key) const {
+  uint32_t hash = BloomHash(key);
+  const std::atomic<uint8_t>* line =
+      data_ + FastRange32(hash, num_lines_) * CACHE_LINE_SIZE;
+  uint32_t h = hash * 0x9e3779b9;
+  for (uint32_t i = 0; i < num_probes_; ++i) {
+    uint32_t bitpos = h >> (32 - 9);
+    if ((line[bitpos >> 3].load(std::memory_order_relaxed) &
+         (1 << (bitpos & 7))) == 0) {
+      return false;
+    }
+    h *= 0x9e3779b9;
+  }
+  return true;
+}
+
+size_t DynamicBloom::ApproximateMemoryUsage() const {
+  return static_cast<size_t>(num_lines_) * CACHE_LINE_SIZE;
+}
+
+}  // namespace vidardb
@@ -0,0 +1,56 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// A bloom filter that is filled while the keys arrive, e.g. the prefix bloom
+// of a memtable. Its memory is taken from an allocator, so it is released
+// together with the memtable arena. All the probes of one key go to the same
+// cache line.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "util/hash.h"
+#include "vidardb/slice.h"
+
+namespace vidardb {
+
+class Allocator;
+class Logger;
+
+class DynamicBloom {
+ public:
+  // allocator: memory of the bits, which lives as long as the allocator.
+  // total_bits: fixed total bits for the bloom, rounded up to whole cache
+  //             lines.
+  // num_probes: number of hash probes for a single key.
+  DynamicBloom(Allocator* allocator, uint32_t total_bits,
+               uint32_t num_probes = 6, Logger* logger = nullptr);
+
+  ~DynamicBloom() {}
+
+  // Assuming single threaded access to this function.
+  void Add(const Slice& key) { AddHash(BloomHash(key), false); }
+
+  // Multithreaded access to this function is OK.
+  void AddConcurrently(const Slice& key) { AddHash(BloomHash(key), true); }
+
+  // Multithreaded access to this function is OK, also against the adds.
+  bool MayContain(const Slice& key) const;
+
+  uint32_t GetNumLines() const { return num_lines_; }
+
+  size_t ApproximateMemoryUsage() const;
+
+ private:
+  void AddHash(uint32_t hash, bool concurrent);
+
+  uint32_t num_lines_;
+  uint32_t num_probes_;
+  std::atomic<uint8_t>* data_;
+};
+
+}  // namespace vidardb
@@ -69,6 +69,14 @@ SequentialFile::~SequentialFile() {
 RandomAccessFile::~RandomAccessFile() {
 }
 
+Status RandomAccessFile::MultiRead(ReadRequest* reqs, size_t num_reqs) {
+  for (size_t i = 0; i < num_reqs; i++) {
+    ReadRequest& req = reqs[i];
+    req.status = Read(req.offset, req.len, &req.result, req.scratch);
+  }
+  return Status::OK();
+}
+
 WritableFile::~WritableFile() {
 }
 
@@ -323,6 +331,8 @@ void AssignEnvOptions(EnvOptions* env_options, const DBOptions& options) {
   env_options->writable_file_max_buffer_size =
       options.writable_file_max_buffer_size;
   env_options->allow_fallocate = options.allow_fallocate;
+  env_options->use_direct_reads = options.use_direct_reads;
+  env_options->rate_limiter = options.rate_limiter.get();
 }
 
 }
@@ -331,11 +341,30 @@ EnvOptions Env::OptimizeForLogWrite(const EnvOptions& env_options,
                                     const DBOptions& db_options) const {
   EnvOptions optimized_env_options(env_options);
   optimized_env_options.bytes_per_sync = db_options.wal_bytes_per_sync;
+  optimized_env_options.rate_limiter = nullptr;
   return optimized_env_options;
 }
 
 EnvOptions Env::OptimizeForManifestWrite(const EnvOptions& env_options) const {
-  return env_options;
+  EnvOptions optimized_env_options(env_options);
+  optimized_env_options.rate_limiter = nullptr;
+  return optimized_env_options;
+}
+
+EnvOptions Env::OptimizeForCompactionTableWrite(
+    const EnvOptions& env_options, const DBOptions& db_options) const {
+  EnvOptions optimized_env_options(env_options);
+  optimized_env_options.use_direct_writes =
+      db_options.use_direct_io_for_flush_and_compaction;
+  return optimized_env_options;
+}
+
+EnvOptions Env::OptimizeForCompactionTableRead(
+    const EnvOptions& env_options, const DBOptions& db_options) const {
+  EnvOptions optimized_env_options(env_options);
+  optimized_env_options.use_direct_reads =
+      db_options.use_direct_io_for_flush_and_compaction;
+  return optimized_env_options;
 }
 
 EnvOptions::EnvOptions(const DBOptions& options) {
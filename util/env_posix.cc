@@ -269,10 +269,12 @@ class PosixEnv : public Env {
       if (options.use_mmap_writes && !forceMmapOff) {
         result->reset(new PosixMmapFile(fname, fd, page_size_, options));
       } else if (options.use_direct_writes) {
+        // no O_APPEND: the last page is written again at its offset when it
+        // fills up, which pwrite doesn't do on an append-only fd in Linux
 #ifdef OS_MACOSX
-        int flags = O_WRONLY | O_APPEND | O_TRUNC | O_CREAT;
+        int flags = O_WRONLY | O_TRUNC | O_CREAT;
 #else
-        int flags = O_WRONLY | O_APPEND | O_TRUNC | O_CREAT | O_DIRECT;
+        int flags = O_WRONLY | O_TRUNC | O_CREAT | O_DIRECT;
 #endif
         TEST_SYNC_POINT_CALLBACK("NewWritableFile:O_DIRECT", &flags);
         close(fd);  // Quanzhao
@@ -22,6 +22,7 @@
 #include "util/iostats_context_imp.h"
 #include "util/random.h"
 #include "util/sync_point.h"
+#include "vidardb/rate_limiter.h"
 
 namespace vidardb {
 
@@ -33,9 +34,24 @@ Status SequentialFileReader::Read(size_t n, Slice* result, char* scratch) {
 
 Status SequentialFileReader::Skip(uint64_t n) { return file_->Skip(n); }
 
+void RandomAccessFileReader::ChargeRateLimiter(size_t n) const {
+  if (rate_limiter_ != nullptr && for_compaction_) {
+    // Charge the whole read up front in burst-sized pieces, so mmap and
+    // buffered files are throttled the same way.
+    size_t left = n;
+    while (left > 0) {
+      size_t allowed = std::min(
+          static_cast<size_t>(rate_limiter_->GetSingleBurstBytes()), left);
+      rate_limiter_->Request(allowed, Env::IO_LOW);
+      left -= allowed;
+    }
+  }
+}
+
 Status RandomAccessFileReader::Read(uint64_t offset, size_t n, Slice* result,
                                     char* scratch) const {
   Status s;
+  ChargeRateLimiter(n);
   uint64_t elapsed = 0;
   {
     StopWatch sw(env_, stats_, hist_type_,
@@ -50,6 +66,32 @@ Status RandomAccessFileReader::Read(uint64_t offset, size_t n, Slice* result,
   return s;
 }
 
+Status RandomAccessFileReader::MultiRead(ReadRequest* reqs,
+                                         size_t num_reqs) const {
+  Status s;
+  size_t total = 0;
+  for (size_t i = 0; i < num_reqs; i++) {
+    total += reqs[i].len;
+  }
+  ChargeRateLimiter(total);
+  uint64_t elapsed = 0;
+  {
+    StopWatch sw(env_, stats_, hist_type_,
+                 (stats_ != nullptr) ? &elapsed : nullptr);
+    IOSTATS_TIMER_GUARD(read_nanos);
+    s = file_->MultiRead(reqs, num_reqs);
+    if (s.ok()) {
+      for (size_t i = 0; i < num_reqs; i++) {
+        IOSTATS_ADD_IF_POSITIVE(bytes_read, reqs[i].result.size());
+      }
+    }
+  }
+  if (stats_ != nullptr && file_read_hist_ != nullptr) {
+    file_read_hist_->Add(elapsed);
+  }
+  return s;
+}
+
 Status WritableFileWriter::Append(const Slice& data) {
   const char* src = data.data();
   size_t left = data.size();
@@ -257,6 +299,21 @@ Status WritableFileWriter::RangeSync(uint64_t offset, uint64_t nbytes) {
 }
 
 size_t WritableFileWriter::RequestToken(size_t bytes, bool align) {
+  Env::IOPriority io_priority;
+  if (rate_limiter_ != nullptr &&
+      (io_priority = writable_file_->GetIOPriority()) < Env::IO_TOTAL) {
+    bytes = std::min(
+        bytes, static_cast<size_t>(rate_limiter_->GetSingleBurstBytes()));
+
+    if (align) {
+      // Here we may actually require more than burst and block
+      // but we can not write less than one page at a time on unbuffered
+      // thus we may want not to use ratelimiter s
+      size_t alignment = buf_.Alignment();
+      bytes = std::max(alignment, TruncateToPageBoundary(alignment, bytes));
+    }
+    rate_limiter_->Request(bytes, io_priority);
+  }
   return bytes;
 }
 
@@ -361,6 +418,10 @@ Status WritableFileWriter::WriteUnbuffered() {
 
 
 namespace {
+// The readahead buffer and the offsets it is filled from are aligned to
+// this, so that files opened with direct I/O read straight into the buffer.
+const size_t kReadaheadAlignment = 4 * 1024;
+
 class ReadaheadRandomAccessFile : public RandomAccessFile {
  public:
   ReadaheadRandomAccessFile(std::unique_ptr<RandomAccessFile>&& file,
@@ -373,7 +434,9 @@ class ReadaheadRandomAccessFile : public RandomAccessFile {
         buffer_offset_(0),
         buffer_len_(0) {
     if (!forward_calls_) {
-      buffer_.reset(new char[readahead_size_]);
+      // the aligned start of a read adds up to an alignment in front of it
+      buffer_.Alignment(kReadaheadAlignment);
+      buffer_.AllocateNewBuffer(readahead_size_ + kReadaheadAlignment);
     } else if (readahead_size_ > 0) {
       file_->EnableReadAhead();
     }
@@ -404,26 +467,34 @@ class ReadaheadRandomAccessFile : public RandomAccessFile {
     if (offset >= buffer_offset_ && offset < buffer_len_ + buffer_offset_) {
       uint64_t offset_in_buffer = offset - buffer_offset_;
       copied = std::min(buffer_len_ - static_cast<size_t>(offset_in_buffer), n);
-      memcpy(scratch, buffer_.get() + offset_in_buffer, copied);
+      memcpy(scratch, buffer_.BufferStart() + offset_in_buffer, copied);
       if (copied == n) {
         // fully cached
         *result = Slice(scratch, n);
         return Status::OK();
       }
     }
+    const uint64_t read_offset = offset + copied;
+    const uint64_t aligned_offset =
+        read_offset - read_offset % kReadaheadAlignment;
+    const size_t skip = static_cast<size_t>(read_offset - aligned_offset);
+    buffer_.Clear();
     Slice readahead_result;
-    Status s = file_->Read(offset + copied, readahead_size_, &readahead_result,
-      buffer_.get());
+    Status s = file_->Read(aligned_offset, buffer_.Capacity(),
+                           &readahead_result, buffer_.Destination());
     if (!s.ok()) {
       return s;
     }
 
-    auto left_to_copy = std::min(readahead_result.size(), n - copied);
-    memcpy(scratch + copied, readahead_result.data(), left_to_copy);
+    size_t left_to_copy = 0;
+    if (readahead_result.size() > skip) {
+      left_to_copy = std::min(readahead_result.size() - skip, n - copied);
+      memcpy(scratch + copied, readahead_result.data() + skip, left_to_copy);
+    }
     *result = Slice(scratch, copied + left_to_copy);
 
-    if (readahead_result.data() == buffer_.get()) {
-      buffer_offset_ = offset + copied;
+    if (readahead_result.data() == buffer_.BufferStart()) {
+      buffer_offset_ = aligned_offset;
       buffer_len_ = readahead_result.size();
     } else {
       buffer_len_ = 0;
@@ -432,6 +503,11 @@ class ReadaheadRandomAccessFile : public RandomAccessFile {
     return Status::OK();
   }
 
+  // The batched reads are random, they bypass the readahead buffer.
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs) override {
+    return file_->MultiRead(reqs, num_reqs);
+  }
+
   virtual size_t GetUniqueId(char* id, size_t max_size) const override {
     return file_->GetUniqueId(id, max_size);
   }
@@ -442,6 +518,10 @@ class ReadaheadRandomAccessFile : public RandomAccessFile {
     return file_->InvalidateCache(offset, length);
   }
 
+  virtual Status Prefetch(uint64_t offset, size_t n) override {
+    return file_->Prefetch(offset, n);
+  }
+
   /********************** Shichao ************************/
   virtual size_t ReadaheadSize() override {
     return readahead_size_;
@@ -454,7 +534,7 @@ class ReadaheadRandomAccessFile : public RandomAccessFile {
   const bool           forward_calls_;
 
   mutable std::mutex   lock_;
-  mutable std::unique_ptr<char[]> buffer_;
+  mutable AlignedBuffer buffer_;
   mutable uint64_t     buffer_offset_;
   mutable size_t       buffer_len_;
 };
@@ -54,18 +54,24 @@ class RandomAccessFileReader {
   Statistics*     stats_;
   uint32_t        hist_type_;
   HistogramImpl*  file_read_hist_;
+  RateLimiter*    rate_limiter_;
+  bool            for_compaction_;
 
  public:
   explicit RandomAccessFileReader(std::unique_ptr<RandomAccessFile>&& raf,
                                   Env* env = nullptr,
                                   Statistics* stats = nullptr,
                                   uint32_t hist_type = 0,
-                                  HistogramImpl* file_read_hist = nullptr)
+                                  HistogramImpl* file_read_hist = nullptr,
+                                  RateLimiter* rate_limiter = nullptr,
+                                  bool for_compaction = false)
       : file_(std::move(raf)),
         env_(env),
         stats_(stats),
         hist_type_(hist_type),
-        file_read_hist_(file_read_hist) {}
+        file_read_hist_(file_read_hist),
+        rate_limiter_(rate_limiter),
+        for_compaction_(for_compaction) {}
 
   RandomAccessFileReader(RandomAccessFileReader&& o) VIDARDB_NOEXCEPT {
     *this = std::move(o);
@@ -77,15 +83,37 @@ class RandomAccessFileReader {
     stats_ = std::move(o.stats_);
     hist_type_ = std::move(o.hist_type_);
     file_read_hist_ = std::move(o.file_read_hist_);
+    rate_limiter_ = std::move(o.rate_limiter_);
+    for_compaction_ = std::move(o.for_compaction_);
     return *this;
   }
 
   RandomAccessFileReader(const RandomAccessFileReader&) = delete;
   RandomAccessFileReader& operator=(const RandomAccessFileReader&) = delete;
 
+  // Reads issued for compaction inputs are charged to rate_limiter_ at
+  // Env::IO_LOW before they hit the file.
   Status Read(uint64_t offset, size_t n, Slice* result, char* scratch) const;
 
+  // Reads the requests in one batch, see RandomAccessFile::MultiRead. The
+  // whole batch is charged to rate_limiter_ like a Read.
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) const;
+
+  // Reads ahead the range in the background, see RandomAccessFile::Prefetch.
+  Status Prefetch(uint64_t offset, size_t n) const {
+    return file_->Prefetch(offset, n);
+  }
+
   RandomAccessFile* file() { return file_.get(); }
+
+  Env* env() const { return env_; }
+
+  RateLimiter* rate_limiter() const { return rate_limiter_; }
+
+  bool for_compaction() const { return for_compaction_; }
+
+ private:
+  void ChargeRateLimiter(size_t n) const;
 };
 
 // Use posix write to write data to a file.
@@ -107,6 +135,7 @@ class WritableFileWriter {
   const bool              use_os_buffer_;
   uint64_t                last_sync_size_;
   uint64_t                bytes_per_sync_;
+  RateLimiter*            rate_limiter_;
 
  public:
   WritableFileWriter(std::unique_ptr<WritableFile>&& file,
@@ -121,7 +150,8 @@ class WritableFileWriter {
         direct_io_(writable_file_->UseDirectIO()),
         use_os_buffer_(writable_file_->UseOSBuffer()),
         last_sync_size_(0),
-        bytes_per_sync_(options.bytes_per_sync) {
+        bytes_per_sync_(options.bytes_per_sync),
+        rate_limiter_(options.rate_limiter) {
 
     buf_.Alignment(writable_file_->GetRequiredBufferAlignment());
     buf_.AllocateNewBuffer(65536);
@@ -12,6 +12,7 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include "vidardb/slice.h"
 
 namespace vidardb {
 
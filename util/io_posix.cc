@@ -18,6 +18,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <algorithm>
+#include <memory>
 #if defined(OS_LINUX)
 #include <linux/fs.h>
 #endif
@@ -32,6 +33,10 @@
 #include <sys/statfs.h>
 #include <sys/syscall.h>
 #endif
+#ifdef VIDARDB_IOURING_PRESENT
+#include <linux/io_uring.h>
+#endif
+#include <vector>
 #include "port/port.h"
 #include "vidardb/slice.h"
 #include "util/coding.h"
@@ -39,6 +44,7 @@
 #include "util/posix_logger.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
+#include "util/thread_local.h"
 
 namespace vidardb {
 
@@ -157,8 +163,7 @@ Status ReadUnaligned(int fd, Slice* data, const uint64_t offset,
 
 Status DirectIORead(int fd, Slice* result, size_t off, size_t n,
                     char* scratch) {
-  if (IsSectorAligned(off) && IsSectorAligned(n) &&
-      IsPageAligned(result->data())) {
+  if (IsSectorAligned(off) && IsSectorAligned(n) && IsPageAligned(scratch)) {
     return ReadAligned(fd, result, off, n, scratch);
   }
   return ReadUnaligned(fd, result, off, n, scratch);
@@ -296,6 +301,154 @@ size_t PosixHelper::GetUniqueIdFromFile(int fd, char* id, size_t max_size) {
   return static_cast<size_t>(rid - id);
 }
 #endif
+#ifdef VIDARDB_IOURING_PRESENT
+/*
+ * IOUring
+ */
+IOUring::IOUring(int ring_fd)
+    : ring_fd_(ring_fd),
+      num_pending_(0),
+      sq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      sq_entries_(0),
+      sqes_(MAP_FAILED),
+      sqes_size_(0),
+      cq_ring_(MAP_FAILED),
+      cq_ring_size_(0) {}
+
+IOUring::~IOUring() {
+  if (cq_ring_ != MAP_FAILED) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sqes_ != MAP_FAILED) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  close(ring_fd_);
+}
+
+IOUring* IOUring::Create(unsigned entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd < 0) {
+    return nullptr;
+  }
+  std::unique_ptr<IOUring> ring(new IOUring(fd));
+
+  ring->sq_ring_size_ =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->sq_ring_ = mmap(nullptr, ring->sq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  ring->sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes_ = mmap(nullptr, ring->sqes_size_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  ring->cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  ring->cq_ring_ = mmap(nullptr, ring->cq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  if (ring->sq_ring_ == MAP_FAILED || ring->sqes_ == MAP_FAILED ||
+      ring->cq_ring_ == MAP_FAILED) {
+    return nullptr;
+  }
+
+  char* sq = static_cast<char*>(ring->sq_ring_);
+  ring->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  ring->sq_entries_ = params.sq_entries;
+  char* cq = static_cast<char*>(ring->cq_ring_);
+  ring->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes_ = cq + params.cq_off.cqes;
+  return ring.release();
+}
+
+void IOUring::PrepareRead(int fd, char* buf, unsigned n, uint64_t offset,
+                          uint64_t user_data) {
+  assert(num_pending_ < sq_entries_);
+  // only this thread moves the tail, the kernel moves the head
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = n;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  // publish the entry before the new tail
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  num_pending_++;
+}
+
+int IOUring::SubmitAndWait(unsigned wait_nr) {
+  int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_,
+                                     num_pending_, wait_nr,
+                                     IORING_ENTER_GETEVENTS, nullptr, 0));
+  if (ret < 0) {
+    return -errno;
+  }
+  num_pending_ -= ret;
+  return ret;
+}
+
+bool IOUring::PopCompletion(uint64_t* user_data, int* res) {
+  unsigned head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  const struct io_uring_cqe* cqe =
+      static_cast<const struct io_uring_cqe*>(cqes_) + (head & *cq_mask_);
+  *user_data = cqe->user_data;
+  *res = cqe->res;
+  // hand the entry back to the kernel
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+namespace {
+const unsigned kIOUringEntries = 64;
+
+void DeleteIOUring(void* ptr) { delete static_cast<IOUring*>(ptr); }
+
+ThreadLocalPtr* ThreadLocalIOUrings() {
+  static ThreadLocalPtr* rings = new ThreadLocalPtr(&DeleteIOUring);
+  return rings;
+}
+
+// Returns the ring of the calling thread, shared by all its files, or
+// nullptr if the kernel doesn't support io_uring.
+IOUring* GetThreadLocalIOUring() {
+  static std::atomic<bool> unsupported(false);
+  ThreadLocalPtr* rings = ThreadLocalIOUrings();
+  IOUring* ring = static_cast<IOUring*>(rings->Get());
+  if (ring == nullptr && !unsupported.load(std::memory_order_relaxed)) {
+    ring = IOUring::Create(kIOUringEntries);
+    if (ring == nullptr) {
+      unsupported.store(true, std::memory_order_relaxed);
+    } else {
+      rings->Reset(ring);
+    }
+  }
+  return ring;
+}
+
+// Drops the ring of the calling thread after a failure, so that the reads
+// left in it are never submitted. The next MultiRead sets up a new one.
+void ResetThreadLocalIOUring() {
+  ThreadLocalPtr* rings = ThreadLocalIOUrings();
+  DeleteIOUring(rings->Get());
+  rings->Reset(nullptr);
+}
+}  // namespace
+#endif  // VIDARDB_IOURING_PRESENT
+
 /*
  * PosixRandomAccessFile
  *
@@ -304,7 +457,9 @@ size_t PosixHelper::GetUniqueIdFromFile(int fd, char* id, size_t max_size) {
 PosixRandomAccessFile::PosixRandomAccessFile(const std::string& fname, int fd,
                                              const EnvOptions& options)
     : /*filename_(fname),*/ RandomAccessFile(fname),  // Shichao
-      fd_(fd), use_os_buffer_(options.use_os_buffer) {
+      fd_(fd),
+      use_os_buffer_(options.use_os_buffer),
+      use_io_uring_(options.use_io_uring) {
   assert(!options.use_mmap_reads || sizeof(void*) < 8);
 }
 
@@ -345,6 +500,85 @@ Status PosixRandomAccessFile::Read(uint64_t offset, size_t n, Slice* result,
   return s;
 }
 
+Status PosixRandomAccessFile::MultiRead(ReadRequest* reqs, size_t num_reqs) {
+#ifdef VIDARDB_IOURING_PRESENT
+  IOUring* ring = use_io_uring_ ? GetThreadLocalIOUring() : nullptr;
+  if (ring != nullptr) {
+    return MultiReadWithIOUring(ring, reqs, num_reqs);
+  }
+#endif
+  return RandomAccessFile::MultiRead(reqs, num_reqs);
+}
+
+#ifdef VIDARDB_IOURING_PRESENT
+Status PosixRandomAccessFile::MultiReadWithIOUring(IOUring* ring,
+                                                   ReadRequest* reqs,
+                                                   size_t num_reqs) {
+  // the bytes read so far by every request
+  std::vector<size_t> done(num_reqs, 0);
+  // the requests to submit again after a short read
+  std::vector<size_t> resubmit;
+  size_t next = 0;
+  unsigned num_inflight = 0;
+  while (next < num_reqs || !resubmit.empty() || num_inflight > 0) {
+    while (num_inflight < ring->entries() &&
+           (next < num_reqs || !resubmit.empty())) {
+      size_t i;
+      if (!resubmit.empty()) {
+        i = resubmit.back();
+        resubmit.pop_back();
+      } else {
+        i = next++;
+        reqs[i].status = Status::OK();
+      }
+      // larger reads are finished by the resubmissions
+      size_t n = std::min(reqs[i].len - done[i], static_cast<size_t>(1) << 30);
+      ring->PrepareRead(fd_, reqs[i].scratch + done[i],
+                        static_cast<unsigned>(n), reqs[i].offset + done[i], i);
+      num_inflight++;
+    }
+
+    int ret = ring->SubmitAndWait(1);
+    if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+      ResetThreadLocalIOUring();
+      return IOError(filename_, -ret);
+    }
+
+    uint64_t i;
+    int res;
+    while (ring->PopCompletion(&i, &res)) {
+      num_inflight--;
+      ReadRequest& req = reqs[i];
+      if (res > 0) {
+        done[i] += res;
+        if (done[i] < req.len) {
+          resubmit.push_back(i);
+        } else {
+          req.result = Slice(req.scratch, done[i]);
+        }
+      } else if (res == 0) {
+        // end of file
+        req.result = Slice(req.scratch, done[i]);
+      } else if (res == -EINTR || res == -EAGAIN) {
+        resubmit.push_back(i);
+      } else {
+        // e.g. an old kernel without IORING_OP_READ, pread reports the
+        // real errors
+        req.status = Read(req.offset, req.len, &req.result, req.scratch);
+      }
+    }
+  }
+
+  if (!use_os_buffer_) {
+    for (size_t i = 0; i < num_reqs; i++) {
+      Fadvise(fd_, static_cast<off_t>(reqs[i].offset),
+              static_cast<off_t>(reqs[i].result.size()), POSIX_FADV_DONTNEED);
+    }
+  }
+  return Status::OK();
+}
+#endif  // VIDARDB_IOURING_PRESENT
+
 #if defined(OS_LINUX) || defined(OS_MACOSX)
 size_t PosixRandomAccessFile::GetUniqueId(char* id, size_t max_size) const {
   return PosixHelper::GetUniqueIdFromFile(fd_, id, max_size);
@@ -387,6 +621,23 @@ Status PosixRandomAccessFile::InvalidateCache(size_t offset, size_t length) {
 #endif
 }
 
+Status PosixRandomAccessFile::Prefetch(uint64_t offset, size_t n) {
+#ifndef OS_LINUX
+  return Status::NotSupported("Prefetch not supported.");
+#else
+  if (!use_os_buffer_) {
+    // the pages would be dropped right after the reads
+    return Status::NotSupported("Prefetch not supported without OS buffer.");
+  }
+  // the kernel starts the reads into the page cache and returns
+  int ret = Fadvise(fd_, static_cast<off_t>(offset), n, POSIX_FADV_WILLNEED);
+  if (ret == 0) {
+    return Status::OK();
+  }
+  return IOError(filename_, errno);
+#endif
+}
+
 /*
  * PosixDirectIORandomAccessFile
  */
@@ -447,6 +698,19 @@ Status PosixMmapReadableFile::InvalidateCache(size_t offset, size_t length) {
 #endif
 }
 
+Status PosixMmapReadableFile::Prefetch(uint64_t offset, size_t n) {
+#ifndef OS_LINUX
+  return Status::NotSupported("Prefetch not supported.");
+#else
+  // the mapped pages are the ones of the page cache
+  int ret = Fadvise(fd_, static_cast<off_t>(offset), n, POSIX_FADV_WILLNEED);
+  if (ret == 0) {
+    return Status::OK();
+  }
+  return IOError(filename_, errno);
+#endif
+}
+
 /*
  * PosixMmapFile
  *
@@ -840,7 +1104,30 @@ Status PosixDirectIOWritableFile::PositionedAppend(const Slice& data,
       !IsPageAligned(data.data())) {
     return Status::IOError("offset or size is not aligned");
   }
-  return PosixWritableFile::PositionedAppend(data, offset);
+  const char* src = data.data();
+  size_t left = data.size();
+  while (left != 0) {
+    ssize_t done = pwrite(fd_, src, left, static_cast<off_t>(offset));
+    if (done < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return IOError(filename_, errno);
+    }
+    left -= done;
+    offset += done;
+    src += done;
+  }
+  filesize_ = offset;
+  return Status::OK();
+}
+
+Status PosixDirectIOWritableFile::Truncate(uint64_t size) {
+  if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    return IOError(filename_, errno);
+  }
+  filesize_ = size;
+  return Status::OK();
 }
 
 /*
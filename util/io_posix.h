@@ -72,11 +72,63 @@ class PosixDirectIOSequentialFile : public SequentialFile {
   std::atomic<size_t> off_{0};  // read offset
 };
 
+#ifdef VIDARDB_IOURING_PRESENT
+// A minimal io_uring for batched reads, set up through the raw system
+// calls. Not thread-safe: every thread uses its own ring, see
+// PosixRandomAccessFile::MultiRead.
+class IOUring {
+ public:
+  // Returns nullptr if the kernel can't set up a ring of the given number
+  // of entries.
+  static IOUring* Create(unsigned entries);
+  ~IOUring();
+
+  // The most reads in flight at once.
+  unsigned entries() const { return sq_entries_; }
+
+  // Queues a read of n bytes at offset of fd into buf, to be submitted by
+  // the next SubmitAndWait. At most entries() reads may be in flight.
+  void PrepareRead(int fd, char* buf, unsigned n, uint64_t offset,
+                   uint64_t user_data);
+
+  // Submits the queued reads and waits until at least wait_nr reads
+  // complete. Returns the number of reads submitted, or -errno.
+  int SubmitAndWait(unsigned wait_nr);
+
+  // Pops a completed read, returns false if there is none.
+  bool PopCompletion(uint64_t* user_data, int* res);
+
+ private:
+  explicit IOUring(int ring_fd);
+
+  int ring_fd_;
+  // reads queued but not submitted yet
+  unsigned num_pending_;
+
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  unsigned* sq_tail_;
+  unsigned* sq_mask_;
+  unsigned* sq_array_;
+  unsigned sq_entries_;
+  void* sqes_;
+  size_t sqes_size_;
+
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned* cq_mask_;
+  void* cqes_;
+};
+#endif  // VIDARDB_IOURING_PRESENT
+
 class PosixRandomAccessFile : public RandomAccessFile {
  protected:
 //  std::string filename_;  // Shichao
   int fd_;
   bool use_os_buffer_;
+  bool use_io_uring_;
 
  public:
   PosixRandomAccessFile(const std::string& fname, int fd,
@@ -85,11 +137,19 @@ class PosixRandomAccessFile : public RandomAccessFile {
 
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const override;
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs) override;
 #if defined(OS_LINUX) || defined(OS_MACOSX)
   virtual size_t GetUniqueId(char* id, size_t max_size) const override;
 #endif
   virtual void Hint(AccessPattern pattern) override;
   virtual Status InvalidateCache(size_t offset, size_t length) override;
+  virtual Status Prefetch(uint64_t offset, size_t n) override;
+
+#ifdef VIDARDB_IOURING_PRESENT
+ private:
+  Status MultiReadWithIOUring(IOUring* ring, ReadRequest* reqs,
+                              size_t num_reqs);
+#endif
 };
 
 // Direct IO random access file direct IO implementation
@@ -105,6 +165,10 @@ class PosixDirectIORandomAccessFile : public PosixRandomAccessFile {
   Status InvalidateCache(size_t offset, size_t length) override {
     return Status::OK();
   }
+  // The reads bypass the OS page cache the prefetch would fill.
+  Status Prefetch(uint64_t offset, size_t n) override {
+    return Status::NotSupported("Prefetch not supported with direct IO.");
+  }
 };
 
 class PosixWritableFile : public WritableFile {
@@ -150,6 +214,8 @@ class PosixDirectIOWritableFile : public PosixWritableFile {
   size_t GetRequiredBufferAlignment() const override { return 4 * 1024; }
   Status Append(const Slice& data) override;
   Status PositionedAppend(const Slice& data, uint64_t offset) override;
+  // The whole pages written leave padding past the end of the data.
+  Status Truncate(uint64_t size) override;
   bool UseDirectIO() const override { return true; }
   Status InvalidateCache(size_t offset, size_t length) override {
     return Status::OK();
@@ -170,6 +236,7 @@ class PosixMmapReadableFile : public RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const override;
   virtual Status InvalidateCache(size_t offset, size_t length) override;
+  virtual Status Prefetch(uint64_t offset, size_t n) override;
 };
 
 class PosixMmapFile : public WritableFile {
@@ -48,6 +48,9 @@ struct LRUHandle {
   uint32_t refs;     // a number of refs to this entry
                      // cache itself is counted as 1
   bool in_cache;     // true, if this entry is referenced by the hash table
+  bool is_high_pri;  // true, if inserted with Cache::Priority::HIGH
+  bool in_high_pri_pool;  // true, if on the LRU list in the high-pri pool
+  bool in_window;    // true, if on the admission window instead of the LRU
   uint32_t hash;     // Hash of key(); used for fast sharding and comparisons
   char key_data[1];  // Beginning of key
 
@@ -72,6 +72,10 @@ void MutableCFOptions::Dump(Logger* log) const {
       disable_auto_compactions);
   Log(log, "       level0_file_num_compaction_trigger: %d",
       level0_file_num_compaction_trigger);
+  Log(log, "      soft_pending_compaction_bytes_limit: %" PRIu64,
+      soft_pending_compaction_bytes_limit);
+  Log(log, "      hard_pending_compaction_bytes_limit: %" PRIu64,
+      hard_pending_compaction_bytes_limit);
   Log(log, "           max_grandparent_overlap_factor: %d",
       max_grandparent_overlap_factor);
   Log(log, "               expanded_compaction_factor: %d",
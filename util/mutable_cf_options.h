@@ -20,6 +20,10 @@ struct MutableCFOptions {
         disable_auto_compactions(options.disable_auto_compactions),
         level0_file_num_compaction_trigger(
             options.level0_file_num_compaction_trigger),
+        soft_pending_compaction_bytes_limit(
+            options.soft_pending_compaction_bytes_limit),
+        hard_pending_compaction_bytes_limit(
+            options.hard_pending_compaction_bytes_limit),
         compaction_pri(options.compaction_pri),
         max_grandparent_overlap_factor(options.max_grandparent_overlap_factor),
         expanded_compaction_factor(options.expanded_compaction_factor),
@@ -44,6 +48,8 @@ struct MutableCFOptions {
         arena_block_size(0),
         disable_auto_compactions(false),
         level0_file_num_compaction_trigger(0),
+        soft_pending_compaction_bytes_limit(0),
+        hard_pending_compaction_bytes_limit(0),
         compaction_pri(kByCompensatedSize),
         max_grandparent_overlap_factor(0),
         expanded_compaction_factor(0),
@@ -86,6 +92,8 @@ struct MutableCFOptions {
   // Compaction related options
   bool disable_auto_compactions;
   int level0_file_num_compaction_trigger;
+  uint64_t soft_pending_compaction_bytes_limit;
+  uint64_t hard_pending_compaction_bytes_limit;
   CompactionPri compaction_pri;
   int max_grandparent_overlap_factor;
   int expanded_compaction_factor;
@@ -25,9 +25,11 @@
 #include "vidardb/cache.h"
 #include "vidardb/comparator.h"
 #include "vidardb/env.h"
+#include "vidardb/rate_limiter.h"
 #include "vidardb/sst_file_manager.h"
 #include "vidardb/memtablerep.h"
 #include "vidardb/slice.h"
+#include "vidardb/slice_transform.h"
 #include "vidardb/table.h"
 #include "vidardb/table_properties.h"
 #include "table/block_based_table_factory.h"
@@ -41,14 +43,19 @@ ImmutableCFOptions::ImmutableCFOptions(const Options& options)
       compaction_options_fifo(options.compaction_options_fifo),
       comparator(options.comparator),
       splitter(options.splitter.get()),
+      prefix_extractor(options.prefix_extractor.get()),
       info_log(options.info_log.get()),
       statistics(options.statistics.get()),
+      block_access_tracer(options.block_access_tracer.get()),
       env(options.env),
+      rate_limiter(options.rate_limiter.get()),
       delayed_write_rate(options.delayed_write_rate),
       allow_mmap_reads(options.allow_mmap_reads),
       allow_mmap_writes(options.allow_mmap_writes),
       db_paths(options.db_paths),
       memtable_factory(options.memtable_factory.get()),
+      memtable_prefix_bloom_size_ratio(
+          options.memtable_prefix_bloom_size_ratio),
       table_factory(options.table_factory.get()),
       table_properties_collector_factories(
           options.table_properties_collector_factories),
@@ -63,12 +70,14 @@ ImmutableCFOptions::ImmutableCFOptions(const Options& options)
           options.new_table_reader_for_compaction_inputs),
       compaction_readahead_size(options.compaction_readahead_size),
       num_levels(options.num_levels),
+      enable_pipelined_flush(options.enable_pipelined_flush),
       listeners(options.listeners),
       row_cache(options.row_cache) {}
 
 ColumnFamilyOptions::ColumnFamilyOptions()
     : comparator(BytewiseComparator()),
       splitter(nullptr),  // compatible with row store
+      prefix_extractor(nullptr),
       write_buffer_size(512 << 20),
       max_write_buffer_number(2),
       min_write_buffer_number_to_merge(1),
@@ -86,11 +95,14 @@ ColumnFamilyOptions::ColumnFamilyOptions()
       source_compaction_factor(1),
       max_grandparent_overlap_factor(10),
       arena_block_size(0),
+      soft_pending_compaction_bytes_limit(64 * 1073741824ull),
+      hard_pending_compaction_bytes_limit(256 * 1073741824ull),
       disable_auto_compactions(false),
       compaction_style(kCompactionStyleLevel),
       compaction_pri(kByCompensatedSize),
       verify_checksums_in_compaction(true),
       memtable_factory(std::shared_ptr<SkipListFactory>(new SkipListFactory)),
+      memtable_prefix_bloom_size_ratio(0),
       table_factory(
           std::shared_ptr<TableFactory>(new BlockBasedTableFactory())),
       paranoid_file_checks(false),
@@ -101,6 +113,7 @@ ColumnFamilyOptions::ColumnFamilyOptions()
 ColumnFamilyOptions::ColumnFamilyOptions(const Options& options)
     : comparator(options.comparator),
       splitter(options.splitter),
+      prefix_extractor(options.prefix_extractor),
       write_buffer_size(options.write_buffer_size),
       max_write_buffer_number(options.max_write_buffer_number),
       min_write_buffer_number_to_merge(
@@ -124,12 +137,18 @@ ColumnFamilyOptions::ColumnFamilyOptions(const Options& options)
       source_compaction_factor(options.source_compaction_factor),
       max_grandparent_overlap_factor(options.max_grandparent_overlap_factor),
       arena_block_size(options.arena_block_size),
+      soft_pending_compaction_bytes_limit(
+          options.soft_pending_compaction_bytes_limit),
+      hard_pending_compaction_bytes_limit(
+          options.hard_pending_compaction_bytes_limit),
       disable_auto_compactions(options.disable_auto_compactions),
       compaction_style(options.compaction_style),
       compaction_pri(options.compaction_pri),
       verify_checksums_in_compaction(options.verify_checksums_in_compaction),
       compaction_options_fifo(options.compaction_options_fifo),
       memtable_factory(options.memtable_factory),
+      memtable_prefix_bloom_size_ratio(
+          options.memtable_prefix_bloom_size_ratio),
       table_factory(options.table_factory),
       table_properties_collector_factories(
           options.table_properties_collector_factories),
@@ -149,6 +168,7 @@ DBOptions::DBOptions()
       paranoid_checks(true),
       env(Env::Default()),
       sst_file_manager(nullptr),
+      rate_limiter(nullptr),
       info_log(nullptr),
 #ifdef NDEBUG
       info_log_level(INFO_LEVEL),
@@ -157,6 +177,7 @@ DBOptions::DBOptions()
 #endif  // NDEBUG
       max_open_files(-1),
       max_file_opening_threads(16),
+      max_range_query_table_readers(0),
       max_total_wal_size(0),
       statistics(nullptr),
       disableDataSync(false),
@@ -179,12 +200,16 @@ DBOptions::DBOptions()
       manifest_preallocation_size(4 * 1024 * 1024),
       allow_os_buffer(true),
       allow_mmap_reads(false),
+      use_direct_reads(false),
+      use_direct_io_for_flush_and_compaction(false),
       allow_mmap_writes(false),
       allow_fallocate(true),
       is_fd_close_on_exec(true),
       stats_dump_period_sec(600),
       advise_random_on_open(true),
       db_write_buffer_size(0),
+      adaptive_write_buffer_sizing(false),
+      write_buffer_cache(nullptr),
       access_hint_on_compaction_start(NORMAL),
       new_table_reader_for_compaction_inputs(false),
       compaction_readahead_size(0),
@@ -194,13 +219,17 @@ DBOptions::DBOptions()
       bytes_per_sync(0),
       wal_bytes_per_sync(0),
       listeners(),
+      operation_trace_one_in(0),
+      slow_operation_micros(0),
       enable_thread_tracking(false),
       delayed_write_rate(2 * 1024U * 1024U),
       allow_concurrent_memtable_write(false),
+      enable_pipelined_flush(false),
       write_thread_slow_yield_usec(3),
       skip_stats_update_on_db_open(false),
       wal_recovery_mode(WALRecoveryMode::kPointInTimeRecovery),
       row_cache(nullptr),
+      block_access_tracer(nullptr),
       fail_if_options_file_error(false),
       dump_malloc_stats(false),
       show_key_fun(nullptr),  // Shichao
@@ -214,10 +243,12 @@ DBOptions::DBOptions(const Options& options)
       paranoid_checks(options.paranoid_checks),
       env(options.env),
       sst_file_manager(options.sst_file_manager),
+      rate_limiter(options.rate_limiter),
       info_log(options.info_log),
       info_log_level(options.info_log_level),
       max_open_files(options.max_open_files),
       max_file_opening_threads(options.max_file_opening_threads),
+      max_range_query_table_readers(options.max_range_query_table_readers),
       max_total_wal_size(options.max_total_wal_size),
       statistics(options.statistics),
       disableDataSync(options.disableDataSync),
@@ -242,12 +273,17 @@ DBOptions::DBOptions(const Options& options)
       manifest_preallocation_size(options.manifest_preallocation_size),
       allow_os_buffer(options.allow_os_buffer),
       allow_mmap_reads(options.allow_mmap_reads),
+      use_direct_reads(options.use_direct_reads),
+      use_direct_io_for_flush_and_compaction(
+          options.use_direct_io_for_flush_and_compaction),
       allow_mmap_writes(options.allow_mmap_writes),
       allow_fallocate(options.allow_fallocate),
       is_fd_close_on_exec(options.is_fd_close_on_exec),
       stats_dump_period_sec(options.stats_dump_period_sec),
       advise_random_on_open(options.advise_random_on_open),
       db_write_buffer_size(options.db_write_buffer_size),
+      adaptive_write_buffer_sizing(options.adaptive_write_buffer_sizing),
+      write_buffer_cache(options.write_buffer_cache),
       access_hint_on_compaction_start(options.access_hint_on_compaction_start),
       new_table_reader_for_compaction_inputs(
           options.new_table_reader_for_compaction_inputs),
@@ -258,13 +294,17 @@ DBOptions::DBOptions(const Options& options)
       bytes_per_sync(options.bytes_per_sync),
       wal_bytes_per_sync(options.wal_bytes_per_sync),
       listeners(options.listeners),
+      operation_trace_one_in(options.operation_trace_one_in),
+      slow_operation_micros(options.slow_operation_micros),
       enable_thread_tracking(options.enable_thread_tracking),
       delayed_write_rate(options.delayed_write_rate),
       allow_concurrent_memtable_write(options.allow_concurrent_memtable_write),
+      enable_pipelined_flush(options.enable_pipelined_flush),
       write_thread_slow_yield_usec(options.write_thread_slow_yield_usec),
       skip_stats_update_on_db_open(options.skip_stats_update_on_db_open),
       wal_recovery_mode(options.wal_recovery_mode),
       row_cache(options.row_cache),
+      block_access_tracer(options.block_access_tracer),
       fail_if_options_file_error(options.fail_if_options_file_error),
       dump_malloc_stats(options.dump_malloc_stats),
       show_key_fun(options.show_key_fun),  // Shichao
@@ -285,6 +325,8 @@ void DBOptions::Dump(Logger* log) const {
   Header(log, "\tOptions.max_open_files: %d", max_open_files);
   Header(log, "\tOptions.max_file_opening_threads: %d",
          max_file_opening_threads);
+  Header(log, "\tOptions.max_range_query_table_readers: %d",
+         max_range_query_table_readers);
   Header(log, "\tOptions.max_total_wal_size: %" PRIu64, max_total_wal_size);
   Header(log, "\tOptions.disableDataSync: %d", disableDataSync);
   Header(log, "\tOptions.use_fsync: %d", use_fsync);
@@ -300,6 +342,9 @@ void DBOptions::Dump(Logger* log) const {
          recycle_log_file_num);
   Header(log, "\tOptions.allow_os_buffer: %d", allow_os_buffer);
   Header(log, "\tOptions.allow_mmap_reads: %d", allow_mmap_reads);
+  Header(log, "\tOptions.use_direct_reads: %d", use_direct_reads);
+  Header(log, "\tOptions.use_direct_io_for_flush_and_compaction: %d",
+         use_direct_io_for_flush_and_compaction);
   Header(log, "\tOptions.allow_fallocate: %d", allow_fallocate);
   Header(log, "\tOptions.allow_mmap_writes: %d", allow_mmap_writes);
   Header(log, "\tOptions.create_missing_column_families: %d",
@@ -328,6 +373,14 @@ void DBOptions::Dump(Logger* log) const {
   Header(log, "\tOptions.advise_random_on_open: %d", advise_random_on_open);
   Header(log, "\tOptions.db_write_buffer_size: %" VIDARDB_PRIszt "d",
          db_write_buffer_size);
+  Header(log, "\tOptions.adaptive_write_buffer_sizing: %d",
+         adaptive_write_buffer_sizing);
+  if (write_buffer_cache) {
+    Header(log, "\tOptions.write_buffer_cache: %" VIDARDB_PRIszt "d",
+           write_buffer_cache->GetCapacity());
+  } else {
+    Header(log, "\tOptions.write_buffer_cache: None");
+  }
   Header(log, "\tOptions.access_hint_on_compaction_start: %s",
          access_hints[access_hint_on_compaction_start]);
   Header(log, "\tOptions.new_table_reader_for_compaction_inputs: %d",
@@ -342,12 +395,19 @@ void DBOptions::Dump(Logger* log) const {
   Header(
       log, "\tOptions.sst_file_manager.rate_bytes_per_sec: %" PRIi64,
       sst_file_manager ? sst_file_manager->GetDeleteRateBytesPerSecond() : 0);
+  Header(log, "\tOptions.rate_limiter.single_burst_bytes: %" PRIi64,
+         rate_limiter ? rate_limiter->GetSingleBurstBytes() : 0);
   Header(log, "\tOptions.bytes_per_sync: %" PRIu64, bytes_per_sync);
   Header(log, "\tOptions.wal_bytes_per_sync: %" PRIu64, wal_bytes_per_sync);
+  Header(log, "\tOptions.operation_trace_one_in: %" PRIu32,
+         operation_trace_one_in);
+  Header(log, "\tOptions.slow_operation_micros: %" PRIu64,
+         slow_operation_micros);
   Header(log, "\tOptions.wal_recovery_mode: %d", wal_recovery_mode);
   Header(log, "\tOptions.enable_thread_tracking: %d", enable_thread_tracking);
   Header(log, "\tOptions.allow_concurrent_memtable_write: %d",
          allow_concurrent_memtable_write);
+  Header(log, "\tOptions.enable_pipelined_flush: %d", enable_pipelined_flush);
   Header(log, "\tOptions.write_thread_slow_yield_usec: %" PRIu64,
          write_thread_slow_yield_usec);
   if (row_cache) {
@@ -363,7 +423,11 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
   if (splitter) {
     Header(log, "\tOptions.splitter: %s", splitter->Name());
   }
+  Header(log, "\tOptions.prefix_extractor: %s",
+         prefix_extractor == nullptr ? "nullptr" : prefix_extractor->Name());
   Header(log, "\tOptions.memtable_factory: %s", memtable_factory->Name());
+  Header(log, "\tOptions.memtable_prefix_bloom_size_ratio: %f",
+         memtable_prefix_bloom_size_ratio);
   Header(log, "\tOptions.table_factory: %s", table_factory->Name());
   Header(log, "\ttable_factory options: %s",
          table_factory->GetPrintableTableOptions().c_str());
@@ -419,6 +483,10 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
   Header(log, "\tOptions.max_grandparent_overlap_factor: %d",
          max_grandparent_overlap_factor);
   Header(log, "\tOptions.arena_block_size: %" VIDARDB_PRIszt, arena_block_size);
+  Header(log, "\tOptions.soft_pending_compaction_bytes_limit: %" PRIu64,
+         soft_pending_compaction_bytes_limit);
+  Header(log, "\tOptions.hard_pending_compaction_bytes_limit: %" PRIu64,
+         hard_pending_compaction_bytes_limit);
   Header(log, "\tOptions.disable_auto_compactions: %d",
          disable_auto_compactions);
   Header(log, "\tOptions.verify_checksums_in_compaction: %d",
@@ -597,8 +665,10 @@ ReadOptions::ReadOptions()
       read_tier(kReadAllTier),
       tailing(false),
       total_order_seek(false),
+      prefix_same_as_start(false),
       pin_data(false),
-      readahead_size(0) {}
+      readahead_size(0),
+      async_readahead_size(0) {}
 
 ReadOptions::ReadOptions(bool cksum, bool cache)
     : verify_checksums(cksum),
@@ -607,6 +677,8 @@ ReadOptions::ReadOptions(bool cksum, bool cache)
       read_tier(kReadAllTier),
       tailing(false),
       total_order_seek(false),
+      prefix_same_as_start(false),
       pin_data(false),
-      readahead_size(0) {}
+      readahead_size(0),
+      async_readahead_size(0) {}
 }  // namespace vidardb
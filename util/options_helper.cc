@@ -19,6 +19,7 @@
 #include "vidardb/convenience.h"
 #include "vidardb/memtablerep.h"
 #include "vidardb/options.h"
+#include "vidardb/slice_transform.h"
 #include "vidardb/table.h"
 
 namespace vidardb {
@@ -287,6 +288,40 @@ bool ParseVectorCompressionType(
   return true;
 }
 
+// Parses the names written by SerializeSingleOptionHelper, e.g.
+// "vidardb.FixedPrefix.4", back to the built-in slice transforms.
+bool ParseSliceTransform(
+    const std::string& value,
+    std::shared_ptr<const SliceTransform>* slice_transform) {
+  static const std::string kFixedPrefixName = "vidardb.FixedPrefix.";
+  static const std::string kCappedPrefixName = "vidardb.CappedPrefix.";
+  static const std::string kDelimiterPrefixName = "vidardb.DelimiterPrefix.";
+  if (value == "nullptr") {
+    slice_transform->reset();
+  } else if (value == "vidardb.Noop") {
+    slice_transform->reset(NewNoopTransform());
+  } else if (value.compare(0, kFixedPrefixName.size(), kFixedPrefixName) ==
+             0) {
+    slice_transform->reset(NewFixedPrefixTransform(
+        ParseSizeT(value.substr(kFixedPrefixName.size()))));
+  } else if (value.compare(0, kCappedPrefixName.size(), kCappedPrefixName) ==
+             0) {
+    slice_transform->reset(NewCappedPrefixTransform(
+        ParseSizeT(value.substr(kCappedPrefixName.size()))));
+  } else if (value.compare(0, kDelimiterPrefixName.size(),
+                           kDelimiterPrefixName) == 0) {
+    int delimiter = ParseInt(value.substr(kDelimiterPrefixName.size()));
+    if (delimiter < 0 || delimiter > 255) {
+      return false;
+    }
+    slice_transform->reset(
+        NewDelimiterPrefixTransform(static_cast<char>(delimiter)));
+  } else {
+    return false;
+  }
+  return true;
+}
+
 bool ParseOptionHelper(char* opt_address, const OptionType& opt_type,
                        const std::string& value) {
   switch (opt_type) {
@@ -337,6 +372,23 @@ bool ParseOptionHelper(char* opt_address, const OptionType& opt_type,
       return ParseEnum<InfoLogLevel>(
           info_log_level_string_map, value,
           reinterpret_cast<InfoLogLevel*>(opt_address));
+    case OptionType::kBlockBasedTableIndexType:
+      return ParseEnum<BlockBasedTableOptions::IndexType>(
+          block_base_table_index_type_string_map, value,
+          reinterpret_cast<BlockBasedTableOptions::IndexType*>(opt_address));
+    case OptionType::kBlockBasedTableDataBlockIndexType:
+      return ParseEnum<BlockBasedTableOptions::DataBlockIndexType>(
+          block_base_table_data_block_index_type_string_map, value,
+          reinterpret_cast<BlockBasedTableOptions::DataBlockIndexType*>(
+              opt_address));
+    case OptionType::kColumnTableIndexType:
+      return ParseEnum<ColumnTableOptions::IndexType>(
+          column_table_index_type_string_map, value,
+          reinterpret_cast<ColumnTableOptions::IndexType*>(opt_address));
+    case OptionType::kSliceTransform:
+      return ParseSliceTransform(
+          value, reinterpret_cast<std::shared_ptr<const SliceTransform>*>(
+                     opt_address));
     default:
       return false;
   }
@@ -416,6 +468,13 @@ bool SerializeSingleOptionHelper(const char* opt_address,
       *value = ptr->get() ? ptr->get()->Name() : kNullptrString;
       break;
     }
+    case OptionType::kSliceTransform: {
+      const auto* ptr =
+          reinterpret_cast<const std::shared_ptr<const SliceTransform>*>(
+              opt_address);
+      *value = ptr->get() ? ptr->get()->Name() : kNullptrString;
+      break;
+    }
     case OptionType::kMemTableRepFactory: {
       const auto* ptr =
           reinterpret_cast<const std::shared_ptr<MemTableRepFactory>*>(
@@ -442,6 +501,23 @@ bool SerializeSingleOptionHelper(const char* opt_address,
       return SerializeEnum<InfoLogLevel>(
           info_log_level_string_map,
           *reinterpret_cast<const InfoLogLevel*>(opt_address), value);
+    case OptionType::kBlockBasedTableIndexType:
+      return SerializeEnum<BlockBasedTableOptions::IndexType>(
+          block_base_table_index_type_string_map,
+          *reinterpret_cast<const BlockBasedTableOptions::IndexType*>(
+              opt_address),
+          value);
+    case OptionType::kBlockBasedTableDataBlockIndexType:
+      return SerializeEnum<BlockBasedTableOptions::DataBlockIndexType>(
+          block_base_table_data_block_index_type_string_map,
+          *reinterpret_cast<const BlockBasedTableOptions::DataBlockIndexType*>(
+              opt_address),
+          value);
+    case OptionType::kColumnTableIndexType:
+      return SerializeEnum<ColumnTableOptions::IndexType>(
+          column_table_index_type_string_map,
+          *reinterpret_cast<const ColumnTableOptions::IndexType*>(opt_address),
+          value);
     default:
       return false;
   }
@@ -471,6 +547,10 @@ bool ParseCompactionOptions(const std::string& name, const std::string& value,
     new_options->disable_auto_compactions = ParseBoolean(name, value);
   } else if (name == "level0_file_num_compaction_trigger") {
     new_options->level0_file_num_compaction_trigger = ParseInt(value);
+  } else if (name == "soft_pending_compaction_bytes_limit") {
+    new_options->soft_pending_compaction_bytes_limit = ParseUint64(value);
+  } else if (name == "hard_pending_compaction_bytes_limit") {
+    new_options->hard_pending_compaction_bytes_limit = ParseUint64(value);
   } else if (name == "max_grandparent_overlap_factor") {
     new_options->max_grandparent_overlap_factor = ParseInt(value);
   } else if (name == "expanded_compaction_factor") {
@@ -1261,6 +1341,10 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.disable_auto_compactions;
   cf_opts.level0_file_num_compaction_trigger =
       mutable_cf_options.level0_file_num_compaction_trigger;
+  cf_opts.soft_pending_compaction_bytes_limit =
+      mutable_cf_options.soft_pending_compaction_bytes_limit;
+  cf_opts.hard_pending_compaction_bytes_limit =
+      mutable_cf_options.hard_pending_compaction_bytes_limit;
   cf_opts.max_grandparent_overlap_factor =
       mutable_cf_options.max_grandparent_overlap_factor;
   cf_opts.expanded_compaction_factor =
@@ -85,12 +85,16 @@ enum class OptionType {
   kComparator,
   kVectorComparator,
   kSplitter,
+  kSliceTransform,
   kMemTableRepFactory,
   kFlushBlockPolicyFactory,
   kEncodingType,
   kWALRecoveryMode,
   kAccessHint,
   kInfoLogLevel,
+  kBlockBasedTableIndexType,
+  kBlockBasedTableDataBlockIndexType,
+  kColumnTableIndexType,
   kUnknown
 };
 
@@ -147,6 +151,7 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
       std::shared_ptr<Logger> info_log;
       std::shared_ptr<RateLimiter> rate_limiter;
       std::shared_ptr<Statistics> statistics;
+      std::shared_ptr<Cache> write_buffer_cache;
       std::vector<DbPath> db_paths;
       std::vector<std::shared_ptr<EventListener>> listeners;
      */
@@ -159,6 +164,12 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"allow_fallocate",
      {offsetof(struct DBOptions, allow_fallocate), OptionType::kBoolean,
       OptionVerificationType::kNormal}},
+    {"use_direct_reads",
+     {offsetof(struct DBOptions, use_direct_reads), OptionType::kBoolean,
+      OptionVerificationType::kNormal}},
+    {"use_direct_io_for_flush_and_compaction",
+     {offsetof(struct DBOptions, use_direct_io_for_flush_and_compaction),
+      OptionType::kBoolean, OptionVerificationType::kNormal}},
     {"allow_mmap_writes",
      {offsetof(struct DBOptions, allow_mmap_writes), OptionType::kBoolean,
       OptionVerificationType::kNormal}},
@@ -228,12 +239,18 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"max_open_files",
      {offsetof(struct DBOptions, max_open_files), OptionType::kInt,
       OptionVerificationType::kNormal}},
+    {"max_range_query_table_readers",
+     {offsetof(struct DBOptions, max_range_query_table_readers),
+      OptionType::kInt, OptionVerificationType::kNormal}},
     {"table_cache_numshardbits",
      {offsetof(struct DBOptions, table_cache_numshardbits), OptionType::kInt,
       OptionVerificationType::kNormal}},
     {"db_write_buffer_size",
      {offsetof(struct DBOptions, db_write_buffer_size), OptionType::kSizeT,
       OptionVerificationType::kNormal}},
+    {"adaptive_write_buffer_sizing",
+     {offsetof(struct DBOptions, adaptive_write_buffer_sizing),
+      OptionType::kBoolean, OptionVerificationType::kNormal}},
     {"keep_log_file_num",
      {offsetof(struct DBOptions, keep_log_file_num), OptionType::kSizeT,
       OptionVerificationType::kNormal}},
@@ -282,6 +299,12 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"wal_bytes_per_sync",
      {offsetof(struct DBOptions, wal_bytes_per_sync), OptionType::kUInt64T,
       OptionVerificationType::kNormal}},
+    {"operation_trace_one_in",
+     {offsetof(struct DBOptions, operation_trace_one_in),
+      OptionType::kUInt32T, OptionVerificationType::kNormal}},
+    {"slow_operation_micros",
+     {offsetof(struct DBOptions, slow_operation_micros), OptionType::kUInt64T,
+      OptionVerificationType::kNormal}},
     {"stats_dump_period_sec",
      {offsetof(struct DBOptions, stats_dump_period_sec), OptionType::kUInt,
       OptionVerificationType::kNormal}},
@@ -291,6 +314,9 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"allow_concurrent_memtable_write",
      {offsetof(struct DBOptions, allow_concurrent_memtable_write),
       OptionType::kBoolean, OptionVerificationType::kNormal}},
+    {"enable_pipelined_flush",
+     {offsetof(struct DBOptions, enable_pipelined_flush),
+      OptionType::kBoolean, OptionVerificationType::kNormal}},
     {"wal_recovery_mode",
      {offsetof(struct DBOptions, wal_recovery_mode),
       OptionType::kWALRecoveryMode, OptionVerificationType::kNormal}},
@@ -375,6 +401,12 @@ static std::unordered_map<std::string, OptionTypeInfo> cf_options_type_info = {
     {"max_bytes_for_level_base",
      {offsetof(struct ColumnFamilyOptions, max_bytes_for_level_base),
       OptionType::kUInt64T, OptionVerificationType::kNormal}},
+    {"soft_pending_compaction_bytes_limit",
+     {offsetof(struct ColumnFamilyOptions, soft_pending_compaction_bytes_limit),
+      OptionType::kUInt64T, OptionVerificationType::kNormal}},
+    {"hard_pending_compaction_bytes_limit",
+     {offsetof(struct ColumnFamilyOptions, hard_pending_compaction_bytes_limit),
+      OptionType::kUInt64T, OptionVerificationType::kNormal}},
     {"target_file_size_base",
      {offsetof(struct ColumnFamilyOptions, target_file_size_base),
       OptionType::kUInt64T, OptionVerificationType::kNormal}},
@@ -393,9 +425,15 @@ static std::unordered_map<std::string, OptionTypeInfo> cf_options_type_info = {
     {"splitter",
      {offsetof(struct ColumnFamilyOptions, splitter), OptionType::kSplitter,
       OptionVerificationType::kByName}},
+    {"prefix_extractor",
+     {offsetof(struct ColumnFamilyOptions, prefix_extractor),
+      OptionType::kSliceTransform, OptionVerificationType::kByNameAllowNull}},
     {"memtable_factory",
      {offsetof(struct ColumnFamilyOptions, memtable_factory),
       OptionType::kMemTableRepFactory, OptionVerificationType::kByName}},
+    {"memtable_prefix_bloom_size_ratio",
+     {offsetof(struct ColumnFamilyOptions, memtable_prefix_bloom_size_ratio),
+      OptionType::kDouble, OptionVerificationType::kNormal}},
     {"table_factory",
      {offsetof(struct ColumnFamilyOptions, table_factory),
       OptionType::kTableFactory, OptionVerificationType::kByName}},
@@ -408,6 +446,8 @@ static std::unordered_map<std::string, OptionTypeInfo>
         /* currently not supported
           std::shared_ptr<Cache> block_cache = nullptr;
           std::shared_ptr<Cache> block_cache_compressed = nullptr;
+          std::shared_ptr<PersistentCache> persistent_cache = nullptr;
+          std::shared_ptr<const FilterPolicy> filter_policy = nullptr;
          */
         {"block_based_table.flush_block_policy_factory",
          {offsetof(struct BlockBasedTableOptions, flush_block_policy_factory),
@@ -427,13 +467,48 @@ static std::unordered_map<std::string, OptionTypeInfo>
           OptionType::kInt, OptionVerificationType::kNormal}},
         {"block_based_table.index_block_restart_interval",
          {offsetof(struct BlockBasedTableOptions, index_block_restart_interval),
-          OptionType::kInt, OptionVerificationType::kNormal}}};
+          OptionType::kInt, OptionVerificationType::kNormal}},
+        {"block_based_table.whole_key_filtering",
+         {offsetof(struct BlockBasedTableOptions, whole_key_filtering),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"block_based_table.index_type",
+         {offsetof(struct BlockBasedTableOptions, index_type),
+          OptionType::kBlockBasedTableIndexType,
+          OptionVerificationType::kNormal}},
+        {"block_based_table.data_block_index_type",
+         {offsetof(struct BlockBasedTableOptions, data_block_index_type),
+          OptionType::kBlockBasedTableDataBlockIndexType,
+          OptionVerificationType::kNormal}},
+        {"block_based_table.data_block_hash_table_util_ratio",
+         {offsetof(struct BlockBasedTableOptions,
+                   data_block_hash_table_util_ratio),
+          OptionType::kDouble, OptionVerificationType::kNormal}},
+        {"block_based_table.metadata_block_size",
+         {offsetof(struct BlockBasedTableOptions, metadata_block_size),
+          OptionType::kUInt64T, OptionVerificationType::kNormal}},
+        {"block_based_table.cache_index_and_filter_blocks",
+         {offsetof(struct BlockBasedTableOptions,
+                   cache_index_and_filter_blocks),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"block_based_table.cache_index_and_filter_blocks_with_high_priority",
+         {offsetof(struct BlockBasedTableOptions,
+                   cache_index_and_filter_blocks_with_high_priority),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"block_based_table.pin_l0_filter_and_index_blocks_in_cache",
+         {offsetof(struct BlockBasedTableOptions,
+                   pin_l0_filter_and_index_blocks_in_cache),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"block_based_table.pin_top_level_index",
+         {offsetof(struct BlockBasedTableOptions, pin_top_level_index),
+          OptionType::kBoolean, OptionVerificationType::kNormal}}};
 
 static std::unordered_map<std::string, OptionTypeInfo> column_table_type_info =
     {
         /* currently not supported
           std::shared_ptr<Cache> block_cache = nullptr;
           std::shared_ptr<Cache> block_cache_compressed = nullptr;
+          std::shared_ptr<PersistentCache> persistent_cache = nullptr;
+          std::shared_ptr<const FilterPolicy> filter_policy = nullptr;
          */
         {"column_table.flush_block_policy_factory",
          {offsetof(struct ColumnTableOptions, flush_block_policy_factory),
@@ -454,6 +529,29 @@ static std::unordered_map<std::string, OptionTypeInfo> column_table_type_info =
         {"column_table.index_block_restart_interval",
          {offsetof(struct ColumnTableOptions, index_block_restart_interval),
           OptionType::kInt, OptionVerificationType::kNormal}},
+        {"column_table.index_type",
+         {offsetof(struct ColumnTableOptions, index_type),
+          OptionType::kColumnTableIndexType, OptionVerificationType::kNormal}},
+        {"column_table.metadata_block_size",
+         {offsetof(struct ColumnTableOptions, metadata_block_size),
+          OptionType::kUInt64T, OptionVerificationType::kNormal}},
+        {"column_table.cache_index_and_filter_blocks",
+         {offsetof(struct ColumnTableOptions, cache_index_and_filter_blocks),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"column_table.cache_index_and_filter_blocks_with_high_priority",
+         {offsetof(struct ColumnTableOptions,
+                   cache_index_and_filter_blocks_with_high_priority),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"column_table.pin_l0_filter_and_index_blocks_in_cache",
+         {offsetof(struct ColumnTableOptions,
+                   pin_l0_filter_and_index_blocks_in_cache),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"column_table.pin_top_level_index",
+         {offsetof(struct ColumnTableOptions, pin_top_level_index),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
+        {"column_table.whole_key_filtering",
+         {offsetof(struct ColumnTableOptions, whole_key_filtering),
+          OptionType::kBoolean, OptionVerificationType::kNormal}},
         {"column_table.column_count",
          {offsetof(struct ColumnTableOptions, column_count),
           OptionType::kUInt32T, OptionVerificationType::kNormal}},
@@ -489,6 +587,27 @@ static std::unordered_map<std::string, DBOptions::AccessHint>
                               {"SEQUENTIAL", DBOptions::AccessHint::SEQUENTIAL},
                               {"WILLNEED", DBOptions::AccessHint::WILLNEED}};
 
+static std::unordered_map<std::string, BlockBasedTableOptions::IndexType>
+    block_base_table_index_type_string_map = {
+        {"kBinarySearch", BlockBasedTableOptions::IndexType::kBinarySearch},
+        {"kHashSearch", BlockBasedTableOptions::IndexType::kHashSearch},
+        {"kTwoLevelIndexSearch",
+         BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch}};
+
+static std::unordered_map<std::string,
+                          BlockBasedTableOptions::DataBlockIndexType>
+    block_base_table_data_block_index_type_string_map = {
+        {"kDataBlockBinarySearch",
+         BlockBasedTableOptions::DataBlockIndexType::kDataBlockBinarySearch},
+        {"kDataBlockBinaryAndHash",
+         BlockBasedTableOptions::DataBlockIndexType::kDataBlockBinaryAndHash}};
+
+static std::unordered_map<std::string, ColumnTableOptions::IndexType>
+    column_table_index_type_string_map = {
+        {"kBinarySearch", ColumnTableOptions::IndexType::kBinarySearch},
+        {"kTwoLevelIndexSearch",
+         ColumnTableOptions::IndexType::kTwoLevelIndexSearch}};
+
 static std::unordered_map<std::string, InfoLogLevel> info_log_level_string_map =
     {{"DEBUG_LEVEL", InfoLogLevel::DEBUG_LEVEL},
      {"INFO_LEVEL", InfoLogLevel::INFO_LEVEL},
@@ -558,6 +558,21 @@ bool AreEqualOptions(
     case OptionType::kInfoLogLevel:
       return (*reinterpret_cast<const InfoLogLevel*>(offset1) ==
               *reinterpret_cast<const InfoLogLevel*>(offset2));
+    case OptionType::kBlockBasedTableIndexType:
+      return (
+          *reinterpret_cast<const BlockBasedTableOptions::IndexType*>(
+              offset1) ==
+          *reinterpret_cast<const BlockBasedTableOptions::IndexType*>(offset2));
+    case OptionType::kBlockBasedTableDataBlockIndexType:
+      return (
+          *reinterpret_cast<const BlockBasedTableOptions::DataBlockIndexType*>(
+              offset1) ==
+          *reinterpret_cast<const BlockBasedTableOptions::DataBlockIndexType*>(
+              offset2));
+    case OptionType::kColumnTableIndexType:
+      return (
+          *reinterpret_cast<const ColumnTableOptions::IndexType*>(offset1) ==
+          *reinterpret_cast<const ColumnTableOptions::IndexType*>(offset2));
     default:
       if (type_info.verification == OptionVerificationType::kByName ||
           type_info.verification == OptionVerificationType::kByNameAllowNull) {
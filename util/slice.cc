@@ -8,12 +8,129 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include <algorithm>
+#include "vidardb/slice_transform.h"
 #include "vidardb/slice.h"
 #include "util/string_util.h"
 #include <stdio.h>
+#include <string.h>
 
 namespace vidardb {
 
+namespace {
+
+class FixedPrefixTransform : public SliceTransform {
+ private:
+  size_t prefix_len_;
+  std::string name_;
+
+ public:
+  explicit FixedPrefixTransform(size_t prefix_len)
+      : prefix_len_(prefix_len),
+        name_("vidardb.FixedPrefix." + ToString(prefix_len_)) {}
+
+  virtual const char* Name() const override { return name_.c_str(); }
+
+  virtual Slice Transform(const Slice& src) const override {
+    assert(InDomain(src));
+    return Slice(src.data(), prefix_len_);
+  }
+
+  virtual bool InDomain(const Slice& src) const override {
+    return (src.size() >= prefix_len_);
+  }
+
+  virtual bool InRange(const Slice& dst) const override {
+    return (dst.size() == prefix_len_);
+  }
+};
+
+class CappedPrefixTransform : public SliceTransform {
+ private:
+  size_t cap_len_;
+  std::string name_;
+
+ public:
+  explicit CappedPrefixTransform(size_t cap_len)
+      : cap_len_(cap_len),
+        name_("vidardb.CappedPrefix." + ToString(cap_len_)) {}
+
+  virtual const char* Name() const override { return name_.c_str(); }
+
+  virtual Slice Transform(const Slice& src) const override {
+    assert(InDomain(src));
+    return Slice(src.data(), std::min(cap_len_, src.size()));
+  }
+
+  virtual bool InDomain(const Slice& src) const override { return true; }
+
+  virtual bool InRange(const Slice& dst) const override {
+    return (dst.size() <= cap_len_);
+  }
+};
+
+class DelimiterPrefixTransform : public SliceTransform {
+ private:
+  char delimiter_;
+  std::string name_;
+
+ public:
+  explicit DelimiterPrefixTransform(char delimiter)
+      : delimiter_(delimiter),
+        name_("vidardb.DelimiterPrefix." +
+              ToString(static_cast<int>(static_cast<unsigned char>(
+                  delimiter_)))) {}
+
+  virtual const char* Name() const override { return name_.c_str(); }
+
+  virtual Slice Transform(const Slice& src) const override {
+    assert(InDomain(src));
+    const char* p =
+        static_cast<const char*>(memchr(src.data(), delimiter_, src.size()));
+    return Slice(src.data(), p - src.data() + 1);
+  }
+
+  virtual bool InDomain(const Slice& src) const override {
+    return memchr(src.data(), delimiter_, src.size()) != nullptr;
+  }
+
+  virtual bool InRange(const Slice& dst) const override {
+    return !dst.empty() && dst[dst.size() - 1] == delimiter_ &&
+           memchr(dst.data(), delimiter_, dst.size()) ==
+               dst.data() + dst.size() - 1;
+  }
+};
+
+class NoopTransform : public SliceTransform {
+ public:
+  explicit NoopTransform() { }
+
+  virtual const char* Name() const override { return "vidardb.Noop"; }
+
+  virtual Slice Transform(const Slice& src) const override { return src; }
+
+  virtual bool InDomain(const Slice& src) const override { return true; }
+
+  virtual bool InRange(const Slice& dst) const override { return true; }
+};
+
+}  // namespace
+
+const SliceTransform* NewFixedPrefixTransform(size_t prefix_len) {
+  return new FixedPrefixTransform(prefix_len);
+}
+
+const SliceTransform* NewCappedPrefixTransform(size_t cap_len) {
+  return new CappedPrefixTransform(cap_len);
+}
+
+const SliceTransform* NewDelimiterPrefixTransform(char delimiter) {
+  return new DelimiterPrefixTransform(delimiter);
+}
+
+const SliceTransform* NewNoopTransform() {
+  return new NoopTransform;
+}
+
 Slice::Slice(const SliceParts& parts, std::string* buf) {
   size_t length = 0;
   for (int i = 0; i < parts.num_parts; ++i) {
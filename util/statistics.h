@@ -10,6 +10,7 @@
 #include <atomic>
 #include <string>
 
+#include "util/core_local.h"
 #include "util/histogram.h"
 #include "util/mutexlock.h"
 #include "port/likely.h"
@@ -51,25 +52,36 @@ class StatisticsImpl : public Statistics {
   Statistics* stats_;
   bool enable_internal_stats_;
 
-  struct Ticker {
-    Ticker() : value(uint_fast64_t()) {}
-
-    std::atomic_uint_fast64_t value;
-    // Pad the structure to make it size of 64 bytes. A plain array of
-    // std::atomic_uint_fast64_t results in huge performance degradataion
-    // due to false sharing.
-    char padding[64 - sizeof(std::atomic_uint_fast64_t)];
+  // Serializes setTickerCount() against the other writers of the shards.
+  mutable port::Mutex aggregate_lock_;
+
+  // The tickers and histograms recorded on one core, which are summed up
+  // over all the cores when they are read. The tickers of a core share
+  // cache lines, only the cores are kept apart.
+  struct StatisticsData {
+    StatisticsData() {
+      for (auto& ticker : tickers_) {
+        ticker.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    std::atomic_uint_fast64_t tickers_[INTERNAL_TICKER_ENUM_MAX];
+    HistogramImpl histograms_[INTERNAL_HISTOGRAM_ENUM_MAX];
+    // Pad the structure to a multiple of 64 bytes, so two cores do not
+    // false share the line at their boundary.
+    char padding[64 - (INTERNAL_TICKER_ENUM_MAX *
+                           sizeof(std::atomic_uint_fast64_t) +
+                       INTERNAL_HISTOGRAM_ENUM_MAX * sizeof(HistogramImpl)) %
+                          64];
   };
 
-  static_assert(sizeof(Ticker) == 64, "Expecting to fit into 64 bytes");
+  CoreLocalArray<StatisticsData> per_core_stats_;
 
-  // Attributes expand to nothing depending on the platform
-  //  __declspec(align(64))
-  Ticker tickers_[INTERNAL_TICKER_ENUM_MAX];
-  //     __attribute__((aligned(64)));
-  //  __declspec(align(64))
-  HistogramImpl histograms_[INTERNAL_HISTOGRAM_ENUM_MAX];
-  //      __attribute__((aligned(64)));
+  uint64_t getTickerCountLocked(uint32_t ticker_type) const;
+  void setTickerCountLocked(uint32_t ticker_type, uint64_t count);
+  // Merges the histogram of all the cores into a new one.
+  std::unique_ptr<HistogramImpl> getHistogramImplLocked(
+      uint32_t histogram_type) const;
 };
 
 // Utility functions
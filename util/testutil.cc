@@ -15,6 +15,7 @@
 
 #include "port/port.h"
 #include "util/file_reader_writer.h"
+#include "vidardb/slice_transform.h"
 
 namespace vidardb {
 namespace test {
@@ -183,6 +184,17 @@ BlockBasedTableOptions RandomBlockBasedTableOptions(Random* rnd) {
   opt.block_size_deviation = rnd->Uniform(100);
   opt.block_restart_interval = rnd->Uniform(100);
   opt.index_block_restart_interval = rnd->Uniform(100);
+  opt.whole_key_filtering = rnd->Uniform(2);
+  opt.index_type =
+      static_cast<BlockBasedTableOptions::IndexType>(rnd->Uniform(3));
+  opt.metadata_block_size = rnd->Uniform(10000000);
+  opt.cache_index_and_filter_blocks = rnd->Uniform(2);
+  opt.cache_index_and_filter_blocks_with_high_priority = rnd->Uniform(2);
+  opt.pin_l0_filter_and_index_blocks_in_cache = rnd->Uniform(2);
+  opt.pin_top_level_index = rnd->Uniform(2);
+  opt.data_block_index_type =
+      rnd->Uniform(2) ? BlockBasedTableOptions::kDataBlockBinarySearch
+                      : BlockBasedTableOptions::kDataBlockBinaryAndHash;
 
   return opt;
 }
@@ -201,6 +213,7 @@ TableFactory* RandomTableFactory(Random* rnd, int pre_defined) {
 
 void RandomInitDBOptions(DBOptions* db_opt, Random* rnd) {
   // boolean options
+  db_opt->adaptive_write_buffer_sizing = rnd->Uniform(2);
   db_opt->advise_random_on_open = rnd->Uniform(2);
   db_opt->allow_mmap_reads = rnd->Uniform(2);
   db_opt->allow_mmap_writes = rnd->Uniform(2);
@@ -208,6 +221,7 @@ void RandomInitDBOptions(DBOptions* db_opt, Random* rnd) {
   db_opt->create_if_missing = rnd->Uniform(2);
   db_opt->create_missing_column_families = rnd->Uniform(2);
   db_opt->disableDataSync = rnd->Uniform(2);
+  db_opt->enable_pipelined_flush = rnd->Uniform(2);
   db_opt->enable_thread_tracking = rnd->Uniform(2);
   db_opt->error_if_exists = rnd->Uniform(2);
   db_opt->is_fd_close_on_exec = rnd->Uniform(2);
@@ -215,12 +229,15 @@ void RandomInitDBOptions(DBOptions* db_opt, Random* rnd) {
   db_opt->skip_stats_update_on_db_open = rnd->Uniform(2);
   db_opt->use_adaptive_mutex = rnd->Uniform(2);
   db_opt->use_fsync = rnd->Uniform(2);
+  db_opt->use_direct_reads = rnd->Uniform(2);
+  db_opt->use_direct_io_for_flush_and_compaction = rnd->Uniform(2);
   db_opt->recycle_log_file_num = rnd->Uniform(2);
 
   // int options
   db_opt->max_background_compactions = rnd->Uniform(100);
   db_opt->max_background_flushes = rnd->Uniform(100);
   db_opt->max_file_opening_threads = rnd->Uniform(100);
+  db_opt->max_range_query_table_readers = rnd->Uniform(100);
   db_opt->max_open_files = rnd->Uniform(100);
   db_opt->table_cache_numshardbits = rnd->Uniform(100);
 
@@ -248,9 +265,11 @@ void RandomInitDBOptions(DBOptions* db_opt, Random* rnd) {
   db_opt->max_manifest_file_size = uint_max + rnd->Uniform(100000);
   db_opt->max_total_wal_size = uint_max + rnd->Uniform(100000);
   db_opt->wal_bytes_per_sync = uint_max + rnd->Uniform(100000);
+  db_opt->slow_operation_micros = uint_max + rnd->Uniform(100000);
 
   // unsigned int options
   db_opt->stats_dump_period_sec = rnd->Uniform(100000);
+  db_opt->operation_trace_one_in = rnd->Uniform(100000);
 }
 
 void RandomInitCFOptions(ColumnFamilyOptions* cf_opt, Random* rnd) {
@@ -284,9 +303,19 @@ void RandomInitCFOptions(ColumnFamilyOptions* cf_opt, Random* rnd) {
   // uint64_t options
   static const uint64_t uint_max = static_cast<uint64_t>(UINT_MAX);
   cf_opt->target_file_size_base = uint_max + rnd->Uniform(10000);
+  cf_opt->soft_pending_compaction_bytes_limit = uint_max + rnd->Uniform(10000);
+  cf_opt->hard_pending_compaction_bytes_limit = uint_max + rnd->Uniform(10000);
+
+  // double options
+  cf_opt->memtable_prefix_bloom_size_ratio =
+      static_cast<double>(rnd->Uniform(10000)) / 40000.0;
 
   // pointer typed options
   cf_opt->table_factory.reset(RandomTableFactory(rnd));
+  if (rnd->Uniform(2)) {
+    cf_opt->prefix_extractor.reset(
+        NewFixedPrefixTransform(rnd->Uniform(10) + 1));
+  }
 
   // custom typed options
   cf_opt->compression = RandomCompressionType(rnd);
@@ -0,0 +1,104 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/trace_file.h"
+
+#include "util/coding.h"
+
+namespace vidardb {
+
+namespace {
+// the records are written to the file in chunks of about this size
+const size_t kBufferSize = 64 << 10;
+const size_t kHeaderSize = 12;
+}  // namespace
+
+Status TraceFileWriter::Open(Env* env, const std::string& fname,
+                             uint64_t magic, uint32_t version) {
+  Status s = env->NewWritableFile(fname, &file_, EnvOptions());
+  if (!s.ok()) {
+    return s;
+  }
+  buffer_.clear();
+  PutFixed64(&buffer_, magic);
+  PutFixed32(&buffer_, version);
+  status_ = Status::OK();
+  return s;
+}
+
+void TraceFileWriter::AddRecord(const Slice& record) {
+  PutFixed32(&buffer_, static_cast<uint32_t>(record.size()));
+  buffer_.append(record.data(), record.size());
+  if (buffer_.size() >= kBufferSize) {
+    Flush();
+  }
+}
+
+Status TraceFileWriter::Close() {
+  Flush();
+  if (status_.ok()) {
+    status_ = file_->Close();
+  }
+  file_.reset();
+  return status_;
+}
+
+void TraceFileWriter::Flush() {
+  if (status_.ok() && !buffer_.empty()) {
+    status_ = file_->Append(buffer_);
+  }
+  buffer_.clear();
+}
+
+Status TraceFileReader::Open(Env* env, const std::string& fname,
+                             uint64_t magic, uint32_t version) {
+  Status s = env->NewSequentialFile(fname, &file_, EnvOptions());
+  if (!s.ok()) {
+    return s;
+  }
+  Slice header;
+  s = Read(kHeaderSize, &header);
+  if (!s.ok()) {
+    return s.IsNotFound() ? Status::Corruption("empty trace file", fname) : s;
+  }
+  if (DecodeFixed64(header.data()) != magic) {
+    return Status::Corruption("not the expected trace file", fname);
+  }
+  if (DecodeFixed32(header.data() + 8) != version) {
+    return Status::NotSupported("trace file version", fname);
+  }
+  return s;
+}
+
+Status TraceFileReader::ReadRecord(Slice* record) {
+  Slice length;
+  Status s = Read(4, &length);
+  if (!s.ok()) {
+    return s;
+  }
+  s = Read(DecodeFixed32(length.data()), record);
+  if (s.IsNotFound()) {
+    return Status::Corruption("truncated trace file");
+  }
+  return s;
+}
+
+Status TraceFileReader::Read(size_t n, Slice* result) {
+  scratch_.resize(n);
+  Status s = file_->Read(n, result, &scratch_[0]);
+  if (!s.ok()) {
+    return s;
+  }
+  if (result->size() < n) {
+    return Status::NotFound("end of the trace file");
+  }
+  if (result->data() != scratch_.data()) {
+    scratch_.assign(result->data(), result->size());
+    *result = Slice(scratch_);
+  }
+  return s;
+}
+
+}  // namespace vidardb
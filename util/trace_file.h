@@ -0,0 +1,59 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "vidardb/env.h"
+#include "vidardb/slice.h"
+#include "vidardb/status.h"
+
+namespace vidardb {
+
+// A trace file starts with a fixed64 magic number and a fixed32 format
+// version, then holds records prefixed by their fixed32 length.
+
+// Not thread safe, the tracers serialize their records.
+class TraceFileWriter {
+ public:
+  Status Open(Env* env, const std::string& fname, uint64_t magic,
+              uint32_t version);
+
+  // Buffers the record, and writes out the buffer once it is large enough.
+  // The first error is kept, and returned by Close().
+  void AddRecord(const Slice& record);
+
+  // Writes out the buffer and closes the file.
+  Status Close();
+
+ private:
+  void Flush();
+
+  std::unique_ptr<WritableFile> file_;
+  std::string buffer_;
+  Status status_;
+};
+
+class TraceFileReader {
+ public:
+  Status Open(Env* env, const std::string& fname, uint64_t magic,
+              uint32_t version);
+
+  // Reads the next record, valid until the next call. Returns NotFound at
+  // the end of the file.
+  Status ReadRecord(Slice* record);
+
+ private:
+  // Reads exactly n bytes, NotFound if the file ends first.
+  Status Read(size_t n, Slice* result);
+
+  std::unique_ptr<SequentialFile> file_;
+  std::string scratch_;
+};
+
+}  // namespace vidardb
@@ -0,0 +1,378 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "utilities/persistent_cache/block_cache_tier.h"
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/mutexlock.h"
+
+namespace vidardb {
+
+const uint32_t BlockCacheTier::kMagic;
+const size_t BlockCacheTier::kHeaderSize;
+const uint64_t BlockCacheTier::kMaxFileSize;
+
+namespace {
+const char kCacheFileSuffix[] = ".cache";
+
+bool ParseCacheFileName(const std::string& name, uint64_t* id) {
+  const size_t suffix_size = sizeof(kCacheFileSuffix) - 1;
+  if (name.size() <= suffix_size ||
+      name.compare(name.size() - suffix_size, suffix_size,
+                   kCacheFileSuffix) != 0) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (size_t i = 0; i < name.size() - suffix_size; i++) {
+    if (name[i] < '0' || name[i] > '9') {
+      return false;
+    }
+    value = value * 10 + (name[i] - '0');
+  }
+  *id = value;
+  return true;
+}
+
+uint32_t RecordChecksum(const char* body, size_t size) {
+  return crc32c::Mask(crc32c::Value(body, size));
+}
+
+// Check the record header at data, and return the size of the whole record,
+// or 0 if it is not a valid one.
+size_t DecodeRecordHeader(const char* data, uint32_t* key_size,
+                          uint32_t* page_size) {
+  if (DecodeFixed32(data) != BlockCacheTier::kMagic) {
+    return 0;
+  }
+  *key_size = DecodeFixed32(data + 2 * sizeof(uint32_t));
+  *page_size = DecodeFixed32(data + 3 * sizeof(uint32_t));
+  return BlockCacheTier::kHeaderSize + *key_size + *page_size;
+}
+
+// Check the checksum of the whole record, and split it into key and page.
+bool DecodeRecord(const Slice& record, Slice* key, Slice* page) {
+  if (record.size() < BlockCacheTier::kHeaderSize) {
+    return false;
+  }
+  uint32_t key_size, page_size;
+  size_t size = DecodeRecordHeader(record.data(), &key_size, &page_size);
+  if (size == 0 || size != record.size()) {
+    return false;
+  }
+  const char* body = record.data() + 2 * sizeof(uint32_t);
+  if (DecodeFixed32(record.data() + sizeof(uint32_t)) !=
+      RecordChecksum(body, size - 2 * sizeof(uint32_t))) {
+    return false;
+  }
+  *key = Slice(record.data() + BlockCacheTier::kHeaderSize, key_size);
+  *page = Slice(key->data() + key_size, page_size);
+  return true;
+}
+}  // namespace
+
+BlockCacheTier::BlockCacheTier(Env* env, const std::string& path,
+                               uint64_t capacity,
+                               const std::shared_ptr<Logger>& log)
+    : env_(env),
+      path_(path),
+      capacity_(capacity),
+      // at least 16 files, so dropping the oldest one frees a small part
+      file_size_(std::min(kMaxFileSize, std::max<uint64_t>(capacity / 16, 1))),
+      log_(log) {}
+
+BlockCacheTier::~BlockCacheTier() {
+  if (writer_ != nullptr) {
+    writer_->Close();
+  }
+}
+
+std::string BlockCacheTier::CacheFileName(uint64_t id) const {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "/%06" PRIu64 "%s", id, kCacheFileSuffix);
+  return path_ + buf;
+}
+
+Status BlockCacheTier::Open() {
+  Status s = env_->CreateDirIfMissing(path_);
+  if (!s.ok()) {
+    return s;
+  }
+  std::vector<std::string> children;
+  s = env_->GetChildren(path_, &children);
+  if (!s.ok()) {
+    return s;
+  }
+  std::vector<uint64_t> ids;
+  for (const auto& child : children) {
+    uint64_t id;
+    if (ParseCacheFileName(child, &id)) {
+      ids.push_back(id);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+
+  MutexLock l(&mutex_);
+  for (uint64_t id : ids) {
+    s = RecoverFile(id);
+    if (!s.ok()) {
+      return s;
+    }
+    next_file_id_ = id + 1;
+  }
+  Evict(0);
+  Log(InfoLogLevel::INFO_LEVEL, log_,
+      "Persistent cache %s: recovered %" VIDARDB_PRIszt " pages in %"
+      VIDARDB_PRIszt " files, %" PRIu64 " bytes",
+      path_.c_str(), index_.size(), files_.size(), usage_);
+  return Status::OK();
+}
+
+Status BlockCacheTier::RecoverFile(uint64_t id) {
+  const std::string fname = CacheFileName(id);
+  uint64_t file_size = 0;
+  Status s = env_->GetFileSize(fname, &file_size);
+  if (!s.ok()) {
+    return s;
+  }
+  if (file_size == 0) {
+    return env_->DeleteFile(fname);
+  }
+
+  std::shared_ptr<CacheFile> file(new CacheFile);
+  file->id = id;
+  file->size = file_size;
+  s = env_->NewRandomAccessFile(fname, &file->reader, EnvOptions());
+  if (!s.ok()) {
+    return s;
+  }
+
+  uint64_t offset = 0;
+  std::string scratch;
+  while (offset + kHeaderSize <= file_size) {
+    char header[kHeaderSize];
+    Slice result;
+    s = file->reader->Read(offset, kHeaderSize, &result, header);
+    if (!s.ok() || result.size() != kHeaderSize) {
+      break;
+    }
+    uint32_t key_size, page_size;
+    size_t size = DecodeRecordHeader(result.data(), &key_size, &page_size);
+    if (size == 0 || offset + size > file_size) {
+      break;
+    }
+    scratch.resize(size);
+    s = file->reader->Read(offset, size, &result, &scratch[0]);
+    Slice key, page;
+    if (!s.ok() || !DecodeRecord(result, &key, &page)) {
+      break;
+    }
+    std::string key_str = key.ToString();
+    index_[key_str] = PageLocation{file, offset, static_cast<uint32_t>(size)};
+    file->keys.push_back(std::move(key_str));
+    offset += size;
+  }
+  if (offset < file_size) {
+    // the tail was not completely written, or is corrupted
+    Log(InfoLogLevel::WARN_LEVEL, log_,
+        "Persistent cache file %s: ignore %" PRIu64 " bytes after offset %"
+        PRIu64, fname.c_str(), file_size - offset, offset);
+  }
+  usage_ += file_size;
+  files_.push_back(file);
+  return Status::OK();
+}
+
+Status BlockCacheTier::NewCacheFile() {
+  if (writer_ != nullptr) {
+    writer_->Close();
+    writer_.reset();
+  }
+  const std::string fname = CacheFileName(next_file_id_);
+  std::shared_ptr<CacheFile> file(new CacheFile);
+  file->id = next_file_id_++;
+  Status s = env_->NewWritableFile(fname, &writer_, EnvOptions());
+  if (s.ok()) {
+    s = env_->NewRandomAccessFile(fname, &file->reader, EnvOptions());
+  }
+  if (!s.ok()) {
+    writer_.reset();
+    return s;
+  }
+  files_.push_back(file);
+  return s;
+}
+
+void BlockCacheTier::Evict(uint64_t bytes) {
+  // the file being written is kept, so the cache may go over its capacity
+  // by one file
+  while (usage_ + bytes > capacity_ &&
+         files_.size() > (writer_ != nullptr ? 1U : 0U)) {
+    std::shared_ptr<CacheFile> file = files_.front();
+    files_.pop_front();
+    for (const auto& key : file->keys) {
+      auto it = index_.find(key);
+      if (it != index_.end() && it->second.file == file) {
+        index_.erase(it);
+      }
+    }
+    usage_ -= file->size;
+    // the lookups in progress still read through file->reader
+    Status s = env_->DeleteFile(CacheFileName(file->id));
+    if (!s.ok()) {
+      Log(InfoLogLevel::ERROR_LEVEL, log_,
+          "Persistent cache: failed to delete file %s: %s",
+          CacheFileName(file->id).c_str(), s.ToString().c_str());
+    }
+  }
+}
+
+Status BlockCacheTier::Insert(const Slice& key, const char* data,
+                              const size_t size) {
+  const size_t record_size = kHeaderSize + key.size() + size;
+  if (record_size > capacity_) {
+    return Status::InvalidArgument("page larger than the persistent cache");
+  }
+
+  std::string record;
+  record.reserve(record_size);
+  PutFixed32(&record, kMagic);
+  PutFixed32(&record, 0);  // checksum, filled below
+  PutFixed32(&record, static_cast<uint32_t>(key.size()));
+  PutFixed32(&record, static_cast<uint32_t>(size));
+  record.append(key.data(), key.size());
+  record.append(data, size);
+  EncodeFixed32(&record[sizeof(uint32_t)],
+                RecordChecksum(record.data() + 2 * sizeof(uint32_t),
+                               record.size() - 2 * sizeof(uint32_t)));
+
+  MutexLock l(&mutex_);
+  if (index_.find(key.ToString()) != index_.end()) {
+    return Status::OK();
+  }
+  Status s;
+  if (writer_ == nullptr ||
+      (files_.back()->size > 0 &&
+       files_.back()->size + record_size > file_size_)) {
+    s = NewCacheFile();
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  Evict(record_size);
+
+  const std::shared_ptr<CacheFile>& file = files_.back();
+  s = writer_->Append(record);
+  if (s.ok()) {
+    s = writer_->Flush();
+  }
+  if (!s.ok()) {
+    // the file may end with a partial record, write the next one elsewhere
+    writer_->Close();
+    writer_.reset();
+    return s;
+  }
+  index_[key.ToString()] =
+      PageLocation{file, file->size, static_cast<uint32_t>(record_size)};
+  file->keys.push_back(key.ToString());
+  file->size += record_size;
+  usage_ += record_size;
+  return s;
+}
+
+Status BlockCacheTier::Lookup(const Slice& key, std::unique_ptr<char[]>* data,
+                              size_t* size) {
+  PageLocation location;
+  {
+    MutexLock l(&mutex_);
+    auto it = index_.find(key.ToString());
+    if (it == index_.end()) {
+      return Status::NotFound();
+    }
+    location = it->second;
+  }
+
+  std::unique_ptr<char[]> scratch(new char[location.size]);
+  Slice record;
+  Status s = location.file->reader->Read(location.offset, location.size,
+                                         &record, scratch.get());
+  Slice record_key, page;
+  if (s.ok() && (!DecodeRecord(record, &record_key, &page) ||
+                 record_key != key)) {
+    s = Status::Corruption("persistent cache page checksum mismatch");
+  }
+  if (!s.ok()) {
+    Log(InfoLogLevel::ERROR_LEVEL, log_,
+        "Persistent cache file %s: drop the page at offset %" PRIu64 ": %s",
+        CacheFileName(location.file->id).c_str(), location.offset,
+        s.ToString().c_str());
+    MutexLock l(&mutex_);
+    auto it = index_.find(key.ToString());
+    if (it != index_.end() && it->second.file == location.file &&
+        it->second.offset == location.offset) {
+      index_.erase(it);
+    }
+    return s;
+  }
+
+  *size = page.size();
+  memmove(scratch.get(), page.data(), page.size());
+  *data = std::move(scratch);
+  return s;
+}
+
+uint64_t BlockCacheTier::GetUsage() const {
+  MutexLock l(&mutex_);
+  return usage_;
+}
+
+uint64_t BlockCacheTier::TEST_NumFiles() const {
+  MutexLock l(&mutex_);
+  return files_.size();
+}
+
+std::string BlockCacheTier::GetPrintableOptions() const {
+  std::string ret;
+  ret.reserve(20000);
+  const int kBufferSize = 200;
+  char buffer[kBufferSize];
+  snprintf(buffer, kBufferSize, "    path: %s\n", path_.c_str());
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "    capacity: %" PRIu64 "\n", capacity_);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "    file_size: %" PRIu64 "\n", file_size_);
+  ret.append(buffer);
+  return ret;
+}
+
+Status NewPersistentCache(Env* const env, const std::string& path,
+                          const uint64_t size,
+                          const std::shared_ptr<Logger>& log,
+                          std::shared_ptr<PersistentCache>* cache) {
+  if (cache == nullptr) {
+    return Status::InvalidArgument("invalid output cache");
+  }
+  if (env == nullptr || path.empty() || size == 0) {
+    return Status::InvalidArgument("invalid persistent cache options");
+  }
+  std::unique_ptr<BlockCacheTier> tier(
+      new BlockCacheTier(env, path, size, log));
+  Status s = tier->Open();
+  if (s.ok()) {
+    cache->reset(tier.release());
+  }
+  return s;
+}
+
+}  // namespace vidardb
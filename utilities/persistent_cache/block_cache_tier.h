@@ -0,0 +1,100 @@
+//  Copyright (c) 2019-present, VidarDB, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "port/port.h"
+#include "vidardb/env.h"
+#include "vidardb/persistent_cache.h"
+
+namespace vidardb {
+
+// A PersistentCache made of log-structured cache files, indexed in memory.
+//
+// The pages are appended to the newest cache file as records
+//
+//    magic (fixed32) | crc (fixed32) | key size (fixed32) |
+//    page size (fixed32) | key | page
+//
+// where crc is the masked crc32c of everything after it. A cache file holds up
+// to file_size bytes, after which the next one is started. When the cache is
+// full the oldest file is deleted with all its pages.
+class BlockCacheTier : public PersistentCache {
+ public:
+  static const uint32_t kMagic = 0x76646263;  // "vdbc"
+  static const size_t kHeaderSize = 4 * sizeof(uint32_t);
+  static const uint64_t kMaxFileSize = 64 << 20;
+
+  BlockCacheTier(Env* env, const std::string& path, uint64_t capacity,
+                 const std::shared_ptr<Logger>& log);
+  virtual ~BlockCacheTier();
+
+  // Create the directory if it is missing, and recover the pages of the
+  // cache files in it.
+  Status Open();
+
+  virtual Status Insert(const Slice& key, const char* data,
+                        const size_t size) override;
+
+  virtual Status Lookup(const Slice& key, std::unique_ptr<char[]>* data,
+                        size_t* size) override;
+
+  virtual uint64_t GetUsage() const override;
+
+  virtual uint64_t GetCapacity() const override { return capacity_; }
+
+  virtual std::string GetPrintableOptions() const override;
+
+  uint64_t TEST_NumFiles() const;
+
+ private:
+  struct CacheFile {
+    uint64_t id = 0;
+    uint64_t size = 0;
+    std::unique_ptr<RandomAccessFile> reader;
+    // the keys of the pages, unindexed when the file is deleted
+    std::vector<std::string> keys;
+  };
+
+  struct PageLocation {
+    std::shared_ptr<CacheFile> file;
+    uint64_t offset;
+    uint32_t size;  // the whole record
+  };
+
+  std::string CacheFileName(uint64_t id) const;
+
+  // Recover the pages of the cache file, up to the first invalid record.
+  Status RecoverFile(uint64_t id);
+
+  // Start a new cache file for the following pages.
+  Status NewCacheFile();
+
+  // Delete the oldest cache files until bytes more fit in the cache.
+  void Evict(uint64_t bytes);
+
+  Env* const env_;
+  const std::string path_;
+  const uint64_t capacity_;
+  const uint64_t file_size_;
+  const std::shared_ptr<Logger> log_;
+
+  mutable port::Mutex mutex_;
+  std::unordered_map<std::string, PageLocation> index_;
+  // oldest first, the last one is written
+  std::deque<std::shared_ptr<CacheFile>> files_;
+  std::unique_ptr<WritableFile> writer_;
+  uint64_t next_file_id_ = 0;
+  uint64_t usage_ = 0;
+};
+
+}  // namespace vidardb